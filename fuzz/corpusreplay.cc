@@ -0,0 +1,71 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+#include "objimporter/textbuffer.hh"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static const double REPLAY_MIN_SECONDS = 0.2;
+
+// Runs one corpus file until enough time has passed for a stable MB/s figure
+static void ReplayFile(const std::string &fileName)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    std::vector<char> contents;
+    if (!ReadFileContents(fileName, contents))
+    {
+        std::cout << fileName << ": unable to read" << std::endl;
+        return;
+    }
+
+    const uint8_t *data = (const uint8_t *)contents.data();
+    int runCount = 0;
+    double seconds = 0.0;
+
+    Clock::time_point start = Clock::now();
+    while (seconds < REPLAY_MIN_SECONDS)
+    {
+        LLVMFuzzerTestOneInput(data, contents.size());
+        ++runCount;
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    double megabytes = contents.size() * (double)runCount / (1024.0 * 1024.0);
+    std::cout << fileName << ": " << contents.size() << " bytes, " << runCount << " runs, "
+              << megabytes / seconds << " MB/s" << std::endl;
+}
+
+// Plain replay driver with the same command line shape as libFuzzer:
+// every argument is a corpus file or a directory of them
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+
+        DIR *directory = opendir(argument.c_str());
+        if (directory == NULL)
+        {
+            ReplayFile(argument);
+            continue;
+        }
+
+        while (dirent *entry = readdir(directory))
+        {
+            std::string fileName = entry->d_name;
+            if (fileName != "." && fileName != "..")
+                ReplayFile(argument + "/" + fileName);
+        }
+
+        closedir(directory);
+    }
+
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "objimporter/mtlfileparser.hh"
+
+// libFuzzer entry point; corpusreplay.cc drives it in builds without libFuzzer
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    ObjParser::MtlFileParser parser("", "fuzz-input.mtl");
+
+    try
+    {
+        parser.ParseBuffer((const char *)data, size);
+    }
+    catch (std::runtime_error &)
+    {
+    }
+
+    std::vector<ObjParser::Material*> materials = parser.GetMaterials();
+    for (size_t i = 0; i < materials.size(); ++i)
+    {
+        delete materials[i];
+    }
+
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "objimporter/objimporter.hh"
+#include "objimporter/objparser.hh"
+
+// libFuzzer entry point; corpusreplay.cc drives it in builds without libFuzzer.
+// Material libraries resolve against assets/ so the seed files keep theirs.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    ObjParser::ObjFileParser parser("assets/", "fuzz-input.obj");
+    ObjParser::IParseResult *result = NULL;
+
+    try
+    {
+        result = parser.ParseBuffer((const char *)data, size);
+    }
+    catch (std::runtime_error &)
+    {
+        return 0;
+    }
+
+    ObjImporter importer(result);
+    delete result;
+
+    return 0;
+}
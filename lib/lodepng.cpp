@@ -32,6 +32,12 @@ Rename this file to lodepng.cpp to use it for C++, or to lodepng.c to use it for
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define LODEPNG_SSE2
+#include <emmintrin.h>
+#endif /*__SSE2__*/
 
 #ifdef LODEPNG_COMPILE_CPP
 #include <fstream>
@@ -453,6 +459,28 @@ static unsigned readBitsFromStream(size_t* bitpointer, const unsigned char* bits
   }
   return result;
 }
+
+/*
+returns the 32 bits at bitpointer without advancing it, of which at least the
+first 25 are valid. The caller must make sure 4 bytes can be read at (bitpointer >> 3).
+*/
+static unsigned peekBitsFromStream(size_t bitpointer, const unsigned char* bitstream)
+{
+  const unsigned char* p = &bitstream[bitpointer >> 3];
+  unsigned value = (unsigned)p[0] | ((unsigned)p[1] << 8) | ((unsigned)p[2] << 16) | ((unsigned)p[3] << 24);
+  return value >> (bitpointer & 0x7);
+}
+
+/*readBitsFromStream for up to 25 bits, taking them all at once when the input is long enough*/
+static unsigned readBitsFromStreamFast(size_t* bitpointer, const unsigned char* bitstream,
+                                       size_t nbits, size_t inbitlength)
+{
+  unsigned result;
+  if(*bitpointer + 32 > inbitlength) return readBitsFromStream(bitpointer, bitstream, nbits);
+  result = peekBitsFromStream(*bitpointer, bitstream) & ((1u << nbits) - 1u);
+  (*bitpointer) += nbits;
+  return result;
+}
 #endif /*LODEPNG_COMPILE_DECODER*/
 
 /* ////////////////////////////////////////////////////////////////////////// */
@@ -505,6 +533,7 @@ typedef struct HuffmanTree
   unsigned* lengths; /*the lengths of the codes of the 1d-tree*/
   unsigned maxbitlen; /*maximum number of bits a single code can get*/
   unsigned numcodes; /*number of symbols in the alphabet = number of codes*/
+  unsigned* table; /*decoder lookup table indexed by the next HUFFMAN_TABLE_BITS input bits, see HuffmanTree_makeTable*/
 } HuffmanTree;
 
 /*function used for debug purposes to draw the tree in ascii art with C++*/
@@ -525,6 +554,7 @@ static void HuffmanTree_init(HuffmanTree* tree)
   tree->tree2d = 0;
   tree->tree1d = 0;
   tree->lengths = 0;
+  tree->table = 0;
 }
 
 static void HuffmanTree_cleanup(HuffmanTree* tree)
@@ -532,6 +562,7 @@ static void HuffmanTree_cleanup(HuffmanTree* tree)
   lodepng_free(tree->tree2d);
   lodepng_free(tree->tree1d);
   lodepng_free(tree->lengths);
+  lodepng_free(tree->table);
 }
 
 /*the tree representation used by the decoder. return value is error*/
@@ -915,6 +946,81 @@ static unsigned generateFixedDistanceTree(HuffmanTree* tree)
 
 #ifdef LODEPNG_COMPILE_DECODER
 
+/*
+The decoder looks up the next HUFFMAN_TABLE_BITS bits of input in a table
+instead of walking tree2d bit by bit. An entry holds:
+bits 0-8: the first symbol
+bits 9-16: a second literal symbol, for HUFFMAN_TABLE_PAIR entries
+bits 17-20: the code length of the first symbol, 0 if the code is longer than
+HUFFMAN_TABLE_BITS or leaves the tree, such codes take the bit by bit path
+bits 21-25: the code length of both symbols of a pair
+*/
+#define HUFFMAN_TABLE_BITS 10u
+#define HUFFMAN_TABLE_MASK ((1u << HUFFMAN_TABLE_BITS) - 1u)
+#define HUFFMAN_TABLE_PAIR (1u << 26)
+#define HUFFMAN_TABLE_SYMBOL(entry) ((entry) & 511u)
+#define HUFFMAN_TABLE_SECOND(entry) (((entry) >> 9) & 255u)
+#define HUFFMAN_TABLE_LENGTH(entry) (((entry) >> 17) & 15u)
+#define HUFFMAN_TABLE_PAIR_LENGTH(entry) (((entry) >> 21) & 31u)
+
+/*fills the table entries of all codes below tree2d node treepos, which are depth bits deep and start with prefix*/
+static void HuffmanTree_fillTable(HuffmanTree* tree, unsigned treepos, unsigned depth, unsigned prefix)
+{
+  unsigned bit;
+  for(bit = 0; bit != 2; ++bit)
+  {
+    unsigned ct = tree->tree2d[(treepos << 1) + bit];
+    unsigned index = prefix | (bit << depth);
+    if(ct < tree->numcodes)
+    {
+      /*every index whose low depth + 1 bits are this code decodes to ct*/
+      unsigned i;
+      for(i = index; i <= HUFFMAN_TABLE_MASK; i += 1u << (depth + 1))
+      {
+        tree->table[i] = ct | ((depth + 1) << 17);
+      }
+    }
+    else if(depth + 1 < HUFFMAN_TABLE_BITS && ct - tree->numcodes < tree->numcodes)
+    {
+      HuffmanTree_fillTable(tree, ct - tree->numcodes, depth + 1, index);
+    }
+  }
+}
+
+/*
+builds the decoder lookup table from tree2d, so it decodes exactly like
+walking the tree does, including for incomplete trees. With pairLiterals, an
+entry whose bits hold two literals (as happens a lot for the literal/length
+tree) decodes both at once.
+*/
+static unsigned HuffmanTree_makeTable(HuffmanTree* tree, unsigned pairLiterals)
+{
+  unsigned i;
+  tree->table = (unsigned*)lodepng_malloc((HUFFMAN_TABLE_MASK + 1) * sizeof(unsigned));
+  if(!tree->table) return 83; /*alloc fail*/
+
+  for(i = 0; i <= HUFFMAN_TABLE_MASK; ++i) tree->table[i] = 0;
+  HuffmanTree_fillTable(tree, 0, 0, 0);
+
+  if(pairLiterals)
+  {
+    /*pair entries keep the fields of their first symbol, so the order of this loop doesn't matter*/
+    for(i = 0; i <= HUFFMAN_TABLE_MASK; ++i)
+    {
+      unsigned entry = tree->table[i];
+      unsigned length = HUFFMAN_TABLE_LENGTH(entry);
+      unsigned second, secondlength;
+      if(length == 0 || HUFFMAN_TABLE_SYMBOL(entry) > 255) continue;
+      second = tree->table[i >> length];
+      secondlength = HUFFMAN_TABLE_LENGTH(second);
+      if(secondlength == 0 || length + secondlength > HUFFMAN_TABLE_BITS || HUFFMAN_TABLE_SYMBOL(second) > 255) continue;
+      tree->table[i] = entry | (HUFFMAN_TABLE_SYMBOL(second) << 9) | ((length + secondlength) << 21) | HUFFMAN_TABLE_PAIR;
+    }
+  }
+
+  return 0;
+}
+
 /*
 returns the code, or (unsigned)(-1) if error happened
 inbitlength is the length of the complete buffer, in bits (so its byte length times 8)
@@ -923,6 +1029,15 @@ static unsigned huffmanDecodeSymbol(const unsigned char* in, size_t* bp,
                                     const HuffmanTree* codetree, size_t inbitlength)
 {
   unsigned treepos = 0, ct;
+  if(codetree->table && *bp + 32 <= inbitlength)
+  {
+    unsigned entry = codetree->table[peekBitsFromStream(*bp, in) & HUFFMAN_TABLE_MASK];
+    if(HUFFMAN_TABLE_LENGTH(entry))
+    {
+      (*bp) += HUFFMAN_TABLE_LENGTH(entry);
+      return HUFFMAN_TABLE_SYMBOL(entry);
+    }
+  }
   for(;;)
   {
     if(*bp >= inbitlength) return (unsigned)(-1); /*error: end of input memory reached without endcode*/
@@ -947,11 +1062,12 @@ static unsigned huffmanDecodeSymbol(const unsigned char* in, size_t* bp,
 /* ////////////////////////////////////////////////////////////////////////// */
 
 /*get the tree of a deflated block with fixed tree, as specified in the deflate specification*/
-static void getTreeInflateFixed(HuffmanTree* tree_ll, HuffmanTree* tree_d)
+static unsigned getTreeInflateFixed(HuffmanTree* tree_ll, HuffmanTree* tree_d)
 {
-  /*TODO: check for out of memory errors*/
-  generateFixedLitLenTree(tree_ll);
-  generateFixedDistanceTree(tree_d);
+  CERROR_TRY_RETURN(generateFixedLitLenTree(tree_ll));
+  CERROR_TRY_RETURN(generateFixedDistanceTree(tree_d));
+  CERROR_TRY_RETURN(HuffmanTree_makeTable(tree_ll, 1));
+  return HuffmanTree_makeTable(tree_d, 0);
 }
 
 /*get the tree of a deflated block with dynamic tree, the tree itself is also Huffman compressed with a known tree*/
@@ -998,6 +1114,8 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 
     error = HuffmanTree_makeFromLengths(&tree_cl, bitlen_cl, NUM_CODE_LENGTH_CODES, 7);
     if(error) break;
+    error = HuffmanTree_makeTable(&tree_cl, 0);
+    if(error) break;
 
     /*now we can use this tree to read the lengths for the tree that this function will return*/
     bitlen_ll = (unsigned*)lodepng_malloc(NUM_DEFLATE_CODE_SYMBOLS * sizeof(unsigned));
@@ -1089,7 +1207,11 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
     /*now we've finally got HLIT and HDIST, so generate the code trees, and the function is done*/
     error = HuffmanTree_makeFromLengths(tree_ll, bitlen_ll, NUM_DEFLATE_CODE_SYMBOLS, 15);
     if(error) break;
+    error = HuffmanTree_makeTable(tree_ll, 1);
+    if(error) break;
     error = HuffmanTree_makeFromLengths(tree_d, bitlen_d, NUM_DISTANCE_SYMBOLS, 15);
+    if(error) break;
+    error = HuffmanTree_makeTable(tree_d, 0);
 
     break; /*end of error-while*/
   }
@@ -1114,13 +1236,33 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
   HuffmanTree_init(&tree_ll);
   HuffmanTree_init(&tree_d);
 
-  if(btype == 1) getTreeInflateFixed(&tree_ll, &tree_d);
+  if(btype == 1) error = getTreeInflateFixed(&tree_ll, &tree_d);
   else if(btype == 2) error = getTreeInflateDynamic(&tree_ll, &tree_d, in, bp, inlength);
 
   while(!error) /*decode all symbols until end reached, breaks at end code*/
   {
     /*code_ll is literal, length or end code*/
-    unsigned code_ll = huffmanDecodeSymbol(in, bp, &tree_ll, inbitlength);
+    unsigned code_ll;
+    if(*bp + 32 <= inbitlength)
+    {
+      unsigned entry = tree_ll.table[peekBitsFromStream(*bp, in) & HUFFMAN_TABLE_MASK];
+      if(entry & HUFFMAN_TABLE_PAIR) /*two literal symbols at once*/
+      {
+        if(!ucvector_resize(out, (*pos) + 2)) ERROR_BREAK(83 /*alloc fail*/);
+        out->data[(*pos)++] = (unsigned char)HUFFMAN_TABLE_SYMBOL(entry);
+        out->data[(*pos)++] = (unsigned char)HUFFMAN_TABLE_SECOND(entry);
+        (*bp) += HUFFMAN_TABLE_PAIR_LENGTH(entry);
+        continue;
+      }
+      else if(HUFFMAN_TABLE_LENGTH(entry))
+      {
+        (*bp) += HUFFMAN_TABLE_LENGTH(entry);
+        code_ll = HUFFMAN_TABLE_SYMBOL(entry);
+      }
+      else code_ll = huffmanDecodeSymbol(in, bp, &tree_ll, inbitlength);
+    }
+    else code_ll = huffmanDecodeSymbol(in, bp, &tree_ll, inbitlength);
+
     if(code_ll <= 255) /*literal symbol*/
     {
       /*ucvector_push_back would do the same, but for some reason the two lines below run 10% faster*/
@@ -1140,7 +1282,7 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
       /*part 2: get extra bits and add the value of that to length*/
       numextrabits_l = LENGTHEXTRA[code_ll - FIRST_LENGTH_CODE_INDEX];
       if((*bp + numextrabits_l) > inbitlength) ERROR_BREAK(51); /*error, bit pointer will jump past memory*/
-      length += readBitsFromStream(bp, in, numextrabits_l);
+      length += readBitsFromStreamFast(bp, in, numextrabits_l, inbitlength);
 
       /*part 3: get distance code*/
       code_d = huffmanDecodeSymbol(in, bp, &tree_d, inbitlength);
@@ -1160,7 +1302,7 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
       /*part 4: get extra bits from distance*/
       numextrabits_d = DISTANCEEXTRA[code_d];
       if((*bp + numextrabits_d) > inbitlength) ERROR_BREAK(51); /*error, bit pointer will jump past memory*/
-      distance += readBitsFromStream(bp, in, numextrabits_d);
+      distance += readBitsFromStreamFast(bp, in, numextrabits_d, inbitlength);
 
       /*part 5: fill in all the out[n] values based on the length and dist*/
       start = (*pos);
@@ -1169,10 +1311,14 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
 
       if(!ucvector_resize(out, (*pos) + length)) ERROR_BREAK(83 /*alloc fail*/);
       if (distance < length) {
-        for(forward = 0; forward < length; ++forward)
+        /*the copy repeats the last distance bytes, copy whole repetitions from backward, doubling each time*/
+        for(forward = 0; forward < length;)
         {
-          out->data[(*pos)++] = out->data[backward++];
+          size_t amount = forward + distance < length - forward ? forward + distance : length - forward;
+          memcpy(out->data + start + forward, out->data + backward, amount);
+          forward += amount;
         }
+        *pos += length;
       } else {
         memcpy(out->data + *pos, out->data + backward, length);
         *pos += length;
@@ -3895,6 +4041,102 @@ unsigned lodepng_inspect(unsigned* w, unsigned* h, LodePNGState* state,
   return state->error;
 }
 
+#ifdef LODEPNG_SSE2
+/*
+SSE2 versions of the filters for 3 and 4 byte pixels. Sub, Average and Paeth
+depend on the pixel to the left, so these work on one pixel at a time with all
+its channels in one register. The first pixel is handled like the others with
+a zero left neighbour, which gives the same predictions as the scalar code.
+*/
+static __m128i loadPixelSSE2(const unsigned char* p, size_t bytewidth)
+{
+  unsigned value = 0;
+  memcpy(&value, p, bytewidth);
+  return _mm_cvtsi32_si128((int)value);
+}
+
+static void storePixelSSE2(unsigned char* p, __m128i pixel, size_t bytewidth)
+{
+  unsigned value = (unsigned)_mm_cvtsi128_si32(pixel);
+  memcpy(p, &value, bytewidth);
+}
+
+static void unfilterUpSSE2(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon,
+                           size_t length)
+{
+  size_t i = 0;
+  for(; i + 16 <= length; i += 16)
+  {
+    __m128i x = _mm_loadu_si128((const __m128i*)&scanline[i]);
+    __m128i b = _mm_loadu_si128((const __m128i*)&precon[i]);
+    _mm_storeu_si128((__m128i*)&recon[i], _mm_add_epi8(x, b));
+  }
+  for(; i != length; ++i) recon[i] = scanline[i] + precon[i];
+}
+
+static void unfilterSubSSE2(unsigned char* recon, const unsigned char* scanline, size_t bytewidth, size_t length)
+{
+  size_t i;
+  __m128i a = _mm_setzero_si128();
+  for(i = 0; i != length; i += bytewidth)
+  {
+    a = _mm_add_epi8(a, loadPixelSSE2(&scanline[i], bytewidth));
+    storePixelSSE2(&recon[i], a, bytewidth);
+  }
+}
+
+static void unfilterAverageSSE2(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon,
+                                size_t bytewidth, size_t length)
+{
+  size_t i;
+  __m128i a = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi8(1);
+  for(i = 0; i != length; i += bytewidth)
+  {
+    __m128i b = loadPixelSSE2(&precon[i], bytewidth);
+    /*_mm_avg_epu8 rounds up, the filter rounds down*/
+    __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+    a = _mm_add_epi8(average, loadPixelSSE2(&scanline[i], bytewidth));
+    storePixelSSE2(&recon[i], a, bytewidth);
+  }
+}
+
+static __m128i absSSE2(__m128i x)
+{
+  return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static __m128i selectSSE2(__m128i mask, __m128i yes, __m128i no)
+{
+  return _mm_or_si128(_mm_and_si128(mask, yes), _mm_andnot_si128(mask, no));
+}
+
+static void unfilterPaethSSE2(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon,
+                              size_t bytewidth, size_t length)
+{
+  /*a, b and c are the left, up and upper left pixels widened to 16 bits, as in paethPredictor*/
+  size_t i;
+  const __m128i zero = _mm_setzero_si128();
+  __m128i a = zero, c = zero;
+  for(i = 0; i != length; i += bytewidth)
+  {
+    __m128i b = _mm_unpacklo_epi8(loadPixelSSE2(&precon[i], bytewidth), zero);
+    __m128i p = _mm_sub_epi16(b, c);
+    __m128i q = _mm_sub_epi16(a, c);
+    __m128i pa = absSSE2(p);
+    __m128i pb = absSSE2(q);
+    __m128i pc = absSSE2(_mm_add_epi16(p, q));
+    __m128i predictor = selectSSE2(_mm_cmplt_epi16(pb, pa), b, a);
+    predictor = selectSSE2(_mm_and_si128(_mm_cmplt_epi16(pc, pa), _mm_cmplt_epi16(pc, pb)), c, predictor);
+
+    __m128i pixel = _mm_add_epi8(_mm_packus_epi16(predictor, zero), loadPixelSSE2(&scanline[i], bytewidth));
+    storePixelSSE2(&recon[i], pixel, bytewidth);
+    a = _mm_unpacklo_epi8(pixel, zero);
+    c = b;
+  }
+}
+#endif /*LODEPNG_SSE2*/
+
 static unsigned unfilterScanline(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon,
                                  size_t bytewidth, unsigned char filterType, size_t length)
 {
@@ -3908,6 +4150,32 @@ static unsigned unfilterScanline(unsigned char* recon, const unsigned char* scan
   */
 
   size_t i;
+#ifdef LODEPNG_SSE2
+  /*the SSE2 functions read each pixel before writing it, so recon may still trail scanline*/
+  if(filterType == 2 && precon)
+  {
+    unfilterUpSSE2(recon, scanline, precon, length);
+    return 0;
+  }
+  else if(bytewidth == 3 || bytewidth == 4)
+  {
+    if(filterType == 1 || (filterType == 4 && !precon))
+    {
+      unfilterSubSSE2(recon, scanline, bytewidth, length);
+      return 0;
+    }
+    else if(filterType == 3 && precon)
+    {
+      unfilterAverageSSE2(recon, scanline, precon, bytewidth, length);
+      return 0;
+    }
+    else if(filterType == 4)
+    {
+      unfilterPaethSSE2(recon, scanline, precon, bytewidth, length);
+      return 0;
+    }
+  }
+#endif /*LODEPNG_SSE2*/
   switch(filterType)
   {
     case 0:
@@ -4639,7 +4907,12 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
     size_t outsize = lodepng_get_raw_size(*w, *h, &state->info_png.color);
     ucvector outv;
     ucvector_init(&outv);
-    if(!ucvector_resizev(&outv, outsize, 0)) state->error = 83; /*alloc fail*/
+    /*postProcessScanlines writes every byte, except for the padding bits when there are less than 8 bits per pixel*/
+    if(lodepng_get_bpp(&state->info_png.color) < 8)
+    {
+      if(!ucvector_resizev(&outv, outsize, 0)) state->error = 83; /*alloc fail*/
+    }
+    else if(!ucvector_resize(&outv, outsize)) state->error = 83; /*alloc fail*/
     if(!state->error) state->error = postProcessScanlines(outv.data, scanlines.data, *w, *h, &state->info_png);
     *out = outv.data;
   }
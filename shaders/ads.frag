@@ -8,40 +8,60 @@ struct LightInfo
     vec3 Ls;
 };
 
-struct MaterialInfo
+uniform LightInfo Light;
+
+// Packed by ADSRenderer::RegisterMaterial, one record per material
+layout (std140) uniform MaterialBlock
 {
-    vec3 Ka;
-    vec3 Kd;
-    vec3 Ks;
-    float Shininess;
-    sampler2D Kd_map;
-    bool hasKdMap;
-};
+    vec4 Ka;
+    vec4 Kd;
+    vec4 Ks;       // w is the shininess
+    ivec4 HasMaps; // Kd, Ks and normal map
+} Material;
 
-uniform LightInfo Light;
-uniform MaterialInfo Material;
+uniform sampler2D KdMap;
+uniform sampler2D KsMap;
+uniform sampler2D NormalMap;
 
 in vec3 Position;
 in vec3 Normal;
 in vec2 TexCoord;
+in vec4 Lighting;
 
 layout (location = 0) out vec4 FragColor;
 
-void phongModel(vec3 position, vec3 normal,
+// Tangent frame from screen-space derivatives, so meshes need no tangents
+mat3 cotangentFrame(vec3 n, vec3 position, vec2 uv)
+{
+    vec3 dp1 = dFdx(position);
+    vec3 dp2 = dFdy(position);
+    vec2 duv1 = dFdx(uv);
+    vec2 duv2 = dFdy(uv);
+
+    vec3 dp2perp = cross(dp2, n);
+    vec3 dp1perp = cross(n, dp1);
+    vec3 t = dp2perp * duv1.x + dp1perp * duv2.x;
+    vec3 b = dp2perp * duv1.y + dp1perp * duv2.y;
+
+    float invmax = inversesqrt(max(max(dot(t, t), dot(b, b)), 1e-20));
+    return mat3(t * invmax, b * invmax, n);
+}
+
+void phongModel(vec3 position, vec3 normal, vec3 specularColor,
                 out vec3 ambient, out vec3 diffuse, out vec3 specular)
 {
-    ambient = Light.La * Material.Ka;
+    ambient = Light.La * Material.Ka.rgb;
 
     vec3 n = normalize(normal);
     vec3 s = normalize(vec3(Light.Position.xyz - position));
     float sDotN = max(dot(s, n), 0.0);
-    diffuse = Light.Ld * Material.Kd * sDotN;
+    diffuse = Light.Ld * Material.Kd.rgb * sDotN;
 
     vec3 v = normalize(-position);
     vec3 r = reflect(-s, n);
     vec3 spec = vec3(0.0);
     if (sDotN > 0.0)
-        spec = Light.Ls * Material.Ks * pow(max(dot(r,v), 0.0), Material.Shininess);
+        spec = Light.Ls * specularColor * pow(max(dot(r,v), 0.0), Material.Ks.w);
 
     specular = spec;
 }
@@ -50,14 +70,31 @@ void main()
 {
     vec3 ambient, diffuse, specular;
     vec4 texColor;
-    phongModel(Position, Normal, ambient, diffuse, specular);
-    if (Material.hasKdMap)
+
+    vec3 normal = normalize(Normal);
+    if (Material.HasMaps.z != 0)
+    {
+        vec3 mapNormal = texture(NormalMap, TexCoord).xyz * 2.0 - 1.0;
+        normal = normalize(cotangentFrame(normal, Position, TexCoord) * mapNormal);
+    }
+
+    vec3 specularColor = Material.Ks.rgb;
+    if (Material.HasMaps.y != 0)
+        specularColor *= texture(KsMap, TexCoord).rgb;
+
+    phongModel(Position, normal, specularColor, ambient, diffuse, specular);
+    if (Material.HasMaps.x != 0)
     {
-        texColor = texture(Material.Kd_map, TexCoord);
+        texColor = texture(KdMap, TexCoord);
     }
     else
     {
         texColor = vec4(1.0);
     }
-    FragColor = vec4(ambient + diffuse, 1.0) * texColor + vec4(specular, 1.0);
+
+    // Baked voxel lighting: r is ambient occlusion, g sky light, b block light
+    float occlusion = 0.4 + 0.6 * Lighting.r;
+    float bakedLight = max(max(Lighting.g, Lighting.b), 0.1);
+
+    FragColor = vec4((ambient + diffuse) * occlusion * bakedLight, 1.0) * texColor + vec4(specular, 1.0);
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 in vec4 VertexPosition;
 in vec3 VertexNormal;
 in vec2 VertexTexCoord;
+in vec4 VertexLighting;
 
 uniform mat4 ModelViewMatrix;
 uniform mat3 NormalMatrix;
@@ -12,10 +13,12 @@ uniform mat4 MVP;
 out vec3 Position;
 out vec3 Normal;
 out vec2 TexCoord;
+out vec4 Lighting;
 
 void main()
 {
     TexCoord = VertexTexCoord;
+    Lighting = VertexLighting;
     Normal = normalize(NormalMatrix * VertexNormal);
     vec4 tmp = ModelViewMatrix * VertexPosition;
     Position = vec3(tmp);
@@ -0,0 +1,29 @@
+#version 330
+
+in vec4 VertexPosition;
+in vec3 VertexNormal;
+in vec2 VertexTexCoord;
+in vec4 VertexLighting;
+in mat4 InstanceModelMatrix;
+
+uniform mat4 ViewMatrix;
+uniform mat4 ProjectionMatrix;
+
+out vec3 Position;
+out vec3 Normal;
+out vec2 TexCoord;
+out vec4 Lighting;
+
+void main()
+{
+    mat4 modelViewMatrix = ViewMatrix * InstanceModelMatrix;
+
+    TexCoord = VertexTexCoord;
+    Lighting = VertexLighting;
+    // Instances are expected to use rotation, translation and uniform scale only
+    Normal = normalize(mat3(modelViewMatrix) * VertexNormal);
+    vec4 tmp = modelViewMatrix * VertexPosition;
+    Position = vec3(tmp);
+
+    gl_Position = ProjectionMatrix * tmp;
+}
@@ -6,12 +6,12 @@
 
 #include "constants.hh"
 #include "moveable.hh"
-#include "rendering/adsrenderer.hh"
+#include "rendering/irenderer.hh"
 
 class Camera : public Moveable
 {
 public:
-    Camera(ADSRenderer *renderer)
+    Camera(IRenderer *renderer)
         : _renderer(renderer)
     {
         _position = glm::vec3( 5.0f, 1.5f, 5.0f);
@@ -56,8 +56,13 @@ public:
         return glm::inverse(_projectionMatrix * _viewMatrix) * vec;
     }
 
+    float GetPixelsPerUnit(unsigned int viewportHeight) const
+    {
+        return viewportHeight / (2.0f * _zoom * _orthoParamY);
+    }
+
 private:
-    ADSRenderer *_renderer;
+    IRenderer *_renderer;
 
     glm::vec3 _position;
     float _rotation;
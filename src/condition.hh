@@ -2,11 +2,35 @@
 
 #include <vector>
 
+#include "inputevent.hh"
+
+// Conditions that list their input sources are only checked again in
+// frames where one of those inputs changed, so Check must depend on
+// nothing else. Without sources a condition is checked every frame.
 class Condition
 {
 public:
     virtual ~Condition() {}
     virtual bool Check() = 0;
+
+    virtual bool GetInputSources(std::vector<InputSource> &sources)
+    {
+        return false;
+    }
+};
+
+// Matches single input events rather than the current state. With sources
+// it is only offered events from those sources.
+class EventCondition
+{
+public:
+    virtual ~EventCondition() {}
+    virtual bool Check(const InputEvent &event) = 0;
+
+    virtual bool GetInputSources(std::vector<InputSource> &sources)
+    {
+        return false;
+    }
 };
 
 class MultiConditionChecker : public Condition
@@ -23,6 +47,17 @@ public:
         return true;
     }
 
+    bool GetInputSources(std::vector<InputSource> &sources)
+    {
+        for (int i = 0; i < _conditions.size(); ++i)
+        {
+            if (!_conditions[i]->GetInputSources(sources))
+                return false;
+        }
+
+        return true;
+    }
+
     void AddCondition(Condition *condition)
     {
         _conditions.push_back(condition);
@@ -0,0 +1,336 @@
+#include <algorithm>
+#include <iterator>
+
+#include "conditionhandler.hh"
+
+ConditionHandler::ConditionHandler()
+    : _nextSequence(0), _frame(0), _updating(false), _activeSorted(true)
+{
+}
+
+ConditionHandler::~ConditionHandler()
+{
+    Clear();
+}
+
+void ConditionHandler::Update()
+{
+    update(std::vector<InputEvent>(), true);
+}
+
+void ConditionHandler::Update(const std::vector<InputEvent> &events)
+{
+    update(events, false);
+}
+
+void ConditionHandler::update(const std::vector<InputEvent> &events, bool checkAll)
+{
+    _updating = true;
+    ++_frame;
+
+    for (int i = 0; i < events.size(); ++i)
+    {
+        dispatchEvent(events[i]);
+    }
+
+    // Conditions such as a button going down this frame turn false again
+    // without an event, so inputs that changed last frame are checked too
+    _previousChangedSources.swap(_changedSources);
+    _changedSources.clear();
+    for (int i = 0; i < events.size(); ++i)
+    {
+        _changedSources.push_back(GetEventSource(events[i]));
+    }
+
+    if (checkAll)
+    {
+        for (std::unordered_map<Condition*, BindingList>::iterator it = _bindingsByCondition.begin();
+             it != _bindingsByCondition.end(); ++it)
+        {
+            for (int i = 0; i < it->second.size(); ++i)
+            {
+                check(it->second[i]);
+            }
+        }
+    }
+    else
+    {
+        const std::vector<InputSource> *changed[] = { &_previousChangedSources, &_changedSources };
+        for (int i = 0; i < 2; ++i)
+        {
+            for (int j = 0; j < changed[i]->size(); ++j)
+            {
+                std::unordered_map<InputSource, BindingList>::iterator found =
+                    _bindingsBySource.find((*changed[i])[j]);
+                if (found == _bindingsBySource.end())
+                    continue;
+
+                for (int k = 0; k < found->second.size(); ++k)
+                {
+                    check(found->second[k]);
+                }
+            }
+        }
+
+        for (int i = 0; i < _unindexedBindings.size(); ++i)
+        {
+            check(_unindexedBindings[i]);
+        }
+
+        for (int i = 0; i < _newBindings.size(); ++i)
+        {
+            check(_newBindings[i]);
+        }
+    }
+    _newBindings.clear();
+
+    runActive();
+
+    _updating = false;
+    deleteRemovedBindings();
+}
+
+void ConditionHandler::dispatchEvent(const InputEvent &event)
+{
+    _running.clear();
+
+    std::unordered_map<InputSource, BindingList>::iterator found =
+        _eventBindingsBySource.find(GetEventSource(event));
+    if (found != _eventBindingsBySource.end())
+    {
+        // Both lists are in binding order
+        std::merge(found->second.begin(), found->second.end(),
+                   _unindexedEventBindings.begin(), _unindexedEventBindings.end(),
+                   std::back_inserter(_running),
+                   [](const Binding *a, const Binding *b) { return a->sequence < b->sequence; });
+    }
+    else
+    {
+        _running = _unindexedEventBindings;
+    }
+
+    for (int i = 0; i < _running.size(); ++i)
+    {
+        Binding *binding = _running[i];
+
+        if (!binding->removed && binding->eventCondition->Check(event))
+            binding->command->Execute();
+    }
+}
+
+void ConditionHandler::check(Binding *binding)
+{
+    if (binding->removed || binding->checkedFrame == _frame)
+        return;
+
+    binding->checkedFrame = _frame;
+    setActive(binding, binding->condition->Check());
+}
+
+void ConditionHandler::setActive(Binding *binding, bool active)
+{
+    if (binding->active == active)
+        return;
+
+    binding->active = active;
+    if (active)
+    {
+        _activeBindings.push_back(binding);
+        _activeSorted = false;
+    }
+    else
+    {
+        _activeBindings.erase(std::find(_activeBindings.begin(), _activeBindings.end(), binding));
+    }
+}
+
+void ConditionHandler::runActive()
+{
+    if (!_activeSorted)
+    {
+        std::sort(_activeBindings.begin(), _activeBindings.end(),
+                  [](const Binding *a, const Binding *b) { return a->sequence < b->sequence; });
+        _activeSorted = true;
+    }
+
+    // Commands may change the bindings, so run from a copy
+    _running = _activeBindings;
+    for (int i = 0; i < _running.size(); ++i)
+    {
+        if (!_running[i]->removed)
+            _running[i]->command->Execute();
+    }
+}
+
+void ConditionHandler::SetHandler(Condition *condition, Command *command)
+{
+    Binding *binding = createBinding(condition, NULL, command);
+    _bindingsByCondition[condition].push_back(binding);
+
+    for (int i = 0; i < binding->sources.size(); ++i)
+    {
+        _bindingsBySource[binding->sources[i]].push_back(binding);
+    }
+    if (!binding->indexed)
+        _unindexedBindings.push_back(binding);
+
+    // Checked in the next update whatever its inputs do
+    _newBindings.push_back(binding);
+}
+
+void ConditionHandler::RemoveHandler(Condition *condition, Command *command)
+{
+    std::unordered_map<Condition*, BindingList>::iterator found = _bindingsByCondition.find(condition);
+    if (found == _bindingsByCondition.end())
+        return;
+
+    Binding *binding = takeBinding(found->second, command);
+    if (found->second.empty())
+        _bindingsByCondition.erase(found);
+
+    if (binding != NULL)
+        removeBinding(binding);
+}
+
+void ConditionHandler::SetEventHandler(EventCondition *condition, Command *command)
+{
+    Binding *binding = createBinding(NULL, condition, command);
+    _bindingsByEventCondition[condition].push_back(binding);
+
+    for (int i = 0; i < binding->sources.size(); ++i)
+    {
+        _eventBindingsBySource[binding->sources[i]].push_back(binding);
+    }
+    if (!binding->indexed)
+        _unindexedEventBindings.push_back(binding);
+}
+
+void ConditionHandler::RemoveEventHandler(EventCondition *condition, Command *command)
+{
+    std::unordered_map<EventCondition*, BindingList>::iterator found = _bindingsByEventCondition.find(condition);
+    if (found == _bindingsByEventCondition.end())
+        return;
+
+    Binding *binding = takeBinding(found->second, command);
+    if (found->second.empty())
+        _bindingsByEventCondition.erase(found);
+
+    if (binding != NULL)
+        removeBinding(binding);
+}
+
+void ConditionHandler::Clear()
+{
+    for (std::unordered_map<Condition*, BindingList>::iterator it = _bindingsByCondition.begin();
+         it != _bindingsByCondition.end(); ++it)
+    {
+        _removedBindings.insert(_removedBindings.end(), it->second.begin(), it->second.end());
+    }
+    for (std::unordered_map<EventCondition*, BindingList>::iterator it = _bindingsByEventCondition.begin();
+         it != _bindingsByEventCondition.end(); ++it)
+    {
+        _removedBindings.insert(_removedBindings.end(), it->second.begin(), it->second.end());
+    }
+
+    for (int i = 0; i < _removedBindings.size(); ++i)
+    {
+        _removedBindings[i]->removed = true;
+    }
+
+    _bindingsByCondition.clear();
+    _bindingsByEventCondition.clear();
+    _bindingsBySource.clear();
+    _eventBindingsBySource.clear();
+    _unindexedBindings.clear();
+    _unindexedEventBindings.clear();
+    _newBindings.clear();
+    _activeBindings.clear();
+    _activeSorted = true;
+
+    if (!_updating)
+        deleteRemovedBindings();
+}
+
+ConditionHandler::Binding *ConditionHandler::createBinding(Condition *condition, EventCondition *eventCondition,
+                                                           Command *command)
+{
+    Binding *binding = new Binding();
+    binding->condition = condition;
+    binding->eventCondition = eventCondition;
+    binding->command = command;
+    binding->sequence = _nextSequence++;
+    binding->indexed = condition != NULL ? condition->GetInputSources(binding->sources)
+                                         : eventCondition->GetInputSources(binding->sources);
+    binding->active = false;
+    binding->removed = false;
+    binding->checkedFrame = 0;
+
+    if (binding->indexed)
+    {
+        std::sort(binding->sources.begin(), binding->sources.end());
+        binding->sources.erase(std::unique(binding->sources.begin(), binding->sources.end()),
+                               binding->sources.end());
+    }
+    else
+    {
+        binding->sources.clear();
+    }
+
+    return binding;
+}
+
+ConditionHandler::Binding *ConditionHandler::takeBinding(BindingList &bindings, Command *command)
+{
+    for (int i = 0; i < bindings.size(); ++i)
+    {
+        if (bindings[i]->command == command)
+        {
+            Binding *binding = bindings[i];
+            bindings.erase(bindings.begin() + i);
+            return binding;
+        }
+    }
+
+    return NULL;
+}
+
+// Only touches the lists for the binding's own inputs
+void ConditionHandler::removeBinding(Binding *binding)
+{
+    std::unordered_map<InputSource, BindingList> &index =
+        binding->condition != NULL ? _bindingsBySource : _eventBindingsBySource;
+    for (int i = 0; i < binding->sources.size(); ++i)
+    {
+        std::unordered_map<InputSource, BindingList>::iterator found = index.find(binding->sources[i]);
+        found->second.erase(std::find(found->second.begin(), found->second.end(), binding));
+        if (found->second.empty())
+            index.erase(found);
+    }
+
+    if (!binding->indexed)
+    {
+        BindingList &unindexed = binding->condition != NULL ? _unindexedBindings : _unindexedEventBindings;
+        unindexed.erase(std::find(unindexed.begin(), unindexed.end(), binding));
+    }
+
+    BindingList::iterator pending = std::find(_newBindings.begin(), _newBindings.end(), binding);
+    if (pending != _newBindings.end())
+        _newBindings.erase(pending);
+
+    setActive(binding, false);
+    binding->removed = true;
+    _removedBindings.push_back(binding);
+
+    // Bindings removed by a running command are still in the running list
+    if (!_updating)
+        deleteRemovedBindings();
+}
+
+void ConditionHandler::deleteRemovedBindings()
+{
+    for (int i = 0; i < _removedBindings.size(); ++i)
+    {
+        delete _removedBindings[i];
+    }
+    _removedBindings.clear();
+}
@@ -1,66 +1,86 @@
 #pragma once
 
+#include <unordered_map>
 #include <vector>
 
 #include "command.hh"
 #include "condition.hh"
+#include "inputevent.hh"
 #include "types.hh"
 
+// Runs commands for the conditions bound to them. Bindings are indexed by
+// the input sources their conditions depend on, so a frame only checks
+// the ones whose inputs changed, plus those that cannot name their inputs.
+// A state binding's last result is kept and its command runs every frame
+// while that result is true. Commands run in the order they were bound,
+// and bindings may be added or removed from inside a command.
 class ConditionHandler
 {
 public:
-    class StateHandler
-    {
-    public:
-        StateHandler(Condition *_condition, Command *_command)
-            : condition(_condition), command(_command)
-        {
-        }
+    ConditionHandler();
+    ~ConditionHandler();
 
-        Condition *condition;
-        Command *command;
-    };
+    // Checks every condition, for callers without events
+    void Update();
 
-public:
-    ConditionHandler()
-    {
-    }
+    // Runs the event handlers once for every event they match, in the order
+    // the events happened, and then the state handlers whose inputs changed
+    void Update(const std::vector<InputEvent> &events);
 
-    void Update()
-    {
-        for (int i = 0; i < _handlers.size(); ++i)
-        {
-            StateHandler *handler = &_handlers[i];
+    void SetHandler(Condition *condition, Command *command);
+    void RemoveHandler(Condition *condition, Command *command);
 
-            if (handler->condition->Check())
-                handler->command->Execute();
-        }
-    }
+    void SetEventHandler(EventCondition *condition, Command *command);
+    void RemoveEventHandler(EventCondition *condition, Command *command);
 
-    void SetHandler(Condition *condition, Command *command)
-    {
-        _handlers.push_back(StateHandler(condition, command));
-    }
+    void Clear();
 
-    void RemoveHandler(Condition *condition, Command *command)
-    {
-        for (int i = 0; i < _handlers.size(); ++i)
-        {
-            StateHandler *handler = &_handlers[i];
-
-            if (handler->condition == condition && handler->command == command)
-            {
-                _handlers.erase(_handlers.begin() + i);
-                return;
-            }
-        }
-    }
-
-    void Clear()
+private:
+    typedef struct Binding
     {
-        _handlers.clear();
-    }
+        Condition *condition;
+        EventCondition *eventCondition;
+        Command *command;
+        unsigned int sequence;
+        std::vector<InputSource> sources;
+        bool indexed;
+        bool active;
+        bool removed;
+        unsigned int checkedFrame;
+    } Binding;
+
+    typedef std::vector<Binding*> BindingList;
+
+    unsigned int _nextSequence;
+    unsigned int _frame;
+    bool _updating;
+
+    std::unordered_map<Condition*, BindingList> _bindingsByCondition;
+    std::unordered_map<EventCondition*, BindingList> _bindingsByEventCondition;
+    std::unordered_map<InputSource, BindingList> _bindingsBySource;
+    std::unordered_map<InputSource, BindingList> _eventBindingsBySource;
+    BindingList _unindexedBindings;
+    BindingList _unindexedEventBindings;
+    BindingList _newBindings;
+    BindingList _activeBindings;
+    bool _activeSorted;
+    BindingList _removedBindings;
+
+    std::vector<InputSource> _changedSources;
+    std::vector<InputSource> _previousChangedSources;
+    BindingList _running;
 
 private:
-    std::vector<StateHandler> _handlers;
+    void update(const std::vector<InputEvent> &events, bool checkAll);
+    void dispatchEvent(const InputEvent &event);
+    void check(Binding *binding);
+    void setActive(Binding *binding, bool active);
+    void runActive();
+
+    Binding *createBinding(Condition *condition, EventCondition *eventCondition, Command *command);
+    Binding *takeBinding(BindingList &bindings, Command *command);
+    void removeBinding(Binding *binding);
+    void deleteRemovedBindings();
+
+    ConditionHandler(const ConditionHandler &o) = delete;
 };
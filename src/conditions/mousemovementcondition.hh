@@ -20,6 +20,12 @@ public:
         return deltaX != 0 || deltaY != 0;
     }
 
+    bool GetInputSources(std::vector<InputSource> &sources)
+    {
+        sources.push_back(GetInputSource(InputSourceType::MouseMove));
+        return true;
+    }
+
 private:
     MouseTracker *_tracker;
 };
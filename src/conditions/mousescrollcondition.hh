@@ -16,6 +16,12 @@ public:
         return _mouseTracker->GetScrollDelta() != 0;
     }
 
+    bool GetInputSources(std::vector<InputSource> &sources)
+    {
+        sources.push_back(GetInputSource(InputSourceType::MouseScroll));
+        return true;
+    }
+
 private:
     MouseTracker *_mouseTracker;
 };
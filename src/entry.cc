@@ -19,30 +19,41 @@
 #include "conditionhandler.hh"
 #include "conditions/mousescrollcondition.hh"
 #include "entity.hh"
+#include "imagecache.hh"
 #include "imageloader.hh"
+#include "inputstate.hh"
 #include "moveable.hh"
 #include "mousetracker.hh"
+#include "objimporter/meshcache.hh"
 #include "objimporter/objimporter.hh"
 #include "objimporter/objparser.hh"
 #include "rendering/adsrenderer.hh"
+#include "rendering/framepipeline.hh"
+#include "utility/fixedsteploop.hh"
+#include "utility/frametimehistogram.hh"
+#include "utility/profiler.hh"
 #include "utility/sleepservice.hh"
 #include "utility/systemtimer.hh"
-#include "utility/ticker.hh"
 #include "testinputhandler.hh"
 #include "tilerenderer.hh"
 #include "types.hh"
+#include "voxellod.hh"
 #include "voxels.hh"
 #include "voxelsector.hh"
 
 using std::cout;
 using std::endl;
 
+static const unsigned int SIMULATION_STEPS_PER_SECOND = 60;
+static const int FRAME_PACKET_WAIT_MILLISECONDS = 10;
+static const char PROFILE_TRACE_FILE_NAME[] = "profile.json";
+
 class SimpleObjectGraphicsComponent
 {
 private:
     typedef struct ExtendedRenderObject
     {
-        RenderObject object;
+        IndexValue meshId;
         IndexValue materialId;
     } ExtendedRenderObject;
 
@@ -50,15 +61,13 @@ public:
     SimpleObjectGraphicsComponent(IRenderer *renderer)
         : _renderer(renderer)
     {
-        ObjParser::ObjFileParser parser("assets/", "textured-things.obj");
-        ObjParser::IParseResult *parseResult = parser.Parse();
-        ObjImporter importer(parseResult);
-        std::vector<RenderObject> renderObjects = importer.GetRenderObjects();
+        ObjImporter importer(LoadObjFileCached("assets/", "textured-things.obj"));
+        std::vector<RenderObject> renderObjects = importer.TakeRenderObjects();
         for (int i = 0; i < renderObjects.size(); ++i)
         {
             RenderObject *renderObject = &renderObjects[i];
             ExtendedRenderObject object;
-            object.object = *renderObject;
+            object.meshId = _renderer->RegisterMesh(*renderObject);
             object.materialId = _renderer->RegisterMaterial(importer.GetMaterial(renderObject->_materialName));
             _renderObjects.push_back(object);
         }
@@ -66,16 +75,13 @@ public:
 
     void update(const glm::vec3 &position)
     {
-        _renderer->SetModelMatrix(glm::translate(glm::mat4(1.0), position));
+        _modelMatrices.clear();
+        _modelMatrices.push_back(glm::translate(glm::mat4(1.0), position));
         for (int i = 0; i < _renderObjects.size(); ++i)
         {
             ExtendedRenderObject *object = &_renderObjects[i];
 
-            _renderer->Render(object->object._indices,
-                              object->object._vertices,
-                              object->object._normals,
-                              object->object._uvCoords,
-                              object->materialId);
+            _renderer->RenderInstanced(object->meshId, _modelMatrices, object->materialId);
         }
     }
 
@@ -83,6 +89,7 @@ private:
     IRenderer *_renderer;
     ObjImporter *_importer;
     std::vector<ExtendedRenderObject> _renderObjects;
+    std::vector<glm::mat4> _modelMatrices;
 };
 
 class SimpleObject : public Entity, public Moveable
@@ -92,11 +99,24 @@ public:
         : _graphicsComponent(graphicsComponent)
     {
         _position = glm::vec3(0.0, 0.0, -6.0);
+        _previousPosition = _position;
+        _interpolation = 0.0f;
+    }
+
+    // Rendering blends from the state before the last simulation step
+    void SaveState()
+    {
+        _previousPosition = _position;
+    }
+
+    void SetInterpolation(float interpolation)
+    {
+        _interpolation = interpolation;
     }
 
     void update()
     {
-        _graphicsComponent->update(_position);
+        _graphicsComponent->update(glm::mix(_previousPosition, _position, _interpolation));
     }
 
     void Move(float x, float y, float z)
@@ -112,6 +132,8 @@ public:
     SimpleObjectGraphicsComponent *_graphicsComponent;
 
     glm::vec3 _position;
+    glm::vec3 _previousPosition;
+    float _interpolation;
 };
 
 SimpleObject *CreateSimpleObject(IRenderer *renderer)
@@ -136,7 +158,8 @@ ApplicationThreadEntry_FunctionSignature(ApplicationThreadEntry)
 
     SystemTimer systemTimer(applicationContext->GetSystemUtility());
     SleepService sleepService(applicationContext->GetSystemUtility());
-    Ticker ticker = Ticker(&systemTimer, &sleepService);
+    MonotonicClock clock;
+    FixedStepLoop loop(&clock, &sleepService, SIMULATION_STEPS_PER_SECOND);
 
     ADSRenderer *adsRenderer = new ADSRenderer();
 
@@ -147,10 +170,19 @@ ApplicationThreadEntry_FunctionSignature(ApplicationThreadEntry)
     lightInfo.Ls = glm::vec3(0.0, 0.0, 0.0);
     adsRenderer->SetLight(lightInfo);
 
-    IRenderer *renderer = (IRenderer *)adsRenderer;
+    // Everything below draws through the recorder, and the logic thread
+    // hands the recorded frames to this thread through the pipeline
+    FramePipeline pipeline;
+    FramePacketRecorder recorder(adsRenderer);
+    IRenderer *renderer = &recorder;
 
-    Framework::ReadingKeyboardState *keyboardState = windowController->GetKeyStateReader();
-    Framework::ReadingMouseState *mouseState = windowController->GetMouseReader();
+    // Input is read from a per-frame snapshot rather than the window's locked state
+    InputState inputState(windowController->GetMouseReader(), &systemTimer);
+    windowController->AddKeyboardEventHandler(&inputState);
+    inputState.Update();
+
+    Framework::ReadingKeyboardState *keyboardState = &inputState;
+    Framework::ReadingMouseState *mouseState = &inputState;
     Framework::ReadingWindowState *windowState = windowController->GetWindowReader();
 
     unsigned int windowWidth, windowHeight, newWindowWidth, newWindowHeight;
@@ -158,7 +190,8 @@ ApplicationThreadEntry_FunctionSignature(ApplicationThreadEntry)
 
     SimpleObject *simpleObject = CreateSimpleObject(renderer);
 
-    TileRenderer tileRenderer(adsRenderer, LoadImageFromPNG("assets/colors.png"), 16, 16);
+    TileRenderer tileRenderer(renderer, ImageCache::GetInstance()->LoadAsync("assets/colors.png", LoadImageFromPNG), 16, 16);
+    VoxelLodSelector lodSelector;
     VoxelRepository voxelRepository;
     voxelRepository.AddVoxelType(VoxelType(0, 0));
     voxelRepository.AddVoxelType(VoxelType(0, 1));
@@ -166,8 +199,7 @@ ApplicationThreadEntry_FunctionSignature(ApplicationThreadEntry)
     voxelRepository.AddVoxelType(VoxelType(1, 1));
 
     MouseTracker *mouseTracker = new MouseTracker(mouseState);
-    Camera *camera = new Camera(adsRenderer);
-    ticker.Start(17);
+    Camera *camera = new Camera(renderer);
 
     ConditionHandler inputHandler;
     TestInputHandlerState testHandlerState(windowController,
@@ -181,7 +213,7 @@ ApplicationThreadEntry_FunctionSignature(ApplicationThreadEntry)
 
     entities.push_back((Entity*)simpleObject);
 
-    VoxelSector *sector = CreateVoxelSector(adsRenderer, &tileRenderer,
+    VoxelSector *sector = CreateVoxelSector(renderer, &tileRenderer, &lodSelector,
                                             &voxelRepository, Position(0, 0, 0));
     // sector->SetVoxel(Position(0, 0, 0), 0);
     // sector->SetVoxel(Position(1, 0, 0), 1);
@@ -195,8 +227,10 @@ ApplicationThreadEntry_FunctionSignature(ApplicationThreadEntry)
     sector->Import("test.map");
     entities.push_back(sector);
 
-    sector = CreateVoxelSector(adsRenderer, &tileRenderer,
+    VoxelSector *originSector = sector;
+    sector = CreateVoxelSector(renderer, &tileRenderer, &lodSelector,
                                &voxelRepository, Position(-1, 0, 0));
+    originSector->SetNeighbor(Direction::Left, sector);
     sector->SetVoxel(Position(14, 0, 0), 0);
     sector->SetVoxel(Position(13, 0, 0), 1);
     sector->SetVoxel(Position(12, 0, 0), 2);
@@ -205,32 +239,104 @@ ApplicationThreadEntry_FunctionSignature(ApplicationThreadEntry)
 
     entities.push_back(sector);
 
-    while (!applicationContext->IsClosing())
-    {
-        windowState->GetSize(&newWindowWidth, &newWindowHeight);
-        if (newWindowWidth != windowWidth || newWindowHeight != windowHeight)
+    // Simulation, meshing and draw recording run here, one packet per frame
+    FrameTimeHistogram logicFrameTimes;
+    System::thread logicThread([&]() {
+        PROFILE_THREAD("Logic");
+        loop.Start();
+        while (!applicationContext->IsClosing())
         {
-            windowWidth = newWindowWidth;
-            windowHeight = newWindowHeight;
-            adsRenderer->SetProjectionMatrix(glm::ortho(-6.0f, 6.0f,
-                                                        -4.0f, 4.0f,
-                                                        1.0f, 100.0f));
+            unsigned long long frameStart = clock.GetNanoseconds();
+
+            // Input is sampled per step, so catch-up steps see no new movement
+            unsigned int steps = loop.BeginFrame();
+            for (unsigned int i = 0; i < steps; ++i)
+            {
+                PROFILE_SCOPE("Simulation step");
+                simpleObject->SaveState();
+                inputState.Update();
+                mouseTracker->update();
+                inputHandler.Update(inputState.GetEvents());
+            }
+            simpleObject->SetInterpolation(loop.GetInterpolation());
+
+            windowState->GetSize(&newWindowWidth, &newWindowHeight);
+            if (newWindowWidth != windowWidth || newWindowHeight != windowHeight)
+            {
+                windowWidth = newWindowWidth;
+                windowHeight = newWindowHeight;
+                renderer->SetProjectionMatrix(glm::ortho(-6.0f, 6.0f,
+                                                         -4.0f, 4.0f,
+                                                         1.0f, 100.0f));
+            }
+
+            if (keyboardState->GetKeyState(System::KeyCode::KeyQ) == Framework::KeyState::Pressed)
+            {
+                applicationContext->Close();
+            }
+
+            {
+                PROFILE_SCOPE("Record frame");
+                FramePacket &packet = pipeline.GetRecordingPacket();
+                recorder.Begin(&packet);
+                packet.step = loop.GetStepCount();
+                lodSelector.SetPixelsPerUnit(camera->GetPixelsPerUnit(windowHeight));
+                for (int i = 0; i < entities.size(); ++i)
+                {
+                    PROFILE_SCOPE("Entity::update");
+                    entities[i]->update();
+                }
+                recorder.End();
+                pipeline.Publish();
+            }
+
+            logicFrameTimes.Add((double)(clock.GetNanoseconds() - frameStart) / NANOSECONDS_PER_MILLISECOND);
+            loop.WaitForNextStep();
         }
+    });
 
-        if (keyboardState->GetKeyState(System::KeyCode::KeyQ) == Framework::KeyState::Pressed)
+    // This thread owns the context and only draws what the logic thread recorded
+    FrameTimeHistogram renderFrameTimes;
+    PROFILE_THREAD("Render");
+    while (!applicationContext->IsClosing())
+    {
+        const FramePacket *packet = pipeline.Acquire(FRAME_PACKET_WAIT_MILLISECONDS);
+        if (packet == NULL)
+            continue;
+
+        unsigned long long frameStart = clock.GetNanoseconds();
         {
-            applicationContext->Close();
+            PROFILE_SCOPE("Render frame");
+            glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+            adsRenderer->ProcessUploads();
+            packet->Replay(adsRenderer);
         }
 
-        glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
-        mouseTracker->update();
-        inputHandler.Update();
-        for (int i = 0; i < entities.size(); ++i)
+        // Measured before swapping, which may wait for the display
+        renderFrameTimes.Add((double)(clock.GetNanoseconds() - frameStart) / NANOSECONDS_PER_MILLISECOND);
         {
-            entities[i]->update();
+            PROFILE_SCOPE("SwapBuffers");
+            windowController->SwapBuffers();
         }
 
-        windowController->SwapBuffers();
-        ticker.WaitUntilNextTick();
+#ifdef ENABLE_PROFILING
+        Profiler::GetInstance()->Collect();
+#endif
     }
+
+    logicThread.join();
+    windowController->RemoveKeyboardEventHandler(&inputState);
+
+#ifdef ENABLE_PROFILING
+    cout << "Logic frames:" << endl;
+    logicFrameTimes.Print(cout);
+    cout << "Render frames:" << endl;
+    renderFrameTimes.Print(cout);
+
+    Profiler *profiler = Profiler::GetInstance();
+    profiler->Collect();
+    profiler->PrintSummary(cout);
+    if (profiler->SaveChromeTrace(PROFILE_TRACE_FILE_NAME))
+        cout << "Trace written to " << PROFILE_TRACE_FILE_NAME << endl;
+#endif
 }
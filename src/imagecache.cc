@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <string>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "imagecache.hh"
+#include "utility/profiler.hh"
+
+static const int IMAGE_CACHE_WAIT_MILLISECONDS = 10;
+
+std::string GetCanonicalPath(const std::string &fileName)
+{
+#ifdef _WIN32
+    char buffer[_MAX_PATH];
+    if (_fullpath(buffer, fileName.c_str(), _MAX_PATH) == NULL)
+        return fileName;
+
+    std::string path = buffer;
+    for (int i = 0; i < path.size(); ++i)
+    {
+        path[i] = path[i] == '\\' ? '/' : tolower(path[i]);
+    }
+
+    return path;
+#else
+    char buffer[PATH_MAX];
+    if (realpath(fileName.c_str(), buffer) == NULL)
+        return fileName;
+
+    return buffer;
+#endif
+}
+
+unsigned int GetProcessorCount()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long count = info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    return count > 0 ? count : 1;
+}
+
+static long long GetModificationTime(const std::string &fileName)
+{
+    struct stat fileStat;
+    if (stat(fileName.c_str(), &fileStat) != 0)
+        return -1;
+
+    return fileStat.st_mtime;
+}
+
+ImageHandle::~ImageHandle()
+{
+    if (_image != NULL)
+    {
+        free(_image->data);
+        free(_image);
+    }
+}
+
+void ImageHandle::AddReference()
+{
+    _cache->_mutex->Lock();
+    ++_references;
+    _cache->_mutex->Unlock();
+}
+
+void ImageHandle::Release()
+{
+    // The handle may be gone once released
+    ImageCache *cache = _cache;
+    cache->_mutex->Lock();
+    cache->release(this);
+    cache->_mutex->Unlock();
+}
+
+bool ImageHandle::IsReady()
+{
+    _cache->_mutex->Lock();
+    bool ready = _state == State::Ready;
+    _cache->_mutex->Unlock();
+
+    return ready;
+}
+
+RawImageInfo *ImageHandle::Wait()
+{
+    return _cache->wait(this);
+}
+
+RawImageInfo *ImageHandle::Get()
+{
+    _cache->_mutex->Lock();
+    RawImageInfo *image = _state == State::Ready ? _image : NULL;
+    _cache->_mutex->Unlock();
+
+    return image;
+}
+
+ImageCache::ImageCache(unsigned int workerCount)
+    : _workerCount(workerCount), _mutex(System::Mutex::Create()),
+      _imageQueued(System::Event::Create(NULL)), _imageDecoded(System::Event::Create(NULL)),
+      _stopping(false)
+{
+}
+
+ImageCache::~ImageCache()
+{
+    _mutex->Lock();
+    _stopping = true;
+    _mutex->Unlock();
+
+    for (int i = 0; i < _workers.size(); ++i)
+    {
+        _imageQueued->Trigger();
+    }
+
+    for (int i = 0; i < _workers.size(); ++i)
+    {
+        _workers[i]->join();
+        delete _workers[i];
+    }
+
+    for (std::unordered_set<ImageHandle*>::iterator i = _handles.begin(); i != _handles.end(); ++i)
+    {
+        delete *i;
+    }
+
+    delete _imageDecoded;
+    delete _imageQueued;
+    delete _mutex;
+}
+
+ImageCache *ImageCache::GetInstance()
+{
+    static ImageCache instance;
+    return &instance;
+}
+
+ImageHandle *ImageCache::LoadAsync(const std::string &fileName, ImageLoaderFunction loader)
+{
+    std::string path = GetCanonicalPath(fileName);
+    long long modificationTime = GetModificationTime(path);
+
+    _mutex->Lock();
+
+    std::unordered_map<std::string, ImageHandle*>::iterator found = _images.find(path);
+    if (found != _images.end() && found->second->_modificationTime == modificationTime)
+    {
+        ImageHandle *handle = found->second;
+        ++handle->_references;
+        _mutex->Unlock();
+        return handle;
+    }
+
+    // A changed file gets a new handle; the old one stays valid for its users
+    if (found != _images.end())
+        release(found->second);
+
+    // One reference each for the caller, the cache entry and the queue
+    ImageHandle *handle = new ImageHandle(this, path, fileName, loader, modificationTime);
+    handle->_references = 3;
+    _handles.insert(handle);
+    _images[path] = handle;
+    _queue.push_back(handle);
+
+    // Workers start with the first request
+    while (_workers.size() < _workerCount)
+    {
+        _workers.push_back(new System::thread([this]() { run(); }));
+    }
+
+    _mutex->Unlock();
+    _imageQueued->Trigger();
+
+    return handle;
+}
+
+RawImageInfo *ImageCache::Load(const std::string &fileName, ImageLoaderFunction loader)
+{
+    ImageHandle *handle = LoadAsync(fileName, loader);
+    RawImageInfo *image = handle->Wait();
+    handle->Release();
+
+    return image;
+}
+
+size_t ImageCache::GetSize()
+{
+    _mutex->Lock();
+    size_t size = _images.size();
+    _mutex->Unlock();
+
+    return size;
+}
+
+size_t ImageCache::GetHandleCount()
+{
+    _mutex->Lock();
+    size_t count = _handles.size();
+    _mutex->Unlock();
+
+    return count;
+}
+
+void ImageCache::run()
+{
+    _mutex->Lock();
+    while (!_stopping)
+    {
+        if (_queue.empty())
+        {
+            _mutex->Unlock();
+            _imageQueued->Wait(IMAGE_CACHE_WAIT_MILLISECONDS);
+            _mutex->Lock();
+            continue;
+        }
+
+        ImageHandle *handle = _queue.front();
+        _queue.pop_front();
+        handle->_state = ImageHandle::State::Decoding;
+
+        // Wake another worker while there is more to do
+        if (!_queue.empty())
+            _imageQueued->Trigger();
+
+        _mutex->Unlock();
+        decode(handle);
+        _mutex->Lock();
+    }
+    _mutex->Unlock();
+}
+
+// Called with the lock held
+void ImageCache::release(ImageHandle *handle)
+{
+    if (--handle->_references > 0)
+        return;
+
+    _handles.erase(handle);
+    delete handle;
+}
+
+// Called without the lock held, with the handle marked as Decoding
+void ImageCache::decode(ImageHandle *handle)
+{
+    PROFILE_SCOPE("ImageCache::decode");
+
+    RawImageInfo *image = handle->_loader(handle->_fileName);
+
+    _mutex->Lock();
+    handle->_image = image;
+    handle->_state = ImageHandle::State::Ready;
+
+    // Failures are not cached, so the next load tries again
+    std::unordered_map<std::string, ImageHandle*>::iterator found = _images.find(handle->_path);
+    if (image == NULL && found != _images.end() && found->second == handle)
+    {
+        _images.erase(found);
+        release(handle);
+    }
+
+    // Drops the queue's reference
+    release(handle);
+    _mutex->Unlock();
+
+    _imageDecoded->Trigger();
+}
+
+RawImageInfo *ImageCache::wait(ImageHandle *handle)
+{
+    _mutex->Lock();
+
+    // Rather than block on an idle queue entry, decode it here
+    if (handle->_state == ImageHandle::State::Queued)
+    {
+        _queue.erase(std::find(_queue.begin(), _queue.end(), handle));
+        handle->_state = ImageHandle::State::Decoding;
+        _mutex->Unlock();
+
+        decode(handle);
+        _mutex->Lock();
+    }
+
+    while (handle->_state != ImageHandle::State::Ready)
+    {
+        _mutex->Unlock();
+        _imageDecoded->Wait(IMAGE_CACHE_WAIT_MILLISECONDS);
+        _mutex->Lock();
+    }
+
+    RawImageInfo *image = handle->_image;
+    _mutex->Unlock();
+
+    return image;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "system/event.hh"
+#include "system/mutex.hh"
+#include "system/thread.hh"
+#include "types.hh"
+
+typedef RawImageInfo *(*ImageLoaderFunction)(const std::string &fileName);
+
+std::string GetCanonicalPath(const std::string &fileName);
+unsigned int GetProcessorCount();
+
+class ImageCache;
+
+// An image that is decoded by the cache's worker pool. Wait() decodes the
+// image on the calling thread if no worker has picked it up yet. Handles are
+// reference counted; every LoadAsync adds a reference that its caller gives
+// back with Release, and the handle and its image are freed with the last one.
+class ImageHandle
+{
+public:
+    void AddReference();
+    void Release();
+
+    bool IsReady();
+    RawImageInfo *Wait();
+
+    // NULL until the image is ready or when decoding failed
+    RawImageInfo *Get();
+
+    const std::string &GetFileName() const
+    {
+        return _fileName;
+    }
+
+private:
+    friend class ImageCache;
+
+    enum class State
+    {
+        Queued,
+        Decoding,
+        Ready
+    };
+
+    ImageHandle(ImageCache *cache, const std::string &path, const std::string &fileName, ImageLoaderFunction loader,
+                long long modificationTime)
+        : _cache(cache), _path(path), _fileName(fileName), _loader(loader), _modificationTime(modificationTime),
+          _references(0), _state(State::Queued), _image(NULL)
+    {
+    }
+
+    ~ImageHandle();
+
+    ImageCache *_cache;
+    std::string _path;
+    std::string _fileName;
+    ImageLoaderFunction _loader;
+    long long _modificationTime;
+    unsigned int _references;
+    State _state;
+    RawImageInfo *_image;
+};
+
+// Process-wide cache of decoded images keyed by canonical path and
+// modification time, so every material that references the same file
+// shares one RawImageInfo. Images are decoded on a pool of workers. The
+// cache keeps a reference to the current handle of each file; it lets go
+// when the file changes and is loaded again, or when decoding fails so the
+// next load retries. Loaders must allocate images and their data with malloc.
+class ImageCache
+{
+public:
+    ImageCache(unsigned int workerCount = GetProcessorCount());
+    ~ImageCache();
+
+    static ImageCache *GetInstance();
+
+    ImageHandle *LoadAsync(const std::string &fileName, ImageLoaderFunction loader);
+
+    // The image stays valid until the file changes and is loaded again
+    RawImageInfo *Load(const std::string &fileName, ImageLoaderFunction loader);
+    size_t GetSize();
+
+    // Includes superseded handles that are still referenced
+    size_t GetHandleCount();
+
+private:
+    friend class ImageHandle;
+
+    unsigned int _workerCount;
+    System::Mutex *_mutex;
+    System::Event *_imageQueued;
+    System::Event *_imageDecoded;
+    std::vector<System::thread*> _workers;
+    std::deque<ImageHandle*> _queue;
+    std::unordered_map<std::string, ImageHandle*> _images;
+    std::unordered_set<ImageHandle*> _handles;
+    bool _stopping;
+
+private:
+    void run();
+    void release(ImageHandle *handle);
+    void decode(ImageHandle *handle);
+    RawImageInfo *wait(ImageHandle *handle);
+};
@@ -1,5 +1,7 @@
 #include <cstdio>
+#include <cstdlib>
 #include <string>
+#include <vector>
 
 #include "imageloader.hh"
 #include "types.hh"
@@ -13,12 +15,11 @@ RawImageInfo *LoadImageFromJPG(const std::string &fileName)
 {
     struct jpeg_decompress_struct info;
     struct jpeg_error_mgr jpegError;
-    ImageData imageData;
-    ImageData scanlinePointer[1];
-    unsigned int imageWidth, imageHeight, dataSize, dataWidth;
-    RawImageInfo *imageInfo = (RawImageInfo *) malloc(sizeof(RawImageInfo));
-    
+    unsigned int dataWidth;
+
     FILE* file = fopen(fileName.c_str(), "rb");
+    if (file == NULL)
+        return NULL;
 
     info.err = jpeg_std_error(&jpegError);
     jpeg_create_decompress(&info);
@@ -28,38 +29,53 @@ RawImageInfo *LoadImageFromJPG(const std::string &fileName)
 
     jpeg_start_decompress(&info);
 
+    RawImageInfo *imageInfo = (RawImageInfo *) malloc(sizeof(RawImageInfo));
     imageInfo->width = info.output_width;
     imageInfo->height = info.output_height;
     imageInfo->components = info.output_components == 4 ? GL_RGBA : GL_RGB;
+    imageInfo->levels = 1;
     dataWidth = imageInfo->width * info.output_components;
-    dataSize = imageInfo->height * dataWidth;
-    imageInfo->data = (ImageData) malloc(dataSize);
+    imageInfo->data = (ImageData) malloc(imageInfo->height * dataWidth);
+
+    // Hand libjpeg every remaining row so it can write as many per call as
+    // its output buffer allows
+    std::vector<JSAMPROW> rows(imageInfo->height);
+    for (unsigned int i = 0; i < imageInfo->height; ++i)
+    {
+        rows[i] = imageInfo->data + dataWidth * i;
+    }
 
     while (info.output_scanline < info.output_height)
     {
-        scanlinePointer[0] = imageInfo->data + dataWidth * info.output_scanline;
-        jpeg_read_scanlines(&info, scanlinePointer, 1);
+        jpeg_read_scanlines(&info, &rows[info.output_scanline], info.output_height - info.output_scanline);
     }
-    
+
     jpeg_finish_decompress(&info);
     jpeg_destroy_decompress(&info);
 
     fclose(file);
-    
+
     return imageInfo;
 }
 
 RawImageInfo *LoadImageFromPNG(const std::string &fileName)
 {
-    RawImageInfo *imageInfo = (RawImageInfo *) malloc(sizeof(RawImageInfo));
-    std::vector<unsigned char> pixels;
+    unsigned char *pixels = NULL;
     unsigned int width, height;
-    
-    lodepng::decode(pixels, imageInfo->width, imageInfo->height, fileName.c_str());
 
+    // Decodes straight into the malloc'd buffer the image keeps
+    if (lodepng_decode32_file(&pixels, &width, &height, fileName.c_str()) != 0)
+    {
+        free(pixels);
+        return NULL;
+    }
+
+    RawImageInfo *imageInfo = (RawImageInfo *) malloc(sizeof(RawImageInfo));
+    imageInfo->width = width;
+    imageInfo->height = height;
     imageInfo->components = GL_RGBA;
-    imageInfo->data = (ImageData) malloc((sizeof (unsigned char)) *pixels.size());
-    memcpy(imageInfo->data, pixels.data(), (sizeof (unsigned char)) *pixels.size());
+    imageInfo->levels = 1;
+    imageInfo->data = pixels;
 
     return imageInfo;
 }
@@ -63,6 +63,12 @@ public:
         return _keyboardState->GetKeyState(_buttonState.GetKey()) == _buttonState.GetState();
     }
 
+    bool GetInputSources(std::vector<InputSource> &sources)
+    {
+        sources.push_back(GetKeySource(_buttonState.GetKey()));
+        return true;
+    }
+
 private:
     Framework::ReadingKeyboardState *_keyboardState;
     ButtonState _buttonState;
@@ -82,7 +88,61 @@ public:
         return _mouseState->GetMouseButtonState(_buttonState.GetButton()) == _buttonState.GetState();
     }
 
+    bool GetInputSources(std::vector<InputSource> &sources)
+    {
+        sources.push_back(GetMouseButtonSource(_buttonState.GetButton()));
+        return true;
+    }
+
 private:
     Framework::ReadingMouseState *_mouseState;
     MouseButtonState _buttonState;
 };
+
+class KeyboardEventCondition : public EventCondition
+{
+public:
+    KeyboardEventCondition(InputEvent::Type type, System::KeyCode key)
+        : _type(type), _key(key)
+    {
+    }
+
+    bool Check(const InputEvent &event)
+    {
+        return event.type == _type && event.key == _key;
+    }
+
+    bool GetInputSources(std::vector<InputSource> &sources)
+    {
+        sources.push_back(GetKeySource(_key));
+        return true;
+    }
+
+private:
+    InputEvent::Type _type;
+    System::KeyCode _key;
+};
+
+class MouseButtonEventCondition : public EventCondition
+{
+public:
+    MouseButtonEventCondition(InputEvent::Type type, System::MouseButton button)
+        : _type(type), _button(button)
+    {
+    }
+
+    bool Check(const InputEvent &event)
+    {
+        return event.type == _type && event.button == _button;
+    }
+
+    bool GetInputSources(std::vector<InputSource> &sources)
+    {
+        sources.push_back(GetMouseButtonSource(_button));
+        return true;
+    }
+
+private:
+    InputEvent::Type _type;
+    System::MouseButton _button;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <system/keycode.hh>
+#include <system/mousebutton.hh>
+
+typedef struct InputEvent
+{
+    enum class Type
+    {
+        KeyDown,
+        KeyUp,
+        MouseButtonDown,
+        MouseButtonUp,
+        MouseMove,
+        MouseScroll
+    };
+
+    Type type;
+    // System ticks in milliseconds
+    unsigned int timestamp;
+
+    // Depending on type
+    System::KeyCode key;
+    System::MouseButton button;
+    int mouseX;
+    int mouseY;
+    int scrollDelta;
+} InputEvent;
+
+// Names one input, such as a key or the mouse wheel, so conditions can say
+// what they depend on and events can say what they changed
+typedef unsigned int InputSource;
+
+enum class InputSourceType
+{
+    Key,
+    MouseButton,
+    MouseMove,
+    MouseScroll
+};
+
+inline InputSource GetInputSource(InputSourceType type, unsigned int code = 0)
+{
+    return ((unsigned int)type << 16) | code;
+}
+
+inline InputSource GetKeySource(System::KeyCode key)
+{
+    return GetInputSource(InputSourceType::Key, (unsigned int)key);
+}
+
+inline InputSource GetMouseButtonSource(System::MouseButton button)
+{
+    return GetInputSource(InputSourceType::MouseButton, (unsigned int)button);
+}
+
+inline InputSource GetEventSource(const InputEvent &event)
+{
+    switch (event.type)
+    {
+    case InputEvent::Type::KeyDown:
+    case InputEvent::Type::KeyUp:
+        return GetKeySource(event.key);
+    case InputEvent::Type::MouseButtonDown:
+    case InputEvent::Type::MouseButtonUp:
+        return GetMouseButtonSource(event.button);
+    case InputEvent::Type::MouseMove:
+        return GetInputSource(InputSourceType::MouseMove);
+    default:
+        return GetInputSource(InputSourceType::MouseScroll);
+    }
+}
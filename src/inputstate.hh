@@ -0,0 +1,223 @@
+#pragma once
+
+#include <atomic>
+#include <bitset>
+#include <vector>
+
+#include <framework/platform.hh>
+
+#include "inputevent.hh"
+#include "utility/spscqueue.hh"
+#include "utility/systemtimer.hh"
+#include "utility/triplebuffer.hh"
+
+static const unsigned int KEY_CODE_COUNT = (unsigned int)System::KeyCode::KeyZ + 1;
+static const unsigned int MOUSE_BUTTON_COUNT = (unsigned int)System::MouseButton::Button3 + 1;
+static const unsigned int INPUT_EVENT_QUEUE_SIZE = 256;
+
+typedef std::bitset<KEY_CODE_COUNT> KeyboardSnapshot;
+typedef std::bitset<MOUSE_BUTTON_COUNT> MouseButtonSnapshot;
+
+typedef struct InputSnapshot
+{
+    InputSnapshot()
+        : mouseX(0), mouseY(0), scrollDelta(0)
+    {
+    }
+
+    Framework::KeyState GetKeyState(System::KeyCode key) const
+    {
+        return keys.test((size_t)key) ? Framework::KeyState::Pressed : Framework::KeyState::Unpressed;
+    }
+
+    Framework::KeyState GetMouseButtonState(System::MouseButton button) const
+    {
+        return mouseButtons.test((size_t)button) ? Framework::KeyState::Pressed : Framework::KeyState::Unpressed;
+    }
+
+    KeyboardSnapshot keys;
+    MouseButtonSnapshot mouseButtons;
+    int mouseX;
+    int mouseY;
+    int scrollDelta;
+} InputSnapshot;
+
+// Keyboard state as of the start of the frame. Key events arrive on the
+// window thread, which publishes the whole key set through a triple
+// buffer; Update picks up the latest one on the logic thread and samples
+// the mouse once, so every query during the frame is a bit lookup.
+//
+// Every key transition is also queued with its time, so a press and
+// release within one frame still shows up in GetEvents. The window does
+// not forward mouse events, so those are derived from the per-frame
+// samples and stamped with the time of the Update.
+class InputState : public Framework::IWritingKeyboardState,
+                   public Framework::ReadingKeyboardState,
+                   public Framework::ReadingMouseState
+{
+public:
+    InputState(Framework::ReadingMouseState *mouseReader, ISystemTimer *timer)
+        : _mouseReader(mouseReader), _timer(timer), _droppedEventCount(0)
+    {
+    }
+
+    // Window thread
+    void PressKey(System::KeyCode key)
+    {
+        if (_pressedKeys.test((size_t)key))
+            return;
+
+        _pressedKeys.set((size_t)key);
+        publishKeys();
+        queueKeyEvent(InputEvent::Type::KeyDown, key);
+    }
+
+    void UnpressKey(System::KeyCode key)
+    {
+        if (!_pressedKeys.test((size_t)key))
+            return;
+
+        _pressedKeys.reset((size_t)key);
+        publishKeys();
+        queueKeyEvent(InputEvent::Type::KeyUp, key);
+    }
+
+    // Logic thread, once per frame
+    void Update()
+    {
+        _previous = _current;
+
+        _keys.Acquire();
+        _current.keys = _keys.GetReadBuffer();
+
+        for (unsigned int i = 0; i < MOUSE_BUTTON_COUNT; ++i)
+        {
+            _current.mouseButtons.set(i, _mouseReader->GetMouseButtonState((System::MouseButton)i) ==
+                                      Framework::KeyState::Pressed);
+        }
+
+        _current.mouseX = _mouseReader->GetMouseX();
+        _current.mouseY = _mouseReader->GetMouseY();
+        _current.scrollDelta = _mouseReader->GetScrollDelta();
+
+        _events.clear();
+        InputEvent event;
+        while (_queue.TryPop(event))
+        {
+            _events.push_back(event);
+        }
+        addMouseEvents();
+    }
+
+    // Everything that happened since the previous Update, oldest first
+    const std::vector<InputEvent> &GetEvents() const
+    {
+        return _events;
+    }
+
+    // Key events lost because the logic thread fell too far behind
+    unsigned int GetDroppedEventCount() const
+    {
+        return _droppedEventCount.load(std::memory_order_relaxed);
+    }
+
+    const InputSnapshot &GetCurrent() const
+    {
+        return _current;
+    }
+
+    const InputSnapshot &GetPrevious() const
+    {
+        return _previous;
+    }
+
+    Framework::KeyState GetKeyState(System::KeyCode key)
+    {
+        return _current.GetKeyState(key);
+    }
+
+    int GetMouseX() const
+    {
+        return _current.mouseX;
+    }
+
+    int GetMouseY() const
+    {
+        return _current.mouseY;
+    }
+
+    Framework::KeyState GetMouseButtonState(System::MouseButton button)
+    {
+        return _current.GetMouseButtonState(button);
+    }
+
+    int GetScrollDelta()
+    {
+        return _current.scrollDelta;
+    }
+
+private:
+    void publishKeys()
+    {
+        _keys.GetWriteBuffer() = _pressedKeys;
+        _keys.Publish();
+    }
+
+    void queueKeyEvent(InputEvent::Type type, System::KeyCode key)
+    {
+        InputEvent event = InputEvent();
+        event.type = type;
+        event.timestamp = _timer->GetTicks();
+        event.key = key;
+
+        if (!_queue.TryPush(event))
+            _droppedEventCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void addMouseEvents()
+    {
+        InputEvent event = InputEvent();
+        event.timestamp = _timer->GetTicks();
+        event.mouseX = _current.mouseX;
+        event.mouseY = _current.mouseY;
+
+        for (unsigned int i = 0; i < MOUSE_BUTTON_COUNT; ++i)
+        {
+            if (_current.mouseButtons.test(i) == _previous.mouseButtons.test(i))
+                continue;
+
+            event.type = _current.mouseButtons.test(i) ? InputEvent::Type::MouseButtonDown
+                                                       : InputEvent::Type::MouseButtonUp;
+            event.button = (System::MouseButton)i;
+            _events.push_back(event);
+        }
+
+        if (_current.mouseX != _previous.mouseX || _current.mouseY != _previous.mouseY)
+        {
+            event.type = InputEvent::Type::MouseMove;
+            _events.push_back(event);
+        }
+
+        if (_current.scrollDelta != 0)
+        {
+            event.type = InputEvent::Type::MouseScroll;
+            event.scrollDelta = _current.scrollDelta;
+            _events.push_back(event);
+        }
+    }
+
+private:
+    Framework::ReadingMouseState *_mouseReader;
+    ISystemTimer *_timer;
+
+    KeyboardSnapshot _pressedKeys;
+    TripleBuffer<KeyboardSnapshot> _keys;
+    SpscQueue<InputEvent, INPUT_EVENT_QUEUE_SIZE> _queue;
+    std::atomic<unsigned int> _droppedEventCount;
+    std::vector<InputEvent> _events;
+
+    InputSnapshot _current;
+    InputSnapshot _previous;
+
+    InputState(const InputState &o) = delete;
+};
@@ -0,0 +1,648 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "meshcompression.hh"
+
+using std::vector;
+
+static const float POSITION_QUANTIZATION_STEPS = 65535.0f;
+static const float NORMAL_QUANTIZATION_STEPS = 127.0f;
+
+static size_t GetVertexCount(const RenderObject &object)
+{
+    return object._vertices.size() / 4;
+}
+
+static unsigned int ZigZag(int value)
+{
+    return ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+}
+
+static int UnZigZag(unsigned int value)
+{
+    return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+static void WriteVarint(vector<unsigned char> &stream, unsigned int value)
+{
+    while (value >= 0x80)
+    {
+        stream.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+
+    stream.push_back((unsigned char)value);
+}
+
+static bool ReadVarint(const unsigned char *&current, const unsigned char *end, unsigned int &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35 && current < end; shift += 7)
+    {
+        unsigned char byte = *current++;
+        value |= (unsigned int)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+// Triangles are coded against FIFOs of recently seen edges and vertices.
+// Each triangle costs one code byte:
+//  - the high nibble names the shared edge, or is 15 if no edge is shared
+//  - the low nibble says where the third vertex comes from: 0 is the next
+//    unseen vertex, 1-14 is a vertex FIFO slot, and 15 is an explicit
+//    zigzag varint delta that follows the code byte
+// A triangle without a shared edge is followed by three explicit deltas.
+// With vertices in first-use order, most triangles take a single byte.
+static const unsigned int INDEX_CODEC_FIFO_SIZE = 16;
+static const unsigned char INDEX_CODEC_EXPLICIT = 15;
+
+class IndexCodecState
+{
+public:
+    IndexCodecState()
+        : _edgeOffset(0), _vertexOffset(0), _next(0), _last(0)
+    {
+        memset(_edges, 0, sizeof(_edges));
+        memset(_vertices, 0, sizeof(_vertices));
+    }
+
+    int FindEdge(const IndexValue *triangle, int &rotation) const
+    {
+        for (unsigned int i = 0; i < INDEX_CODEC_EXPLICIT; ++i)
+        {
+            const IndexValue *edge = GetEdge(i);
+            for (rotation = 0; rotation < 3; ++rotation)
+            {
+                if (edge[0] == triangle[rotation] && edge[1] == triangle[(rotation + 1) % 3])
+                    return i;
+            }
+        }
+
+        return -1;
+    }
+
+    int FindVertex(IndexValue vertex) const
+    {
+        for (unsigned int i = 0; i + 1 < INDEX_CODEC_EXPLICIT; ++i)
+        {
+            if (GetVertex(i) == vertex)
+                return i;
+        }
+
+        return -1;
+    }
+
+    const IndexValue *GetEdge(unsigned int age) const
+    {
+        return _edges[(_edgeOffset - 1 - age) % INDEX_CODEC_FIFO_SIZE];
+    }
+
+    IndexValue GetVertex(unsigned int age) const
+    {
+        return _vertices[(_vertexOffset - 1 - age) % INDEX_CODEC_FIFO_SIZE];
+    }
+
+    void PushEdge(IndexValue first, IndexValue second)
+    {
+        IndexValue *edge = _edges[_edgeOffset++ % INDEX_CODEC_FIFO_SIZE];
+        edge[0] = first;
+        edge[1] = second;
+    }
+
+    // Vertices that were new or explicit enter the vertex FIFO
+    void PushVertex(IndexValue vertex)
+    {
+        _vertices[_vertexOffset++ % INDEX_CODEC_FIFO_SIZE] = vertex;
+        if (vertex == _next)
+            ++_next;
+    }
+
+    IndexValue GetNext() const
+    {
+        return _next;
+    }
+
+    unsigned int EncodeExplicit(IndexValue vertex)
+    {
+        unsigned int delta = ZigZag((int)(vertex - _last));
+        _last = vertex;
+        return delta;
+    }
+
+    IndexValue DecodeExplicit(unsigned int delta)
+    {
+        _last += (IndexValue)UnZigZag(delta);
+        return _last;
+    }
+
+private:
+    IndexValue _edges[INDEX_CODEC_FIFO_SIZE][2];
+    IndexValue _vertices[INDEX_CODEC_FIFO_SIZE];
+    unsigned int _edgeOffset;
+    unsigned int _vertexOffset;
+    IndexValue _next;
+    IndexValue _last;
+};
+
+static void EncodeIndices(const vector<IndexValue> &indices, vector<unsigned char> &stream)
+{
+    IndexCodecState state;
+    size_t triangleEnd = indices.size() - indices.size() % 3;
+
+    for (size_t i = 0; i < triangleEnd; i += 3)
+    {
+        const IndexValue *triangle = &indices[i];
+        int rotation;
+        int edge = state.FindEdge(triangle, rotation);
+
+        if (edge < 0)
+        {
+            stream.push_back(INDEX_CODEC_EXPLICIT << 4);
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                WriteVarint(stream, state.EncodeExplicit(triangle[corner]));
+                state.PushVertex(triangle[corner]);
+            }
+
+            state.PushEdge(triangle[1], triangle[0]);
+            state.PushEdge(triangle[2], triangle[1]);
+            state.PushEdge(triangle[0], triangle[2]);
+            continue;
+        }
+
+        IndexValue first = triangle[rotation];
+        IndexValue second = triangle[(rotation + 1) % 3];
+        IndexValue third = triangle[(rotation + 2) % 3];
+        int vertex = state.FindVertex(third);
+
+        if (third == state.GetNext())
+        {
+            stream.push_back((unsigned char)(edge << 4));
+            state.PushVertex(third);
+        }
+        else if (vertex >= 0)
+        {
+            stream.push_back((unsigned char)(edge << 4 | (vertex + 1)));
+        }
+        else
+        {
+            stream.push_back((unsigned char)(edge << 4 | INDEX_CODEC_EXPLICIT));
+            WriteVarint(stream, state.EncodeExplicit(third));
+            state.PushVertex(third);
+        }
+
+        state.PushEdge(third, second);
+        state.PushEdge(first, third);
+    }
+
+    for (size_t i = triangleEnd; i < indices.size(); ++i)
+    {
+        WriteVarint(stream, state.EncodeExplicit(indices[i]));
+    }
+}
+
+// Decodes at most indexCount indices; stops early on a malformed stream
+static size_t DecodeIndices(const CompressedRenderObject &object, IndexValue *indices)
+{
+    const unsigned char *current = object._indices.data();
+    const unsigned char *end = current + object._indices.size();
+    size_t triangleEnd = object._indexCount - object._indexCount % 3;
+    IndexCodecState state;
+    IndexValue triangle[3];
+    unsigned int delta;
+
+    for (size_t i = 0; i < triangleEnd; i += 3)
+    {
+        if (current == end)
+            return i;
+
+        unsigned char code = *current++;
+        unsigned int edge = code >> 4;
+        unsigned int vertex = code & 15;
+
+        if (edge == INDEX_CODEC_EXPLICIT)
+        {
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                if (!ReadVarint(current, end, delta))
+                    return i;
+
+                triangle[corner] = state.DecodeExplicit(delta);
+                state.PushVertex(triangle[corner]);
+            }
+
+            state.PushEdge(triangle[1], triangle[0]);
+            state.PushEdge(triangle[2], triangle[1]);
+            state.PushEdge(triangle[0], triangle[2]);
+        }
+        else
+        {
+            triangle[0] = state.GetEdge(edge)[0];
+            triangle[1] = state.GetEdge(edge)[1];
+
+            if (vertex == 0)
+            {
+                triangle[2] = state.GetNext();
+                state.PushVertex(triangle[2]);
+            }
+            else if (vertex < INDEX_CODEC_EXPLICIT)
+            {
+                triangle[2] = state.GetVertex(vertex - 1);
+            }
+            else
+            {
+                if (!ReadVarint(current, end, delta))
+                    return i;
+
+                triangle[2] = state.DecodeExplicit(delta);
+                state.PushVertex(triangle[2]);
+            }
+
+            state.PushEdge(triangle[2], triangle[1]);
+            state.PushEdge(triangle[0], triangle[2]);
+        }
+
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            if (triangle[corner] >= object._vertexCount)
+                return i;
+
+            if (indices != NULL)
+                indices[i + corner] = triangle[corner];
+        }
+    }
+
+    for (size_t i = triangleEnd; i < object._indexCount; ++i)
+    {
+        if (!ReadVarint(current, end, delta))
+            return i;
+
+        IndexValue index = state.DecodeExplicit(delta);
+        if (index >= object._vertexCount)
+            return i;
+
+        if (indices != NULL)
+            indices[i] = index;
+    }
+
+    return current == end ? object._indexCount : 0;
+}
+
+static void EncodeOctahedral(const float *normal, signed char *encoded)
+{
+    float x = normal[0];
+    float y = normal[1];
+    float z = normal[2];
+    float length = std::fabs(x) + std::fabs(y) + std::fabs(z);
+
+    if (length == 0.0f)
+    {
+        x = 0.0f;
+        y = 0.0f;
+        z = 1.0f;
+        length = 1.0f;
+    }
+
+    x /= length;
+    y /= length;
+
+    if (z < 0.0f)
+    {
+        float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    encoded[0] = (signed char)std::max(-127.0f, std::min(127.0f, std::floor(x * NORMAL_QUANTIZATION_STEPS + 0.5f)));
+    encoded[1] = (signed char)std::max(-127.0f, std::min(127.0f, std::floor(y * NORMAL_QUANTIZATION_STEPS + 0.5f)));
+}
+
+unsigned short FloatToHalf(float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    unsigned short sign = (unsigned short)((bits >> 16) & 0x8000);
+    bits &= 0x7fffffff;
+
+    if (bits > 0x7f800000)
+        return sign | 0x7e00;
+
+    // Rounds to infinity past the largest half, 65504
+    if (bits >= 0x477ff000)
+        return sign | 0x7c00;
+
+    if (bits < 0x38800000)
+    {
+        float magnitude;
+        memcpy(&magnitude, &bits, sizeof(magnitude));
+        return sign | (unsigned short)std::nearbyint(magnitude * 16777216.0f);
+    }
+
+    // Rebias the exponent and round the mantissa to nearest even
+    unsigned int mantissaOdd = (bits >> 13) & 1;
+    bits += 0xc8000fff + mantissaOdd;
+    return sign | (unsigned short)(bits >> 13);
+}
+
+float HalfToFloat(unsigned short value)
+{
+    unsigned int exponentMantissa = value & 0x7fff;
+    unsigned int shifted = exponentMantissa << 13;
+    unsigned int magicBits = (254 - 15) << 23;
+
+    float scaled;
+    float magic;
+    memcpy(&scaled, &shifted, sizeof(scaled));
+    memcpy(&magic, &magicBits, sizeof(magic));
+    scaled *= magic;
+
+    unsigned int bits;
+    memcpy(&bits, &scaled, sizeof(bits));
+    if (exponentMantissa > 0x7bff)
+        bits |= 255 << 23;
+    bits |= (unsigned int)(value & 0x8000) << 16;
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+static void DecodePositions(const CompressedRenderObject &object, float *positions)
+{
+    const unsigned short *quantized = object._vertices.data();
+    const float *offset = &object._positionOffset[0];
+    const float *scale = &object._positionScale[0];
+    size_t vertex = 0;
+
+#if defined(__SSE2__)
+    // Four vertices per step: 12 quantized components become four vec4s
+    const __m128 scaleA = _mm_setr_ps(scale[0], scale[1], scale[2], scale[0]);
+    const __m128 scaleB = _mm_setr_ps(scale[1], scale[2], scale[0], scale[1]);
+    const __m128 scaleC = _mm_setr_ps(scale[2], scale[0], scale[1], scale[2]);
+    const __m128 offsetA = _mm_setr_ps(offset[0], offset[1], offset[2], offset[0]);
+    const __m128 offsetB = _mm_setr_ps(offset[1], offset[2], offset[0], offset[1]);
+    const __m128 offsetC = _mm_setr_ps(offset[2], offset[0], offset[1], offset[2]);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; vertex + 4 <= object._vertexCount; vertex += 4)
+    {
+        const unsigned short *source = quantized + vertex * 3;
+        __m128i first = _mm_loadu_si128((const __m128i *)source);
+        __m128i second = _mm_loadl_epi64((const __m128i *)(source + 8));
+
+        __m128 a = _mm_cvtepi32_ps(_mm_unpacklo_epi16(first, zero));
+        __m128 b = _mm_cvtepi32_ps(_mm_unpackhi_epi16(first, zero));
+        __m128 c = _mm_cvtepi32_ps(_mm_unpacklo_epi16(second, zero));
+
+        a = _mm_add_ps(_mm_mul_ps(a, scaleA), offsetA);
+        b = _mm_add_ps(_mm_mul_ps(b, scaleB), offsetB);
+        c = _mm_add_ps(_mm_mul_ps(c, scaleC), offsetC);
+
+        float *destination = positions + vertex * 4;
+        _mm_storeu_ps(destination, _mm_shuffle_ps(a, _mm_unpackhi_ps(a, one), _MM_SHUFFLE(1, 0, 1, 0)));
+        _mm_storeu_ps(destination + 4, _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 3, 3)),
+                                                      _mm_shuffle_ps(b, one, _MM_SHUFFLE(0, 0, 1, 1)),
+                                                      _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(destination + 8, _mm_shuffle_ps(b, _mm_shuffle_ps(c, one, _MM_SHUFFLE(0, 0, 0, 0)),
+                                                      _MM_SHUFFLE(2, 0, 3, 2)));
+        _mm_storeu_ps(destination + 12, _mm_shuffle_ps(c, _mm_shuffle_ps(c, one, _MM_SHUFFLE(0, 0, 3, 3)),
+                                                       _MM_SHUFFLE(2, 0, 2, 1)));
+    }
+#endif
+
+    for (; vertex < object._vertexCount; ++vertex)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            positions[vertex * 4 + i] = (float)quantized[vertex * 3 + i] * scale[i] + offset[i];
+        }
+
+        positions[vertex * 4 + 3] = 1.0f;
+    }
+}
+
+static void DecodeNormals(const CompressedRenderObject &object, float *normals)
+{
+    const signed char *encoded = object._normals.data();
+    size_t vertex = 0;
+
+#if defined(__SSE2__)
+    const __m128 steps = _mm_set1_ps(NORMAL_QUANTIZATION_STEPS);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    // The fourth store spills one float into the next vertex, so the last
+    // group is left to the scalar loop
+    for (; vertex + 4 < object._vertexCount; vertex += 4)
+    {
+        __m128i bytes = _mm_loadl_epi64((const __m128i *)(encoded + vertex * 2));
+        __m128i words = _mm_srai_epi16(_mm_unpacklo_epi8(bytes, bytes), 8);
+        __m128 low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16));
+        __m128 high = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16));
+
+        __m128 x = _mm_div_ps(_mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)), steps);
+        __m128 y = _mm_div_ps(_mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1)), steps);
+        __m128 z = _mm_sub_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, x)), _mm_andnot_ps(signMask, y));
+
+        __m128 fold = _mm_max_ps(_mm_xor_ps(z, signMask), _mm_setzero_ps());
+        x = _mm_sub_ps(x, _mm_or_ps(fold, _mm_and_ps(x, signMask)));
+        y = _mm_sub_ps(y, _mm_or_ps(fold, _mm_and_ps(y, signMask)));
+
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        x = _mm_div_ps(x, length);
+        y = _mm_div_ps(y, length);
+        z = _mm_div_ps(z, length);
+
+        __m128 w = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        float *destination = normals + vertex * 3;
+        _mm_storeu_ps(destination, x);
+        _mm_storeu_ps(destination + 3, y);
+        _mm_storeu_ps(destination + 6, z);
+        _mm_storeu_ps(destination + 9, w);
+    }
+#endif
+
+    for (; vertex < object._vertexCount; ++vertex)
+    {
+        float x = (float)encoded[vertex * 2] / NORMAL_QUANTIZATION_STEPS;
+        float y = (float)encoded[vertex * 2 + 1] / NORMAL_QUANTIZATION_STEPS;
+        float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+        float fold = std::max(-z, 0.0f);
+        x -= std::signbit(x) ? -fold : fold;
+        y -= std::signbit(y) ? -fold : fold;
+
+        float length = std::sqrt(x * x + y * y + z * z);
+        normals[vertex * 3] = x / length;
+        normals[vertex * 3 + 1] = y / length;
+        normals[vertex * 3 + 2] = z / length;
+    }
+}
+
+static void DecodeHalfs(const unsigned short *halfs, size_t count, float *values)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // Same bit manipulation as HalfToFloat, eight values per step
+    const __m128i noSign = _mm_set1_epi32(0x7fff);
+    const __m128i wasInfNan = _mm_set1_epi32(0x7bff);
+    const __m128i infNanExponent = _mm_set1_epi32(255 << 23);
+    const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i packed = _mm_loadu_si128((const __m128i *)(halfs + i));
+        __m128i unpacked[2] = {_mm_unpacklo_epi16(packed, zero), _mm_unpackhi_epi16(packed, zero)};
+
+        for (int half = 0; half < 2; ++half)
+        {
+            __m128i exponentMantissa = _mm_and_si128(unpacked[half], noSign);
+            __m128i sign = _mm_slli_epi32(_mm_xor_si128(unpacked[half], exponentMantissa), 16);
+            __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exponentMantissa, 13)), magic);
+            __m128i infNan = _mm_and_si128(_mm_cmpgt_epi32(exponentMantissa, wasInfNan), infNanExponent);
+
+            _mm_storeu_ps(values + i + half * 4, _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNan))));
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        values[i] = HalfToFloat(halfs[i]);
+    }
+}
+
+CompressedRenderObject CompressRenderObject(const RenderObject &object)
+{
+    CompressedRenderObject compressed;
+    size_t vertexCount = GetVertexCount(object);
+
+    compressed._vertexCount = vertexCount;
+    compressed._indexCount = object._indices.size();
+    compressed._materialName = object._materialName;
+    compressed._light = object._light;
+
+    glm::vec3 minimum(0.0f);
+    glm::vec3 maximum(0.0f);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        glm::vec3 position(object._vertices[vertex * 4], object._vertices[vertex * 4 + 1], object._vertices[vertex * 4 + 2]);
+        minimum = vertex == 0 ? position : glm::min(minimum, position);
+        maximum = vertex == 0 ? position : glm::max(maximum, position);
+    }
+
+    glm::vec3 extent = maximum - minimum;
+    compressed._positionOffset = minimum;
+    compressed._positionScale = extent / POSITION_QUANTIZATION_STEPS;
+
+    compressed._vertices.resize(vertexCount * 3);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            float normalized = extent[i] > 0.0f ? (object._vertices[vertex * 4 + i] - minimum[i]) / extent[i] : 0.0f;
+            compressed._vertices[vertex * 3 + i] = (unsigned short)std::floor(normalized * POSITION_QUANTIZATION_STEPS + 0.5f);
+        }
+    }
+
+    compressed._normals.resize(vertexCount * 2);
+    if (object._normals.size() == vertexCount * 3)
+    {
+        for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            EncodeOctahedral(&object._normals[vertex * 3], &compressed._normals[vertex * 2]);
+        }
+    }
+
+    if (object._uvCoords.size() == vertexCount * 2)
+    {
+        compressed._uvCoords.resize(object._uvCoords.size());
+        for (size_t i = 0; i < object._uvCoords.size(); ++i)
+        {
+            compressed._uvCoords[i] = FloatToHalf(object._uvCoords[i]);
+        }
+    }
+
+    compressed._indices.reserve(object._indices.size() / 3 + 16);
+    EncodeIndices(object._indices, compressed._indices);
+
+    return compressed;
+}
+
+RenderObject DecompressRenderObject(const CompressedRenderObject &object)
+{
+    RenderObject decompressed;
+    decompressed._materialName = object._materialName;
+    decompressed._light = object._light;
+
+    decompressed._indices.resize(object._indexCount);
+    if (DecodeIndices(object, decompressed._indices.data()) != object._indexCount)
+    {
+        std::stringstream errorStream;
+        errorStream << "Runtime error: corrupt index stream in compressed mesh: " << object._materialName;
+        throw std::runtime_error(errorStream.str());
+    }
+
+    decompressed._vertices.resize(object._vertexCount * 4);
+    DecodePositions(object, decompressed._vertices.data());
+
+    decompressed._normals.resize(object._vertexCount * 3);
+    DecodeNormals(object, decompressed._normals.data());
+
+    decompressed._uvCoords.resize(object._uvCoords.size());
+    DecodeHalfs(object._uvCoords.data(), object._uvCoords.size(), decompressed._uvCoords.data());
+
+    return decompressed;
+}
+
+bool IsValidCompressedRenderObject(const CompressedRenderObject &object)
+{
+    size_t vertexCount = object._vertexCount;
+
+    if (object._vertices.size() != vertexCount * 3 || object._normals.size() != vertexCount * 2)
+        return false;
+
+    if (!object._uvCoords.empty() && object._uvCoords.size() != vertexCount * 2)
+        return false;
+
+    if (!object._light.empty() && object._light.size() != vertexCount * 4)
+        return false;
+
+    return DecodeIndices(object, NULL) == object._indexCount;
+}
+
+size_t GetMemoryFootprint(const RenderObject &object)
+{
+    return object._indices.size() * sizeof(IndexValue) +
+        object._vertices.size() * sizeof(float) +
+        object._normals.size() * sizeof(float) +
+        object._uvCoords.size() * sizeof(float) +
+        object._light.size();
+}
+
+size_t GetMemoryFootprint(const CompressedRenderObject &object)
+{
+    return object._indices.size() +
+        object._vertices.size() * sizeof(unsigned short) +
+        object._normals.size() * sizeof(signed char) +
+        object._uvCoords.size() * sizeof(unsigned short) +
+        object._light.size();
+}
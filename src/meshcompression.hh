@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "rendering/irenderer.hh"
+#include "types.hh"
+
+// A RenderObject packed for storage:
+//  - positions are 16 bit fixed point inside the object's bounding box
+//  - normals are 8 bit octahedral pairs
+//  - UVs are half floats
+//  - indices use an edge and vertex FIFO triangle codec, about one byte per
+//    triangle once vertices are in first-use order
+//  - light bytes are stored as is
+// Decoding gives back RenderObject buffers ready for upload, with w = 1.
+typedef struct CompressedRenderObject
+{
+    unsigned int _vertexCount;
+    unsigned int _indexCount;
+    glm::vec3 _positionOffset;
+    glm::vec3 _positionScale;
+    std::vector<unsigned char> _indices;
+    std::vector<unsigned short> _vertices;
+    std::vector<signed char> _normals;
+    std::vector<unsigned short> _uvCoords;
+    std::vector<unsigned char> _light;
+    std::string _materialName;
+} CompressedRenderObject;
+
+CompressedRenderObject CompressRenderObject(const RenderObject &object);
+RenderObject DecompressRenderObject(const CompressedRenderObject &object);
+
+// Checks attribute sizes and that the index stream holds exactly _indexCount
+// in-range indices, so untrusted data can be decoded safely
+bool IsValidCompressedRenderObject(const CompressedRenderObject &object);
+
+size_t GetMemoryFootprint(const RenderObject &object);
+size_t GetMemoryFootprint(const CompressedRenderObject &object);
+
+unsigned short FloatToHalf(float value);
+float HalfToFloat(unsigned short value);
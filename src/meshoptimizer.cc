@@ -0,0 +1,457 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "meshoptimizer.hh"
+#include "utility/profiler.hh"
+
+using std::vector;
+
+static const unsigned int FORSYTH_CACHE_SIZE = 32;
+static const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+static const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+static const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+static const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+static const unsigned int CLUSTER_MIN_TRIANGLES = 16;
+
+static size_t GetVertexCount(const RenderObject &object)
+{
+    return object._vertices.size() / 4;
+}
+
+static bool HasUVs(const RenderObject &object)
+{
+    return !object._uvCoords.empty() && object._uvCoords.size() == GetVertexCount(object) * 2;
+}
+
+static bool HasLight(const RenderObject &object)
+{
+    return !object._light.empty() && object._light.size() == GetVertexCount(object) * 4;
+}
+
+template <class T>
+static void RemapAttribute(vector<T> &values, int componentCount, const vector<IndexValue> &remap, size_t newVertexCount)
+{
+    vector<T> remapped(newVertexCount * componentCount);
+    for (size_t vertex = 0; vertex < remap.size(); ++vertex)
+    {
+        for (int i = 0; i < componentCount; ++i)
+        {
+            remapped[remap[vertex] * componentCount + i] = values[vertex * componentCount + i];
+        }
+    }
+
+    values.swap(remapped);
+}
+
+// remap must send every referenced vertex to a slot below newVertexCount
+static void RemapVertices(RenderObject &object, const vector<IndexValue> &remap, size_t newVertexCount)
+{
+    bool hasUVs = HasUVs(object);
+    bool hasLight = HasLight(object);
+
+    RemapAttribute(object._vertices, 4, remap, newVertexCount);
+    RemapAttribute(object._normals, 3, remap, newVertexCount);
+    if (hasUVs)
+        RemapAttribute(object._uvCoords, 2, remap, newVertexCount);
+    if (hasLight)
+        RemapAttribute(object._light, 4, remap, newVertexCount);
+
+    for (size_t i = 0; i < object._indices.size(); ++i)
+    {
+        object._indices[i] = remap[object._indices[i]];
+    }
+}
+
+VertexCacheStatistics AnalyzeVertexCache(const vector<IndexValue> &indices, size_t vertexCount, unsigned int cacheSize)
+{
+    VertexCacheStatistics statistics = { 0.0f, 0.0f };
+    if (indices.empty() || vertexCount == 0)
+        return statistics;
+
+    // FIFO cache: a vertex is resident while fewer than cacheSize misses happened since its own
+    vector<unsigned int> missTimes(vertexCount, 0);
+    unsigned int misses = 0;
+
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        IndexValue vertex = indices[i];
+        if (missTimes[vertex] == 0 || misses - missTimes[vertex] >= cacheSize)
+            missTimes[vertex] = ++misses;
+    }
+
+    statistics.acmr = (float)misses / (indices.size() / 3);
+    statistics.atvr = (float)misses / vertexCount;
+
+    return statistics;
+}
+
+class VertexHasher
+{
+public:
+    VertexHasher(const RenderObject *object)
+        : _object(object), _hasUVs(HasUVs(*object)), _hasLight(HasLight(*object))
+    {
+    }
+
+    size_t operator()(IndexValue vertex) const
+    {
+        unsigned int hash = 2166136261u;
+        hash = hashBytes(hash, &_object->_vertices[vertex * 4], 4 * sizeof(float));
+        hash = hashBytes(hash, &_object->_normals[vertex * 3], 3 * sizeof(float));
+        if (_hasUVs)
+            hash = hashBytes(hash, &_object->_uvCoords[vertex * 2], 2 * sizeof(float));
+        if (_hasLight)
+            hash = hashBytes(hash, &_object->_light[vertex * 4], 4);
+
+        return hash;
+    }
+
+    bool operator()(IndexValue first, IndexValue second) const
+    {
+        return memcmp(&_object->_vertices[first * 4], &_object->_vertices[second * 4], 4 * sizeof(float)) == 0 &&
+            memcmp(&_object->_normals[first * 3], &_object->_normals[second * 3], 3 * sizeof(float)) == 0 &&
+            (!_hasUVs || memcmp(&_object->_uvCoords[first * 2], &_object->_uvCoords[second * 2], 2 * sizeof(float)) == 0) &&
+            (!_hasLight || memcmp(&_object->_light[first * 4], &_object->_light[second * 4], 4) == 0);
+    }
+
+private:
+    const RenderObject *_object;
+    bool _hasUVs;
+    bool _hasLight;
+
+private:
+    static unsigned int hashBytes(unsigned int hash, const void *data, size_t size)
+    {
+        const unsigned char *bytes = (const unsigned char *)data;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+
+        return hash;
+    }
+};
+
+void WeldVertices(RenderObject &object)
+{
+    size_t vertexCount = GetVertexCount(object);
+    VertexHasher hasher(&object);
+    std::unordered_map<IndexValue, IndexValue, VertexHasher, VertexHasher> uniqueVertices(vertexCount, hasher, hasher);
+
+    vector<IndexValue> remap(vertexCount);
+    IndexValue uniqueCount = 0;
+    for (IndexValue vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        std::pair<std::unordered_map<IndexValue, IndexValue, VertexHasher, VertexHasher>::iterator, bool> inserted =
+            uniqueVertices.insert(std::make_pair(vertex, uniqueCount));
+        if (inserted.second)
+            ++uniqueCount;
+
+        remap[vertex] = inserted.first->second;
+    }
+
+    RemapVertices(object, remap, uniqueCount);
+}
+
+static float GetForsythVertexScore(int cachePosition, unsigned int remainingValence)
+{
+    if (remainingValence == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        if (cachePosition < 3)
+        {
+            score = FORSYTH_LAST_TRIANGLE_SCORE;
+        }
+        else
+        {
+            float scale = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            score = powf(1.0f - (cachePosition - 3) * scale, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+
+    return score + FORSYTH_VALENCE_BOOST_SCALE * powf((float)remainingValence, -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+void OptimizeVertexCache(vector<IndexValue> &indices, size_t vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Per-vertex lists of the triangles that still have to be emitted
+    vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        ++adjacencyOffsets[indices[i] + 1];
+    }
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        adjacencyOffsets[vertex + 1] += adjacencyOffsets[vertex];
+    }
+
+    vector<unsigned int> remainingValence(vertexCount, 0);
+    vector<unsigned int> adjacency(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        IndexValue vertex = indices[i];
+        adjacency[adjacencyOffsets[vertex] + remainingValence[vertex]++] = i / 3;
+    }
+
+    vector<int> cachePositions(vertexCount, -1);
+    vector<float> vertexScores(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        vertexScores[vertex] = GetForsythVertexScore(-1, remainingValence[vertex]);
+    }
+
+    vector<char> emitted(triangleCount, 0);
+    vector<IndexValue> output;
+    output.reserve(indices.size());
+
+    vector<IndexValue> cache, nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    size_t scanPosition = 0;
+    long bestTriangle = -1;
+
+    while (output.size() < indices.size())
+    {
+        if (bestTriangle < 0)
+        {
+            while (emitted[scanPosition])
+                ++scanPosition;
+            bestTriangle = scanPosition;
+        }
+
+        emitted[bestTriangle] = 1;
+        nextCache.clear();
+
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            IndexValue vertex = indices[bestTriangle * 3 + corner];
+            output.push_back(vertex);
+            nextCache.push_back(vertex);
+
+            unsigned int *triangles = &adjacency[adjacencyOffsets[vertex]];
+            for (unsigned int i = 0; i < remainingValence[vertex]; ++i)
+            {
+                if (triangles[i] == bestTriangle)
+                {
+                    triangles[i] = triangles[--remainingValence[vertex]];
+                    break;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            IndexValue vertex = cache[i];
+            if (vertex != nextCache[0] && vertex != nextCache[1] && vertex != nextCache[2])
+                nextCache.push_back(vertex);
+        }
+
+        for (size_t i = 0; i < nextCache.size(); ++i)
+        {
+            IndexValue vertex = nextCache[i];
+            cachePositions[vertex] = i < FORSYTH_CACHE_SIZE ? (int)i : -1;
+            vertexScores[vertex] = GetForsythVertexScore(cachePositions[vertex], remainingValence[vertex]);
+        }
+
+        if (nextCache.size() > FORSYTH_CACHE_SIZE)
+            nextCache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(nextCache);
+
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            IndexValue vertex = cache[i];
+            const unsigned int *triangles = &adjacency[adjacencyOffsets[vertex]];
+            for (unsigned int j = 0; j < remainingValence[vertex]; ++j)
+            {
+                unsigned int triangle = triangles[j];
+                float score = vertexScores[indices[triangle * 3]] +
+                    vertexScores[indices[triangle * 3 + 1]] +
+                    vertexScores[indices[triangle * 3 + 2]];
+
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestTriangle = triangle;
+                }
+            }
+        }
+    }
+
+    indices.swap(output);
+}
+
+typedef struct TriangleCluster
+{
+    size_t firstTriangle;
+    size_t triangleCount;
+    float sortKey;
+} TriangleCluster;
+
+static bool IsDrawnEarlier(const TriangleCluster &first, const TriangleCluster &second)
+{
+    return first.sortKey > second.sortKey;
+}
+
+void OptimizeOverdraw(RenderObject &object, float threshold)
+{
+    vector<IndexValue> &indices = object._indices;
+    size_t triangleCount = indices.size() / 3;
+    size_t vertexCount = GetVertexCount(object);
+    if (triangleCount == 0)
+        return;
+
+    float targetAcmr = AnalyzeVertexCache(indices, vertexCount).acmr * threshold;
+
+    // Clusters start where the cache is cold again (every corner misses) or,
+    // once a cluster is large enough, wherever its own ACMR is within budget
+    vector<TriangleCluster> clusters;
+    vector<unsigned int> missTimes(vertexCount, 0);
+    unsigned int misses = 0;
+    unsigned int clusterMisses = 0;
+
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        unsigned int triangleMisses = 0;
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            IndexValue vertex = indices[triangle * 3 + corner];
+            if (missTimes[vertex] == 0 || misses - missTimes[vertex] >= MESH_OPTIMIZER_CACHE_SIZE)
+            {
+                missTimes[vertex] = ++misses;
+                ++triangleMisses;
+            }
+        }
+
+        bool startCluster = clusters.empty() || triangleMisses == 3;
+        if (!startCluster)
+        {
+            const TriangleCluster &current = clusters.back();
+            startCluster = current.triangleCount >= CLUSTER_MIN_TRIANGLES &&
+                (float)clusterMisses / current.triangleCount <= targetAcmr;
+        }
+
+        if (startCluster)
+        {
+            TriangleCluster cluster = { triangle, 0, 0.0f };
+            clusters.push_back(cluster);
+            clusterMisses = 0;
+        }
+
+        ++clusters.back().triangleCount;
+        clusterMisses += triangleMisses;
+    }
+
+    vector<glm::vec3> centroids(clusters.size());
+    vector<glm::vec3> normals(clusters.size());
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+
+    for (size_t i = 0; i < clusters.size(); ++i)
+    {
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+
+        for (size_t triangle = clusters[i].firstTriangle; triangle < clusters[i].firstTriangle + clusters[i].triangleCount; ++triangle)
+        {
+            glm::vec3 corners[3];
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const float *position = &object._vertices[indices[triangle * 3 + corner] * 4];
+                corners[corner] = glm::vec3(position[0], position[1], position[2]);
+            }
+
+            glm::vec3 cross = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+            float triangleArea = glm::length(cross) * 0.5f;
+
+            centroid += (corners[0] + corners[1] + corners[2]) * (triangleArea / 3.0f);
+            normal += cross;
+            area += triangleArea;
+        }
+
+        centroids[i] = area > 0.0f ? centroid / area : centroid;
+        normals[i] = glm::length(normal) > 0.0f ? glm::normalize(normal) : normal;
+        meshCentroid += centroid;
+        meshArea += area;
+    }
+
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    for (size_t i = 0; i < clusters.size(); ++i)
+    {
+        clusters[i].sortKey = glm::dot(centroids[i] - meshCentroid, normals[i]);
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), IsDrawnEarlier);
+
+    vector<IndexValue> sorted;
+    sorted.reserve(indices.size());
+    for (size_t i = 0; i < clusters.size(); ++i)
+    {
+        sorted.insert(sorted.end(),
+                      indices.begin() + clusters[i].firstTriangle * 3,
+                      indices.begin() + (clusters[i].firstTriangle + clusters[i].triangleCount) * 3);
+    }
+
+    indices.swap(sorted);
+}
+
+void OptimizeVertexFetch(RenderObject &object)
+{
+    const IndexValue unused = 0xffffffff;
+    vector<IndexValue> remap(GetVertexCount(object), unused);
+    IndexValue nextVertex = 0;
+
+    for (size_t i = 0; i < object._indices.size(); ++i)
+    {
+        IndexValue vertex = object._indices[i];
+        if (remap[vertex] == unused)
+            remap[vertex] = nextVertex++;
+    }
+
+    // Vertices no triangle uses are moved past the end and dropped
+    IndexValue droppedVertex = nextVertex;
+    for (size_t vertex = 0; vertex < remap.size(); ++vertex)
+    {
+        if (remap[vertex] == unused)
+            remap[vertex] = droppedVertex++;
+    }
+
+    RemapVertices(object, remap, droppedVertex);
+
+    object._vertices.resize(nextVertex * 4);
+    object._normals.resize(nextVertex * 3);
+    if (!object._uvCoords.empty())
+        object._uvCoords.resize(nextVertex * 2);
+    if (!object._light.empty())
+        object._light.resize(nextVertex * 4);
+}
+
+void OptimizeMesh(RenderObject &object, bool optimizeOverdraw)
+{
+    PROFILE_SCOPE("OptimizeMesh");
+
+    WeldVertices(object);
+    OptimizeVertexCache(object._indices, GetVertexCount(object));
+
+    if (optimizeOverdraw)
+        OptimizeOverdraw(object, 1.05f);
+
+    OptimizeVertexFetch(object);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "rendering/irenderer.hh"
+#include "types.hh"
+
+const unsigned int MESH_OPTIMIZER_CACHE_SIZE = 32;
+
+typedef struct VertexCacheStatistics
+{
+    // Vertex shader invocations per triangle and per unique vertex
+    float acmr;
+    float atvr;
+} VertexCacheStatistics;
+
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<IndexValue> &indices,
+                                         size_t vertexCount,
+                                         unsigned int cacheSize = MESH_OPTIMIZER_CACHE_SIZE);
+
+// Merges vertices whose position, normal, UV and light are identical
+void WeldVertices(RenderObject &object);
+
+// Forsyth's linear-speed triangle reordering for post-transform cache reuse
+void OptimizeVertexCache(std::vector<IndexValue> &indices, size_t vertexCount);
+
+// Splits the cache-ordered triangles into clusters and draws outward-facing
+// clusters first; threshold bounds the allowed ACMR increase (1.05 = 5%)
+void OptimizeOverdraw(RenderObject &object, float threshold);
+
+// Renumbers vertices in order of first use so fetches walk memory linearly
+void OptimizeVertexFetch(RenderObject &object);
+
+// Runs every pass above; the result has to be drawn with its index buffer
+void OptimizeMesh(RenderObject &object, bool optimizeOverdraw = false);
@@ -1,9 +1,9 @@
 #pragma once
 
-#include <map>
-
 #include <framework/platform.hh>
 
+#include "inputstate.hh"
+
 class MouseTracker
 {
 private:
@@ -13,9 +13,6 @@ public:
     {
         _mouseCurrentX = _mouseState->GetMouseX();
         _mouseCurrentY = _mouseState->GetMouseY();
-
-        _previousButtonState[System::MouseButton::Button2] = Framework::KeyState::Unpressed;
-        _currentButtonState[System::MouseButton::Button2] = Framework::KeyState::Unpressed;
     }
 
     void GetPosition(int *mouseX, int *mouseY)
@@ -37,14 +34,12 @@ public:
 
     bool IsButtonDownFrame(System::MouseButton button) const
     {
-        return _previousButtonState.at(button) == Framework::KeyState::Unpressed &&
-            _currentButtonState.at(button) == Framework::KeyState::Pressed;
+        return !_previousButtons.test((size_t)button) && _currentButtons.test((size_t)button);
     }
 
     bool IsButtonUpFrame(System::MouseButton button) const
     {
-        return _previousButtonState.at(button) == Framework::KeyState::Pressed &&
-            _currentButtonState.at(button) == Framework::KeyState::Unpressed;
+        return _previousButtons.test((size_t)button) && !_currentButtons.test((size_t)button);
     }
 
     void ResetPreviousPosition()
@@ -60,8 +55,12 @@ public:
     {
         ResetPreviousPosition();
 
-        _previousButtonState[System::MouseButton::Button2] = _currentButtonState[System::MouseButton::Button2];
-        _currentButtonState[System::MouseButton::Button2] = _mouseState->GetMouseButtonState(System::MouseButton::Button2);
+        _previousButtons = _currentButtons;
+        for (unsigned int i = 0; i < MOUSE_BUTTON_COUNT; ++i)
+        {
+            _currentButtons.set(i, _mouseState->GetMouseButtonState((System::MouseButton)i) ==
+                                Framework::KeyState::Pressed);
+        }
 
         _scrollDelta = _mouseState->GetScrollDelta();
 
@@ -77,6 +76,6 @@ private:
     int _mouseDeltaX, _mouseDeltaY;
     int _scrollDelta;
 
-    std::map<System::MouseButton, Framework::KeyState> _currentButtonState;
-    std::map<System::MouseButton, Framework::KeyState> _previousButtonState;
+    MouseButtonSnapshot _currentButtons;
+    MouseButtonSnapshot _previousButtons;
 };
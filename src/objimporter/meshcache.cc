@@ -0,0 +1,355 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "imagecache.hh"
+#include "meshcache.hh"
+#include "meshcompression.hh"
+#include "meshoptimizer.hh"
+#include "objimporter.hh"
+#include "objparser.hh"
+#include "textbuffer.hh"
+#include "utility/profiler.hh"
+
+using std::string;
+using std::vector;
+
+static const unsigned int COOKED_MESH_MAGIC = 0x4d4b4f43; // "COKM"
+static const unsigned int COOKED_MESH_VERSION = 4;
+
+typedef struct SourceFileStamp
+{
+    unsigned long long size;
+    long long modificationTime;
+    unsigned long long hash;
+} SourceFileStamp;
+
+static unsigned long long HashBytes(const char *data, size_t size)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+unsigned long long HashFileContents(const string &fileName)
+{
+    vector<char> contents;
+    if (!ReadFileContents(fileName, contents))
+        return 0;
+
+    return HashBytes(contents.data(), contents.size());
+}
+
+static bool StatSourceFile(const string &fileName, SourceFileStamp &stamp)
+{
+    struct stat fileStat;
+    if (stat(fileName.c_str(), &fileStat) != 0)
+        return false;
+
+    stamp.size = fileStat.st_size;
+    stamp.modificationTime = fileStat.st_mtime;
+    stamp.hash = 0;
+
+    return true;
+}
+
+class CookedMeshWriter
+{
+public:
+    template <class T>
+    void Write(const T &value)
+    {
+        const char *bytes = (const char *)&value;
+        _buffer.insert(_buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <class T>
+    void WriteArray(const vector<T> &values)
+    {
+        Write((unsigned int)values.size());
+        const char *bytes = (const char *)values.data();
+        _buffer.insert(_buffer.end(), bytes, bytes + values.size() * sizeof(T));
+    }
+
+    void WriteString(const string &value)
+    {
+        Write((unsigned int)value.size());
+        _buffer.insert(_buffer.end(), value.begin(), value.end());
+    }
+
+    const vector<char> &GetBuffer() const
+    {
+        return _buffer;
+    }
+
+private:
+    vector<char> _buffer;
+};
+
+class CookedMeshReader
+{
+public:
+    CookedMeshReader(const vector<char> &buffer)
+        : _current(buffer.data()), _end(buffer.data() + buffer.size()), _valid(true)
+    {
+    }
+
+    template <class T>
+    T Read()
+    {
+        T value = T();
+        readBytes(&value, sizeof(T));
+        return value;
+    }
+
+    template <class T>
+    void ReadArray(vector<T> &values)
+    {
+        unsigned int count = Read<unsigned int>();
+        if (!_valid || count > (_end - _current) / sizeof(T))
+        {
+            _valid = false;
+            return;
+        }
+
+        values.resize(count);
+        readBytes(values.data(), count * sizeof(T));
+    }
+
+    string ReadString()
+    {
+        unsigned int size = Read<unsigned int>();
+        if (!_valid || size > _end - _current)
+        {
+            _valid = false;
+            return string();
+        }
+
+        string value(_current, size);
+        _current += size;
+        return value;
+    }
+
+    bool IsValid() const
+    {
+        return _valid;
+    }
+
+    bool IsAtEnd() const
+    {
+        return _current == _end;
+    }
+
+private:
+    const char *_current;
+    const char *_end;
+    bool _valid;
+
+private:
+    void readBytes(void *destination, size_t size)
+    {
+        if (!_valid || size > (size_t)(_end - _current))
+        {
+            _valid = false;
+            return;
+        }
+
+        if (size > 0)
+            memcpy(destination, _current, size);
+        _current += size;
+    }
+};
+
+string GetCookedMeshPath(const string &path, const string &fileName)
+{
+    return path + fileName + ".cooked";
+}
+
+CookedMesh CookObjFile(const string &path, const string &fileName)
+{
+    PROFILE_SCOPE("CookObjFile");
+    CookedMesh mesh;
+
+    ObjParser::ObjFileParser parser(path.c_str(), fileName.c_str());
+    ObjParser::IParseResult *parseResult = parser.ParseParallel(GetProcessorCount());
+    ObjImporter importer(parseResult);
+
+    vector<RenderObject> renderObjects = importer.TakeRenderObjects();
+    mesh.materials = importer.GetMaterials();
+
+    for (int i = 0; i < renderObjects.size(); ++i)
+    {
+        OptimizeMesh(renderObjects[i]);
+        mesh.renderObjects.push_back(CompressRenderObject(renderObjects[i]));
+    }
+
+    mesh.sourceFiles.push_back(path + fileName);
+    const vector<string> &materialLibraries = parseResult->GetMaterialLibraries();
+    for (int i = 0; i < materialLibraries.size(); ++i)
+    {
+        mesh.sourceFiles.push_back(path + materialLibraries[i]);
+    }
+
+    delete parseResult;
+
+    return mesh;
+}
+
+bool LoadCookedMesh(const string &cookedFileName, CookedMesh &mesh)
+{
+    vector<char> buffer;
+    if (!ReadFileContents(cookedFileName, buffer))
+        return false;
+
+    CookedMeshReader reader(buffer);
+    if (reader.Read<unsigned int>() != COOKED_MESH_MAGIC || reader.Read<unsigned int>() != COOKED_MESH_VERSION)
+        return false;
+
+    CookedMesh result;
+
+    unsigned int sourceFileCount = reader.Read<unsigned int>();
+    for (unsigned int i = 0; i < sourceFileCount && reader.IsValid(); ++i)
+    {
+        string sourceFileName = reader.ReadString();
+        SourceFileStamp recorded = reader.Read<SourceFileStamp>();
+        SourceFileStamp current;
+
+        if (!reader.IsValid() || !StatSourceFile(sourceFileName, current) || current.size != recorded.size)
+            return false;
+
+        // A touched but unchanged source keeps the cooked file valid
+        if (current.modificationTime != recorded.modificationTime && HashFileContents(sourceFileName) != recorded.hash)
+            return false;
+
+        result.sourceFiles.push_back(sourceFileName);
+    }
+
+    unsigned int materialCount = reader.Read<unsigned int>();
+    for (unsigned int i = 0; i < materialCount && reader.IsValid(); ++i)
+    {
+        ObjParser::Material material;
+        material.name = reader.ReadString();
+        material.ambientColor = reader.Read<ObjParser::ColorValue>();
+        material.diffuseColor = reader.Read<ObjParser::ColorValue>();
+        material.specularColor = reader.Read<ObjParser::ColorValue>();
+        material.specularExponent = reader.Read<float>();
+        material.diffuseMap = reader.ReadString();
+        material.specularMap = reader.ReadString();
+        material.bumpMap = reader.ReadString();
+        result.materials.push_back(material);
+    }
+
+    unsigned int renderObjectCount = reader.Read<unsigned int>();
+    for (unsigned int i = 0; i < renderObjectCount && reader.IsValid(); ++i)
+    {
+        CompressedRenderObject object;
+        object._materialName = reader.ReadString();
+        object._vertexCount = reader.Read<unsigned int>();
+        object._indexCount = reader.Read<unsigned int>();
+        object._positionOffset = reader.Read<glm::vec3>();
+        object._positionScale = reader.Read<glm::vec3>();
+        reader.ReadArray(object._indices);
+        reader.ReadArray(object._vertices);
+        reader.ReadArray(object._normals);
+        reader.ReadArray(object._uvCoords);
+        reader.ReadArray(object._light);
+
+        if (reader.IsValid() && !IsValidCompressedRenderObject(object))
+            return false;
+
+        result.renderObjects.push_back(object);
+    }
+
+    if (!reader.IsValid() || !reader.IsAtEnd())
+        return false;
+
+    mesh = result;
+    return true;
+}
+
+bool SaveCookedMesh(const string &cookedFileName, const CookedMesh &mesh)
+{
+    CookedMeshWriter writer;
+
+    writer.Write(COOKED_MESH_MAGIC);
+    writer.Write(COOKED_MESH_VERSION);
+
+    writer.Write((unsigned int)mesh.sourceFiles.size());
+    for (int i = 0; i < mesh.sourceFiles.size(); ++i)
+    {
+        SourceFileStamp stamp;
+        if (!StatSourceFile(mesh.sourceFiles[i], stamp))
+            return false;
+        stamp.hash = HashFileContents(mesh.sourceFiles[i]);
+
+        writer.WriteString(mesh.sourceFiles[i]);
+        writer.Write(stamp);
+    }
+
+    writer.Write((unsigned int)mesh.materials.size());
+    for (int i = 0; i < mesh.materials.size(); ++i)
+    {
+        const ObjParser::Material &material = mesh.materials[i];
+        writer.WriteString(material.name);
+        writer.Write(material.ambientColor);
+        writer.Write(material.diffuseColor);
+        writer.Write(material.specularColor);
+        writer.Write(material.specularExponent);
+        writer.WriteString(material.diffuseMap);
+        writer.WriteString(material.specularMap);
+        writer.WriteString(material.bumpMap);
+    }
+
+    writer.Write((unsigned int)mesh.renderObjects.size());
+    for (int i = 0; i < mesh.renderObjects.size(); ++i)
+    {
+        const CompressedRenderObject &object = mesh.renderObjects[i];
+        writer.WriteString(object._materialName);
+        writer.Write(object._vertexCount);
+        writer.Write(object._indexCount);
+        writer.Write(object._positionOffset);
+        writer.Write(object._positionScale);
+        writer.WriteArray(object._indices);
+        writer.WriteArray(object._vertices);
+        writer.WriteArray(object._normals);
+        writer.WriteArray(object._uvCoords);
+        writer.WriteArray(object._light);
+    }
+
+    const vector<char> &buffer = writer.GetBuffer();
+    FILE *file = fopen(cookedFileName.c_str(), "wb");
+    if (file == NULL)
+        return false;
+
+    bool written = fwrite(buffer.data(), buffer.size(), 1, file) == 1;
+    fclose(file);
+
+    if (!written)
+        remove(cookedFileName.c_str());
+
+    return written;
+}
+
+CookedMesh LoadObjFileCached(const string &path, const string &fileName)
+{
+    CookedMesh mesh;
+    string cookedFileName = GetCookedMeshPath(path, fileName);
+
+    if (!LoadCookedMesh(cookedFileName, mesh))
+    {
+        mesh = CookObjFile(path, fileName);
+
+        // The cache is only an optimization, a read-only asset directory still loads
+        SaveCookedMesh(cookedFileName, mesh);
+    }
+
+    return mesh;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "meshcompression.hh"
+#include "objtypes.hh"
+
+typedef struct CookedMesh
+{
+    std::vector<CompressedRenderObject> renderObjects;
+    std::vector<ObjParser::Material> materials;
+    std::vector<std::string> sourceFiles;
+} CookedMesh;
+
+// Cooked files live next to their source as "<source>.cooked" and are only
+// accepted while every source file still matches its recorded size, mtime
+// and content hash.
+std::string GetCookedMeshPath(const std::string &path, const std::string &fileName);
+
+CookedMesh CookObjFile(const std::string &path, const std::string &fileName);
+bool LoadCookedMesh(const std::string &cookedFileName, CookedMesh &mesh);
+bool SaveCookedMesh(const std::string &cookedFileName, const CookedMesh &mesh);
+
+CookedMesh LoadObjFileCached(const std::string &path, const std::string &fileName);
+
+unsigned long long HashFileContents(const std::string &fileName);
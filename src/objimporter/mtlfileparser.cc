@@ -1,28 +1,29 @@
-#include <cstdlib>
-#include <fstream>
+#include <cstring>
 #include <sstream>
 #include <string>
 #include <stdexcept>
-#include <unordered_map>
 #include <vector>
 
 #include "mtlfileparser.hh"
+#include "textbuffer.hh"
 
 using namespace ObjParser;
 
-using std::ifstream;
 using std::string;
-using std::unordered_map;
 using std::vector;
 
 /*
  * Grammar:
  * <ambient color> -> Ka FLOAT FLOAT FLOAT
  * <material> -> newmtl IDENTIFIER
+ * <texture map> -> (map_Kd | map_Ks | map_bump | bump) {OPTION {VALUE}} FILENAME
  * <line> -> <line definition> LINEEND
- * <line definition> -> <material> | <ambient color>
+ * <line definition> -> <material> | <ambient color> | <texture map> | ...
  */
 
+// Specular exponent of materials without an Ns statement
+static const float MTL_DEFAULT_SPECULAR_EXPONENT = 0.5f;
+
 class MtlFileParserImplementation : public MtlFileParser::IMtlFileParserImplementation
 {
 private:
@@ -38,6 +39,9 @@ private:
         OpticalDensity,
         SpecularColor,
         SpecularExponent,
+        SpecularMap,
+        BumpMap,
+        Ignored,
         LineEnd,
         FileName,
         Identifier,
@@ -70,6 +74,12 @@ private:
             return "SpecularColor";
         case Token::SpecularExponent:
             return "SpecularExponent";
+        case Token::SpecularMap:
+            return "SpecularMap";
+        case Token::BumpMap:
+            return "BumpMap";
+        case Token::Ignored:
+            return "Ignored";
         case Token::LineEnd:
             return "LineEnd";
         case Token::FileName:
@@ -85,18 +95,19 @@ private:
         }
     }
 
+    typedef struct Keyword
+    {
+        const char *text;
+        Token token;
+    } Keyword;
+
     class MtlTokenScanner
     {
     public:
-        MtlTokenScanner(const char *fileName)
-            : _fileName(fileName), _currentToken(Token::Start), _line(1)
+        MtlTokenScanner(const string &fileName, const char *begin, const char *end)
+            : _fileName(fileName), _current(begin), _end(end), _currentToken(Token::Start), _line(1)
         {
-            _fileStream.open(fileName);
-        }
-
-        ~MtlTokenScanner()
-        {
-            _fileStream.close();
+            _token.begin = _token.end = _current;
         }
 
         int GetLine() const
@@ -104,11 +115,6 @@ private:
             return _line;
         }
 
-        bool isOpen() const
-        {
-            return _fileStream.is_open();
-        }
-
         Token GetCurrentToken() const
         {
             return _currentToken;
@@ -116,7 +122,12 @@ private:
 
         string GetTokenBuffer() const
         {
-            return _tokenBuffer;
+            return _token.ToString();
+        }
+
+        const StringRange &GetTokenRange() const
+        {
+            return _token;
         }
 
         void MatchToken(Token token)
@@ -132,7 +143,7 @@ private:
                 errorStream << "   Expected: " << GetStringForToken(token) << " Actual: " << GetStringForToken(_currentToken) << std::endl;
                 if (_currentToken == Token::Identifier)
                 {
-                    errorStream << "   Identifier: " << _tokenBuffer << std::endl;
+                    errorStream << "   Identifier: " << _token.ToString() << std::endl;
                 }
                 throw std::runtime_error(errorStream.str());
             }
@@ -140,52 +151,104 @@ private:
     
     private:
         string _fileName;
-        ifstream _fileStream;
+        const char *_current;
+        const char *_end;
         Token _currentToken;
         unsigned int _line;
-        string _tokenBuffer;
+        StringRange _token;
 
-        bool checkForString(const std::string s)
+        static bool isSpace(char c)
         {
-            string actual;
-        
-            for (actual = ""; actual.size() <= s.size(); actual.push_back(_fileStream.get()))
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+
+        const char *findWordEnd(const char *start) const
+        {
+            while (start != _end && !isSpace(*start) && *start != '\n' && *start != '#')
+                ++start;
+            return start;
+        }
+
+        const char *skipSpaces(const char *start) const
+        {
+            while (start != _end && isSpace(*start))
+                ++start;
+            return start;
+        }
+
+        static bool isNumber(const char *begin, const char *end)
+        {
+            if (begin != end && (*begin == '-' || *begin == '+'))
+                ++begin;
+            if (begin == end)
+                return false;
+
+            for (; begin != end; ++begin)
             {
-                if (actual != s.substr(0, actual.size()))
-                {
-                    for (int i = 0; i < actual.size(); ++i)
-                        _fileStream.unget();
+                if (!IsDigit(*begin) && *begin != '.')
                     return false;
+            }
+            return true;
+        }
+
+        // Texture statements may put options like "-bm 0.5" before the
+        // file name, which is the rest of the line and may contain spaces
+        void scanFileName(bool skipOptions)
+        {
+            const char *lineEnd = _current;
+            while (lineEnd != _end && *lineEnd != '\n')
+                ++lineEnd;
+
+            const char *nameEnd = lineEnd;
+            while (nameEnd != _current && isSpace(nameEnd[-1]))
+                --nameEnd;
+
+            const char *nameBegin = _current;
+            while (skipOptions && nameBegin + 1 < nameEnd && nameBegin[0] == '-' && !IsDigit(nameBegin[1]) && nameBegin[1] != '.')
+            {
+                nameBegin = skipSpaces(findWordEnd(nameBegin));
+
+                for (const char *argumentEnd = findWordEnd(nameBegin); argumentEnd < nameEnd; argumentEnd = findWordEnd(nameBegin))
+                {
+                    StringRange argument = { nameBegin, argumentEnd };
+                    if (!isNumber(argument.begin, argument.end) && !argument.Equals("on") && !argument.Equals("off"))
+                        break;
+                    nameBegin = skipSpaces(argumentEnd);
                 }
             }
 
-            return true;
+            _currentToken = Token::FileName;
+            _token.begin = nameBegin;
+            _token.end = nameEnd;
+            _current = lineEnd;
         }
 
         void GetNextToken()
         {
-            char input = _fileStream.get();
-            _tokenBuffer = "";
-
-            while (input == ' ' || input == '#')
+            while (_current != _end && (isSpace(*_current) || *_current == '#'))
             {
-                if (input == '#')
+                if (*_current == '#')
                 {
-                    for (input = _fileStream.get(); input != '\n' && input != EOF; input = _fileStream.get())  {}
-                    if (input == '\n')
-                        ++_line;
+                    while (_current != _end && *_current != '\n')
+                        ++_current;
+                }
+                else
+                {
+                    ++_current;
                 }
-                input = _fileStream.get();
             }
 
-            if (input == EOF)
+            _token.begin = _token.end = _current;
+
+            if (_current == _end)
             {
                 _currentToken = Token::ScanEOF;
                 return;
             }
-            
-            if (input == '\n')
+
+            if (*_current == '\n')
             {
+                ++_current;
                 _currentToken = Token::LineEnd;
                 ++_line;
                 return;
@@ -194,100 +257,82 @@ private:
             bool isLineStart = _currentToken == Token::LineEnd || _currentToken == Token::Start;
             if (isLineStart)
             {
-                _fileStream.unget();
-                
-                if (checkForString("newmtl"))
+                static const Keyword keywords[] = {
+                    { "newmtl", Token::MaterialName },
+                    { "Ka", Token::AmbientColor },
+                    { "Kd", Token::DiffuseColor },
+                    { "Ks", Token::SpecularColor },
+                    { "Ns", Token::SpecularExponent },
+                    { "Ni", Token::OpticalDensity },
+                    { "d", Token::DissolveFactor },
+                    { "illum", Token::IlluminationModel },
+                    { "map_Kd", Token::DiffuseMap },
+                    { "map_Ks", Token::SpecularMap },
+                    { "map_bump", Token::BumpMap },
+                    { "map_Bump", Token::BumpMap },
+                    { "bump", Token::BumpMap },
+                    { "Ke", Token::Ignored },
+                    { "Tr", Token::Ignored },
+                    { "Tf", Token::Ignored },
+                    { "map_Ka", Token::Ignored },
+                    { "map_Ns", Token::Ignored },
+                    { "map_d", Token::Ignored },
+                    { "disp", Token::Ignored },
+                    { "refl", Token::Ignored }
+                };
+
+                StringRange word = { _current, findWordEnd(_current) };
+                for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); ++i)
                 {
-                    _currentToken = Token::MaterialName;
-                    return;
-                }
-
-                if (checkForString("Ka"))
-                {
-                    _currentToken = Token::AmbientColor;
-                    return;
-                }
-
-                if (checkForString("Kd"))
-                {
-                    _currentToken = Token::DiffuseColor;
-                    return;
-                }
-
-                if (checkForString("map_Kd"))
-                {
-                    _currentToken = Token::DiffuseMap;
-                    return;
-                }
-
-                if (checkForString("Ks"))
-                {
-                    _currentToken = Token::SpecularColor;
-                    return;
-                }
-
-                if (checkForString("Ns"))
-                {
-                    _currentToken = Token::SpecularExponent;
-                    return;
-                }
-
-                if (checkForString("Ni"))
-                {
-                    _currentToken = Token::OpticalDensity;
-                    return;
-                }
-
-                if (checkForString("d"))
-                {
-                    _currentToken = Token::DissolveFactor;
-                    return;
-                }
-
-                if (checkForString("illum"))
-                {
-                    _currentToken = Token::IlluminationModel;
-                    return;
+                    if (word.Equals(keywords[i].text))
+                    {
+                        _current = word.end;
+                        _currentToken = keywords[i].token;
+                        return;
+                    }
                 }
             }
+            else if (_currentToken == Token::DiffuseMap || _currentToken == Token::SpecularMap ||
+                     _currentToken == Token::BumpMap || _currentToken == Token::Ignored)
+            {
+                scanFileName(_currentToken != Token::Ignored);
+                return;
+            }
+            else if (_currentToken == Token::MaterialName)
+            {
+                _currentToken = Token::Identifier;
+                _token.end = _current = findWordEnd(_current);
+                return;
+            }
             else
             {
-                if (input == '-' || input == '.' || isdigit(input)) // float or int
+                const char *tokenStart = _current;
+                char input = *_current;
+
+                if (input == '-' || input == '+' || input == '.' || IsDigit(input)) // float or int
                 {
-                    _currentToken = Token::Integer;
-                    while (input == '-' || input == '.' || isdigit(input))
+                    _currentToken = input == '.' ? Token::Float : Token::Integer;
+                    for (++_current; _current != _end; ++_current)
                     {
-                        _tokenBuffer.push_back(input);
-                        if (input == '.')
+                        char c = *_current;
+                        if (c == '.' || c == 'e' || c == 'E')
                             _currentToken = Token::Float;
-                        input = _fileStream.get();
+                        else if (!IsDigit(c) && c != '-' && c != '+')
+                            break;
                     }
 
-                    _fileStream.unget();
+                    _token.begin = tokenStart;
+                    _token.end = _current;
                     return;
                 }
 
-                if (isalnum(input))
+                if (IsAlphaNumeric(input) || input == '_')
                 {
                     _currentToken = Token::Identifier;
-                    while (isalnum(input) || input == '.' || input == '-' || input == '_')
-                    {
-                        _tokenBuffer.push_back(input);
-                        input = _fileStream.get();
-                    }
+                    _current = findWordEnd(tokenStart);
 
-                    if (input == '\\' || input == ':')
-                    {
-                        _currentToken = Token::FileName;
-
-                        do 
-                        {
-                            _tokenBuffer.push_back(input);
-                            input = _fileStream.get();
-                        } while (isalnum(input) || input == '.' || input == '-' || input == '_' || input == '\\');
-                    }
-
-                    _fileStream.unget();
+                    _token.begin = tokenStart;
+                    _token.end = _current;
                     return;
                 }
             }
@@ -306,15 +351,22 @@ public:
 
     void Parse()
     {
-        _scanner = new MtlTokenScanner((string(_path) + _fileName).c_str());
-
-        if (!_scanner->isOpen())
+        vector<char> contents;
+        if (!ReadFileContents(string(_path) + _fileName, contents))
         {
             std::stringstream errorStream;
             errorStream << "Runtime error: unable to open MTL file: " << _fileName;
             throw std::runtime_error(errorStream.str());
         }
 
+        ParseBuffer(contents.data(), contents.size());
+    }
+
+    void ParseBuffer(const char *data, size_t size)
+    {
+        MtlTokenScanner scanner(_fileName, data, data + size);
+        _scanner = &scanner;
+
         _scanner->MatchToken(Token::Start);
         
         while (_scanner->GetCurrentToken() != Token::ScanEOF)
@@ -322,7 +374,7 @@ public:
             MatchLine();
         }
 
-        delete _scanner;
+        _scanner = NULL;
     }
 
     vector<Material*> GetMaterials() const
@@ -339,82 +391,110 @@ private:
 
     void MatchLine()
     {
-        if (_scanner->GetCurrentToken() == Token::MaterialName)
+        Token token = _scanner->GetCurrentToken();
+
+        if (token != Token::MaterialName && token != Token::LineEnd && token != Token::ScanEOF && _currentMaterial == NULL)
+        {
+            std::stringstream errorStream;
+            errorStream << "Mtl parse error: statement before newmtl: " << _fileName << " line: " << _scanner->GetLine();
+            throw std::runtime_error(errorStream.str());
+        }
+
+        if (token == Token::MaterialName)
         {
             _scanner->MatchToken(Token::MaterialName);
             _currentMaterial = new Material();
             _currentMaterial->name = _scanner->GetTokenBuffer();
+            _currentMaterial->specularExponent = MTL_DEFAULT_SPECULAR_EXPONENT;
             _materials.push_back(_currentMaterial);
             _scanner->MatchToken(Token::Identifier);
         }
-        else if (_scanner->GetCurrentToken() == Token::AmbientColor)
+        else if (token == Token::AmbientColor)
         {
             _scanner->MatchToken(Token::AmbientColor);
-            ColorValue color;
-            color.red = atof(_scanner->GetTokenBuffer().c_str());
-            MatchValue();
-            color.green = atof(_scanner->GetTokenBuffer().c_str());
-            MatchValue();
-            color.blue = atof(_scanner->GetTokenBuffer().c_str());
-            MatchValue();
-
-            _currentMaterial->ambientColor = color;
+            _currentMaterial->ambientColor = MatchColor();
         }
-        else if (_scanner->GetCurrentToken() == Token::DiffuseColor)
+        else if (token == Token::DiffuseColor)
         {
             _scanner->MatchToken(Token::DiffuseColor);
-            ColorValue color;
-            color.red = atof(_scanner->GetTokenBuffer().c_str());
-            MatchValue();
-            color.green = atof(_scanner->GetTokenBuffer().c_str());
-            MatchValue();
-            color.blue = atof(_scanner->GetTokenBuffer().c_str());
-            MatchValue();
-
-            _currentMaterial->diffuseColor = color;
+            _currentMaterial->diffuseColor = MatchColor();
         }
-        else if (_scanner->GetCurrentToken() == Token::SpecularColor)
+        else if (token == Token::SpecularColor)
         {
             _scanner->MatchToken(Token::SpecularColor);
-            ColorValue color;
-            color.red = atof(_scanner->GetTokenBuffer().c_str());
-            MatchValue();
-            color.green = atof(_scanner->GetTokenBuffer().c_str());
-            MatchValue();
-            color.blue = atof(_scanner->GetTokenBuffer().c_str());
-            MatchValue();
-
-            _currentMaterial->specularColor = color;
+            _currentMaterial->specularColor = MatchColor();
         }
-        else if (_scanner->GetCurrentToken() == Token::OpticalDensity)
+        else if (token == Token::OpticalDensity)
         {
             _scanner->MatchToken(Token::OpticalDensity);
             MatchValue();
         }
-        else if (_scanner->GetCurrentToken() == Token::DissolveFactor)
+        else if (token == Token::DissolveFactor)
         {
             _scanner->MatchToken(Token::DissolveFactor);
             MatchValue();
         }
-        else if (_scanner->GetCurrentToken() == Token::IlluminationModel)
+        else if (token == Token::IlluminationModel)
         {
             _scanner->MatchToken(Token::IlluminationModel);
             _scanner->MatchToken(Token::Integer);
         }
-        else if (_scanner->GetCurrentToken() == Token::DiffuseMap)
+        else if (token == Token::DiffuseMap)
         {
             _scanner->MatchToken(Token::DiffuseMap);
-            _currentMaterial->diffuseMap = _scanner->GetTokenBuffer();
-            _scanner->MatchToken(Token::FileName);
+            _currentMaterial->diffuseMap = MatchFileName();
+        }
+        else if (token == Token::SpecularMap)
+        {
+            _scanner->MatchToken(Token::SpecularMap);
+            _currentMaterial->specularMap = MatchFileName();
+        }
+        else if (token == Token::BumpMap)
+        {
+            _scanner->MatchToken(Token::BumpMap);
+            _currentMaterial->bumpMap = MatchFileName();
         }
-        else if (_scanner->GetCurrentToken() == Token::SpecularExponent)
+        else if (token == Token::SpecularExponent)
         {
             _scanner->MatchToken(Token::SpecularExponent);
-            _currentMaterial->specularExponent = atof(_scanner->GetTokenBuffer().c_str());
+            _currentMaterial->specularExponent = ParseFloat(_scanner->GetTokenRange());
             MatchValue();
         }
+        else if (token == Token::Ignored)
+        {
+            _scanner->MatchToken(Token::Ignored);
+            _scanner->MatchToken(Token::FileName);
+        }
+
+        if (_scanner->GetCurrentToken() != Token::ScanEOF)
+            _scanner->MatchToken(Token::LineEnd);
+    }
+
+    ColorValue MatchColor()
+    {
+        ColorValue color;
+        color.red = ParseFloat(_scanner->GetTokenRange());
+        MatchValue();
+        color.green = ParseFloat(_scanner->GetTokenRange());
+        MatchValue();
+        color.blue = ParseFloat(_scanner->GetTokenRange());
+        MatchValue();
+
+        return color;
+    }
+
+    string MatchFileName()
+    {
+        string fileName = _scanner->GetTokenBuffer();
+        if (fileName.empty())
+        {
+            std::stringstream errorStream;
+            errorStream << "Mtl parse error: Expected file name: " << _fileName << " line: " << _scanner->GetLine();
+            throw std::runtime_error(errorStream.str());
+        }
 
-        _scanner->MatchToken(Token::LineEnd);
+        _scanner->MatchToken(Token::FileName);
+        return fileName;
     }
 
     void MatchValue()
@@ -451,6 +531,11 @@ void MtlFileParser::Parse()
     _implementation->Parse();
 }
 
+void MtlFileParser::ParseBuffer(const char *data, size_t size)
+{
+    _implementation->ParseBuffer(data, size);
+}
+
 vector<Material*> MtlFileParser::GetMaterials() const
 {
     return _implementation->GetMaterials();
@@ -15,6 +15,7 @@ namespace ObjParser
         public:
             virtual ~IMtlFileParserImplementation() {}
             virtual void Parse() = 0;
+            virtual void ParseBuffer(const char *data, size_t size) = 0;
             virtual std::vector<Material*> GetMaterials() const = 0;
         };
 
@@ -24,6 +25,10 @@ namespace ObjParser
 
         void Parse();
 
+        // Parses the size bytes at data instead of reading the file; the file
+        // name given to the constructor is only used in error messages
+        void ParseBuffer(const char *data, size_t size);
+
         std::vector<Material*> GetMaterials() const;
     
     private:
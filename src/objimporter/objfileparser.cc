@@ -1,19 +1,22 @@
 #include <cstdlib>
-#include <fstream>
+#include <cstring>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <iostream>
 
+#include <system/thread.hh>
+
 #include "mtlfileparser.hh"
 #include "objparser.hh"
+#include "textbuffer.hh"
 
 using namespace ObjParser;
 
-using std::ifstream;
 using std::string;
 using std::unordered_map;
 using std::vector;
@@ -97,38 +100,50 @@ std::string GetStringForToken(Token token)
     }
 }
 
+// Face indices as written, before they are resolved against the values
+// defined so far
+static const int NO_RAW_INDEX = INT_MIN;
+
+typedef struct RawFaceCorner
+{
+    int vertex;
+    int uv;
+    int normal;
+} RawFaceCorner;
+
 class ObjTokenScanner
 {
 public:
-    ObjTokenScanner(const char *fileName)
-        : _fileName(fileName), _currentToken(Token::START), _line(1)
+    ObjTokenScanner(const string &fileName, const char *begin, const char *end)
+        : _fileName(fileName), _current(begin), _end(end), _currentToken(Token::START), _line(1)
     {
-        _fileStream.open(fileName);
+        _token.begin = _token.end = _current;
     }
 
-    ~ObjTokenScanner()
+    Token GetCurrentToken() const
     {
-        _fileStream.close();
+        return _currentToken;
     }
 
-    bool isOpen() const
+    int GetLine() const
     {
-        return _fileStream.is_open();
+        return _line;
     }
 
-    Token GetCurrentToken() const
+    string GetTokenBuffer() const
     {
-        return _currentToken;
+        return _token.ToString();
     }
 
-    int GetLine() const
+    const StringRange &GetTokenRange() const
     {
-        return _line;
+        return _token;
     }
 
-    string GetTokenBuffer() const
+    // The value of the current INT_LITERAL or FLOAT_LITERAL
+    const NumberValue &GetNumber() const
     {
-        return _tokenBuffer;
+        return _number;
     }
     
     void MatchToken(Token token)
@@ -144,42 +159,99 @@ public:
             errorStream << "   Expected: " << GetStringForToken(token) << " Actual: " << GetStringForToken(_currentToken) << std::endl;
             if (_currentToken == Token::IDENTIFIER)
             {
-                errorStream << "   Identifier: " << _tokenBuffer << std::endl;
+                errorStream << "   Identifier: " << _token.ToString() << std::endl;
             }
             throw std::runtime_error(errorStream.str());
         }
     }
 
-    void GetNextToken()
+    // Reads the numbers of a v, vt or vn line straight from the buffer, which
+    // is far cheaper than going token by token, and moves on to the line end.
+    // Returns false with nothing consumed when the line holds anything else,
+    // so the caller can match its tokens and report errors as usual.
+    bool ScanValues(float *values, int count)
+    {
+        const char *current = _current;
+        NumberValue number;
+        for (int i = 0; i < count; ++i)
+        {
+            current = skipBlanks(current);
+            if (!scanNumber(current, number))
+                return false;
+            values[i] = number.floatValue;
+        }
+
+        if (!isLineEnd(skipBlanks(current)))
+            return false;
+
+        _current = current;
+        GetNextToken();
+        return true;
+    }
+
+    // The same for the corners of an f line. Indices that are left out are
+    // NO_RAW_INDEX, which ParseNumber never returns.
+    bool ScanFaceCorners(vector<RawFaceCorner> &corners)
     {
-        _tokenBuffer.clear();
+        corners.clear();
 
-        if (_fileStream.eof())
+        const char *current = skipBlanks(_current);
+        while (!isLineEnd(current))
         {
-            _currentToken = Token::SCANEOF;
-            return;
+            RawFaceCorner corner = { NO_RAW_INDEX, NO_RAW_INDEX, NO_RAW_INDEX };
+            if (!scanIndex(current, corner.vertex))
+                return false;
+
+            if (current != _end && *current == '/')
+            {
+                ++current;
+                if (current != _end && *current != '/' && !scanIndex(current, corner.uv))
+                    return false;
+
+                if (current != _end && *current == '/')
+                {
+                    ++current;
+                    if (!scanIndex(current, corner.normal))
+                        return false;
+                }
+            }
+
+            corners.push_back(corner);
+            current = skipBlanks(current);
         }
 
-        char input = _fileStream.get();
-        char nextInput = _fileStream.peek();
+        _current = current;
+        GetNextToken();
+        return true;
+    }
 
-        while (input == ' ' || input == '#')
+    void GetNextToken()
+    {
+        while (_current != _end && (*_current == ' ' || *_current == '\t' || *_current == '\r' || *_current == '#'))
         {
-            if (input == '#')
+            if (*_current == '#')
+            {
+                while (_current != _end && *_current != '\n')
+                    ++_current;
+            }
+            else
             {
-                for (input = _fileStream.get(); input != '\n' && input != EOF; input = _fileStream.get())  {}
-                if (input == '\n')
-                    ++_line;
+                ++_current;
             }
-            input = _fileStream.get();
         }
-                
-        if (input == EOF)
+
+        _token.begin = _token.end = _current;
+
+        if (_current == _end)
         {
             _currentToken = Token::SCANEOF;
             return;
         }
-            
+
+        const char *tokenStart = _current;
+        char input = *_current++;
+        char nextInput = peek(0);
+
         if (input == '\n')
         {
             _currentToken = Token::NEWLINE;
@@ -208,52 +280,30 @@ public:
                 return;
             }
         
-            if (input == 'v' && nextInput == 't')
+            if (input == 'v' && nextInput == 't' && peek(1) == ' ')
             {
-                _fileStream.get();
-            
-                if (_fileStream.peek() == ' ')
-                {
-                    _currentToken = Token::VERTEX_TEXTURE_INDICATOR;
-                    return;
-                }
-            
-                _fileStream.unget();
+                ++_current;
+                _currentToken = Token::VERTEX_TEXTURE_INDICATOR;
+                return;
             }
 
-            if (input == 'v' && nextInput == 'n')
+            if (input == 'v' && nextInput == 'n' && peek(1) == ' ')
             {
-                _fileStream.get();
-            
-                if (_fileStream.peek() == ' ')
-                {
-                    _currentToken = Token::VERTEX_NORMAL_INDICATOR;
-                    return;
-                }
-            
-                _fileStream.unget();
+                ++_current;
+                _currentToken = Token::VERTEX_NORMAL_INDICATOR;
+                return;
             }
             
-            if (input == 'u' && nextInput == 's')
+            if (input == 'u' && checkForString(tokenStart, "usemtl"))
             {
-                _fileStream.unget();
-                if (checkForString("usemtl"))
-                {
-                    _currentToken = Token::MATERIAL_NAME;
-                    return;
-                }
-                _fileStream.get();
+                _currentToken = Token::MATERIAL_NAME;
+                return;
             }
 
-            if (input == 'm')
+            if (input == 'm' && checkForString(tokenStart, "mtllib"))
             {
-                _fileStream.unget();
-                if (checkForString("mtllib"))
-                {
-                    _currentToken = Token::MATERIAL_LIBRARY_INDICATOR;
-                    return;
-                }
-                _fileStream.get();
+                _currentToken = Token::MATERIAL_LIBRARY_INDICATOR;
+                return;
             }
 
             if (input == 'o' && nextInput == ' ')
@@ -276,44 +326,47 @@ public:
                 return;
             }
 
-            if (input == '-' || input == '.' || isdigit(input)) // float or int
+            if (input == '-' || input == '+' || input == '.' || IsDigit(input)) // float or int
             {
-                _currentToken = Token::INT_LITERAL;
-                while (input == '-' || input == '.' || isdigit(input))
+                // The value is read while scanning, so it never needs a second pass
+                _current = ParseNumber(tokenStart, _end, _number);
+                bool isFloat = _number.isFloat;
+
+                // Whatever else looks like part of a number still belongs to the token
+                for (; _current != _end; ++_current)
                 {
-                    _tokenBuffer.push_back(input);
-                    if (input == '.')
-                        _currentToken = Token::FLOAT_LITERAL;
-                    input = _fileStream.get();
+                    char c = *_current;
+                    if (c == '.' || c == 'e' || c == 'E')
+                        isFloat = true;
+                    else if (!IsDigit(c) && c != '-' && c != '+')
+                        break;
                 }
 
-                _fileStream.unget();
+                _currentToken = isFloat ? Token::FLOAT_LITERAL : Token::INT_LITERAL;
+                _token.begin = tokenStart;
+                _token.end = _current;
                 return;
             }
 
-            if (isalnum(input))
+            if (IsAlphaNumeric(input))
             {
                 if (_currentToken == Token::MATERIAL_LIBRARY_INDICATOR)
                 {
                     _currentToken = Token::FILENAME;
 
-                    while (isalnum(input) || input == '-' || input == '_' || input == ':' || input == '.')
-                    {
-                        _tokenBuffer.push_back(input);
-                        input = _fileStream.get();
-                    }
+                    while (_current != _end && (IsAlphaNumeric(*_current) || *_current == '-' || *_current == '_' || *_current == ':' || *_current == '.'))
+                        ++_current;
                 }
                 else
                 {
                     _currentToken = Token::IDENTIFIER;
-                    while (isalnum(input) || input == '-' || input == '_' || input == '.')
-                    {
-                        _tokenBuffer.push_back(input);
-                        input = _fileStream.get();
-                    }
+
+                    while (_current != _end && (IsAlphaNumeric(*_current) || *_current == '-' || *_current == '_' || *_current == '.'))
+                        ++_current;
                 }
 
-                _fileStream.unget();
+                _token.begin = tokenStart;
+                _token.end = _current;
                 return;
             }
         }
@@ -326,25 +379,81 @@ public:
 
 private:
     string _fileName;
-    ifstream _fileStream;
+    const char *_current;
+    const char *_end;
     Token _currentToken;
     unsigned int _line;
-    string _tokenBuffer;
+    StringRange _token;
+    NumberValue _number;
 
-    bool checkForString(const std::string s)
+    char peek(int offset) const
     {
-        string actual;
-        
-        for (actual = ""; actual.size() <= s.size(); actual.push_back(_fileStream.get()))
+        return offset < _end - _current ? _current[offset] : '\0';
+    }
+
+    const char *skipBlanks(const char *current) const
+    {
+        while (current != _end && (*current == ' ' || *current == '\t' || *current == '\r'))
+            ++current;
+
+        return current;
+    }
+
+    bool isLineEnd(const char *current) const
+    {
+        return current == _end || *current == '\n' || *current == '#';
+    }
+
+    static bool isNumberCharacter(char c)
+    {
+        return IsDigit(c) || c == '.' || c == 'e' || c == 'E' || c == '-' || c == '+';
+    }
+
+    // Only succeeds where GetNextToken would see the same number as one token
+    bool scanNumber(const char *&current, NumberValue &number) const
+    {
+        if (current == _end || !(IsDigit(*current) || *current == '-' || *current == '+' || *current == '.'))
+            return false;
+
+        const char *numberEnd = ParseNumber(current, _end, number);
+        if (numberEnd != _end && isNumberCharacter(*numberEnd))
+            return false;
+
+        current = numberEnd;
+        return true;
+    }
+
+    // Indices are plain integers, so they skip the float work of scanNumber.
+    // Long ones are left to ParseNumber, which clamps them.
+    bool scanIndex(const char *&current, int &index) const
+    {
+        const char *digits = current;
+        bool negative = digits != _end && *digits == '-';
+        if (digits != _end && (*digits == '-' || *digits == '+'))
+            ++digits;
+
+        const char *indexEnd = digits;
+        int value = 0;
+        for (; indexEnd != _end && IsDigit(*indexEnd) && indexEnd - digits < 9; ++indexEnd)
         {
-            if (actual != s.substr(0, actual.size()))
-            {
-                for (int i = 0; i < actual.size(); ++i)
-                    _fileStream.unget();
-                return false;
-            }
+            value = value * 10 + (*indexEnd - '0');
         }
 
+        if (indexEnd == digits || (indexEnd != _end && isNumberCharacter(*indexEnd)))
+            return false;
+
+        index = negative ? -value : value;
+        current = indexEnd;
+        return true;
+    }
+
+    bool checkForString(const char *start, const char *s)
+    {
+        size_t length = strlen(s);
+        if (length > _end - start || memcmp(start, s, length) != 0)
+            return false;
+
+        _current = start + length;
         return true;
     }
 };
@@ -352,75 +461,184 @@ private:
 class ObjParseResult : public IParseResult
 {
 public:
-    std::vector<Vertex> GetVertices() const
+    ~ObjParseResult()
+    {
+        for (int i = 0; i < _materials.size(); ++i)
+        {
+            delete _materials[i];
+        }
+    }
+
+    const std::vector<Vertex> &GetVertices() const
     {
         return _vertices;
     }
 
-    std::vector<Normal> GetNormals() const
+    const std::vector<Normal> &GetNormals() const
     {
         return _normals;
     }
 
-    std::vector<UVCoord> GetUVCoords() const
+    const std::vector<UVCoord> &GetUVCoords() const
     {
         return _uvCoords;
     }
 
-    std::vector<IndexValue> GetIndices() const
+    const FaceList &GetFaces() const
     {
-        return _indices;
+        return _faces;
     }
 
-    std::vector<Face> GetFaces() const
+    const std::vector<Material*> &GetMaterials() const
     {
-        return _faces;
+        return _materials;
     }
 
-    std::vector<Material*> GetMaterials() const
+    const std::vector<std::string> &GetMaterialLibraries() const
     {
-        return _materials;
+        return _materialLibraries;
     }
 
     std::vector<Vertex> _vertices;
     std::vector<Normal> _normals;
     std::vector<UVCoord> _uvCoords;
-    std::vector<IndexValue> _indices;
-    std::vector<Face> _faces;
+    FaceList _faces;
     std::vector<Material*> _materials;
+    std::vector<std::string> _materialLibraries;
 };
 
-class ObjFileParserImplementation : public ObjFileParser::IObjFileParserImplementation
+enum class FaceAttribute
+{
+    Vertex,
+    UV,
+    Normal
+};
+
+typedef struct RelativeIndex
+{
+    size_t corner;
+    FaceAttribute attribute;
+} RelativeIndex;
+
+typedef struct MaterialDirective
+{
+    bool isLibrary;
+    string name;
+    unsigned int line;
+} MaterialDirective;
+
+// Parses one line-aligned range of an OBJ file. Material directives and
+// relative indices are only recorded here, because their meaning depends
+// on the chunks before this one; ObjFileParserImplementation resolves them
+// while merging the chunks in file order.
+class ObjChunkParser
 {
 public:
-    ObjFileParserImplementation(const char *path, const char *fileName)
-        : _path(path), _fileName(fileName), _scanner(NULL)
+    ObjChunkParser(const string &fileName, const char *begin, const char *end)
+        : _currentMaterialId(0), _fileName(fileName), _scanner(fileName, begin, end)
+    {
+    }
+
+    void Parse()
+    {
+        Start();
+
+        while (ParseLine())
+        {
+        }
+    }
+
+    void Start()
+    {
+        _scanner.GetNextToken();
+    }
+
+    // Returns false once the end of the chunk is reached
+    bool ParseLine()
     {
+        if (_scanner.GetCurrentToken() == Token::SCANEOF)
+            return false;
+
+        MatchLine();
+        return true;
     }
 
-    ~ObjFileParserImplementation()
+    // Drops the faces parsed so far but keeps the material ids they used
+    void ClearFaces()
+    {
+        _faces.corners.clear();
+        _faces.offsets.clear();
+        _faces.counts.clear();
+        _faces.materialIds.clear();
+        _relativeIndices.clear();
+    }
+
+    bool TryParse()
+    {
+        try
+        {
+            Parse();
+            return true;
+        }
+        catch (std::runtime_error &)
+        {
+            return false;
+        }
+    }
+
+public:
+    vector<Vertex> _vertices;
+    vector<Normal> _normals;
+    vector<UVCoord> _uvCoords;
+    FaceList _faces;
+    vector<RelativeIndex> _relativeIndices;
+    vector<MaterialDirective> _materialDirectives;
+    IndexValue _currentMaterialId;
+
+private:
+    string _fileName;
+    ObjTokenScanner _scanner;
+    unordered_map<string, IndexValue> _materialIds;
+    vector<RawFaceCorner> _rawCorners;
+
+private:
+    float MatchValue();
+    void MatchLine();
+    void MatchValues(Token indicator, float *values, int count);
+    void MatchFaces();
+    void MatchFaceIndex(IndexValue &index, FaceAttribute attribute, size_t definedCount);
+    void resolveFaceIndex(int value, IndexValue &index, FaceAttribute attribute, size_t definedCount);
+};
+
+class ObjFileParserImplementation : public ObjFileParser::IObjFileParserImplementation
+{
+public:
+    ObjFileParserImplementation(const char *path, const char *fileName)
+        : _path(path), _fileName(fileName)
     {
-        if (_scanner != NULL)
-            delete _scanner;
     }
 
     IParseResult *Parse();
+    IParseResult *ParseParallel(unsigned int chunkCount);
+    IParseResult *ParseStreaming(IFaceListener *listener);
+    IParseResult *ParseBuffer(const char *data, size_t size);
 
-    vector<float> GetVertices();
-    vector<float> GetNormals();
-    vector<IndexValue> GetIndices();
-    vector<Face> GetFaces();
-    
 private:
     const char *_path;
     const char *_fileName;
-    ObjTokenScanner *_scanner;
-    ObjParseResult *_result;
-    string _currentMaterial;
-    void MatchValue();
-    void MatchLine();
+
+private:
+    IParseResult *parse(unsigned int chunkCount);
+    IParseResult *parse(const char *begin, const char *end, unsigned int chunkCount);
+    void readContents(vector<char> &contents);
+    void validateFace(const FaceCorner *corners, IndexValue cornerCount,
+                      size_t vertexCount, size_t uvCount, size_t normalCount);
+    void mergeChunks(const vector<ObjChunkParser*> &chunks, ObjParseResult *result);
+    void loadMaterials(ObjChunkParser *chunk, ObjParseResult *result, size_t firstDirective = 0);
 };
 
+static const size_t OBJ_MIN_CHUNK_SIZE = 64 * 1024;
+
 ObjFileParser::ObjFileParser(const char *path, const char *filename)
     : _implementation(new ObjFileParserImplementation(path, filename))
 {
@@ -436,193 +654,558 @@ IParseResult *ObjFileParser::Parse()
     return _implementation->Parse();
 }
 
+IParseResult *ObjFileParser::ParseParallel(unsigned int chunkCount)
+{
+    return _implementation->ParseParallel(chunkCount);
+}
+
+IParseResult *ObjFileParser::ParseStreaming(IFaceListener *listener)
+{
+    return _implementation->ParseStreaming(listener);
+}
+
+IParseResult *ObjFileParser::ParseBuffer(const char *data, size_t size)
+{
+    return _implementation->ParseBuffer(data, size);
+}
+
 IParseResult *ObjFileParserImplementation::Parse()
 {
-    _scanner = new ObjTokenScanner((string(_path) + _fileName).c_str());
-    _result = new ObjParseResult();
+    return parse(1);
+}
+
+IParseResult *ObjFileParserImplementation::ParseParallel(unsigned int chunkCount)
+{
+    try
+    {
+        return parse(chunkCount);
+    }
+    catch (std::runtime_error &)
+    {
+        // Chunks only know their local line numbers, so let the serial
+        // parser report the error
+        return parse(1);
+    }
+}
+
+IParseResult *ObjFileParserImplementation::ParseStreaming(IFaceListener *listener)
+{
+    vector<char> contents;
+    readContents(contents);
+
+    ObjChunkParser chunk(_fileName, contents.data(), contents.data() + contents.size());
+    ObjParseResult *result = new ObjParseResult();
 
-    if (!_scanner->isOpen())
+    try
+    {
+        size_t loadedDirectives = 0;
+        chunk.Start();
+
+        while (chunk.ParseLine())
+        {
+            if (chunk._materialDirectives.size() > loadedDirectives)
+            {
+                size_t materialCount = result->_materials.size();
+                loadMaterials(&chunk, result, loadedDirectives);
+                loadedDirectives = chunk._materialDirectives.size();
+
+                for (size_t i = materialCount; i < result->_materials.size(); ++i)
+                {
+                    listener->OnMaterial(*result->_materials[i]);
+                }
+            }
+
+            const FaceList &faces = chunk._faces;
+            if (faces.Size() > 0)
+            {
+                const FaceCorner *corners = faces.corners.data() + faces.offsets[0];
+                validateFace(corners, faces.counts[0], chunk._vertices.size(), chunk._uvCoords.size(), chunk._normals.size());
+
+                listener->OnFace(chunk._vertices, chunk._normals, chunk._uvCoords,
+                                 corners, faces.counts[0],
+                                 faces.materialNames[faces.materialIds[0]]);
+                chunk.ClearFaces();
+            }
+        }
+    }
+    catch (...)
+    {
+        delete result;
+        throw;
+    }
+
+    result->_vertices.swap(chunk._vertices);
+    result->_normals.swap(chunk._normals);
+    result->_uvCoords.swap(chunk._uvCoords);
+    result->_faces.materialNames.swap(chunk._faces.materialNames);
+
+    return result;
+}
+
+void ObjFileParserImplementation::readContents(vector<char> &contents)
+{
+    if (!ReadFileContents(string(_path) + _fileName, contents))
     {
         std::stringstream errorStream;
         errorStream << "Runtime error: unable to open OBJ file: " << _fileName;
         throw std::runtime_error(errorStream.str());
     }
+}
 
-    _scanner->GetNextToken();
-        
-    while (_scanner->GetCurrentToken() != Token::SCANEOF)
-    {
-        MatchLine();
-    }
+IParseResult *ObjFileParserImplementation::ParseBuffer(const char *data, size_t size)
+{
+    return parse(data, data + size, 1);
+}
 
-    _scanner->MatchToken(Token::SCANEOF);
+IParseResult *ObjFileParserImplementation::parse(unsigned int chunkCount)
+{
+    vector<char> contents;
+    readContents(contents);
 
-    return _result;
+    return parse(contents.data(), contents.data() + contents.size(), chunkCount);
 }
 
-void ObjFileParserImplementation::MatchValue()
+IParseResult *ObjFileParserImplementation::parse(const char *begin, const char *end, unsigned int chunkCount)
 {
-    if (_scanner->GetCurrentToken() == Token::FLOAT_LITERAL)
+    size_t size = end - begin;
+    if (chunkCount > size / OBJ_MIN_CHUNK_SIZE)
+        chunkCount = size / OBJ_MIN_CHUNK_SIZE;
+
+    vector<ObjChunkParser*> chunks;
+    const char *chunkBegin = begin;
+    for (unsigned int i = 1; i < chunkCount; ++i)
     {
-        _scanner->MatchToken(Token::FLOAT_LITERAL);
+        const char *target = begin + size / chunkCount * i;
+        if (target < chunkBegin)
+            continue;
+
+        const char *lineEnd = (const char *)memchr(target, '\n', end - target);
+        if (lineEnd == NULL)
+            break;
+
+        chunks.push_back(new ObjChunkParser(_fileName, chunkBegin, lineEnd + 1));
+        chunkBegin = lineEnd + 1;
     }
-    else if (_scanner->GetCurrentToken() == Token::INT_LITERAL)
+    chunks.push_back(new ObjChunkParser(_fileName, chunkBegin, end));
+
+    bool success = true;
+    if (chunks.size() == 1)
     {
-        _scanner->MatchToken(Token::INT_LITERAL);
+        try
+        {
+            chunks[0]->Parse();
+        }
+        catch (...)
+        {
+            delete chunks[0];
+            throw;
+        }
     }
     else
     {
-        std::stringstream errorStream;
-        errorStream << "Obj parse error: Expected value type: " << _fileName << " line: " << _scanner->GetLine();
-        throw std::runtime_error(errorStream.str());
+        vector<System::thread*> threads;
+        vector<char> chunkSucceeded(chunks.size(), 0);
+        for (int i = 1; i < chunks.size(); ++i)
+        {
+            ObjChunkParser *chunk = chunks[i];
+            char *succeeded = &chunkSucceeded[i];
+            threads.push_back(new System::thread([chunk, succeeded]() { *succeeded = chunk->TryParse(); }));
+        }
+
+        chunkSucceeded[0] = chunks[0]->TryParse();
+
+        for (int i = 0; i < threads.size(); ++i)
+        {
+            threads[i]->join();
+            delete threads[i];
+        }
+
+        for (int i = 0; i < chunkSucceeded.size(); ++i)
+        {
+            success = success && chunkSucceeded[i];
+        }
     }
-}
 
-void ObjFileParserImplementation::MatchLine()
-{
-    if (_scanner->GetCurrentToken() == Token::GEOMETRIC_VERTEX_INDICATOR)
+    ObjParseResult *result = new ObjParseResult();
+    try
     {
-        Vertex vertex;
-        _scanner->MatchToken(Token::GEOMETRIC_VERTEX_INDICATOR);
-        vertex.coordinates[0] = atof(_scanner->GetTokenBuffer().c_str());
-        MatchValue();
-        vertex.coordinates[1] = atof(_scanner->GetTokenBuffer().c_str());
-        MatchValue();
-        vertex.coordinates[2] = atof(_scanner->GetTokenBuffer().c_str());
-        MatchValue();
-        vertex.coordinates[3] = 1.0;
+        if (!success)
+            throw std::runtime_error("Obj parse error: chunk failed to parse");
+
+        mergeChunks(chunks, result);
 
-        _result->_vertices.push_back(vertex);
+        const FaceList &faces = result->_faces;
+        for (size_t i = 0; i < faces.Size(); ++i)
+        {
+            validateFace(faces.corners.data() + faces.offsets[i], faces.counts[i],
+                         result->_vertices.size(), result->_uvCoords.size(), result->_normals.size());
+        }
     }
-    else if (_scanner->GetCurrentToken() == Token::VERTEX_NORMAL_INDICATOR)
+    catch (...)
     {
-        Normal normal;
-        _scanner->MatchToken(Token::VERTEX_NORMAL_INDICATOR);
-        normal.coordinates[0] = atof(_scanner->GetTokenBuffer().c_str());        
-        MatchValue();
-        normal.coordinates[1] = atof(_scanner->GetTokenBuffer().c_str());        
-        MatchValue();
-        normal.coordinates[2] = atof(_scanner->GetTokenBuffer().c_str());        
-        MatchValue();
+        for (int i = 0; i < chunks.size(); ++i)
+        {
+            delete chunks[i];
+        }
+        delete result;
+        throw;
+    }
 
-        _result->_normals.push_back(normal);
+    for (int i = 0; i < chunks.size(); ++i)
+    {
+        delete chunks[i];
     }
-    else if (_scanner->GetCurrentToken() == Token::VERTEX_TEXTURE_INDICATOR)
+
+    return result;
+}
+
+void ObjFileParserImplementation::mergeChunks(const vector<ObjChunkParser*> &chunks, ObjParseResult *result)
+{
+    if (chunks.size() == 1)
     {
-        UVCoord uvCoord;
-        _scanner->MatchToken(Token::VERTEX_TEXTURE_INDICATOR);
-        uvCoord.coordinates[0] = atof(_scanner->GetTokenBuffer().c_str());
-        MatchValue();
-        uvCoord.coordinates[1] = atof(_scanner->GetTokenBuffer().c_str());
-        MatchValue();
+        ObjChunkParser *chunk = chunks[0];
+        result->_vertices.swap(chunk->_vertices);
+        result->_normals.swap(chunk->_normals);
+        result->_uvCoords.swap(chunk->_uvCoords);
+        std::swap(result->_faces, chunk->_faces);
+        loadMaterials(chunk, result);
+
+        return;
+    }
 
-        _result->_uvCoords.push_back(uvCoord);
+    size_t vertexCount = 0, normalCount = 0, uvCount = 0, faceCount = 0, cornerCount = 0;
+    for (int i = 0; i < chunks.size(); ++i)
+    {
+        vertexCount += chunks[i]->_vertices.size();
+        normalCount += chunks[i]->_normals.size();
+        uvCount += chunks[i]->_uvCoords.size();
+        faceCount += chunks[i]->_faces.Size();
+        cornerCount += chunks[i]->_faces.corners.size();
     }
-    else if (_scanner->GetCurrentToken() == Token::GROUP_INDICATOR)
+
+    FaceList &faces = result->_faces;
+    result->_vertices.reserve(vertexCount);
+    result->_normals.reserve(normalCount);
+    result->_uvCoords.reserve(uvCount);
+    faces.corners.reserve(cornerCount);
+    faces.offsets.reserve(faceCount);
+    faces.counts.reserve(faceCount);
+    faces.materialIds.reserve(faceCount);
+
+    unordered_map<string, IndexValue> materialIds;
+    IndexValue currentMaterialId = 0;
+    for (int i = 0; i < chunks.size(); ++i)
     {
-        _scanner->MatchToken(Token::GROUP_INDICATOR);
+        ObjChunkParser *chunk = chunks[i];
+        FaceList &chunkFaces = chunk->_faces;
 
-        while (_scanner->GetCurrentToken() == Token::IDENTIFIER)
+        for (int j = 0; j < chunk->_relativeIndices.size(); ++j)
         {
-            _scanner->MatchToken(Token::IDENTIFIER);
+            const RelativeIndex &relativeIndex = chunk->_relativeIndices[j];
+            FaceCorner &corner = chunkFaces.corners[relativeIndex.corner];
+            if (relativeIndex.attribute == FaceAttribute::Vertex)
+                corner.vertex += result->_vertices.size();
+            else if (relativeIndex.attribute == FaceAttribute::UV)
+                corner.uv += result->_uvCoords.size();
+            else
+                corner.normal += result->_normals.size();
         }
+
+        loadMaterials(chunk, result);
+
+        // Local id 0 means the faces continue the material of the previous chunk
+        vector<IndexValue> globalMaterialIds(chunkFaces.materialNames.size(), currentMaterialId);
+        for (int j = 1; j < chunkFaces.materialNames.size(); ++j)
+        {
+            const string &name = chunkFaces.materialNames[j];
+            unordered_map<string, IndexValue>::iterator found = materialIds.find(name);
+            if (found == materialIds.end())
+            {
+                found = materialIds.insert(std::make_pair(name, (IndexValue)faces.materialNames.size())).first;
+                faces.materialNames.push_back(name);
+            }
+            globalMaterialIds[j] = found->second;
+        }
+
+        if (chunk->_currentMaterialId != 0)
+            currentMaterialId = globalMaterialIds[chunk->_currentMaterialId];
+
+        IndexValue cornerOffset = faces.corners.size();
+        for (int j = 0; j < chunkFaces.Size(); ++j)
+        {
+            faces.offsets.push_back(chunkFaces.offsets[j] + cornerOffset);
+            faces.materialIds.push_back(globalMaterialIds[chunkFaces.materialIds[j]]);
+        }
+        faces.counts.insert(faces.counts.end(), chunkFaces.counts.begin(), chunkFaces.counts.end());
+        faces.corners.insert(faces.corners.end(), chunkFaces.corners.begin(), chunkFaces.corners.end());
+
+        result->_vertices.insert(result->_vertices.end(), chunk->_vertices.begin(), chunk->_vertices.end());
+        result->_normals.insert(result->_normals.end(), chunk->_normals.begin(), chunk->_normals.end());
+        result->_uvCoords.insert(result->_uvCoords.end(), chunk->_uvCoords.begin(), chunk->_uvCoords.end());
     }
-    else if (_scanner->GetCurrentToken() == Token::SMOOTHING_GROUP)
+}
+
+// Indices can only be checked once every chunk before them is known
+void ObjFileParserImplementation::validateFace(const FaceCorner *corners, IndexValue cornerCount,
+                                               size_t vertexCount, size_t uvCount, size_t normalCount)
+{
+    for (IndexValue i = 0; i < cornerCount; ++i)
     {
-        _scanner->MatchToken(Token::SMOOTHING_GROUP);
+        const FaceCorner &corner = corners[i];
+        if (corner.vertex >= vertexCount ||
+            (corner.uv != NO_INDEX && corner.uv >= uvCount) ||
+            (corner.normal != NO_INDEX && corner.normal >= normalCount))
+        {
+            std::stringstream errorStream;
+            errorStream << "Obj parse error: face index out of range: " << _fileName;
+            throw std::runtime_error(errorStream.str());
+        }
+    }
+}
 
-        if (_scanner->GetCurrentToken() == Token::IDENTIFIER)
+void ObjFileParserImplementation::loadMaterials(ObjChunkParser *chunk, ObjParseResult *result, size_t firstDirective)
+{
+    for (size_t i = firstDirective; i < chunk->_materialDirectives.size(); ++i)
+    {
+        const MaterialDirective &directive = chunk->_materialDirectives[i];
+        if (directive.isLibrary)
         {
-            if (_scanner->GetTokenBuffer() == "off")
+            MtlFileParser mtlParser(_path, directive.name.c_str());
+            try
             {
-                _scanner->MatchToken(Token::IDENTIFIER);
+                mtlParser.Parse();
             }
-            else
+            catch (std::runtime_error &)
             {
-                std::stringstream errorStream;
-                errorStream << "Obj parse error: Expected \"off\": " << _fileName << " line: " << _scanner->GetLine();
-                throw std::runtime_error(errorStream.str());
+                // The parser does not own the materials it already read
+                vector<Material*> partialMaterials = mtlParser.GetMaterials();
+                for (int j = 0; j < partialMaterials.size(); ++j)
+                {
+                    delete partialMaterials[j];
+                }
+                throw;
             }
+            result->_materialLibraries.push_back(directive.name);
+
+            vector<Material*> newMaterials = mtlParser.GetMaterials();
+            result->_materials.insert(result->_materials.end(), newMaterials.begin(), newMaterials.end());
+            continue;
+        }
+
+        bool materialFound = false;
+        for (int j = 0; j < result->_materials.size(); ++j)
+        {
+            if (result->_materials[j]->name == directive.name)
+            {
+                materialFound = true;
+                break;
+            }
+        }
+
+        if (!materialFound)
+        {
+            std::stringstream errorStream;
+            errorStream << "Parse error: could not find referenced material: " << directive.name << " - " << _fileName << " line: " << directive.line;
+            throw std::runtime_error(errorStream.str());
         }
     }
-    else if (_scanner->GetCurrentToken() == Token::OBJECT_NAME_INDICATOR)
+}
+
+float ObjChunkParser::MatchValue()
+{
+    float value = _scanner.GetNumber().floatValue;
+    if (_scanner.GetCurrentToken() == Token::FLOAT_LITERAL)
+    {
+        _scanner.MatchToken(Token::FLOAT_LITERAL);
+    }
+    else if (_scanner.GetCurrentToken() == Token::INT_LITERAL)
     {
-        _scanner->MatchToken(Token::OBJECT_NAME_INDICATOR);
+        _scanner.MatchToken(Token::INT_LITERAL);
+    }
+    else
+    {
+        std::stringstream errorStream;
+        errorStream << "Obj parse error: Expected value type: " << _fileName << " line: " << _scanner.GetLine();
+        throw std::runtime_error(errorStream.str());
+    }
 
-        while (_scanner->GetCurrentToken() == Token::IDENTIFIER)
+    return value;
+}
+
+void ObjChunkParser::MatchValues(Token indicator, float *values, int count)
+{
+    if (_scanner.ScanValues(values, count))
+        return;
+
+    _scanner.MatchToken(indicator);
+    for (int i = 0; i < count; ++i)
+    {
+        values[i] = MatchValue();
+    }
+}
+
+void ObjChunkParser::MatchFaces()
+{
+    IndexValue cornerOffset = _faces.corners.size();
+    if (_scanner.ScanFaceCorners(_rawCorners))
+    {
+        for (size_t i = 0; i < _rawCorners.size(); ++i)
         {
-            _scanner->MatchToken(Token::IDENTIFIER);
+            const RawFaceCorner &rawCorner = _rawCorners[i];
+            FaceCorner corner = { NO_INDEX, NO_INDEX, NO_INDEX };
+            resolveFaceIndex(rawCorner.vertex, corner.vertex, FaceAttribute::Vertex, _vertices.size());
+            if (rawCorner.uv != NO_RAW_INDEX)
+                resolveFaceIndex(rawCorner.uv, corner.uv, FaceAttribute::UV, _uvCoords.size());
+            if (rawCorner.normal != NO_RAW_INDEX)
+                resolveFaceIndex(rawCorner.normal, corner.normal, FaceAttribute::Normal, _normals.size());
+
+            _faces.corners.push_back(corner);
         }
     }
-    else if (_scanner->GetCurrentToken() == Token::POLYGON_FACE_INDICATOR)
+    else
     {
-        Face face;
-        _scanner->MatchToken(Token::POLYGON_FACE_INDICATOR);
-        face.material = _currentMaterial;
-
-        while (_scanner->GetCurrentToken() != Token::NEWLINE)
+        _scanner.MatchToken(Token::POLYGON_FACE_INDICATOR);
+        while (_scanner.GetCurrentToken() != Token::NEWLINE && _scanner.GetCurrentToken() != Token::SCANEOF)
         {
-            face.vertexIndices.push_back(atoi(_scanner->GetTokenBuffer().c_str()) - 1);
-            _scanner->MatchToken(Token::INT_LITERAL);
+            FaceCorner corner = { NO_INDEX, NO_INDEX, NO_INDEX };
+            MatchFaceIndex(corner.vertex, FaceAttribute::Vertex, _vertices.size());
 
-            if (_scanner->GetCurrentToken() == Token::INDEX_SEPARATOR)
+            if (_scanner.GetCurrentToken() == Token::INDEX_SEPARATOR)
             {
-                _scanner->MatchToken(Token::INDEX_SEPARATOR);
+                _scanner.MatchToken(Token::INDEX_SEPARATOR);
 
-                if (_scanner->GetCurrentToken() == Token::INT_LITERAL)
-                {
-                    face.UVIndices.push_back(atoi(_scanner->GetTokenBuffer().c_str()) - 1);
-                    _scanner->MatchToken(Token::INT_LITERAL);
-                }
+                if (_scanner.GetCurrentToken() == Token::INT_LITERAL)
+                    MatchFaceIndex(corner.uv, FaceAttribute::UV, _uvCoords.size());
 
-                if (_scanner->GetCurrentToken() == Token::INDEX_SEPARATOR)
+                if (_scanner.GetCurrentToken() == Token::INDEX_SEPARATOR)
                 {
-                    _scanner->MatchToken(Token::INDEX_SEPARATOR);
-                    face.normalIndices.push_back(atoi(_scanner->GetTokenBuffer().c_str()) - 1);
-                    _scanner->MatchToken(Token::INT_LITERAL);
+                    _scanner.MatchToken(Token::INDEX_SEPARATOR);
+                    MatchFaceIndex(corner.normal, FaceAttribute::Normal, _normals.size());
                 }
             }
+
+            _faces.corners.push_back(corner);
         }
+    }
+
+    _faces.offsets.push_back(cornerOffset);
+    _faces.counts.push_back(_faces.corners.size() - cornerOffset);
+    _faces.materialIds.push_back(_currentMaterialId);
+}
+
+void ObjChunkParser::MatchFaceIndex(IndexValue &index, FaceAttribute attribute, size_t definedCount)
+{
+    int value = _scanner.GetNumber().intValue;
+    _scanner.MatchToken(Token::INT_LITERAL);
+    resolveFaceIndex(value, index, attribute, definedCount);
+}
+
+void ObjChunkParser::resolveFaceIndex(int value, IndexValue &index, FaceAttribute attribute, size_t definedCount)
+{
+    if (value < 0)
+    {
+        RelativeIndex relativeIndex = { _faces.corners.size(), attribute };
+        _relativeIndices.push_back(relativeIndex);
+        index = definedCount + value;
+    }
+    else
+    {
+        index = value - 1;
+    }
+}
 
-        _result->_faces.push_back(face);
+void ObjChunkParser::MatchLine()
+{
+    if (_scanner.GetCurrentToken() == Token::GEOMETRIC_VERTEX_INDICATOR)
+    {
+        Vertex vertex;
+        MatchValues(Token::GEOMETRIC_VERTEX_INDICATOR, vertex.coordinates, 3);
+        vertex.coordinates[3] = 1.0;
+
+        _vertices.push_back(vertex);
     }
-    else if (_scanner->GetCurrentToken() == Token::MATERIAL_NAME)
+    else if (_scanner.GetCurrentToken() == Token::VERTEX_NORMAL_INDICATOR)
     {
-        _scanner->MatchToken(Token::MATERIAL_NAME);
-        _currentMaterial = _scanner->GetTokenBuffer();
-        bool materialFound = false;
+        Normal normal;
+        MatchValues(Token::VERTEX_NORMAL_INDICATOR, normal.coordinates, 3);
+
+        _normals.push_back(normal);
+    }
+    else if (_scanner.GetCurrentToken() == Token::VERTEX_TEXTURE_INDICATOR)
+    {
+        UVCoord uvCoord;
+        MatchValues(Token::VERTEX_TEXTURE_INDICATOR, uvCoord.coordinates, 2);
 
-        for (int i = 0; i < _result->_materials.size(); ++i)
+        _uvCoords.push_back(uvCoord);
+    }
+    else if (_scanner.GetCurrentToken() == Token::GROUP_INDICATOR)
+    {
+        _scanner.MatchToken(Token::GROUP_INDICATOR);
+
+        while (_scanner.GetCurrentToken() == Token::IDENTIFIER)
         {
-            if (_result->_materials[i]->name == _currentMaterial)
+            _scanner.MatchToken(Token::IDENTIFIER);
+        }
+    }
+    else if (_scanner.GetCurrentToken() == Token::SMOOTHING_GROUP)
+    {
+        _scanner.MatchToken(Token::SMOOTHING_GROUP);
+
+        if (_scanner.GetCurrentToken() == Token::IDENTIFIER)
+        {
+            if (_scanner.GetTokenBuffer() == "off")
             {
-                materialFound = true;
-                break;
+                _scanner.MatchToken(Token::IDENTIFIER);
             }
+            else
+            {
+                std::stringstream errorStream;
+                errorStream << "Obj parse error: Expected \"off\": " << _fileName << " line: " << _scanner.GetLine();
+                throw std::runtime_error(errorStream.str());
+            }
+        }
+    }
+    else if (_scanner.GetCurrentToken() == Token::OBJECT_NAME_INDICATOR)
+    {
+        _scanner.MatchToken(Token::OBJECT_NAME_INDICATOR);
+
+        while (_scanner.GetCurrentToken() == Token::IDENTIFIER)
+        {
+            _scanner.MatchToken(Token::IDENTIFIER);
         }
+    }
+    else if (_scanner.GetCurrentToken() == Token::POLYGON_FACE_INDICATOR)
+    {
+        MatchFaces();
+    }
+    else if (_scanner.GetCurrentToken() == Token::MATERIAL_NAME)
+    {
+        _scanner.MatchToken(Token::MATERIAL_NAME);
+        string name = _scanner.GetTokenBuffer();
 
-        if (!materialFound)
+        unordered_map<string, IndexValue>::iterator found = _materialIds.find(name);
+        if (found == _materialIds.end())
         {
-            std::stringstream errorStream;
-            errorStream << "Parse error: could not find referenced material: " << _currentMaterial << " - " << _fileName << " line: " << _scanner->GetLine();
-            throw std::runtime_error(errorStream.str());
+            found = _materialIds.insert(std::make_pair(name, (IndexValue)_faces.materialNames.size())).first;
+            _faces.materialNames.push_back(name);
         }
+        _currentMaterialId = found->second;
+
+        MaterialDirective directive = { false, name, _scanner.GetLine() };
+        _materialDirectives.push_back(directive);
 
-        _scanner->MatchToken(Token::IDENTIFIER);
+        _scanner.MatchToken(Token::IDENTIFIER);
     }
-    else if (_scanner->GetCurrentToken() == Token::MATERIAL_LIBRARY_INDICATOR)
+    else if (_scanner.GetCurrentToken() == Token::MATERIAL_LIBRARY_INDICATOR)
     {
-        _scanner->MatchToken(Token::MATERIAL_LIBRARY_INDICATOR);
-        string fileName = _scanner->GetTokenBuffer();
-        _scanner->MatchToken(Token::FILENAME);            
+        _scanner.MatchToken(Token::MATERIAL_LIBRARY_INDICATOR);
 
-        MtlFileParser mtlParser(_path, fileName.c_str());
-        mtlParser.Parse();
+        MaterialDirective directive = { true, _scanner.GetTokenBuffer(), _scanner.GetLine() };
+        _materialDirectives.push_back(directive);
 
-        vector<Material*> newMaterials = mtlParser.GetMaterials();
-        _result->_materials.reserve(_result->_materials.size() + newMaterials.size());
-        _result->_materials.insert(_result->_materials.end(), newMaterials.begin(), newMaterials.end());
+        _scanner.MatchToken(Token::FILENAME);
     }
 
-    _scanner->MatchToken(Token::NEWLINE);
+    if (_scanner.GetCurrentToken() != Token::SCANEOF)
+        _scanner.MatchToken(Token::NEWLINE);
 }
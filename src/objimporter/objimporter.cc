@@ -5,10 +5,15 @@
 
 #include "types.hh"
 #include "objimporter.hh"
+#include "imagecache.hh"
 #include "imageloader.hh"
+#include "texturecompression.hh"
 
-RawImageInfo *LoadImage(const std::string &fileName)
+static RawImageInfo *LoadImage(const std::string &fileName)
 {
+    if (fileName.size() < 4)
+        return NULL;
+
     std::string extension = fileName.substr(fileName.size() - 4, 4);
     if (extension == ".png")
         return LoadImageFromPNG(fileName);
@@ -17,32 +22,42 @@ RawImageInfo *LoadImage(const std::string &fileName)
     return NULL;
 }
 
-MaterialInfo ObjImporter::translateMaterial(ObjParser::Material *material)
+static RawImageInfo *LoadCookedImage(const std::string &fileName)
+{
+    return LoadTextureCached(fileName, LoadImage);
+}
+
+static ImageHandle *LoadMap(const std::string &fileName)
+{
+    return fileName.empty() ? NULL : ImageCache::GetInstance()->LoadAsync(fileName, LoadCookedImage);
+}
+
+static glm::vec3 TranslateColor(const ObjParser::ColorValue &color)
+{
+    return glm::vec3(color.red, color.green, color.blue);
+}
+
+MaterialInfo TranslateObjMaterial(const ObjParser::Material &material)
 {
     MaterialInfo info;
 
-    info.Ka = translateColor(material->ambientColor);
-    info.Kd = translateColor(material->diffuseColor);
-    info.Ks = translateColor(material->specularColor);
-    info.shininess = 0.5;
+    info.Ka = TranslateColor(material.ambientColor);
+    info.Kd = TranslateColor(material.diffuseColor);
+    info.Ks = TranslateColor(material.specularColor);
+    info.shininess = material.specularExponent;
 
-    info.Kd_imageInfo = material->diffuseMap.empty() ? NULL : LoadImage(material->diffuseMap);
+    info.Kd_image = LoadMap(material.diffuseMap);
+    info.Ks_image = LoadMap(material.specularMap);
+    info.normal_image = LoadMap(material.bumpMap);
     
     return info;
 }
 
 MaterialInfo ObjImporter::GetMaterial(const std::string &name)
 {
-    std::vector<ObjParser::Material*> materials = _parseResult->GetMaterials();
-    ObjParser::Material *material = NULL;
-
-    for (int i = 0; i < materials.size(); ++i)
-    {
-        if (materials[i]->name == name)
-        {
-            return translateMaterial(materials[i]);
-        }
-    }
+    std::unordered_map<std::string, size_t>::iterator found = _materialIndices.find(name);
+    if (found != _materialIndices.end())
+        return TranslateObjMaterial(_materials[found->second]);
 
     std::stringstream errorStream;
     errorStream << "Runtime error: unable to find material in parse result: " << name;
@@ -1,124 +1,118 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <glm/glm.hpp>
 
 #include "GL/gl_core_3_3.h"
 
 #include "rendering/irenderer.hh"
+#include "meshcache.hh"
+#include "meshcompression.hh"
 #include "objparser.hh"
 #include "types.hh"
 
-class ObjImporter
+// Fan-triangulates faces into unwelded render buffers, one vertex per corner
+class RenderObjectBuilder
 {
 public:
-    ObjImporter(ObjParser::IParseResult *result)
-        : _parseResult(result)
+    void Reserve(size_t cornerCount, bool hasUVs)
     {
-        translateAllVertices();
+        _indices.reserve(cornerCount);
+        _vertices.reserve(cornerCount * 4);
+        _normals.reserve(cornerCount * 3);
+        if (hasUVs)
+            _uvCoords.reserve(cornerCount * 2);
     }
 
-    std::vector<RenderObject> GetRenderObjects()
+    void AddFace(const std::vector<ObjParser::Vertex> &vertices,
+                 const std::vector<ObjParser::Normal> &normals,
+                 const std::vector<ObjParser::UVCoord> &uvCoords,
+                 const ObjParser::FaceCorner *corners,
+                 IndexValue cornerCount)
     {
-        return _renderObjects;
+        ObjParser::Normal faceNormal = calculateFaceNormal(vertices, corners, cornerCount);
+
+        // Triangulate as a fan around the first corner
+        for (int j = 2; j < cornerCount; ++j)
+        {
+            addCorner(corners[0], vertices, normals, uvCoords, faceNormal);
+            addCorner(corners[j - 1], vertices, normals, uvCoords, faceNormal);
+            addCorner(corners[j], vertices, normals, uvCoords, faceNormal);
+        }
     }
 
-    MaterialInfo GetMaterial(const std::string &name);
+    size_t GetTriangleCount() const
+    {
+        return _indices.size() / 3;
+    }
 
-private:
-    ObjParser::IParseResult *_parseResult;
+    // Moves the buffers into a render object, leaving the builder empty
+    RenderObject TakeRenderObject(const std::string &materialName)
+    {
+        RenderObject renderObject;
+
+        renderObject._indices.swap(_indices);
+        renderObject._vertices.swap(_vertices);
+        renderObject._normals.swap(_normals);
+        renderObject._uvCoords.swap(_uvCoords);
+        renderObject._materialName = materialName;
+
+        return renderObject;
+    }
 
+private:
     std::vector<IndexValue> _indices;
     std::vector<float> _vertices;
     std::vector<float> _normals;
     std::vector<float> _uvCoords;
-    std::string _currentMaterial;
-
-    std::vector<RenderObject> _renderObjects;
 
 private:
-    void translateAllVertices()
+    void addCorner(const ObjParser::FaceCorner &corner,
+                   const std::vector<ObjParser::Vertex> &vertices,
+                   const std::vector<ObjParser::Normal> &normals,
+                   const std::vector<ObjParser::UVCoord> &uvCoords,
+                   const ObjParser::Normal &faceNormal)
     {
-        _vertices.clear();
-        _normals.clear();
-
-        std::vector<ObjParser::Face> faces = _parseResult->GetFaces();
-        std::vector<ObjParser::Vertex> vertices = _parseResult->GetVertices();
-        std::vector<ObjParser::Normal> normals = _parseResult->GetNormals();
-        std::vector<ObjParser::UVCoord> uvCoords = _parseResult->GetUVCoords();
-
-        _currentMaterial = faces[0].material;
+        _indices.push_back(_indices.size());
+        addVertex(vertices[corner.vertex]);
+        addNormal(corner.normal == ObjParser::NO_INDEX ? faceNormal : normals[corner.normal]);
 
-        for (int i = 0; i < faces.size(); ++i)
-        {
-            ObjParser::Face face = faces[i];
-            if (face.material != _currentMaterial)
-            {
-                _renderObjects.push_back(MakeRenderObjectFromCurrentState());
-                ClearCurrentState();
-                _currentMaterial = face.material;
-            }
-
-            for (int j = 0; j < face.normalIndices.size(); ++j)
-            {
-                if (j >= 3)
-                {
-                    _indices.push_back(face.vertexIndices.size()*i + j - 3);
-                    _indices.push_back(face.vertexIndices.size()*i + j - 1);
-                    addNormal(normals[face.normalIndices[j-3]]);
-                    addVertex(vertices[face.vertexIndices[j-3]]);
-                    addNormal(normals[face.normalIndices[j-1]]);
-                    addVertex(vertices[face.vertexIndices[j-1]]);
-
-                    if (face.UVIndices.size() > 0)
-                    {
-                        addUVCoord(uvCoords[face.UVIndices[j-3]]);
-                        addUVCoord(uvCoords[face.UVIndices[j-1]]);
-                    }
-                }
-
-                if (face.UVIndices.size() > 0)
-                    addUVCoord(uvCoords[face.UVIndices[j]]);
-
-                _indices.push_back(face.vertexIndices.size()*i + j);
-                addNormal(normals[face.normalIndices[j]]);
-                addVertex(vertices[face.vertexIndices[j]]);
-            }
-        }
-
-        _renderObjects.push_back(MakeRenderObjectFromCurrentState());
+        if (corner.uv != ObjParser::NO_INDEX)
+            addUVCoord(uvCoords[corner.uv]);
     }
 
-    void ClearCurrentState()
+    ObjParser::Normal calculateFaceNormal(const std::vector<ObjParser::Vertex> &vertices,
+                                          const ObjParser::FaceCorner *corners,
+                                          IndexValue cornerCount)
     {
-        _indices.clear();
-        _vertices.clear();
-        _normals.clear();
-        _uvCoords.clear();
-        _currentMaterial.clear();
-    }
+        ObjParser::Normal normal = { { 0.0f, 0.0f, 0.0f } };
+        if (cornerCount < 3 || corners[0].normal != ObjParser::NO_INDEX)
+            return normal;
 
-    RenderObject MakeRenderObjectFromCurrentState()
-    {
-        RenderObject renderObject;
+        glm::vec3 first = glm::vec3(translateVertex(vertices[corners[0].vertex]));
+        glm::vec3 second = glm::vec3(translateVertex(vertices[corners[1].vertex]));
+        glm::vec3 third = glm::vec3(translateVertex(vertices[corners[2].vertex]));
+        glm::vec3 cross = glm::cross(second - first, third - first);
+        if (glm::length(cross) > 0.0f)
+            cross = glm::normalize(cross);
 
-        renderObject._indices = _indices;
-        renderObject._vertices = _vertices;
-        renderObject._normals = _normals;
-        renderObject._uvCoords = _uvCoords;
-        renderObject._materialName = _currentMaterial;
+        for (int i = 0; i < 3; ++i)
+        {
+            normal.coordinates[i] = cross[i];
+        }
 
-        return renderObject;
+        return normal;
     }
 
-    void addUVCoord(ObjParser::UVCoord uvCoord)
+    void addUVCoord(const ObjParser::UVCoord &uvCoord)
     {
         _uvCoords.push_back(uvCoord.coordinates[0]);
         _uvCoords.push_back(uvCoord.coordinates[1]);
     }
 
-    void addVertex(ObjParser::Vertex vertex)
+    void addVertex(const ObjParser::Vertex &vertex)
     {
         for (int i = 0; i < 4; ++i)
         {
@@ -126,7 +120,7 @@ private:
         }
     }
 
-    void addNormal(ObjParser::Normal normal)
+    void addNormal(const ObjParser::Normal &normal)
     {
         for (int i = 0; i < 3; ++i)
         {
@@ -134,20 +128,126 @@ private:
         }
     }
 
-    MaterialInfo translateMaterial(ObjParser::Material *material);
+    glm::vec4 translateVertex(const ObjParser::Vertex &vertex)
+    {
+        return glm::vec4(vertex.coordinates[0], vertex.coordinates[1], vertex.coordinates[2], vertex.coordinates[3]);
+    }
+};
+
+// Shared with StreamingObjImporter; queues texture decodes on the ImageCache
+MaterialInfo TranslateObjMaterial(const ObjParser::Material &material);
+
+class ObjImporter
+{
+public:
+    ObjImporter(ObjParser::IParseResult *result)
+        : _parseResult(result)
+    {
+        translateAllVertices();
+        copyMaterials();
+        indexMaterials();
+    }
+
+    ObjImporter(CookedMesh mesh)
+        : _parseResult(NULL)
+    {
+        _renderObjects.reserve(mesh.renderObjects.size());
+        for (int i = 0; i < mesh.renderObjects.size(); ++i)
+        {
+            _renderObjects.push_back(DecompressRenderObject(mesh.renderObjects[i]));
+        }
+        _materials.swap(mesh.materials);
+        indexMaterials();
+    }
+
+    const std::vector<RenderObject> &GetRenderObjects() const
+    {
+        return _renderObjects;
+    }
 
-    glm::vec3 translateColor(ObjParser::ColorValue color)
+    // Hands the render buffers to the caller, leaving the importer empty
+    std::vector<RenderObject> TakeRenderObjects()
     {
-        return glm::vec3(color.red, color.green, color.blue);
+        std::vector<RenderObject> renderObjects;
+        renderObjects.swap(_renderObjects);
+        return renderObjects;
     }
 
-    glm::vec3 translateNormal(ObjParser::Normal vertex)
+    const std::vector<ObjParser::Material> &GetMaterials() const
     {
-        return glm::vec3(vertex.coordinates[0], vertex.coordinates[1], vertex.coordinates[2]);
+        return _materials;
     }
 
-    glm::vec4 translateVertex(ObjParser::Vertex vertex)
+    MaterialInfo GetMaterial(const std::string &name);
+
+private:
+    ObjParser::IParseResult *_parseResult;
+
+    RenderObjectBuilder _builder;
+    std::vector<RenderObject> _renderObjects;
+    std::vector<ObjParser::Material> _materials;
+    std::unordered_map<std::string, size_t> _materialIndices;
+
+private:
+    void indexMaterials()
     {
-        return glm::vec4(vertex.coordinates[0], vertex.coordinates[1], vertex.coordinates[2], vertex.coordinates[3]);
+        for (size_t i = 0; i < _materials.size(); ++i)
+        {
+            _materialIndices[_materials[i].name] = i;
+        }
+    }
+
+    void copyMaterials()
+    {
+        const std::vector<ObjParser::Material*> &materials = _parseResult->GetMaterials();
+        for (int i = 0; i < materials.size(); ++i)
+        {
+            _materials.push_back(*materials[i]);
+        }
+    }
+
+    void translateAllVertices()
+    {
+        const ObjParser::FaceList &faces = _parseResult->GetFaces();
+        const std::vector<ObjParser::Vertex> &vertices = _parseResult->GetVertices();
+        const std::vector<ObjParser::Normal> &normals = _parseResult->GetNormals();
+        const std::vector<ObjParser::UVCoord> &uvCoords = _parseResult->GetUVCoords();
+
+        if (faces.Size() == 0)
+            return;
+
+        IndexValue currentMaterialId = faces.materialIds[0];
+        reserveCurrentState(faces, 0);
+
+        for (int i = 0; i < faces.Size(); ++i)
+        {
+            if (faces.materialIds[i] != currentMaterialId)
+            {
+                _renderObjects.push_back(_builder.TakeRenderObject(faces.materialNames[currentMaterialId]));
+                currentMaterialId = faces.materialIds[i];
+                reserveCurrentState(faces, i);
+            }
+
+            _builder.AddFace(vertices, normals, uvCoords, faces.corners.data() + faces.offsets[i], faces.counts[i]);
+        }
+
+        _renderObjects.push_back(_builder.TakeRenderObject(faces.materialNames[currentMaterialId]));
+    }
+
+    // Sizes the buffers for the run of faces sharing the material of firstFace
+    void reserveCurrentState(const ObjParser::FaceList &faces, size_t firstFace)
+    {
+        size_t cornerCount = 0;
+        bool hasUVs = false;
+        for (size_t i = firstFace; i < faces.Size() && faces.materialIds[i] == faces.materialIds[firstFace]; ++i)
+        {
+            if (faces.counts[i] >= 3)
+            {
+                cornerCount += (faces.counts[i] - 2) * 3;
+                hasUVs = hasUVs || faces.corners[faces.offsets[i]].uv != ObjParser::NO_INDEX;
+            }
+        }
+
+        _builder.Reserve(cornerCount, hasUVs);
     }
 };
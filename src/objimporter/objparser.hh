@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string>
 #include <vector>
 
 #include "types.hh"
@@ -10,12 +11,32 @@ namespace ObjParser
     class IParseResult
     {
     public:
-        virtual std::vector<Vertex> GetVertices() const = 0;
-        virtual std::vector<Normal> GetNormals() const = 0;
-        virtual std::vector<UVCoord> GetUVCoords() const = 0;
-        virtual std::vector<IndexValue> GetIndices() const = 0;
-        virtual std::vector<Face> GetFaces() const = 0;
-        virtual std::vector<Material*> GetMaterials() const = 0;
+        virtual ~IParseResult() {}
+
+        virtual const std::vector<Vertex> &GetVertices() const = 0;
+        virtual const std::vector<Normal> &GetNormals() const = 0;
+        virtual const std::vector<UVCoord> &GetUVCoords() const = 0;
+        virtual const FaceList &GetFaces() const = 0;
+        virtual const std::vector<Material*> &GetMaterials() const = 0;
+        virtual const std::vector<std::string> &GetMaterialLibraries() const = 0;
+    };
+
+    class IFaceListener
+    {
+    public:
+        virtual ~IFaceListener() {}
+
+        // Called for each material as its library is loaded, before any face uses it
+        virtual void OnMaterial(const Material &material) = 0;
+
+        // The attribute arrays hold everything parsed so far; they and the
+        // corners are only valid during the call
+        virtual void OnFace(const std::vector<Vertex> &vertices,
+                            const std::vector<Normal> &normals,
+                            const std::vector<UVCoord> &uvCoords,
+                            const FaceCorner *corners,
+                            IndexValue cornerCount,
+                            const std::string &materialName) = 0;
     };
 
     class ObjFileParser
@@ -26,6 +47,9 @@ namespace ObjParser
         public:
             virtual ~IObjFileParserImplementation() {}
             virtual IParseResult *Parse() = 0;
+            virtual IParseResult *ParseParallel(unsigned int chunkCount) = 0;
+            virtual IParseResult *ParseStreaming(IFaceListener *listener) = 0;
+            virtual IParseResult *ParseBuffer(const char *data, size_t size) = 0;
         };
 
     public:
@@ -33,6 +57,19 @@ namespace ObjParser
         ~ObjFileParser();
 
         IParseResult *Parse();
+
+        // Splits the file at line boundaries and parses the pieces on
+        // separate threads; the result matches Parse()
+        IParseResult *ParseParallel(unsigned int chunkCount);
+
+        // Hands each face to the listener as soon as it is read instead of
+        // storing it, so the result holds everything except the faces
+        IParseResult *ParseStreaming(IFaceListener *listener);
+
+        // Parses the size bytes at data instead of reading the file; the file
+        // name given to the constructor is only used in error messages, and
+        // material libraries still load from its path
+        IParseResult *ParseBuffer(const char *data, size_t size);
     
     private:
         IObjFileParserImplementation *_implementation;
@@ -20,6 +20,8 @@ namespace ObjParser
         ColorValue specularColor;
         float specularExponent;
         std::string diffuseMap;
+        std::string specularMap;
+        std::string bumpMap;
     } Material;
 
     typedef struct Vertex
@@ -37,11 +39,33 @@ namespace ObjParser
         float coordinates[2];
     } UVCoords;
 
-    typedef struct Face
+    static const IndexValue NO_INDEX = 0xffffffff;
+
+    typedef struct FaceCorner
+    {
+        IndexValue vertex;
+        IndexValue uv;
+        IndexValue normal;
+    } FaceCorner;
+
+    // Face i uses corners [offsets[i], offsets[i] + counts[i]) and the
+    // material materialNames[materialIds[i]]; id 0 is "no material"
+    typedef struct FaceList
     {
-        std::vector<IndexValue> vertexIndices;
-        std::vector<IndexValue> normalIndices;
-        std::vector<IndexValue> UVIndices;
-        std::string material;
-    } Face;
+        FaceList()
+            : materialNames(1)
+        {
+        }
+
+        size_t Size() const
+        {
+            return offsets.size();
+        }
+
+        std::vector<FaceCorner> corners;
+        std::vector<IndexValue> offsets;
+        std::vector<IndexValue> counts;
+        std::vector<IndexValue> materialIds;
+        std::vector<std::string> materialNames;
+    } FaceList;
 }
@@ -0,0 +1,208 @@
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "streamingobjimporter.hh"
+
+using std::string;
+using std::vector;
+
+static const int STREAMING_WAIT_MILLISECONDS = 10;
+
+// Unwinds the parser on the worker thread when the importer is destroyed early
+typedef struct ImportCancelled
+{
+} ImportCancelled;
+
+StreamingObjImporter::StreamingObjImporter(const string &path,
+                                           const string &fileName,
+                                           size_t batchTriangles,
+                                           size_t maxQueuedBatches)
+    : _path(path), _fileName(fileName), _batchTriangles(batchTriangles), _maxQueuedBatches(maxQueuedBatches),
+      _mutex(System::Mutex::Create()), _batchQueued(System::Event::Create(NULL)), _batchTaken(System::Event::Create(NULL)),
+      _worker(NULL), _parsed(false), _cancelled(false)
+{
+    _worker = new System::thread([this]() { run(); });
+}
+
+StreamingObjImporter::~StreamingObjImporter()
+{
+    _mutex->Lock();
+    _cancelled = true;
+    _mutex->Unlock();
+    _batchTaken->Trigger();
+
+    _worker->join();
+    delete _worker;
+
+    delete _batchTaken;
+    delete _batchQueued;
+    delete _mutex;
+}
+
+bool StreamingObjImporter::TryGetBatch(RenderObject &batch)
+{
+    bool finished;
+    return takeBatch(batch, finished);
+}
+
+bool StreamingObjImporter::WaitForBatch(RenderObject &batch)
+{
+    bool finished = false;
+    while (!takeBatch(batch, finished))
+    {
+        if (finished)
+            return false;
+
+        _batchQueued->Wait(STREAMING_WAIT_MILLISECONDS);
+    }
+
+    return true;
+}
+
+bool StreamingObjImporter::IsFinished()
+{
+    _mutex->Lock();
+    bool finished = _parsed && _batches.empty();
+    _mutex->Unlock();
+
+    return finished;
+}
+
+bool StreamingObjImporter::takeBatch(RenderObject &batch, bool &finished)
+{
+    _mutex->Lock();
+
+    if (!_error.empty())
+    {
+        string error = _error;
+        _mutex->Unlock();
+        throw std::runtime_error(error);
+    }
+
+    finished = _parsed;
+    if (_batches.empty())
+    {
+        _mutex->Unlock();
+        return false;
+    }
+
+    std::swap(batch, _batches.front());
+    _batches.pop_front();
+    _mutex->Unlock();
+
+    _batchTaken->Trigger();
+    return true;
+}
+
+void StreamingObjImporter::run()
+{
+    BatchListener listener(this);
+
+    try
+    {
+        ObjParser::ObjFileParser parser(_path.c_str(), _fileName.c_str());
+        delete parser.ParseStreaming(&listener);
+        listener.Flush();
+    }
+    catch (ImportCancelled &)
+    {
+    }
+    catch (std::exception &error)
+    {
+        _mutex->Lock();
+        _error = error.what();
+        _mutex->Unlock();
+    }
+
+    _mutex->Lock();
+    _parsed = true;
+    _mutex->Unlock();
+    _batchQueued->Trigger();
+}
+
+void StreamingObjImporter::pushBatch(RenderObject &batch)
+{
+    for (;;)
+    {
+        _mutex->Lock();
+
+        if (_cancelled)
+        {
+            _mutex->Unlock();
+            throw ImportCancelled();
+        }
+
+        if (_batches.size() < _maxQueuedBatches)
+        {
+            _batches.push_back(RenderObject());
+            std::swap(_batches.back(), batch);
+            _mutex->Unlock();
+
+            _batchQueued->Trigger();
+            return;
+        }
+
+        _mutex->Unlock();
+        _batchTaken->Wait(STREAMING_WAIT_MILLISECONDS);
+    }
+}
+
+void StreamingObjImporter::addMaterial(const ObjParser::Material &material)
+{
+    _mutex->Lock();
+    _materialIndices[material.name] = _materials.size();
+    _materials.push_back(material);
+    _mutex->Unlock();
+}
+
+ObjParser::Material StreamingObjImporter::findMaterial(const string &name)
+{
+    _mutex->Lock();
+
+    std::unordered_map<string, size_t>::iterator found = _materialIndices.find(name);
+    if (found != _materialIndices.end())
+    {
+        ObjParser::Material material = _materials[found->second];
+        _mutex->Unlock();
+        return material;
+    }
+
+    _mutex->Unlock();
+
+    std::stringstream errorStream;
+    errorStream << "Runtime error: unable to find material in streamed OBJ file: " << name;
+    throw std::runtime_error(errorStream.str());
+}
+
+void StreamingObjImporter::BatchListener::OnMaterial(const ObjParser::Material &material)
+{
+    _importer->addMaterial(material);
+}
+
+void StreamingObjImporter::BatchListener::OnFace(const vector<ObjParser::Vertex> &vertices,
+                                                 const vector<ObjParser::Normal> &normals,
+                                                 const vector<ObjParser::UVCoord> &uvCoords,
+                                                 const ObjParser::FaceCorner *corners,
+                                                 IndexValue cornerCount,
+                                                 const string &materialName)
+{
+    size_t triangleCount = cornerCount >= 3 ? cornerCount - 2 : 0;
+    if (materialName != _materialName || _builder.GetTriangleCount() + triangleCount > _importer->_batchTriangles)
+        Flush();
+
+    _materialName = materialName;
+    _builder.AddFace(vertices, normals, uvCoords, corners, cornerCount);
+}
+
+void StreamingObjImporter::BatchListener::Flush()
+{
+    if (_builder.GetTriangleCount() == 0)
+        return;
+
+    RenderObject batch = _builder.TakeRenderObject(_materialName);
+    _importer->pushBatch(batch);
+}
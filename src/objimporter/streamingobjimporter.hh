@@ -0,0 +1,97 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <system/event.hh>
+#include <system/mutex.hh>
+#include <system/thread.hh>
+
+#include "rendering/irenderer.hh"
+#include "objimporter.hh"
+#include "objparser.hh"
+
+const size_t STREAMING_BATCH_TRIANGLES = 16384;
+const size_t STREAMING_MAX_QUEUED_BATCHES = 4;
+
+// Parses and triangulates an OBJ file on a worker thread and queues the
+// result as render objects of at most batchTriangles triangles, split at
+// material changes. The worker waits while maxQueuedBatches are pending,
+// so memory grows with the vertex data and the batch size, not the face
+// count.
+class StreamingObjImporter
+{
+public:
+    StreamingObjImporter(const std::string &path,
+                         const std::string &fileName,
+                         size_t batchTriangles = STREAMING_BATCH_TRIANGLES,
+                         size_t maxQueuedBatches = STREAMING_MAX_QUEUED_BATCHES);
+    ~StreamingObjImporter();
+
+    // Moves the oldest pending batch into batch; returns false if none is
+    // ready yet. Parse errors from the worker are rethrown here.
+    bool TryGetBatch(RenderObject &batch);
+
+    // Blocks until a batch is ready; returns false once the file is done
+    bool WaitForBatch(RenderObject &batch);
+
+    bool IsFinished();
+
+    MaterialInfo GetMaterial(const std::string &name)
+    {
+        return TranslateObjMaterial(findMaterial(name));
+    }
+
+private:
+    class BatchListener : public ObjParser::IFaceListener
+    {
+    public:
+        BatchListener(StreamingObjImporter *importer)
+            : _importer(importer)
+        {
+        }
+
+        void OnMaterial(const ObjParser::Material &material);
+        void OnFace(const std::vector<ObjParser::Vertex> &vertices,
+                    const std::vector<ObjParser::Normal> &normals,
+                    const std::vector<ObjParser::UVCoord> &uvCoords,
+                    const ObjParser::FaceCorner *corners,
+                    IndexValue cornerCount,
+                    const std::string &materialName);
+
+        void Flush();
+
+    private:
+        StreamingObjImporter *_importer;
+        RenderObjectBuilder _builder;
+        std::string _materialName;
+    };
+
+private:
+    std::string _path;
+    std::string _fileName;
+    size_t _batchTriangles;
+    size_t _maxQueuedBatches;
+
+    System::Mutex *_mutex;
+    System::Event *_batchQueued;
+    System::Event *_batchTaken;
+    System::thread *_worker;
+
+    // Guarded by _mutex
+    std::deque<RenderObject> _batches;
+    std::vector<ObjParser::Material> _materials;
+    std::unordered_map<std::string, size_t> _materialIndices;
+    std::string _error;
+    bool _parsed;
+    bool _cancelled;
+
+private:
+    void run();
+    void pushBatch(RenderObject &batch);
+    void addMaterial(const ObjParser::Material &material);
+    ObjParser::Material findMaterial(const std::string &name);
+    bool takeBatch(RenderObject &batch, bool &finished);
+};
@@ -0,0 +1,32 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "textbuffer.hh"
+
+bool ReadFileContents(const std::string &fileName, std::vector<char> &contents)
+{
+    FILE *file = fopen(fileName.c_str(), "rb");
+    if (file == NULL)
+        return false;
+
+    // Some platforms open directories too, with a bogus size
+    struct stat status;
+    if (fstat(fileno(file), &status) != 0 || !S_ISREG(status.st_mode))
+    {
+        fclose(file);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    contents.resize(size);
+    bool success = size == 0 || fread(contents.data(), size, 1, file) == 1;
+    fclose(file);
+
+    return success;
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Non-owning view of characters inside a TextBuffer
+typedef struct StringRange
+{
+    const char *begin;
+    const char *end;
+
+    size_t Size() const
+    {
+        return end - begin;
+    }
+
+    bool Equals(const char *s) const
+    {
+        size_t length = strlen(s);
+        return Size() == length && memcmp(begin, s, length) == 0;
+    }
+
+    std::string ToString() const
+    {
+        return std::string(begin, end);
+    }
+} StringRange;
+
+bool ReadFileContents(const std::string &fileName, std::vector<char> &contents);
+
+inline bool IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool IsAlphaNumeric(char c)
+{
+    return IsDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+inline double GetPowerOfTen(int exponent)
+{
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    if (exponent < (int)(sizeof(powers) / sizeof(powers[0])))
+        return powers[exponent];
+
+    return std::pow(10.0, exponent);
+}
+
+// A number as both ParseFloat and ParseInt read it
+typedef struct NumberValue
+{
+    float floatValue;
+    // Indices that large are rejected as out of range anyway
+    int intValue;
+    // Whether a fraction or an exponent was present
+    bool isFloat;
+} NumberValue;
+
+inline const char *ParseExponent(const char *current, const char *end, int &exponent)
+{
+    bool negative = false;
+    if (current != end && (*current == '-' || *current == '+'))
+    {
+        negative = *current == '-';
+        ++current;
+    }
+
+    int value = 0;
+    for (; current != end && IsDigit(*current); ++current)
+    {
+        if (value < 10000)
+            value = value * 10 + (*current - '0');
+    }
+
+    exponent += negative ? -value : value;
+    return current;
+}
+
+inline float GetScaledValue(unsigned long long mantissa, int exponent, bool negative)
+{
+    double value = (double)mantissa;
+    if (exponent < 0)
+        value /= GetPowerOfTen(-exponent);
+    else if (exponent > 0)
+        value *= GetPowerOfTen(exponent);
+
+    return (float)(negative ? -value : value);
+}
+
+// Handles numbers with more digits than fit in the mantissa, keeping the
+// first 19 significant ones
+inline const char *ParseLongNumber(const char *current, const char *end, bool negative, NumberValue &number)
+{
+    unsigned long long mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    int intValue = 0;
+
+    for (; current != end && IsDigit(*current); ++current)
+    {
+        int digit = *current - '0';
+        intValue = intValue > (INT_MAX - digit) / 10 ? INT_MAX : intValue * 10 + digit;
+
+        if (significantDigits < 19)
+        {
+            mantissa = mantissa * 10 + digit;
+            if (mantissa != 0)
+                ++significantDigits;
+        }
+        else
+        {
+            ++exponent;
+        }
+    }
+
+    if (current != end && *current == '.')
+    {
+        number.isFloat = true;
+        for (++current; current != end && IsDigit(*current); ++current)
+        {
+            if (significantDigits < 19)
+            {
+                mantissa = mantissa * 10 + (*current - '0');
+                if (mantissa != 0)
+                    ++significantDigits;
+                --exponent;
+            }
+        }
+    }
+
+    if (current != end && (*current == 'e' || *current == 'E'))
+    {
+        number.isFloat = true;
+        current = ParseExponent(current + 1, end, exponent);
+    }
+
+    number.floatValue = GetScaledValue(mantissa, exponent, negative);
+    number.intValue = negative ? -intValue : intValue;
+
+    return current;
+}
+
+// Locale-independent replacement for atof and atoi in a single pass. Reads
+// the number at the start of [begin, end) and returns where it stops.
+inline const char *ParseNumber(const char *begin, const char *end, NumberValue &number)
+{
+    const char *current = begin;
+    bool negative = false;
+
+    if (current != end && (*current == '-' || *current == '+'))
+    {
+        negative = *current == '-';
+        ++current;
+    }
+
+    // The digits are summed up without any checks first, which is exact as
+    // long as there are at most 19 of them
+    const char *digits = current;
+    unsigned long long mantissa = 0;
+    for (; current != end && IsDigit(*current); ++current)
+    {
+        mantissa = mantissa * 10 + (*current - '0');
+    }
+
+    size_t integerDigits = current - digits;
+    unsigned long long integerPart = mantissa;
+    size_t fractionDigits = 0;
+
+    number.isFloat = false;
+    if (current != end && *current == '.')
+    {
+        number.isFloat = true;
+        const char *fraction = ++current;
+        for (; current != end && IsDigit(*current); ++current)
+        {
+            mantissa = mantissa * 10 + (*current - '0');
+        }
+        fractionDigits = current - fraction;
+    }
+
+    if (integerDigits + fractionDigits > 19)
+        return ParseLongNumber(digits, end, negative, number);
+
+    int exponent = -(int)fractionDigits;
+    if (current != end && (*current == 'e' || *current == 'E'))
+    {
+        number.isFloat = true;
+        current = ParseExponent(current + 1, end, exponent);
+    }
+
+    // Clamps to INT_MAX, or -INT_MAX when negative, instead of overflowing
+    int intValue = integerPart > INT_MAX ? INT_MAX : (int)integerPart;
+
+    number.floatValue = GetScaledValue(mantissa, exponent, negative);
+    number.intValue = negative ? -intValue : intValue;
+
+    return current;
+}
+
+inline float ParseFloat(const StringRange &range)
+{
+    NumberValue number;
+    ParseNumber(range.begin, range.end, number);
+    return number.floatValue;
+}
+
+inline int ParseInt(const StringRange &range)
+{
+    NumberValue number;
+    ParseNumber(range.begin, range.end, number);
+    return number.intValue;
+}
@@ -1,7 +1,10 @@
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <GL/gl_core_3_3.h>
@@ -9,8 +12,13 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "adsrenderer.hh"
+#include "imagecache.hh"
+#include "meshbuffers.hh"
+#include "texturecompression.hh"
 #include "shaderprogram.hh"
 #include "types.hh"
+#include "uploadmanager.hh"
+#include "utility/profiler.hh"
 
 using std::cout;
 using std::endl;
@@ -65,13 +73,50 @@ private:
     }
 };
 
+static bool HasExtension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        if (strcmp((const char *)glGetStringi(GL_EXTENSIONS, i), name) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+// std140 layout of MaterialBlock in ads.frag
+typedef struct GPUMaterial
+{
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular; // w is the shininess
+    GLint hasMaps[4];   // Kd, Ks and normal map, unused
+} GPUMaterial;
+
+static const GLuint MATERIAL_BLOCK_BINDING = 0;
+static const char S3TC_EXTENSION[] = "GL_EXT_texture_compression_s3tc";
+static const GLint KD_MAP_UNIT = 0;
+static const GLint KS_MAP_UNIT = 1;
+static const GLint NORMAL_MAP_UNIT = 2;
+
+static const GLubyte WHITE_TEXEL[4] = { 255, 255, 255, 255 };
+static const GLubyte FLAT_NORMAL_TEXEL[4] = { 128, 128, 255, 255 };
+
+typedef struct PendingTexture
+{
+    ImageHandle *image;
+    GLuint textureId;
+} PendingTexture;
+
 class ADSRendererImplementation : public ADSRenderer::IADSRendererImplementation
 {
 public:
     ADSRendererImplementation()
         : _indexBuffer(GL_ELEMENT_ARRAY_BUFFER),
           _positionBuffer(GL_ARRAY_BUFFER), _normalBuffer(GL_ARRAY_BUFFER),
-          _uvBuffer(GL_ARRAY_BUFFER)
+          _uvBuffer(GL_ARRAY_BUFFER), _lightBuffer(GL_ARRAY_BUFFER)
     {
         _shaderProgram = new ShaderProgram("ads");
 
@@ -87,18 +132,65 @@ public:
         _shaderProgram->BindAttribLocation(0, "VertexPosition");
         _shaderProgram->BindAttribLocation(1, "VertexNormal");
         _shaderProgram->BindAttribLocation(2, "VertexTexCoord");
+        _shaderProgram->BindAttribLocation(3, "VertexLighting");
 
         _shaderProgram->Link();
+        setUpMaterialBindings(_shaderProgram);
         _shaderProgram->Use();
 
         _positionBuffer.SetUp(0, 4, GL_FLOAT, GL_FALSE, 0, (GLubyte *)NULL);
         _normalBuffer.SetUp(1, 3, GL_FLOAT, GL_FALSE, 0, (GLubyte *)NULL);
         _uvBuffer.SetUp(2, 2, GL_FLOAT, GL_FALSE, 0, (GLubyte *)NULL);
+        _lightBuffer.SetUp(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (GLubyte *)NULL);
 
         _modelViewMatrixLocation = _shaderProgram->GetUniformLocation("ModelViewMatrix");
         _normalMatrixLocation = _shaderProgram->GetUniformLocation("NormalMatrix");
         _projectionMatrixLocation = _shaderProgram->GetUniformLocation("ProjectionMatrix");
         _MVPMatrixLocation = _shaderProgram->GetUniformLocation("MVP");
+
+        _instancedShaderProgram = new ShaderProgram("ads_instanced", "ads");
+        _instancedShaderProgram->BindAttribLocation(0, "VertexPosition");
+        _instancedShaderProgram->BindAttribLocation(1, "VertexNormal");
+        _instancedShaderProgram->BindAttribLocation(2, "VertexTexCoord");
+        _instancedShaderProgram->BindAttribLocation(3, "VertexLighting");
+        _instancedShaderProgram->BindAttribLocation(MeshBuffers::InstanceMatrixLocation, "InstanceModelMatrix");
+        _instancedShaderProgram->Link();
+        setUpMaterialBindings(_instancedShaderProgram);
+
+        _instancedViewMatrixLocation = _instancedShaderProgram->GetUniformLocation("ViewMatrix");
+        _instancedProjectionMatrixLocation = _instancedShaderProgram->GetUniformLocation("ProjectionMatrix");
+
+        glGenBuffers(1, &_instanceBuffer);
+
+        // Each record starts at a multiple of the offset alignment so it can be bound with glBindBufferRange
+        GLint alignment = 1;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        _materialStride = (sizeof(GPUMaterial) + alignment - 1) / alignment * alignment;
+        glGenBuffers(1, &_materialBuffer);
+
+        _uploadManager = new UploadManager();
+        _hasS3tc = HasExtension(S3TC_EXTENSION);
+
+        _shaderProgram->Use();
+    }
+
+    ~ADSRendererImplementation()
+    {
+        // Queued uploads refer to the meshes, so they go first
+        delete _uploadManager;
+
+        for (int i = 0; i < _meshes.size(); ++i)
+        {
+            delete _meshes[i];
+        }
+
+        for (int i = 0; i < _materials.size(); ++i)
+        {
+            releaseImages(_materials[i]);
+        }
+
+        glDeleteBuffers(1, &_instanceBuffer);
+        glDeleteBuffers(1, &_materialBuffer);
     }
 
     void Use()
@@ -108,18 +200,36 @@ public:
 
     IndexValue RegisterMaterial(MaterialInfo material)
     {
-        IndexValue index = _materials.size();
-        if (material.Kd_imageInfo != NULL)
+        for (IndexValue i = 0; i < _materials.size(); ++i)
         {
-            material.hasKdMap = true;
-            material.Kd_mapId = registerTexture(material.Kd_imageInfo);
-        }
-        else
-        {
-            material.hasKdMap = false;
+            if (materialsMatch(_materials[i], material))
+            {
+                releaseImages(material);
+                return i;
+            }
         }
 
+        IndexValue index = _materials.size();
+        material.hasKdMap = registerMap(material.Kd_image, material.Kd_mapId, WHITE_TEXEL);
+        material.hasKsMap = registerMap(material.Ks_image, material.Ks_mapId, WHITE_TEXEL);
+        material.hasNormalMap = registerMap(material.normal_image, material.normal_mapId, FLAT_NORMAL_TEXEL);
         _materials.push_back(material);
+
+        GPUMaterial record;
+        record.ambient = glm::vec4(material.Ka, 1.0f);
+        record.diffuse = glm::vec4(material.Kd, 1.0f);
+        record.specular = glm::vec4(material.Ks, material.shininess);
+        record.hasMaps[0] = material.hasKdMap;
+        record.hasMaps[1] = material.hasKsMap;
+        record.hasMaps[2] = material.hasNormalMap;
+        record.hasMaps[3] = 0;
+
+        _materialRecords.resize(_materials.size() * _materialStride);
+        memcpy(&_materialRecords[index * _materialStride], &record, sizeof(record));
+
+        glBindBuffer(GL_UNIFORM_BUFFER, _materialBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, _materialRecords.size(), _materialRecords.data(), GL_STATIC_DRAW);
+
         return index;
     }
 
@@ -156,20 +266,70 @@ public:
 
         glm::vec4 viewLightPosition = _modelViewMatrix * _light.position;
 
-        _shaderProgram->SetUniform("Light.Position", viewLightPosition);
-        _shaderProgram->SetUniform("Light.La", glm::value_ptr(_light.La));
-        _shaderProgram->SetUniform("Light.Ld", glm::value_ptr(_light.Ld));
-        _shaderProgram->SetUniform("Light.Ls", glm::value_ptr(_light.Ls));
+        setLightUniforms(_shaderProgram, viewLightPosition);
+
+        _instancedShaderProgram->Use();
+        setLightUniforms(_instancedShaderProgram, viewLightPosition);
+        _shaderProgram->Use();
+    }
+
+    IndexValue RegisterMesh(const RenderObject &object)
+    {
+        IndexValue index = _meshes.size();
+        _meshes.push_back(new MeshBuffers(object, _instanceBuffer, _uploadManager));
+        glBindVertexArray(_vaoHandle);
+
+        return index;
+    }
+
+    void ProcessUploads()
+    {
+        if (!_pendingTextures.empty())
+            resolvePendingTextures();
+
+        _uploadManager->Update();
+    }
+
+    void RenderInstanced(IndexValue meshId,
+                         const vector<glm::mat4> &modelMatrices,
+                         const IndexValue &materialId)
+    {
+        if (modelMatrices.empty())
+            return;
+
+        _instancedShaderProgram->Use();
+
+        glUniformMatrix4fv(_instancedViewMatrixLocation, 1, GL_FALSE, glm::value_ptr(_viewMatrix));
+        glUniformMatrix4fv(_instancedProjectionMatrixLocation, 1, GL_FALSE, glm::value_ptr(_projectionMatrix));
+        useMaterial(materialId);
+
+        _meshes[meshId]->DrawInstanced(modelMatrices);
+
+        glBindVertexArray(_vaoHandle);
+        _shaderProgram->Use();
     }
 
     void Render(const vector<IndexValue> &indices,
                 const vector<float> &vertices,
                 const vector<float> &normals,
                 const std::vector<float> &UVs,
+                const std::vector<unsigned char> &light,
                 const IndexValue &materialId)
     {
         glBindVertexArray(_vaoHandle);
 
+        // Geometry without baked lighting is drawn fully lit
+        if (light.empty())
+        {
+            glDisableVertexAttribArray(3);
+            glVertexAttrib4f(3, 1.0f, 1.0f, 1.0f, 1.0f);
+        }
+        else
+        {
+            _shaderProgram->EnableAttribArray(3);
+            _lightBuffer.UseDataCollection(light);
+        }
+
         glUniformMatrix4fv(_modelViewMatrixLocation, 1, GL_FALSE, glm::value_ptr(_modelViewMatrix));
         glUniformMatrix3fv(_normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(_normalMatrix));
         glUniformMatrix4fv(_projectionMatrixLocation, 1, GL_FALSE, glm::value_ptr(_projectionMatrix));
@@ -191,16 +351,29 @@ private:
     VertexArrayBuffer<float> _positionBuffer;
     VertexArrayBuffer<float> _normalBuffer;
     VertexArrayBuffer<float> _uvBuffer;
+    VertexArrayBuffer<unsigned char> _lightBuffer;
 
     vector<MaterialInfo> _materials;
+    vector<char> _materialRecords;
+    GLuint _materialBuffer;
+    size_t _materialStride;
+    std::unordered_map<ImageHandle*, GLuint> _textures;
+    vector<PendingTexture> _pendingTextures;
+    vector<MeshBuffers*> _meshes;
+    UploadManager *_uploadManager;
+    bool _hasS3tc;
 
     ShaderProgram *_shaderProgram;
+    ShaderProgram *_instancedShaderProgram;
     GLuint _vaoHandle;
+    GLuint _instanceBuffer;
 
     GLuint _modelViewMatrixLocation;
     GLuint _normalMatrixLocation;
     GLuint _projectionMatrixLocation;
     GLuint _MVPMatrixLocation;
+    GLuint _instancedViewMatrixLocation;
+    GLuint _instancedProjectionMatrixLocation;
 
     glm::mat4 _projectionMatrix;
     glm::mat4 _viewMatrix;
@@ -211,36 +384,180 @@ private:
     glm::mat3 _normalMatrix;
 
 private:
-    GLuint registerTexture(RawImageInfo *imageInfo)
+    static bool materialsMatch(const MaterialInfo &first, const MaterialInfo &second)
+    {
+        return first.Ka == second.Ka &&
+            first.Kd == second.Kd &&
+            first.Ks == second.Ks &&
+            first.shininess == second.shininess &&
+            first.Kd_image == second.Kd_image &&
+            first.Ks_image == second.Ks_image &&
+            first.normal_image == second.normal_image;
+    }
+
+    static void releaseImages(const MaterialInfo &material)
     {
+        ImageHandle *images[] = { material.Kd_image, material.Ks_image, material.normal_image };
+        for (int i = 0; i < 3; ++i)
+        {
+            if (images[i] != NULL)
+                images[i]->Release();
+        }
+    }
+
+    bool registerMap(ImageHandle *image, GLuint &mapId, const GLubyte *placeholder)
+    {
+        mapId = image != NULL ? registerTexture(image, placeholder) : 0;
+        return image != NULL;
+    }
+
+    // Textures whose image is still decoding show a single placeholder texel
+    // until resolvePendingTextures uploads the real image
+    GLuint registerTexture(ImageHandle *image, const GLubyte *placeholder)
+    {
+        std::unordered_map<ImageHandle*, GLuint>::iterator found = _textures.find(image);
+        if (found != _textures.end())
+            return found->second;
+
         GLuint textureId;
         glGenTextures(1, &textureId);
         glBindTexture(GL_TEXTURE_2D, textureId);
-        glTexImage2D(GL_TEXTURE_2D, 0, imageInfo->components,
-                     imageInfo->width, imageInfo->height, 0,
-                     imageInfo->components, GL_UNSIGNED_BYTE, imageInfo->data);
         glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+
+        if (image->IsReady())
+        {
+            uploadTexture(textureId, image->Get());
+        }
+        else
+        {
+            PendingTexture pending = { image, textureId };
+            _pendingTextures.push_back(pending);
+        }
 
+        _textures[image] = textureId;
         return textureId;
     }
 
-    void useMaterial(IndexValue index)
+    // The image streams into a new texture that replaces the placeholder once
+    // it is complete, so a half uploaded texture is never sampled
+    void uploadTexture(GLuint placeholderId, RawImageInfo *imageInfo)
     {
-        useMaterial(_materials[index]);
+        // A failed decode keeps its placeholder
+        if (imageInfo == NULL)
+            return;
+
+        unsigned int levels = std::max(1u, imageInfo->levels);
+        if (IsCompressedImage(*imageInfo) && !_hasS3tc)
+        {
+            // Decompressed right away into the placeholder
+            glBindTexture(GL_TEXTURE_2D, placeholderId);
+            uploadDecompressedLevels(imageInfo);
+            setTextureFilter(levels);
+            return;
+        }
+
+        GLuint textureId;
+        glGenTextures(1, &textureId);
+
+        UploadManager::CompletionCallback onComplete = [this, placeholderId, textureId, levels]() {
+            replaceTexture(placeholderId, textureId, levels);
+        };
+        _uploadManager->UploadTexture(textureId, imageInfo, onComplete);
     }
 
-    void useMaterial(const MaterialInfo &info)
+    void replaceTexture(GLuint placeholderId, GLuint textureId, unsigned int levels)
     {
-        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, textureId);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        setTextureFilter(levels);
+
+        for (int i = 0; i < _materials.size(); ++i)
+        {
+            MaterialInfo &material = _materials[i];
+            material.Kd_mapId = material.Kd_mapId == placeholderId ? textureId : material.Kd_mapId;
+            material.Ks_mapId = material.Ks_mapId == placeholderId ? textureId : material.Ks_mapId;
+            material.normal_mapId = material.normal_mapId == placeholderId ? textureId : material.normal_mapId;
+        }
+
+        for (std::unordered_map<ImageHandle*, GLuint>::iterator i = _textures.begin(); i != _textures.end(); ++i)
+        {
+            if (i->second == placeholderId)
+                i->second = textureId;
+        }
+
+        glDeleteTextures(1, &placeholderId);
+    }
+
+    void setTextureFilter(unsigned int levels)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_NEAREST_MIPMAP_LINEAR : GL_NEAREST);
+    }
+
+    void uploadDecompressedLevels(RawImageInfo *imageInfo)
+    {
+        for (unsigned int level = 0; level < std::max(1u, imageInfo->levels); ++level)
+        {
+            RawImageInfo *pixels = DecompressImage(*imageInfo, level);
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, pixels->width, pixels->height, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, pixels->data);
+            free(pixels->data);
+            free(pixels);
+        }
+    }
+
+    void resolvePendingTextures()
+    {
+        for (size_t i = 0; i < _pendingTextures.size();)
+        {
+            if (!_pendingTextures[i].image->IsReady())
+            {
+                ++i;
+                continue;
+            }
+
+            uploadTexture(_pendingTextures[i].textureId, _pendingTextures[i].image->Get());
+            _pendingTextures[i] = _pendingTextures.back();
+            _pendingTextures.pop_back();
+        }
+    }
+
+    void setUpMaterialBindings(ShaderProgram *program)
+    {
+        program->Use();
+        program->BindUniformBlock("MaterialBlock", MATERIAL_BLOCK_BINDING);
+        program->SetUniform("KdMap", KD_MAP_UNIT);
+        program->SetUniform("KsMap", KS_MAP_UNIT);
+        program->SetUniform("NormalMap", NORMAL_MAP_UNIT);
+    }
+
+    void useMaterial(IndexValue materialId)
+    {
+        const MaterialInfo &info = _materials[materialId];
+
+        if (!_pendingTextures.empty())
+            resolvePendingTextures();
+
+        glActiveTexture(GL_TEXTURE0 + KD_MAP_UNIT);
         glBindTexture(GL_TEXTURE_2D, info.Kd_mapId);
+        glActiveTexture(GL_TEXTURE0 + KS_MAP_UNIT);
+        glBindTexture(GL_TEXTURE_2D, info.Ks_mapId);
+        glActiveTexture(GL_TEXTURE0 + NORMAL_MAP_UNIT);
+        glBindTexture(GL_TEXTURE_2D, info.normal_mapId);
+        glActiveTexture(GL_TEXTURE0);
+
+        glBindBufferRange(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, _materialBuffer,
+                          materialId * _materialStride, sizeof(GPUMaterial));
+    }
 
-        _shaderProgram->SetUniform("Material.Ka", glm::value_ptr(info.Ka));
-        _shaderProgram->SetUniform("Material.Kd", glm::value_ptr(info.Kd));
-        _shaderProgram->SetUniform("Material.Ks", glm::value_ptr(info.Ks));
-        _shaderProgram->SetUniform("Material.Shininess", &info.shininess);
-        _shaderProgram->SetUniform("Material.Kd_map", 0);
-        _shaderProgram->SetUniform("Material.hasKdMap", (int)info.hasKdMap);
+    void setLightUniforms(ShaderProgram *program, const glm::vec4 &viewLightPosition)
+    {
+        program->SetUniform("Light.Position", viewLightPosition);
+        program->SetUniform("Light.La", glm::value_ptr(_light.La));
+        program->SetUniform("Light.Ld", glm::value_ptr(_light.Ld));
+        program->SetUniform("Light.Ls", glm::value_ptr(_light.Ls));
     }
 };
 
@@ -284,11 +601,43 @@ void ADSRenderer::SetLight(LightInfo info)
     _implementation->SetLight(info);
 }
 
+IndexValue ADSRenderer::RegisterMesh(const RenderObject &object)
+{
+    return _implementation->RegisterMesh(object);
+}
+
+void ADSRenderer::ProcessUploads()
+{
+    PROFILE_SCOPE("ADSRenderer::ProcessUploads");
+    _implementation->ProcessUploads();
+}
+
+void ADSRenderer::RenderInstanced(IndexValue meshId,
+                                  const std::vector<glm::mat4> &modelMatrices,
+                                  const IndexValue &materialId)
+{
+    PROFILE_SCOPE("ADSRenderer::RenderInstanced");
+    _implementation->RenderInstanced(meshId, modelMatrices, materialId);
+}
+
+void ADSRenderer::Render(const std::vector<IndexValue> &indices,
+                         const std::vector<float> &vertices,
+                         const std::vector<float> &normals,
+                         const std::vector<float> &UVs,
+                         const IndexValue &materialId)
+{
+    PROFILE_SCOPE("ADSRenderer::Render");
+    _implementation->Render(indices, vertices, normals, UVs,
+                            std::vector<unsigned char>(), materialId);
+}
+
 void ADSRenderer::Render(const std::vector<IndexValue> &indices,
                          const std::vector<float> &vertices,
                          const std::vector<float> &normals,
                          const std::vector<float> &UVs,
+                         const std::vector<unsigned char> &light,
                          const IndexValue &materialId)
 {
-    _implementation->Render(indices, vertices, normals, UVs, materialId);
+    PROFILE_SCOPE("ADSRenderer::Render");
+    _implementation->Render(indices, vertices, normals, UVs, light, materialId);
 }
@@ -19,10 +19,24 @@ public:
     void SetProjectionMatrix(const glm::mat4 &matrix);
     void SetLight(LightInfo info);
 
+    IndexValue RegisterMesh(const RenderObject &object);
+    void RenderInstanced(IndexValue meshId,
+                         const std::vector<glm::mat4> &modelMatrices,
+                         const IndexValue &materialId);
+
+    // Spends this frame's budget on streaming textures and meshes
+    void ProcessUploads();
+
+    void Render(const std::vector<IndexValue> &indices,
+                const std::vector<float> &vertices,
+                const std::vector<float> &normals,
+                const std::vector<float> &UVs,
+                const IndexValue &materialId);
     void Render(const std::vector<IndexValue> &indices,
                 const std::vector<float> &vertices,
                 const std::vector<float> &normals,
                 const std::vector<float> &UVs,
+                const std::vector<unsigned char> &light,
                 const IndexValue &materialId);
 
 public:
@@ -37,10 +51,17 @@ public:
         virtual void SetProjectionMatrix(const glm::mat4 &matrix) = 0;
         virtual void SetLight(LightInfo info) = 0;
 
+        virtual IndexValue RegisterMesh(const RenderObject &object) = 0;
+        virtual void RenderInstanced(IndexValue meshId,
+                                     const std::vector<glm::mat4> &modelMatrices,
+                                     const IndexValue &materialId) = 0;
+        virtual void ProcessUploads() = 0;
+
         virtual void Render(const std::vector<IndexValue> &indices,
                         const std::vector<float> &vertices,
                         const std::vector<float> &normals,
                         const std::vector<float> &UVs,
+                        const std::vector<unsigned char> &light,
                         const IndexValue &materialId) = 0;
     };
 
@@ -0,0 +1,206 @@
+#include "framepacket.hh"
+
+FramePacket::FramePacket()
+    : step(0), _geometryCount(0), _instanceMatrixCount(0)
+{
+}
+
+void FramePacket::Clear()
+{
+    step = 0;
+    _commands.clear();
+    _geometryCount = 0;
+    _instanceMatrixCount = 0;
+}
+
+void FramePacket::AddCommand(DrawCommand::Type type)
+{
+    DrawCommand command = DrawCommand();
+    command.type = type;
+    _commands.push_back(command);
+}
+
+void FramePacket::AddMatrix(DrawCommand::Type type, const glm::mat4 &matrix)
+{
+    AddCommand(type);
+    _commands.back().matrix = matrix;
+}
+
+RenderObject &FramePacket::AddGeometry(DrawCommand::Type type, IndexValue materialId)
+{
+    if (_geometryCount == _geometry.size())
+        _geometry.push_back(RenderObject());
+
+    AddCommand(type);
+    _commands.back().materialId = materialId;
+    _commands.back().slot = _geometryCount;
+
+    return _geometry[_geometryCount++];
+}
+
+void FramePacket::AddInstanced(IndexValue meshId, const std::vector<glm::mat4> &modelMatrices,
+                               IndexValue materialId)
+{
+    if (_instanceMatrixCount == _instanceMatrices.size())
+        _instanceMatrices.push_back(std::vector<glm::mat4>());
+
+    AddCommand(DrawCommand::Type::RenderInstanced);
+    _commands.back().meshId = meshId;
+    _commands.back().materialId = materialId;
+    _commands.back().slot = _instanceMatrixCount;
+
+    _instanceMatrices[_instanceMatrixCount++].assign(modelMatrices.begin(), modelMatrices.end());
+}
+
+void FramePacket::Replay(IRenderer *renderer) const
+{
+    for (int i = 0; i < _commands.size(); ++i)
+    {
+        const DrawCommand &command = _commands[i];
+
+        switch (command.type)
+        {
+        case DrawCommand::Type::Use:
+            renderer->Use();
+            break;
+        case DrawCommand::Type::SetModelMatrix:
+            renderer->SetModelMatrix(command.matrix);
+            break;
+        case DrawCommand::Type::SetViewMatrix:
+            renderer->SetViewMatrix(command.matrix);
+            break;
+        case DrawCommand::Type::SetProjectionMatrix:
+            renderer->SetProjectionMatrix(command.matrix);
+            break;
+        case DrawCommand::Type::Render:
+        {
+            const RenderObject &object = _geometry[command.slot];
+            renderer->Render(object._indices, object._vertices, object._normals, object._uvCoords,
+                             command.materialId);
+            break;
+        }
+        case DrawCommand::Type::RenderWithLight:
+        {
+            const RenderObject &object = _geometry[command.slot];
+            renderer->Render(object._indices, object._vertices, object._normals, object._uvCoords,
+                             object._light, command.materialId);
+            break;
+        }
+        case DrawCommand::Type::RenderInstanced:
+            renderer->RenderInstanced(command.meshId, _instanceMatrices[command.slot], command.materialId);
+            break;
+        }
+    }
+}
+
+FramePacketRecorder::FramePacketRecorder(IRenderer *target)
+    : _target(target), _packet(NULL)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        _hasMatrix[i] = false;
+    }
+}
+
+void FramePacketRecorder::Begin(FramePacket *packet)
+{
+    _packet = packet;
+    _packet->Clear();
+
+    const DrawCommand::Type types[] = { DrawCommand::Type::SetModelMatrix, DrawCommand::Type::SetViewMatrix,
+                                        DrawCommand::Type::SetProjectionMatrix };
+    for (int i = 0; i < 3; ++i)
+    {
+        if (_hasMatrix[i])
+            _packet->AddMatrix(types[i], _matrices[i]);
+    }
+}
+
+void FramePacketRecorder::End()
+{
+    _packet = NULL;
+}
+
+void FramePacketRecorder::Render(const std::vector<IndexValue> &indices,
+                                 const std::vector<float> &vertices,
+                                 const std::vector<float> &normals,
+                                 const std::vector<float> &UVs,
+                                 const IndexValue &materialId)
+{
+    if (_packet == NULL)
+        return;
+
+    RenderObject &object = _packet->AddGeometry(DrawCommand::Type::Render, materialId);
+    object._indices.assign(indices.begin(), indices.end());
+    object._vertices.assign(vertices.begin(), vertices.end());
+    object._normals.assign(normals.begin(), normals.end());
+    object._uvCoords.assign(UVs.begin(), UVs.end());
+}
+
+void FramePacketRecorder::Render(const std::vector<IndexValue> &indices,
+                                 const std::vector<float> &vertices,
+                                 const std::vector<float> &normals,
+                                 const std::vector<float> &UVs,
+                                 const std::vector<unsigned char> &light,
+                                 const IndexValue &materialId)
+{
+    if (_packet == NULL)
+        return;
+
+    RenderObject &object = _packet->AddGeometry(DrawCommand::Type::RenderWithLight, materialId);
+    object._indices.assign(indices.begin(), indices.end());
+    object._vertices.assign(vertices.begin(), vertices.end());
+    object._normals.assign(normals.begin(), normals.end());
+    object._uvCoords.assign(UVs.begin(), UVs.end());
+    object._light.assign(light.begin(), light.end());
+}
+
+IndexValue FramePacketRecorder::RegisterMesh(const RenderObject &object)
+{
+    return _target->RegisterMesh(object);
+}
+
+void FramePacketRecorder::RenderInstanced(IndexValue meshId,
+                                          const std::vector<glm::mat4> &modelMatrices,
+                                          const IndexValue &materialId)
+{
+    if (_packet != NULL)
+        _packet->AddInstanced(meshId, modelMatrices, materialId);
+}
+
+void FramePacketRecorder::Use()
+{
+    if (_packet != NULL)
+        _packet->AddCommand(DrawCommand::Type::Use);
+}
+
+IndexValue FramePacketRecorder::RegisterMaterial(MaterialInfo material)
+{
+    return _target->RegisterMaterial(material);
+}
+
+void FramePacketRecorder::SetModelMatrix(const glm::mat4 &matrix)
+{
+    setMatrix(DrawCommand::Type::SetModelMatrix, matrix);
+}
+
+void FramePacketRecorder::SetViewMatrix(const glm::mat4 &matrix)
+{
+    setMatrix(DrawCommand::Type::SetViewMatrix, matrix);
+}
+
+void FramePacketRecorder::SetProjectionMatrix(const glm::mat4 &matrix)
+{
+    setMatrix(DrawCommand::Type::SetProjectionMatrix, matrix);
+}
+
+// Matrices set between packets are kept for the next one
+void FramePacketRecorder::setMatrix(DrawCommand::Type type, const glm::mat4 &matrix)
+{
+    int index = (int)type - (int)DrawCommand::Type::SetModelMatrix;
+    _matrices[index] = matrix;
+    _hasMatrix[index] = true;
+
+    if (_packet != NULL)
+        _packet->AddMatrix(type, matrix);
+}
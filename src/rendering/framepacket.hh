@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "irenderer.hh"
+#include "types.hh"
+
+typedef struct DrawCommand
+{
+    enum class Type
+    {
+        Use,
+        SetModelMatrix,
+        SetViewMatrix,
+        SetProjectionMatrix,
+        Render,
+        RenderWithLight,
+        RenderInstanced
+    };
+
+    Type type;
+    glm::mat4 matrix;
+    IndexValue meshId;
+    IndexValue materialId;
+    // Slot in the packet's geometry or instance matrices
+    size_t slot;
+} DrawCommand;
+
+// Everything the render thread needs to draw one frame, recorded by the
+// logic thread. Packets are reused, and Clear keeps the storage of the
+// geometry and matrix slots so steady frames do not allocate.
+class FramePacket
+{
+public:
+    FramePacket();
+
+    void Clear();
+
+    void AddCommand(DrawCommand::Type type);
+    void AddMatrix(DrawCommand::Type type, const glm::mat4 &matrix);
+
+    // Returns the geometry slot for the caller to fill
+    RenderObject &AddGeometry(DrawCommand::Type type, IndexValue materialId);
+    void AddInstanced(IndexValue meshId, const std::vector<glm::mat4> &modelMatrices, IndexValue materialId);
+
+    // Issues the recorded calls in order; call on the thread owning the context
+    void Replay(IRenderer *renderer) const;
+
+    size_t GetCommandCount() const
+    {
+        return _commands.size();
+    }
+
+    // Simulation step the packet was recorded after
+    unsigned long long step;
+
+private:
+    std::vector<DrawCommand> _commands;
+    std::vector<RenderObject> _geometry;
+    size_t _geometryCount;
+    std::vector<std::vector<glm::mat4> > _instanceMatrices;
+    size_t _instanceMatrixCount;
+};
+
+// Stands in for the real renderer on the logic thread and records draws
+// into a packet. Registration needs the GL context, so it is passed on to
+// the target and must happen before the logic thread starts.
+class FramePacketRecorder : public IRenderer
+{
+public:
+    FramePacketRecorder(IRenderer *target);
+
+    // The current model, view and projection matrices open every packet
+    void Begin(FramePacket *packet);
+    void End();
+
+    void Render(const std::vector<IndexValue> &indices,
+                const std::vector<float> &vertices,
+                const std::vector<float> &normals,
+                const std::vector<float> &UVs,
+                const IndexValue &materialId);
+    void Render(const std::vector<IndexValue> &indices,
+                const std::vector<float> &vertices,
+                const std::vector<float> &normals,
+                const std::vector<float> &UVs,
+                const std::vector<unsigned char> &light,
+                const IndexValue &materialId);
+
+    IndexValue RegisterMesh(const RenderObject &object);
+    void RenderInstanced(IndexValue meshId,
+                         const std::vector<glm::mat4> &modelMatrices,
+                         const IndexValue &materialId);
+
+    void Use();
+    IndexValue RegisterMaterial(MaterialInfo material);
+
+    void SetModelMatrix(const glm::mat4 &matrix);
+    void SetViewMatrix(const glm::mat4 &matrix);
+    void SetProjectionMatrix(const glm::mat4 &matrix);
+
+private:
+    IRenderer *_target;
+    FramePacket *_packet;
+
+    glm::mat4 _matrices[3];
+    bool _hasMatrix[3];
+
+private:
+    void setMatrix(DrawCommand::Type type, const glm::mat4 &matrix);
+
+    FramePacketRecorder(const FramePacketRecorder &o) = delete;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <system/event.hh>
+
+#include "framepacket.hh"
+#include "utility/triplebuffer.hh"
+
+// Hands frame packets from the logic thread to the render thread. With
+// three packets the logic thread always has one to record into and the
+// render thread always keeps the one it is drawing, so neither waits for
+// the other; a packet the render thread never got to is replaced.
+class FramePipeline
+{
+public:
+    FramePipeline()
+        : _published(System::Event::Create(NULL))
+    {
+    }
+
+    ~FramePipeline()
+    {
+        delete _published;
+    }
+
+    // Logic thread
+    FramePacket &GetRecordingPacket()
+    {
+        return _packets.GetWriteBuffer();
+    }
+
+    void Publish()
+    {
+        _packets.Publish();
+        _published->Trigger();
+    }
+
+    // Render thread. Returns the newest packet, or NULL when none arrived
+    // within the timeout.
+    const FramePacket *Acquire(int timeoutMilliseconds)
+    {
+        if (!_packets.Acquire())
+        {
+            _published->Wait(timeoutMilliseconds);
+            if (!_packets.Acquire())
+                return NULL;
+        }
+
+        return &_packets.GetReadBuffer();
+    }
+
+private:
+    TripleBuffer<FramePacket> _packets;
+    System::Event *_published;
+
+    FramePipeline(const FramePipeline &o) = delete;
+};
@@ -13,6 +13,7 @@ typedef struct RenderObject
     std::vector<float> _vertices;
     std::vector<float> _normals;
     std::vector<float> _uvCoords;
+    std::vector<unsigned char> _light;
     std::string _materialName;
 } RenderObject;
 
@@ -27,7 +28,26 @@ public:
                         const std::vector<float> &UVs,
                         const IndexValue &materialId) = 0;
 
+    // light holds four normalized bytes per vertex: ambient occlusion,
+    // sky light, block light and an unused channel
+    virtual void Render(const std::vector<IndexValue> &indices,
+                        const std::vector<float> &vertices,
+                        const std::vector<float> &normals,
+                        const std::vector<float> &UVs,
+                        const std::vector<unsigned char> &light,
+                        const IndexValue &materialId) = 0;
+
+    // Uploads the object once and returns a handle for RenderInstanced
+    virtual IndexValue RegisterMesh(const RenderObject &object) = 0;
+
+    // Draws every instance of a registered mesh in a single draw call
+    virtual void RenderInstanced(IndexValue meshId,
+                                 const std::vector<glm::mat4> &modelMatrices,
+                                 const IndexValue &materialId) = 0;
+
     virtual void Use() = 0;
+
+    // Takes over the caller's references to the material's images
     virtual IndexValue RegisterMaterial(MaterialInfo material) = 0;
 
     virtual void SetModelMatrix(const glm::mat4 &matrix) = 0;
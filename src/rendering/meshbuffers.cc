@@ -0,0 +1,78 @@
+#include "meshbuffers.hh"
+
+MeshBuffers::MeshBuffers(const RenderObject &object, GLuint instanceBuffer, UploadManager *uploadManager)
+    : _instanceBuffer(instanceBuffer), _vertexCount(object._indices.size()), _hasLight(!object._light.empty()),
+      _pendingUploads(0), _uploadManager(uploadManager)
+{
+    glGenVertexArrays(1, &_vaoHandle);
+    glBindVertexArray(_vaoHandle);
+    glGenBuffers(BufferCount, _bufferHandles);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _bufferHandles[0]);
+    streamData(GL_ELEMENT_ARRAY_BUFFER, _bufferHandles[0], object._indices);
+
+    setUpAttribute(_bufferHandles[1], 0, 4, GL_FLOAT, GL_FALSE, object._vertices);
+    setUpAttribute(_bufferHandles[2], 1, 3, GL_FLOAT, GL_FALSE, object._normals);
+    setUpAttribute(_bufferHandles[3], 2, 2, GL_FLOAT, GL_FALSE, object._uvCoords);
+
+    if (_hasLight)
+        setUpAttribute(_bufferHandles[4], 3, 4, GL_UNSIGNED_BYTE, GL_TRUE, object._light);
+
+    // The per-instance model matrix takes four consecutive vec4 slots
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceBuffer);
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        GLuint location = InstanceMatrixLocation + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (GLubyte *)NULL + column * sizeof(glm::vec4));
+        glVertexAttribDivisor(location, 1);
+    }
+}
+
+MeshBuffers::~MeshBuffers()
+{
+    glDeleteBuffers(BufferCount, _bufferHandles);
+    glDeleteVertexArrays(1, &_vaoHandle);
+}
+
+void MeshBuffers::DrawInstanced(const std::vector<glm::mat4> &modelMatrices)
+{
+    if (_pendingUploads > 0 || modelMatrices.empty())
+        return;
+
+    glBindVertexArray(_vaoHandle);
+
+    // Current attribute values are context state rather than part of the
+    // vertex array, so meshes without baked lighting set theirs on each draw
+    if (!_hasLight)
+        glVertexAttrib4f(3, 1.0f, 1.0f, 1.0f, 1.0f);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, modelMatrices.size() * sizeof(glm::mat4), modelMatrices.data(), GL_STREAM_DRAW);
+
+    glDrawElementsInstanced(GL_TRIANGLES, _vertexCount, GL_UNSIGNED_INT, NULL, modelMatrices.size());
+}
+
+template <class T>
+void MeshBuffers::setUpAttribute(GLuint bufferHandle, GLuint location, GLint size, GLenum type,
+                                 GLboolean normalized, const std::vector<T> &data)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, bufferHandle);
+    streamData(GL_ARRAY_BUFFER, bufferHandle, data);
+    glEnableVertexAttribArray(location);
+    glVertexAttribPointer(location, size, type, normalized, 0, NULL);
+}
+
+// Allocates the buffer bound to target and queues its contents
+template <class T>
+void MeshBuffers::streamData(GLenum target, GLuint bufferHandle, const std::vector<T> &data)
+{
+    glBufferData(target, data.size() * sizeof(T), NULL, GL_STATIC_DRAW);
+    if (data.empty())
+        return;
+
+    ++_pendingUploads;
+    _uploadManager->UploadBuffer(bufferHandle, data.data(), data.size() * sizeof(T),
+                                 [this]() { --_pendingUploads; });
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/gl_core_3_3.h>
+#include <glm/glm.hpp>
+
+#include "irenderer.hh"
+#include "uploadmanager.hh"
+
+// Buffer contents stream in through the upload manager; the mesh is not
+// drawn until all of them have arrived
+class MeshBuffers
+{
+public:
+    MeshBuffers(const RenderObject &object, GLuint instanceBuffer, UploadManager *uploadManager);
+    ~MeshBuffers();
+
+    // Uploads the model matrices to the instance buffer and draws every
+    // instance with a single call
+    void DrawInstanced(const std::vector<glm::mat4> &modelMatrices);
+
+    bool IsUploaded() const
+    {
+        return _pendingUploads == 0;
+    }
+
+public:
+    static const GLuint InstanceMatrixLocation = 4;
+
+private:
+    static const int BufferCount = 5;
+
+    GLuint _vaoHandle;
+    GLuint _bufferHandles[BufferCount];
+    GLuint _instanceBuffer;
+    GLsizei _vertexCount;
+    bool _hasLight;
+    int _pendingUploads;
+    UploadManager *_uploadManager;
+
+private:
+    template <class T>
+    void setUpAttribute(GLuint bufferHandle, GLuint location, GLint size, GLenum type,
+                        GLboolean normalized, const std::vector<T> &data);
+
+    template <class T>
+    void streamData(GLenum target, GLuint bufferHandle, const std::vector<T> &data);
+
+    MeshBuffers(const MeshBuffers &o) = delete;
+};
@@ -7,6 +7,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "shaderprogram.hh"
+#include "uploadmanager.hh"
 
 std::string GetShaderLog(GLuint shaderHandle)
 {
@@ -83,10 +84,20 @@ GLuint CreateShader(GLenum type, const std::string &fileName)
 
 ShaderProgram::ShaderProgram(const char *name)
 {
-    std::string vertexShaderFileName = std::string(name) + ".vert";
+    createProgram(name, name);
+}
+
+ShaderProgram::ShaderProgram(const char *vertexShaderName, const char *fragmentShaderName)
+{
+    createProgram(vertexShaderName, fragmentShaderName);
+}
+
+void ShaderProgram::createProgram(const char *vertexShaderName, const char *fragmentShaderName)
+{
+    std::string vertexShaderFileName = std::string(vertexShaderName) + ".vert";
     _vertexShaderHandle = CreateShader(GL_VERTEX_SHADER, vertexShaderFileName);
 
-    std::string fragmentShaderFileName = std::string(name) + ".frag";
+    std::string fragmentShaderFileName = std::string(fragmentShaderName) + ".frag";
     _fragmentShaderHandle = CreateShader(GL_FRAGMENT_SHADER, fragmentShaderFileName);
 
     _shaderProgramHandle = glCreateProgram();
@@ -143,14 +154,23 @@ void ShaderProgram::BindBuffer(GLenum targetType, GLuint bufferHandle)
     glBindBuffer(targetType, bufferHandle);
 }
 
-GLuint ShaderProgram::RegisterTexture(RawImageInfo *imageInfo)
+GLuint ShaderProgram::RegisterTexture(RawImageInfo *imageInfo, UploadManager *uploadManager)
 {
     GLuint textureId;
     glGenTextures(1, &textureId);
+    if (uploadManager != NULL)
+    {
+        uploadManager->UploadTexture(textureId, imageInfo, UploadManager::CompletionCallback());
+    }
+    else
+    {
+        glBindTexture(GL_TEXTURE_2D, textureId);
+        glTexImage2D(GL_TEXTURE_2D, 0, imageInfo->components,
+                     imageInfo->width, imageInfo->height, 0,
+                     imageInfo->components, GL_UNSIGNED_BYTE, imageInfo->data);
+    }
+
     glBindTexture(GL_TEXTURE_2D, textureId);
-    glTexImage2D(GL_TEXTURE_2D, 0, imageInfo->components,
-                 imageInfo->width, imageInfo->height, 0,
-                 imageInfo->components, GL_UNSIGNED_BYTE, imageInfo->data);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
@@ -172,6 +192,13 @@ GLuint ShaderProgram::GetUniformLocation(const char *uniformName)
     return glGetUniformLocation(_shaderProgramHandle, uniformName);
 }
 
+void ShaderProgram::BindUniformBlock(const char *blockName, GLuint binding)
+{
+    GLuint blockIndex = glGetUniformBlockIndex(_shaderProgramHandle, blockName);
+    if (blockIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(_shaderProgramHandle, blockIndex, binding);
+}
+
 void ShaderProgram::SetUniform(const char *uniformName, const int info)
 {
     GLuint uniformLocation = glGetUniformLocation(_shaderProgramHandle, uniformName);
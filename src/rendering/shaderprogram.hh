@@ -7,10 +7,13 @@
 
 #include "types.hh"
 
+class UploadManager;
+
 class ShaderProgram
 {
 public:
     ShaderProgram(const char *name);
+    ShaderProgram(const char *vertexShaderName, const char *fragmentShaderName);
     ~ShaderProgram();
 
     void Link();
@@ -26,9 +29,12 @@ public:
     void BindAttribPointer(GLuint location, GLint size, GLenum type, GLboolean normalized, GLsizei stride);
     void BufferData(GLenum targetType, const int size, const void *data);
 
-    GLuint RegisterTexture(RawImageInfo *imageInfo);
+    // With an upload manager the texture streams in over the next frames
+    // and the image must stay valid until it has
+    GLuint RegisterTexture(RawImageInfo *imageInfo, UploadManager *uploadManager = NULL);
     
     GLuint GetUniformLocation(const char *uniformName);
+    void BindUniformBlock(const char *blockName, GLuint binding);
     void SetUniform(const char *uniformName, const int info);
     void SetUniform(const char *uniformName, const float *info);
     void SetUniform(const char *uniformName, const glm::vec3 &info);
@@ -38,4 +44,7 @@ private:
     GLuint _vertexShaderHandle;
     GLuint _fragmentShaderHandle;
     GLuint _shaderProgramHandle;
+
+private:
+    void createProgram(const char *vertexShaderName, const char *fragmentShaderName);
 };
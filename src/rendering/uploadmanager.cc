@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <cstring>
+
+#include "texturecompression.hh"
+#include "uploadmanager.hh"
+
+static const size_t STAGING_ALIGNMENT = 16;
+static const GLuint64 FLUSH_WAIT_NANOSECONDS = 100000000;
+
+static bool IsTextureUpload(const RawImageInfo *image)
+{
+    return image != NULL;
+}
+
+// Texture levels are copied in whole rows, which for S3TC are rows of 4x4 blocks
+static unsigned int GetRowCount(const RawImageInfo &image, unsigned int level)
+{
+    unsigned int height = GetLevelHeight(image, level);
+    return IsCompressedImage(image) ? (height + 3) / 4 : height;
+}
+
+UploadManager::UploadManager(size_t frameBudget, unsigned int stagingBufferCount)
+    : _frameBudget(std::max<size_t>(frameBudget, 1)), _stagingBuffers(std::max(stagingBufferCount, 1u)),
+      _nextStagingBuffer(0), _pendingBytes(0), _lastFrameBytes(0)
+{
+    for (int i = 0; i < _stagingBuffers.size(); ++i)
+    {
+        StagingBuffer &staging = _stagingBuffers[i];
+        glGenBuffers(1, &staging.buffer);
+        glBindBuffer(GL_COPY_READ_BUFFER, staging.buffer);
+        glBufferData(GL_COPY_READ_BUFFER, _frameBudget, NULL, GL_STREAM_DRAW);
+        staging.size = _frameBudget;
+        staging.fence = NULL;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+UploadManager::~UploadManager()
+{
+    for (int i = 0; i < _stagingBuffers.size(); ++i)
+    {
+        if (_stagingBuffers[i].fence != NULL)
+            glDeleteSync(_stagingBuffers[i].fence);
+        glDeleteBuffers(1, &_stagingBuffers[i].buffer);
+    }
+
+    for (int i = 0; i < _uploads.size(); ++i)
+    {
+        delete _uploads[i];
+    }
+}
+
+void UploadManager::UploadTexture(GLuint textureId, const RawImageInfo *image, CompletionCallback onComplete)
+{
+    unsigned int levels = std::max(1u, image->levels);
+
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    for (unsigned int level = 0; level < levels; ++level)
+    {
+        if (IsCompressedImage(*image))
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, image->components,
+                                   GetLevelWidth(*image, level), GetLevelHeight(*image, level), 0,
+                                   GetLevelSize(*image, level), NULL);
+        }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_2D, level, image->components,
+                         GetLevelWidth(*image, level), GetLevelHeight(*image, level), 0,
+                         image->components, GL_UNSIGNED_BYTE, NULL);
+        }
+    }
+
+    Upload *upload = new Upload();
+    upload->target = textureId;
+    upload->image = image;
+    upload->level = 0;
+    upload->row = 0;
+    upload->offset = 0;
+    upload->onComplete = onComplete;
+    _uploads.push_back(upload);
+    _pendingBytes += GetImageSize(*image);
+}
+
+void UploadManager::UploadBuffer(GLuint bufferId, const void *data, size_t size, CompletionCallback onComplete)
+{
+    Upload *upload = new Upload();
+    upload->target = bufferId;
+    upload->image = NULL;
+    upload->level = 0;
+    upload->row = 0;
+    upload->data.assign((const unsigned char *)data, (const unsigned char *)data + size);
+    upload->offset = 0;
+    upload->onComplete = onComplete;
+    _uploads.push_back(upload);
+    _pendingBytes += size;
+}
+
+void UploadManager::Update()
+{
+    step(false);
+}
+
+void UploadManager::Flush()
+{
+    while (!_uploads.empty())
+    {
+        step(true);
+    }
+}
+
+// Stages as much of the queue as the budget allows in the next staging
+// buffer and submits it. Returns false when nothing could be staged.
+bool UploadManager::step(bool wait)
+{
+    _lastFrameBytes = 0;
+    if (_uploads.empty())
+        return false;
+
+    StagingBuffer &staging = _stagingBuffers[_nextStagingBuffer];
+    if (staging.fence != NULL)
+    {
+        GLenum status = glClientWaitSync(staging.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                         wait ? FLUSH_WAIT_NANOSECONDS : 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+            return false;
+
+        glDeleteSync(staging.fence);
+        staging.fence = NULL;
+    }
+
+    // A single row may be larger than the budget; it still goes through on its own
+    Chunk first;
+    planChunk(_uploads.front(), 0, _frameBudget, true, first);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer);
+    if (first.size > staging.size)
+    {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, first.size, NULL, GL_STREAM_DRAW);
+        staging.size = first.size;
+    }
+
+    // Unsynchronized is safe because the fence above has been passed
+    unsigned char *mapped = (unsigned char *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, staging.size,
+                                                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT |
+                                                              GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped == NULL)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+
+    size_t budget = std::min(_frameBudget, staging.size);
+    size_t used = 0;
+    _chunks.clear();
+    for (int i = 0; i < _uploads.size(); ++i)
+    {
+        Upload *upload = _uploads[i];
+        Chunk chunk;
+        while (planChunk(upload, (used + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT,
+                         budget, _chunks.empty(), chunk))
+        {
+            const unsigned char *source = IsTextureUpload(upload->image) ? upload->image->data : upload->data.data();
+            memcpy(mapped + chunk.stagingOffset, source + chunk.offset, chunk.size);
+            used = chunk.stagingOffset + chunk.size;
+
+            _chunks.push_back(chunk);
+            advance(upload, chunk);
+        }
+
+        // Later uploads only start once this one is fully staged
+        if (!isStaged(upload))
+            break;
+    }
+
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, staging.buffer);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < _chunks.size(); ++i)
+    {
+        submitChunk(_chunks[i]);
+        _lastFrameBytes += _chunks[i].size;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    staging.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _nextStagingBuffer = (_nextStagingBuffer + 1) % _stagingBuffers.size();
+    _pendingBytes -= _lastFrameBytes;
+
+    // Callbacks run last, since they may queue more uploads
+    std::vector<Upload*> completed;
+    while (!_uploads.empty())
+    {
+        if (!isStaged(_uploads.front()))
+            break;
+
+        completed.push_back(_uploads.front());
+        _uploads.pop_front();
+    }
+
+    for (int i = 0; i < completed.size(); ++i)
+    {
+        if (completed[i]->onComplete)
+            completed[i]->onComplete();
+        delete completed[i];
+    }
+
+    return true;
+}
+
+// Plans the next chunk of upload to be staged at stagingOffset, ending at or
+// before budget. With force, at least one row is planned regardless.
+bool UploadManager::planChunk(Upload *upload, size_t stagingOffset, size_t budget, bool force, Chunk &chunk)
+{
+    size_t available = budget > stagingOffset ? budget - stagingOffset : 0;
+
+    chunk.upload = upload;
+    chunk.stagingOffset = stagingOffset;
+    chunk.offset = upload->offset;
+
+    if (!IsTextureUpload(upload->image))
+    {
+        chunk.level = 0;
+        chunk.row = 0;
+        chunk.rowCount = 0;
+        chunk.size = std::min(upload->data.size() - upload->offset, available);
+        return chunk.size > 0;
+    }
+
+    const RawImageInfo &image = *upload->image;
+    if (upload->level >= std::max(1u, image.levels))
+        return false;
+
+    unsigned int rowCount = GetRowCount(image, upload->level);
+    size_t rowSize = GetLevelSize(image, upload->level) / rowCount;
+
+    chunk.level = upload->level;
+    chunk.row = upload->row;
+    chunk.rowCount = std::min<size_t>(rowCount - upload->row, available / rowSize);
+    if (chunk.rowCount == 0 && force)
+        chunk.rowCount = 1;
+    chunk.size = chunk.rowCount * rowSize;
+
+    return chunk.rowCount > 0;
+}
+
+bool UploadManager::isStaged(const Upload *upload)
+{
+    size_t size = IsTextureUpload(upload->image) ? GetImageSize(*upload->image) : upload->data.size();
+    return upload->offset >= size;
+}
+
+void UploadManager::advance(Upload *upload, const Chunk &chunk)
+{
+    upload->offset += chunk.size;
+    if (!IsTextureUpload(upload->image))
+        return;
+
+    upload->row += chunk.rowCount;
+    if (upload->row == GetRowCount(*upload->image, upload->level))
+    {
+        ++upload->level;
+        upload->row = 0;
+    }
+}
+
+void UploadManager::submitChunk(const Chunk &chunk)
+{
+    const RawImageInfo *image = chunk.upload->image;
+    if (!IsTextureUpload(image))
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, chunk.upload->target);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, chunk.stagingOffset, chunk.offset, chunk.size);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return;
+    }
+
+    // With a pixel unpack buffer bound the data pointer is an offset into it
+    const GLvoid *pixels = (const GLubyte *)NULL + chunk.stagingOffset;
+    GLsizei width = GetLevelWidth(*image, chunk.level);
+    GLint levelHeight = GetLevelHeight(*image, chunk.level);
+
+    glBindTexture(GL_TEXTURE_2D, chunk.upload->target);
+    if (IsCompressedImage(*image))
+    {
+        GLint y = chunk.row * 4;
+        GLsizei height = std::min<GLint>(chunk.rowCount * 4, levelHeight - y);
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, chunk.level, 0, y, width, height,
+                                  image->components, chunk.size, pixels);
+    }
+    else
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, chunk.level, 0, chunk.row, width, chunk.rowCount,
+                        image->components, GL_UNSIGNED_BYTE, pixels);
+    }
+}
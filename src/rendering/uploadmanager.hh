@@ -0,0 +1,109 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include <GL/gl_core_3_3.h>
+
+#include "types.hh"
+
+static const size_t DEFAULT_UPLOAD_FRAME_BUDGET = 4 * 1024 * 1024;
+static const unsigned int DEFAULT_UPLOAD_STAGING_BUFFER_COUNT = 3;
+
+// Streams texture levels and buffer contents to the GPU through a ring of
+// staging buffers. Each Update copies at most the frame budget, in whole
+// texture rows (block rows for S3TC), so a burst of new materials or meshes
+// is spread over several frames instead of stalling one. A staging buffer is
+// fenced after use and skipped until the GPU is done reading from it.
+class UploadManager
+{
+public:
+    typedef std::function<void()> CompletionCallback;
+
+    UploadManager(size_t frameBudget = DEFAULT_UPLOAD_FRAME_BUDGET,
+                  unsigned int stagingBufferCount = DEFAULT_UPLOAD_STAGING_BUFFER_COUNT);
+    ~UploadManager();
+
+    // Allocates storage for every level of the texture and queues its
+    // contents. The image must stay valid until onComplete is called.
+    // Compressed images need S3TC support, which the caller checks.
+    void UploadTexture(GLuint textureId, const RawImageInfo *image, CompletionCallback onComplete);
+
+    // The data is copied; the buffer must already have storage for size bytes
+    void UploadBuffer(GLuint bufferId, const void *data, size_t size, CompletionCallback onComplete);
+
+    // Spends up to the frame budget on queued uploads, call once per frame
+    void Update();
+
+    // Uploads everything that is queued, waiting for staging buffers as needed
+    void Flush();
+
+    bool IsIdle() const
+    {
+        return _uploads.empty();
+    }
+
+    size_t GetPendingBytes() const
+    {
+        return _pendingBytes;
+    }
+
+    size_t GetFrameBudget() const
+    {
+        return _frameBudget;
+    }
+
+    // Bytes copied by the last Update or by the last step of Flush
+    size_t GetLastFrameBytes() const
+    {
+        return _lastFrameBytes;
+    }
+
+private:
+    typedef struct Upload
+    {
+        GLuint target;
+        const RawImageInfo *image;
+        unsigned int level;
+        unsigned int row;
+        std::vector<unsigned char> data;
+        size_t offset;
+        CompletionCallback onComplete;
+    } Upload;
+
+    typedef struct StagingBuffer
+    {
+        GLuint buffer;
+        size_t size;
+        GLsync fence;
+    } StagingBuffer;
+
+    typedef struct Chunk
+    {
+        Upload *upload;
+        size_t stagingOffset;
+        unsigned int level;
+        unsigned int row;
+        unsigned int rowCount;
+        size_t offset;
+        size_t size;
+    } Chunk;
+
+    size_t _frameBudget;
+    std::vector<StagingBuffer> _stagingBuffers;
+    unsigned int _nextStagingBuffer;
+    std::deque<Upload*> _uploads;
+    std::vector<Chunk> _chunks;
+    size_t _pendingBytes;
+    size_t _lastFrameBytes;
+
+private:
+    bool step(bool wait);
+    bool planChunk(Upload *upload, size_t stagingOffset, size_t budget, bool force, Chunk &chunk);
+    static bool isStaged(const Upload *upload);
+    void advance(Upload *upload, const Chunk &chunk);
+    void submitChunk(const Chunk &chunk);
+
+    UploadManager(const UploadManager &o) = delete;
+};
@@ -27,6 +27,12 @@ public:
         return _mouseTracker->IsButtonDownFrame(_button);
     }
 
+    bool GetInputSources(std::vector<InputSource> &sources)
+    {
+        sources.push_back(GetMouseButtonSource(_button));
+        return true;
+    }
+
 private:
     MouseTracker *_mouseTracker;
     System::MouseButton _button;
@@ -46,6 +52,12 @@ public:
         return _mouseTracker->IsButtonUpFrame(_button);
     }
 
+    bool GetInputSources(std::vector<InputSource> &sources)
+    {
+        sources.push_back(GetMouseButtonSource(_button));
+        return true;
+    }
+
 private:
     MouseTracker *_mouseTracker;
     System::MouseButton _button;
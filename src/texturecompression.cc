@@ -0,0 +1,673 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "texturecompression.hh"
+
+using std::string;
+using std::vector;
+
+static const unsigned int DDS_MAGIC = 0x20534444; // "DDS "
+static const unsigned int DDS_FOURCC_DXT1 = 0x31545844;
+static const unsigned int DDS_FOURCC_DXT5 = 0x35545844;
+static const unsigned int DDS_COOKED_TAG = 0x58544b43; // "CKTX"
+
+static const unsigned int DDSD_CAPS = 0x1;
+static const unsigned int DDSD_HEIGHT = 0x2;
+static const unsigned int DDSD_WIDTH = 0x4;
+static const unsigned int DDSD_PIXELFORMAT = 0x1000;
+static const unsigned int DDSD_MIPMAPCOUNT = 0x20000;
+static const unsigned int DDSD_LINEARSIZE = 0x80000;
+static const unsigned int DDPF_FOURCC = 0x4;
+static const unsigned int DDSCAPS_COMPLEX = 0x8;
+static const unsigned int DDSCAPS_TEXTURE = 0x1000;
+static const unsigned int DDSCAPS_MIPMAP = 0x400000;
+
+typedef struct DDSPixelFormat
+{
+    unsigned int size;
+    unsigned int flags;
+    unsigned int fourCC;
+    unsigned int rgbBitCount;
+    unsigned int masks[4];
+} DDSPixelFormat;
+
+// The cooked source stamp lives in reserved[0..4]
+typedef struct DDSHeader
+{
+    unsigned int size;
+    unsigned int flags;
+    unsigned int height;
+    unsigned int width;
+    unsigned int linearSize;
+    unsigned int depth;
+    unsigned int mipMapCount;
+    unsigned int reserved[11];
+    DDSPixelFormat format;
+    unsigned int caps[4];
+    unsigned int reserved2;
+} DDSHeader;
+
+static unsigned short PackColor565(const unsigned char *color)
+{
+    return (unsigned short)(((color[0] * 31 + 127) / 255) << 11 |
+                            ((color[1] * 63 + 127) / 255) << 5 |
+                            ((color[2] * 31 + 127) / 255));
+}
+
+static void UnpackColor565(unsigned short packed, int *color)
+{
+    int red = packed >> 11;
+    int green = (packed >> 5) & 63;
+    int blue = packed & 31;
+
+    color[0] = red << 3 | red >> 2;
+    color[1] = green << 2 | green >> 4;
+    color[2] = blue << 3 | blue >> 2;
+}
+
+static void WriteLittleEndian(unsigned char *destination, unsigned long long value, int byteCount)
+{
+    for (int i = 0; i < byteCount; ++i)
+    {
+        destination[i] = (unsigned char)(value >> (i * 8));
+    }
+}
+
+static unsigned long long ReadLittleEndian(const unsigned char *source, int byteCount)
+{
+    unsigned long long value = 0;
+    for (int i = 0; i < byteCount; ++i)
+    {
+        value |= (unsigned long long)source[i] << (i * 8);
+    }
+
+    return value;
+}
+
+static void FindBlockBounds(const unsigned char *pixels, unsigned char *minimum, unsigned char *maximum)
+{
+#if defined(__SSE2__)
+    __m128i rows[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        rows[i] = _mm_loadu_si128((const __m128i *)(pixels + i * 16));
+    }
+
+    __m128i low = _mm_min_epu8(_mm_min_epu8(rows[0], rows[1]), _mm_min_epu8(rows[2], rows[3]));
+    __m128i high = _mm_max_epu8(_mm_max_epu8(rows[0], rows[1]), _mm_max_epu8(rows[2], rows[3]));
+    low = _mm_min_epu8(low, _mm_srli_si128(low, 8));
+    low = _mm_min_epu8(low, _mm_srli_si128(low, 4));
+    high = _mm_max_epu8(high, _mm_srli_si128(high, 8));
+    high = _mm_max_epu8(high, _mm_srli_si128(high, 4));
+
+    unsigned int packedLow = _mm_cvtsi128_si32(low);
+    unsigned int packedHigh = _mm_cvtsi128_si32(high);
+    memcpy(minimum, &packedLow, 4);
+    memcpy(maximum, &packedHigh, 4);
+#else
+    memcpy(minimum, pixels, 4);
+    memcpy(maximum, pixels, 4);
+    for (int i = 1; i < 16; ++i)
+    {
+        for (int channel = 0; channel < 4; ++channel)
+        {
+            minimum[channel] = std::min(minimum[channel], pixels[i * 4 + channel]);
+            maximum[channel] = std::max(maximum[channel], pixels[i * 4 + channel]);
+        }
+    }
+#endif
+}
+
+// Projections of each pixel onto the endpoint axis, relative to the low endpoint
+static void ProjectBlock(const unsigned char *pixels, const int *low, const int *axis, int *projections)
+{
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i base = _mm_setr_epi16(low[0], low[1], low[2], 0, low[0], low[1], low[2], 0);
+    const __m128i direction = _mm_setr_epi16(axis[0], axis[1], axis[2], 0, axis[0], axis[1], axis[2], 0);
+
+    for (int row = 0; row < 4; ++row)
+    {
+        __m128i packed = _mm_loadu_si128((const __m128i *)(pixels + row * 16));
+        __m128i first = _mm_madd_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(packed, zero), base), direction);
+        __m128i second = _mm_madd_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(packed, zero), base), direction);
+
+        // Each pixel's dot product is split over two lanes
+        first = _mm_add_epi32(first, _mm_srli_epi64(first, 32));
+        second = _mm_add_epi32(second, _mm_srli_epi64(second, 32));
+
+        __m128 sums = _mm_shuffle_ps(_mm_castsi128_ps(first), _mm_castsi128_ps(second), _MM_SHUFFLE(2, 0, 2, 0));
+        _mm_storeu_si128((__m128i *)(projections + row * 4), _mm_castps_si128(sums));
+    }
+#else
+    for (int i = 0; i < 16; ++i)
+    {
+        projections[i] = 0;
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            projections[i] += (pixels[i * 4 + channel] - low[channel]) * axis[channel];
+        }
+    }
+#endif
+}
+
+// Flips green and blue across the bounding box when they fall as red (or
+// green, for blocks without red variation) rises, so the endpoints lie on
+// the diagonal the colors actually follow
+static void SelectDiagonal(const unsigned char *pixels, unsigned char *high, unsigned char *low)
+{
+    int center[3];
+    for (int channel = 0; channel < 3; ++channel)
+    {
+        center[channel] = (high[channel] + low[channel]) / 2;
+    }
+
+    int covariance[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; ++i)
+    {
+        int red = pixels[i * 4] - center[0];
+        int green = pixels[i * 4 + 1] - center[1];
+        int blue = pixels[i * 4 + 2] - center[2];
+        covariance[0] += red * green;
+        covariance[1] += red * blue;
+        covariance[2] += green * blue;
+    }
+
+    bool redVaries = high[0] != low[0];
+    if (redVaries && covariance[0] < 0)
+        std::swap(high[1], low[1]);
+
+    int blueCovariance = redVaries ? covariance[1] : covariance[2];
+    if (blueCovariance < 0)
+        std::swap(high[2], low[2]);
+}
+
+// Bounding box endpoints inset by 1/16th of the range, as in van Waveren's
+// real-time DXT encoder, with indices chosen by projection onto the axis
+static void EncodeColorBlock(const unsigned char *pixels, const unsigned char *minimum,
+                             const unsigned char *maximum, unsigned char *block)
+{
+    unsigned char high[3];
+    unsigned char low[3];
+    for (int channel = 0; channel < 3; ++channel)
+    {
+        int inset = (maximum[channel] - minimum[channel]) >> 4;
+        high[channel] = maximum[channel] - inset;
+        low[channel] = minimum[channel] + inset;
+    }
+
+    SelectDiagonal(pixels, high, low);
+
+    unsigned short color0 = PackColor565(high);
+    unsigned short color1 = PackColor565(low);
+    unsigned int indices = 0;
+
+    // Four-color blocks need color0 > color1
+    if (color0 < color1)
+        std::swap(color0, color1);
+
+    if (color0 != color1)
+    {
+        int endpoint0[3];
+        int endpoint1[3];
+        UnpackColor565(color0, endpoint0);
+        UnpackColor565(color1, endpoint1);
+
+        int axis[3];
+        int lengthSquared = 0;
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            axis[channel] = endpoint0[channel] - endpoint1[channel];
+            lengthSquared += axis[channel] * axis[channel];
+        }
+
+        int projections[16];
+        ProjectBlock(pixels, endpoint1, axis, projections);
+
+        // Thresholds at 1/6, 3/6 and 5/6 of the way to color0 pick
+        // color1, 2/3 color1 + 1/3 color0, 1/3 color1 + 2/3 color0 and color0
+        static const unsigned int paletteIndex[4] = { 1, 3, 2, 0 };
+        for (int i = 0; i < 16; ++i)
+        {
+            int scaled = projections[i] * 6;
+            int step = (scaled > lengthSquared) + (scaled > 3 * lengthSquared) + (scaled > 5 * lengthSquared);
+            indices |= paletteIndex[step] << (i * 2);
+        }
+    }
+
+    WriteLittleEndian(block, color0, 2);
+    WriteLittleEndian(block + 2, color1, 2);
+    WriteLittleEndian(block + 4, indices, 4);
+}
+
+void EncodeBC1Block(const unsigned char *pixels, unsigned char *block)
+{
+    unsigned char minimum[4];
+    unsigned char maximum[4];
+    FindBlockBounds(pixels, minimum, maximum);
+    EncodeColorBlock(pixels, minimum, maximum, block);
+}
+
+void EncodeBC3Block(const unsigned char *pixels, unsigned char *block)
+{
+    unsigned char minimum[4];
+    unsigned char maximum[4];
+    FindBlockBounds(pixels, minimum, maximum);
+
+    int alphaRange = maximum[3] - minimum[3];
+    unsigned long long indices = 0;
+
+    if (alphaRange > 0)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            int step = ((pixels[i * 4 + 3] - minimum[3]) * 7 + alphaRange / 2) / alphaRange;
+            unsigned long long index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+            indices |= index << (i * 3);
+        }
+    }
+
+    block[0] = maximum[3];
+    block[1] = minimum[3];
+    WriteLittleEndian(block + 2, indices, 6);
+    EncodeColorBlock(pixels, minimum, maximum, block + 8);
+}
+
+static void DecodeColorBlock(const unsigned char *block, unsigned char *pixels, bool allowTransparent)
+{
+    unsigned short color0 = (unsigned short)ReadLittleEndian(block, 2);
+    unsigned short color1 = (unsigned short)ReadLittleEndian(block + 2, 2);
+    unsigned int indices = (unsigned int)ReadLittleEndian(block + 4, 4);
+
+    int palette[4][4];
+    UnpackColor565(color0, palette[0]);
+    UnpackColor565(color1, palette[1]);
+
+    bool fourColors = color0 > color1 || !allowTransparent;
+    for (int channel = 0; channel < 3; ++channel)
+    {
+        if (fourColors)
+        {
+            palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+            palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+        }
+        else
+        {
+            palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+            palette[3][channel] = 0;
+        }
+    }
+
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = fourColors ? 255 : 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        const int *color = palette[(indices >> (i * 2)) & 3];
+        for (int channel = 0; channel < 4; ++channel)
+        {
+            pixels[i * 4 + channel] = (unsigned char)color[channel];
+        }
+    }
+}
+
+void DecodeBC1Block(const unsigned char *block, unsigned char *pixels)
+{
+    DecodeColorBlock(block, pixels, true);
+}
+
+void DecodeBC3Block(const unsigned char *block, unsigned char *pixels)
+{
+    DecodeColorBlock(block + 8, pixels, false);
+
+    int alpha[8];
+    alpha[0] = block[0];
+    alpha[1] = block[1];
+    if (alpha[0] > alpha[1])
+    {
+        for (int i = 2; i < 8; ++i)
+        {
+            alpha[i] = ((8 - i) * alpha[0] + (i - 1) * alpha[1]) / 7;
+        }
+    }
+    else
+    {
+        for (int i = 2; i < 6; ++i)
+        {
+            alpha[i] = ((6 - i) * alpha[0] + (i - 1) * alpha[1]) / 5;
+        }
+        alpha[6] = 0;
+        alpha[7] = 255;
+    }
+
+    unsigned long long indices = ReadLittleEndian(block + 2, 6);
+    for (int i = 0; i < 16; ++i)
+    {
+        pixels[i * 4 + 3] = (unsigned char)alpha[(indices >> (i * 3)) & 7];
+    }
+}
+
+bool IsCompressedImage(const RawImageInfo &image)
+{
+    return image.components == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ||
+        image.components == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+unsigned int GetLevelWidth(const RawImageInfo &image, unsigned int level)
+{
+    return std::max(1u, image.width >> level);
+}
+
+unsigned int GetLevelHeight(const RawImageInfo &image, unsigned int level)
+{
+    return std::max(1u, image.height >> level);
+}
+
+static unsigned int GetComponentCount(const RawImageInfo &image)
+{
+    return image.components == GL_RGB ? 3 : 4;
+}
+
+size_t GetLevelSize(const RawImageInfo &image, unsigned int level)
+{
+    size_t width = GetLevelWidth(image, level);
+    size_t height = GetLevelHeight(image, level);
+
+    if (!IsCompressedImage(image))
+        return width * height * GetComponentCount(image);
+
+    size_t blockSize = image.components == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16;
+    return ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+size_t GetImageSize(const RawImageInfo &image)
+{
+    size_t size = 0;
+    for (unsigned int level = 0; level < std::max(1u, image.levels); ++level)
+    {
+        size += GetLevelSize(image, level);
+    }
+
+    return size;
+}
+
+static vector<unsigned char> ToRGBA(const RawImageInfo &image)
+{
+    size_t pixelCount = (size_t)image.width * image.height;
+    vector<unsigned char> pixels(pixelCount * 4, 255);
+    unsigned int componentCount = GetComponentCount(image);
+
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        memcpy(&pixels[i * 4], image.data + i * componentCount, componentCount);
+    }
+
+    return pixels;
+}
+
+static vector<unsigned char> Downsample(const vector<unsigned char> &pixels, unsigned int width, unsigned int height)
+{
+    unsigned int halfWidth = std::max(1u, width / 2);
+    unsigned int halfHeight = std::max(1u, height / 2);
+    vector<unsigned char> result(halfWidth * halfHeight * 4);
+
+    for (unsigned int y = 0; y < halfHeight; ++y)
+    {
+        for (unsigned int x = 0; x < halfWidth; ++x)
+        {
+            unsigned int x0 = std::min(x * 2, width - 1);
+            unsigned int x1 = std::min(x * 2 + 1, width - 1);
+            unsigned int y0 = std::min(y * 2, height - 1);
+            unsigned int y1 = std::min(y * 2 + 1, height - 1);
+
+            for (int channel = 0; channel < 4; ++channel)
+            {
+                int sum = pixels[(y0 * width + x0) * 4 + channel] + pixels[(y0 * width + x1) * 4 + channel] +
+                    pixels[(y1 * width + x0) * 4 + channel] + pixels[(y1 * width + x1) * 4 + channel];
+                result[(y * halfWidth + x) * 4 + channel] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+
+    return result;
+}
+
+static void CompressLevel(const vector<unsigned char> &pixels, unsigned int width, unsigned int height,
+                          bool hasAlpha, unsigned char *destination)
+{
+    unsigned char block[64];
+    size_t blockSize = hasAlpha ? 16 : 8;
+
+    for (unsigned int blockY = 0; blockY < height; blockY += 4)
+    {
+        for (unsigned int blockX = 0; blockX < width; blockX += 4)
+        {
+            // Edge blocks repeat the last row and column
+            for (unsigned int y = 0; y < 4; ++y)
+            {
+                for (unsigned int x = 0; x < 4; ++x)
+                {
+                    unsigned int sourceX = std::min(blockX + x, width - 1);
+                    unsigned int sourceY = std::min(blockY + y, height - 1);
+                    memcpy(&block[(y * 4 + x) * 4], &pixels[(sourceY * width + sourceX) * 4], 4);
+                }
+            }
+
+            if (hasAlpha)
+                EncodeBC3Block(block, destination);
+            else
+                EncodeBC1Block(block, destination);
+            destination += blockSize;
+        }
+    }
+}
+
+RawImageInfo *CompressImage(const RawImageInfo &image, bool generateMips)
+{
+    vector<unsigned char> pixels = ToRGBA(image);
+
+    bool hasAlpha = false;
+    for (size_t i = 3; i < pixels.size() && !hasAlpha; i += 4)
+    {
+        hasAlpha = pixels[i] != 255;
+    }
+
+    RawImageInfo *compressed = (RawImageInfo *) malloc(sizeof(RawImageInfo));
+    compressed->width = image.width;
+    compressed->height = image.height;
+    compressed->components = hasAlpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    compressed->levels = 1;
+
+    if (generateMips)
+    {
+        while (GetLevelWidth(*compressed, compressed->levels - 1) > 1 || GetLevelHeight(*compressed, compressed->levels - 1) > 1)
+        {
+            ++compressed->levels;
+        }
+    }
+
+    compressed->data = (ImageData) malloc(GetImageSize(*compressed));
+
+    unsigned char *destination = compressed->data;
+    for (unsigned int level = 0; level < compressed->levels; ++level)
+    {
+        unsigned int width = GetLevelWidth(*compressed, level);
+        unsigned int height = GetLevelHeight(*compressed, level);
+
+        if (level > 0)
+            pixels = Downsample(pixels, GetLevelWidth(*compressed, level - 1), GetLevelHeight(*compressed, level - 1));
+
+        CompressLevel(pixels, width, height, hasAlpha, destination);
+        destination += GetLevelSize(*compressed, level);
+    }
+
+    return compressed;
+}
+
+RawImageInfo *DecompressImage(const RawImageInfo &image, unsigned int level)
+{
+    const unsigned char *source = image.data;
+    for (unsigned int i = 0; i < level; ++i)
+    {
+        source += GetLevelSize(image, i);
+    }
+
+    RawImageInfo *decompressed = (RawImageInfo *) malloc(sizeof(RawImageInfo));
+    decompressed->width = GetLevelWidth(image, level);
+    decompressed->height = GetLevelHeight(image, level);
+    decompressed->components = GL_RGBA;
+    decompressed->levels = 1;
+    decompressed->data = (ImageData) malloc(GetLevelSize(*decompressed, 0));
+
+    bool hasAlpha = image.components == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    size_t blockSize = hasAlpha ? 16 : 8;
+    unsigned char block[64];
+
+    for (unsigned int blockY = 0; blockY < decompressed->height; blockY += 4)
+    {
+        for (unsigned int blockX = 0; blockX < decompressed->width; blockX += 4)
+        {
+            if (hasAlpha)
+                DecodeBC3Block(source, block);
+            else
+                DecodeBC1Block(source, block);
+            source += blockSize;
+
+            for (unsigned int y = 0; y < 4 && blockY + y < decompressed->height; ++y)
+            {
+                for (unsigned int x = 0; x < 4 && blockX + x < decompressed->width; ++x)
+                {
+                    memcpy(&decompressed->data[((blockY + y) * decompressed->width + blockX + x) * 4], &block[(y * 4 + x) * 4], 4);
+                }
+            }
+        }
+    }
+
+    return decompressed;
+}
+
+bool SaveDDS(const string &fileName, const RawImageInfo &image,
+             unsigned long long sourceSize, long long sourceModificationTime)
+{
+    if (!IsCompressedImage(image))
+        return false;
+
+    DDSHeader header;
+    memset(&header, 0, sizeof(header));
+    header.size = sizeof(DDSHeader);
+    header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    header.height = image.height;
+    header.width = image.width;
+    header.linearSize = GetLevelSize(image, 0);
+    header.mipMapCount = std::max(1u, image.levels);
+    header.reserved[0] = DDS_COOKED_TAG;
+    WriteLittleEndian((unsigned char *)&header.reserved[1], sourceSize, 8);
+    WriteLittleEndian((unsigned char *)&header.reserved[3], sourceModificationTime, 8);
+    header.format.size = sizeof(DDSPixelFormat);
+    header.format.flags = DDPF_FOURCC;
+    header.format.fourCC = image.components == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? DDS_FOURCC_DXT1 : DDS_FOURCC_DXT5;
+    header.caps[0] = DDSCAPS_TEXTURE | (header.mipMapCount > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+    FILE *file = fopen(fileName.c_str(), "wb");
+    if (file == NULL)
+        return false;
+
+    bool written = fwrite(&DDS_MAGIC, sizeof(DDS_MAGIC), 1, file) == 1 &&
+        fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(image.data, GetImageSize(image), 1, file) == 1;
+    fclose(file);
+
+    return written;
+}
+
+RawImageInfo *LoadDDS(const string &fileName, unsigned long long *sourceSize, long long *sourceModificationTime)
+{
+    FILE *file = fopen(fileName.c_str(), "rb");
+    if (file == NULL)
+        return NULL;
+
+    unsigned int magic = 0;
+    DDSHeader header;
+    if (fread(&magic, sizeof(magic), 1, file) != 1 || fread(&header, sizeof(header), 1, file) != 1 ||
+        magic != DDS_MAGIC || header.size != sizeof(DDSHeader) || (header.format.flags & DDPF_FOURCC) == 0 ||
+        (header.format.fourCC != DDS_FOURCC_DXT1 && header.format.fourCC != DDS_FOURCC_DXT5) ||
+        header.width == 0 || header.height == 0 || header.mipMapCount > 32)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    RawImageInfo *image = (RawImageInfo *) malloc(sizeof(RawImageInfo));
+    image->width = header.width;
+    image->height = header.height;
+    image->components = header.format.fourCC == DDS_FOURCC_DXT1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    image->levels = (header.flags & DDSD_MIPMAPCOUNT) != 0 ? std::max(1u, header.mipMapCount) : 1;
+
+    size_t size = GetImageSize(*image);
+    image->data = (ImageData) malloc(size);
+    if (fread(image->data, size, 1, file) != 1)
+    {
+        fclose(file);
+        free(image->data);
+        free(image);
+        return NULL;
+    }
+    fclose(file);
+
+    bool cooked = header.reserved[0] == DDS_COOKED_TAG;
+    if (sourceSize != NULL)
+        *sourceSize = cooked ? ReadLittleEndian((const unsigned char *)&header.reserved[1], 8) : 0;
+    if (sourceModificationTime != NULL)
+        *sourceModificationTime = cooked ? ReadLittleEndian((const unsigned char *)&header.reserved[3], 8) : 0;
+
+    return image;
+}
+
+string GetCookedTexturePath(const string &fileName)
+{
+    return fileName + ".cooked.dds";
+}
+
+RawImageInfo *LoadTextureCached(const string &fileName, ImageLoaderFunction loader)
+{
+    struct stat sourceStat;
+    if (stat(fileName.c_str(), &sourceStat) != 0)
+        return loader(fileName);
+
+    string cookedFileName = GetCookedTexturePath(fileName);
+    unsigned long long sourceSize;
+    long long sourceModificationTime;
+    RawImageInfo *cooked = LoadDDS(cookedFileName, &sourceSize, &sourceModificationTime);
+
+    if (cooked != NULL)
+    {
+        if (sourceSize == (unsigned long long)sourceStat.st_size && sourceModificationTime == sourceStat.st_mtime)
+            return cooked;
+
+        free(cooked->data);
+        free(cooked);
+    }
+
+    RawImageInfo *source = loader(fileName);
+    if (source == NULL)
+        return NULL;
+
+    cooked = CompressImage(*source);
+    free(source->data);
+    free(source);
+
+    // A read-only asset directory just means cooking again next launch
+    SaveDDS(cookedFileName, *cooked, sourceStat.st_size, sourceStat.st_mtime);
+
+    return cooked;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+
+#include "imagecache.hh"
+#include "types.hh"
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// Blocks are 4x4 RGBA pixels in row order, 64 bytes. BC1 blocks are
+// 8 bytes and BC3 blocks are 16.
+void EncodeBC1Block(const unsigned char *pixels, unsigned char *block);
+void EncodeBC3Block(const unsigned char *pixels, unsigned char *block);
+void DecodeBC1Block(const unsigned char *block, unsigned char *pixels);
+void DecodeBC3Block(const unsigned char *block, unsigned char *pixels);
+
+bool IsCompressedImage(const RawImageInfo &image);
+unsigned int GetLevelWidth(const RawImageInfo &image, unsigned int level);
+unsigned int GetLevelHeight(const RawImageInfo &image, unsigned int level);
+size_t GetLevelSize(const RawImageInfo &image, unsigned int level);
+size_t GetImageSize(const RawImageInfo &image);
+
+// Encodes an RGB or RGBA image to BC1, or to BC3 when any pixel is not
+// opaque, with a box-filtered mip chain down to 1x1. The result is
+// malloc'd like the images the loaders return.
+RawImageInfo *CompressImage(const RawImageInfo &image, bool generateMips = true);
+
+// RGBA8 pixels of one level, for GPUs without S3TC and for tests
+RawImageInfo *DecompressImage(const RawImageInfo &image, unsigned int level);
+
+bool SaveDDS(const std::string &fileName, const RawImageInfo &image,
+             unsigned long long sourceSize = 0, long long sourceModificationTime = 0);
+RawImageInfo *LoadDDS(const std::string &fileName,
+                      unsigned long long *sourceSize = NULL, long long *sourceModificationTime = NULL);
+
+// Cooked textures live next to their source as "<source>.cooked.dds" and
+// are only used while the source keeps its recorded size and mtime;
+// otherwise the source is decoded with loader, compressed and re-cooked
+std::string GetCookedTexturePath(const std::string &fileName);
+RawImageInfo *LoadTextureCached(const std::string &fileName, ImageLoaderFunction loader);
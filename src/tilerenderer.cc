@@ -1,8 +1,10 @@
+#include "imagecache.hh"
 #include "tilerenderer.hh"
+#include "utility/profiler.hh"
 
-TileRenderer::TileRenderer(IRenderer *renderer, RawImageInfo *tilemapImage, float tileWidth, float tileHeight)
-    : _renderer(renderer), _tilemapWidth(tilemapImage->width),
-      _tilemapHeight(tilemapImage->height), _tileWidth(tileWidth),
+TileRenderer::TileRenderer(IRenderer *renderer, ImageHandle *tilemapImage, float tileWidth, float tileHeight)
+    : _renderer(renderer), _tilemapWidth(tilemapImage->Wait()->width),
+      _tilemapHeight(tilemapImage->Wait()->height), _tileWidth(tileWidth),
       _tileHeight(tileHeight)
 {
     MaterialInfo tilemapMaterialInfo;
@@ -10,7 +12,9 @@ TileRenderer::TileRenderer(IRenderer *renderer, RawImageInfo *tilemapImage, floa
     tilemapMaterialInfo.Kd = glm::vec3(1.0f, 1.0f, 1.0f);
     tilemapMaterialInfo.Ks = glm::vec3(0.0f, 0.0f, 0.0f);
     tilemapMaterialInfo.shininess = 1.0f;
-    tilemapMaterialInfo.Kd_imageInfo = tilemapImage;
+    tilemapMaterialInfo.Kd_image = tilemapImage;
+    tilemapMaterialInfo.Ks_image = NULL;
+    tilemapMaterialInfo.normal_image = NULL;
 
     _materialId = _renderer->RegisterMaterial(tilemapMaterialInfo);
 }
@@ -18,28 +22,46 @@ TileRenderer::TileRenderer(IRenderer *renderer, RawImageInfo *tilemapImage, floa
 void TileRenderer::Render(IndexValue tileX, IndexValue tileY,
                           const glm::vec4 &location, Direction direction)
 {
-    std::vector<IndexValue> indices;
-    std::vector<float> vertices;
-    std::vector<float> normals;
+    RenderObject object;
+    AppendFace(object, tileX, tileY, location, direction);
+    Render(object);
+}
+
+void TileRenderer::Render(const RenderObject &object)
+{
+    PROFILE_SCOPE("TileRenderer::Render");
+
+    if (object._indices.empty())
+        return;
+
+    _renderer->Render(object._indices, object._vertices, object._normals,
+                      object._uvCoords, object._light, _materialId);
+}
+
+void TileRenderer::AppendFace(RenderObject &object, IndexValue tileX, IndexValue tileY,
+                              const glm::vec4 &location, Direction direction, float size)
+{
+    std::vector<IndexValue> &indices = object._indices;
+    std::vector<float> &vertices = object._vertices;
+    std::vector<float> &normals = object._normals;
     std::vector<float> UVs = GetUVsForTile(tileX, tileY);
 
-    indices.push_back(0);
-    indices.push_back(1);
-    indices.push_back(2);
-    indices.push_back(3);
-    indices.push_back(4);
-    indices.push_back(5);
+    IndexValue firstIndex = indices.size();
+    for (IndexValue i = 0; i < 6; ++i)
+    {
+        indices.push_back(firstIndex + i);
+    }
 
     switch(direction)
     {
     case Direction::Up:
         addToVector(vertices, location);
-        addToVector(vertices, location + glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(1.0f, 0.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f, 0.0f, 1.0f, 0.0f));
 
         addToVector(vertices, location);
-        addToVector(vertices, location + glm::vec4(1.0f, 0.0f, 1.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f, 0.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
 
         addToVector(normals, glm::vec3(0.0f, 1.0f, 0.0f));
         addToVector(normals, glm::vec3(0.0f, 1.0f, 0.0f));
@@ -51,13 +73,13 @@ void TileRenderer::Render(IndexValue tileX, IndexValue tileY,
         break;
 
     case Direction::Down:
-        addToVector(vertices, location + glm::vec4(0.0f, -1.0f, 0.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(1.0f, -1.0f, 0.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(1.0f, -1.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f, -1.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f, -1.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f, -1.0f, 1.0f, 0.0f));
 
-        addToVector(vertices, location + glm::vec4(0.0f, -1.0f, 0.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(1.0f, -1.0f, 1.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(0.0f, -1.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f, -1.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f, -1.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f, -1.0f, 1.0f, 0.0f));
 
         addToVector(normals, glm::vec3(0.0f,-1.0f, 0.0f));
         addToVector(normals, glm::vec3(0.0f,-1.0f, 0.0f));
@@ -69,13 +91,13 @@ void TileRenderer::Render(IndexValue tileX, IndexValue tileY,
         break;
 
     case Direction::Left:
-        addToVector(vertices, location + glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(0.0f,-1.0f, 0.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(0.0f,-1.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f,-1.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f,-1.0f, 1.0f, 0.0f));
 
-        addToVector(vertices, location + glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(0.0f,-1.0f, 1.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f,-1.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
 
         addToVector(normals, glm::vec3(-1.0f, 0.0f, 0.0f));
         addToVector(normals, glm::vec3(-1.0f, 0.0f, 0.0f));
@@ -87,13 +109,13 @@ void TileRenderer::Render(IndexValue tileX, IndexValue tileY,
         break;
 
     case Direction::Right:
-        addToVector(vertices, location + glm::vec4(1.0f, 0.0f, 1.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(1.0f,-1.0f, 1.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(1.0f,-1.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f, 0.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f,-1.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f,-1.0f, 0.0f, 0.0f));
 
-        addToVector(vertices, location + glm::vec4(1.0f, 0.0f, 1.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(1.0f,-1.0f, 0.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f, 0.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f,-1.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
 
         addToVector(normals, glm::vec3( 1.0f, 0.0f, 0.0f));
         addToVector(normals, glm::vec3( 1.0f, 0.0f, 0.0f));
@@ -105,13 +127,13 @@ void TileRenderer::Render(IndexValue tileX, IndexValue tileY,
         break;
 
     case Direction::Forward:
-        addToVector(vertices, location + glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(0.0f,-1.0f, 1.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(1.0f,-1.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f,-1.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f,-1.0f, 1.0f, 0.0f));
 
-        addToVector(vertices, location + glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(1.0f,-1.0f, 1.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(1.0f, 0.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f,-1.0f, 1.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f, 0.0f, 1.0f, 0.0f));
 
         addToVector(normals, glm::vec3( 0.0f, 0.0f, 1.0f));
         addToVector(normals, glm::vec3( 0.0f, 0.0f, 1.0f));
@@ -123,13 +145,13 @@ void TileRenderer::Render(IndexValue tileX, IndexValue tileY,
         break;
 
     case Direction::Backward:
-        addToVector(vertices, location + glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(1.0f,-1.0f, 0.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(0.0f,-1.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f,-1.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f,-1.0f, 0.0f, 0.0f));
 
-        addToVector(vertices, location + glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(0.0f,-1.0f, 0.0f, 0.0f));
-        addToVector(vertices, location + glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f,-1.0f, 0.0f, 0.0f));
+        addToVector(vertices, location + size * glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
 
         addToVector(normals, glm::vec3( 0.0f, 0.0f, 1.0f));
         addToVector(normals, glm::vec3( 0.0f, 0.0f, 1.0f));
@@ -141,7 +163,7 @@ void TileRenderer::Render(IndexValue tileX, IndexValue tileY,
         break;
     }
 
-    _renderer->Render(indices, vertices, normals, UVs, _materialId);
+    object._uvCoords.insert(object._uvCoords.end(), UVs.begin(), UVs.end());
 }
 
 void TileRenderer::addToVector(std::vector<float> &list, const glm::vec4 &vec)
@@ -20,11 +20,16 @@ enum class Direction
 class TileRenderer
 {
 public:
-    TileRenderer(IRenderer *renderer, RawImageInfo *tilemapImage,
+    TileRenderer(IRenderer *renderer, ImageHandle *tilemapImage,
                  float tileWidth, float tileHeight);
 
     void Render(IndexValue tileX, IndexValue tileY,
                 const glm::vec4 &location, Direction direction);
+    void Render(const RenderObject &object);
+
+    void AppendFace(RenderObject &object, IndexValue tileX, IndexValue tileY,
+                    const glm::vec4 &location, Direction direction,
+                    float size = 1.0f);
 
 private:
     IRenderer *_renderer;
@@ -7,6 +7,8 @@ typedef unsigned int IndexValue;
 
 typedef unsigned char *ImageData;
 
+class ImageHandle;
+
 class Position
 {
 public:
@@ -23,7 +25,10 @@ typedef struct RawImageInfo
     ImageData data;
     unsigned int width;
     unsigned int height;
+    // GL_RGB, GL_RGBA or an S3TC format, with every mip level stored back
+    // to back in data
     GLuint components;
+    unsigned int levels;
 } RawImageInfo;
 
 typedef struct LightInfo
@@ -40,7 +45,13 @@ typedef struct MaterialInfo
     glm::vec3 Kd;
     glm::vec3 Ks;
     float shininess;
-    RawImageInfo *Kd_imageInfo;
+    ImageHandle *Kd_image;
+    ImageHandle *Ks_image;
+    ImageHandle *normal_image;
     GLuint Kd_mapId;
+    GLuint Ks_mapId;
+    GLuint normal_mapId;
     bool hasKdMap;
+    bool hasKsMap;
+    bool hasNormalMap;
 } MaterialInfo;
@@ -0,0 +1,81 @@
+#include <algorithm>
+
+#include "fixedsteploop.hh"
+
+static const unsigned long long SPIN_MARGIN_NANOSECONDS = 200000;
+static const unsigned long long MAX_SPIN_NANOSECONDS = 20 * NANOSECONDS_PER_MILLISECOND;
+
+FixedStepLoop::FixedStepLoop(IMonotonicClock *clock, ISleepService *sleepService, unsigned int stepsPerSecond,
+                             unsigned int maxCatchUpSteps)
+    : _clock(clock), _sleepService(sleepService), _stepsPerSecond(std::max(stepsPerSecond, 1u)),
+      _maxCatchUpSteps(std::max(maxCatchUpSteps, 1u)), _start(0), _step(0), _skippedSteps(0),
+      _interpolation(0.0), _spinNanoseconds(NANOSECONDS_PER_MILLISECOND)
+{
+}
+
+void FixedStepLoop::Start()
+{
+    _start = _clock->GetNanoseconds();
+    _step = 0;
+    _skippedSteps = 0;
+    _interpolation = 0.0;
+}
+
+unsigned int FixedStepLoop::BeginFrame()
+{
+    unsigned long long now = _clock->GetNanoseconds();
+
+    // Steps that are due are those with a time at or before now
+    unsigned long long due = (now - _start) * _stepsPerSecond / NANOSECONDS_PER_SECOND + 1;
+    unsigned long long steps = due > _step ? due - _step : 0;
+    _step += steps;
+    if (steps > _maxCatchUpSteps)
+    {
+        _skippedSteps += steps - _maxCatchUpSteps;
+        steps = _maxCatchUpSteps;
+    }
+
+    unsigned long long previous = GetStepTime(_step - 1);
+    unsigned long long next = GetStepTime(_step);
+    _interpolation = now > previous ? std::min(1.0, (double)(now - previous) / (next - previous)) : 0.0;
+    if (_interpolation >= 1.0)
+        _interpolation = 0.0;
+
+    return steps;
+}
+
+void FixedStepLoop::WaitForNextStep()
+{
+    waitUntil(GetStepTime(_step));
+}
+
+void FixedStepLoop::waitUntil(unsigned long long time)
+{
+    unsigned long long now = _clock->GetNanoseconds();
+    while (now < time)
+    {
+        unsigned long long remaining = time - now;
+        if (remaining < _spinNanoseconds + NANOSECONDS_PER_MILLISECOND)
+        {
+            now = _clock->GetNanoseconds();
+            continue;
+        }
+
+        unsigned long long requested = (remaining - _spinNanoseconds) / NANOSECONDS_PER_MILLISECOND;
+        _sleepService->Sleep(requested);
+        unsigned long long woken = _clock->GetNanoseconds();
+
+        // Grow the spin window at once when a sleep runs long, and shrink
+        // it slowly when sleeps are accurate
+        unsigned long long slept = woken - now;
+        unsigned long long overshoot = slept > requested * NANOSECONDS_PER_MILLISECOND ?
+            slept - requested * NANOSECONDS_PER_MILLISECOND : 0;
+        unsigned long long wanted = std::min(overshoot + SPIN_MARGIN_NANOSECONDS, MAX_SPIN_NANOSECONDS);
+        if (wanted > _spinNanoseconds)
+            _spinNanoseconds = wanted;
+        else
+            _spinNanoseconds -= (_spinNanoseconds - wanted) / 16;
+
+        now = woken;
+    }
+}
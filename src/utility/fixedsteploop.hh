@@ -0,0 +1,72 @@
+#pragma once
+
+#include "sleepservice.hh"
+#include "systemtimer.hh"
+
+static const unsigned long long NANOSECONDS_PER_SECOND = 1000000000ULL;
+static const unsigned long long NANOSECONDS_PER_MILLISECOND = 1000000ULL;
+static const unsigned int DEFAULT_MAX_CATCH_UP_STEPS = 5;
+
+// Runs a simulation at a fixed rate however long frames take. Step n is
+// due at start + n / stepsPerSecond, computed from the step number rather
+// than accumulated, so the schedule never drifts. Each frame simulates the
+// steps that came due since the last one and renders the state
+// GetInterpolation of the way towards the next step.
+class FixedStepLoop
+{
+public:
+    FixedStepLoop(IMonotonicClock *clock, ISleepService *sleepService, unsigned int stepsPerSecond,
+                  unsigned int maxCatchUpSteps = DEFAULT_MAX_CATCH_UP_STEPS);
+
+    void Start();
+
+    // Number of steps to simulate this frame. After a long stall at most
+    // maxCatchUpSteps are returned and the rest are skipped.
+    unsigned int BeginFrame();
+
+    // Fraction of a step between the last simulated step and the time of
+    // BeginFrame, in [0, 1)
+    double GetInterpolation() const
+    {
+        return _interpolation;
+    }
+
+    // Sleeps while there is time to spare and spins for the rest, so the
+    // next step is met to within a few microseconds of the clock
+    void WaitForNextStep();
+
+    unsigned long long GetStepTime(unsigned long long step) const
+    {
+        // Rounded up, so a step is never due before its time
+        return _start + (step * NANOSECONDS_PER_SECOND + _stepsPerSecond - 1) / _stepsPerSecond;
+    }
+
+    // Steps simulated and skipped so far; their sum is the next step number
+    unsigned long long GetStepCount() const
+    {
+        return _step - _skippedSteps;
+    }
+
+    unsigned long long GetSkippedStepCount() const
+    {
+        return _skippedSteps;
+    }
+
+private:
+    IMonotonicClock *_clock;
+    ISleepService *_sleepService;
+    unsigned int _stepsPerSecond;
+    unsigned int _maxCatchUpSteps;
+
+    unsigned long long _start;
+    unsigned long long _step;
+    unsigned long long _skippedSteps;
+    double _interpolation;
+
+    // How long before a deadline to stop sleeping, learned from how far
+    // sleeps overshoot
+    unsigned long long _spinNanoseconds;
+
+private:
+    void waitUntil(unsigned long long time);
+};
@@ -0,0 +1,95 @@
+#include <iomanip>
+#include <string>
+
+#include "frametimehistogram.hh"
+
+static const size_t HISTOGRAM_BAR_WIDTH = 50;
+
+FrameTimeHistogram::FrameTimeHistogram(unsigned int maxMilliseconds)
+    : _buckets(maxMilliseconds + 1, 0), _count(0), _total(0.0), _max(0.0)
+{
+}
+
+void FrameTimeHistogram::Add(double milliseconds)
+{
+    size_t bucket = milliseconds > 0.0 ? (size_t)milliseconds : 0;
+    if (bucket >= _buckets.size())
+        bucket = _buckets.size() - 1;
+
+    ++_buckets[bucket];
+    ++_count;
+    _total += milliseconds;
+    if (milliseconds > _max)
+        _max = milliseconds;
+}
+
+void FrameTimeHistogram::Clear()
+{
+    _buckets.assign(_buckets.size(), 0);
+    _count = 0;
+    _total = 0.0;
+    _max = 0.0;
+}
+
+size_t FrameTimeHistogram::GetCount() const
+{
+    return _count;
+}
+
+double FrameTimeHistogram::GetMean() const
+{
+    return _count > 0 ? _total / _count : 0.0;
+}
+
+double FrameTimeHistogram::GetMax() const
+{
+    return _max;
+}
+
+double FrameTimeHistogram::GetPercentile(double fraction) const
+{
+    size_t target = (size_t)(fraction * _count + 0.5);
+    size_t seen = 0;
+    for (size_t i = 0; i < _buckets.size(); ++i)
+    {
+        seen += _buckets[i];
+        if (seen >= target && seen > 0)
+            return i + 1 < _buckets.size() ? i + 1.0 : _max;
+    }
+
+    return 0.0;
+}
+
+size_t FrameTimeHistogram::GetCountAbove(double milliseconds) const
+{
+    size_t count = 0;
+    for (size_t i = 0; i < _buckets.size(); ++i)
+    {
+        if (i >= milliseconds)
+            count += _buckets[i];
+    }
+
+    return count;
+}
+
+void FrameTimeHistogram::Print(std::ostream &stream) const
+{
+    size_t largest = 1;
+    for (size_t i = 0; i < _buckets.size(); ++i)
+    {
+        largest = _buckets[i] > largest ? _buckets[i] : largest;
+    }
+
+    for (size_t i = 0; i < _buckets.size(); ++i)
+    {
+        if (_buckets[i] == 0)
+            continue;
+
+        size_t width = (_buckets[i] * HISTOGRAM_BAR_WIDTH + largest - 1) / largest;
+        stream << std::setw(4) << i << (i + 1 < _buckets.size() ? "  ms " : "+ ms ")
+               << std::string(width, '#') << " " << _buckets[i] << std::endl;
+    }
+
+    stream << _count << " frames, mean " << GetMean() << " ms, p99 " << GetPercentile(0.99)
+           << " ms, max " << _max << " ms" << std::endl;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+// Frame times in 1 ms buckets, with everything from maxMilliseconds up in
+// the last one. Spikes show up in the tail: compare GetPercentile(0.99)
+// and GetMax() with the median.
+class FrameTimeHistogram
+{
+public:
+    FrameTimeHistogram(unsigned int maxMilliseconds = 100);
+
+    void Add(double milliseconds);
+    void Clear();
+
+    size_t GetCount() const;
+    double GetMean() const;
+    double GetMax() const;
+
+    // Upper edge of the bucket below which the given fraction of frames fall
+    double GetPercentile(double fraction) const;
+    size_t GetCountAbove(double milliseconds) const;
+
+    void Print(std::ostream &stream) const;
+
+private:
+    std::vector<size_t> _buckets;
+    size_t _count;
+    double _total;
+    double _max;
+};
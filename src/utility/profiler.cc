@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#include "profiler.hh"
+
+static std::atomic<unsigned int> nextProfilerId(1);
+
+// The calling thread's ring in the profiler it last recorded to. A thread
+// that records to another profiler registers a new ring there.
+typedef struct ThreadBufferCache
+{
+    unsigned int profilerId;
+    void *buffer;
+} ThreadBufferCache;
+
+static thread_local ThreadBufferCache threadBufferCache = { 0, NULL };
+
+static void WriteJsonString(std::ostream &stream, const std::string &text)
+{
+    stream << '"';
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        char c = text[i];
+        if (c == '"' || c == '\\')
+            stream << '\\' << c;
+        else if ((unsigned char)c < 0x20)
+            stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c
+                   << std::dec << std::setfill(' ');
+        else
+            stream << c;
+    }
+    stream << '"';
+}
+
+Profiler::Profiler(size_t summaryWindow, size_t traceCapacity)
+    : _id(nextProfilerId++), _startTime(GetTime()), _summaryWindow(std::max<size_t>(summaryWindow, 1)),
+      _traceCapacity(traceCapacity), _mutex(System::Mutex::Create()), _droppedTraceEvents(0)
+{
+}
+
+Profiler::~Profiler()
+{
+    for (int i = 0; i < _threads.size(); ++i)
+    {
+        delete _threads[i];
+    }
+
+    delete _mutex;
+}
+
+// Never destroyed, since worker threads of other singletons may still
+// close scopes during static destruction
+Profiler *Profiler::GetInstance()
+{
+    static Profiler *instance = new Profiler();
+    return instance;
+}
+
+void Profiler::Record(const char *name, unsigned long long start, unsigned long long end)
+{
+    ThreadBuffer *thread = getThreadBuffer();
+
+    ProfileEvent event;
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    if (!thread->events.TryPush(event))
+        thread->dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadName(const std::string &name)
+{
+    ThreadBuffer *thread = getThreadBuffer();
+
+    _mutex->Lock();
+    thread->name = name;
+    _mutex->Unlock();
+}
+
+void Profiler::Collect()
+{
+    _mutex->Lock();
+    std::vector<ThreadBuffer*> threads = _threads;
+    _mutex->Unlock();
+
+    ProfileEvent event;
+    for (int i = 0; i < threads.size(); ++i)
+    {
+        while (threads[i]->events.TryPop(event))
+        {
+            ScopeSamples &samples = getScopeSamples(event.name);
+            double duration = (double)(event.end - event.start) / 1000000.0;
+            if (samples.durations.size() < _summaryWindow)
+            {
+                samples.durations.push_back(duration);
+            }
+            else
+            {
+                samples.durations[samples.next] = duration;
+                samples.next = (samples.next + 1) % _summaryWindow;
+            }
+            ++samples.calls;
+
+            if (_trace.size() < _traceCapacity)
+            {
+                TraceEvent traceEvent;
+                traceEvent.name = event.name;
+                traceEvent.threadId = threads[i]->id;
+                traceEvent.start = event.start;
+                traceEvent.end = event.end;
+                _trace.push_back(traceEvent);
+            }
+            else
+            {
+                ++_droppedTraceEvents;
+            }
+        }
+    }
+}
+
+std::vector<ProfileSummary> Profiler::GetSummaries()
+{
+    std::vector<ProfileSummary> summaries;
+    std::vector<double> sorted;
+    for (std::unordered_map<std::string, ScopeSamples>::iterator i = _scopes.begin(); i != _scopes.end(); ++i)
+    {
+        sorted = i->second.durations;
+        std::sort(sorted.begin(), sorted.end());
+
+        ProfileSummary summary;
+        summary.name = i->first;
+        summary.calls = i->second.calls;
+        summary.min = sorted.front();
+        summary.max = sorted.back();
+
+        double total = 0.0;
+        for (int j = 0; j < sorted.size(); ++j)
+        {
+            total += sorted[j];
+        }
+        summary.average = total / sorted.size();
+
+        // The smallest duration at least 99% of the window is within
+        size_t rank = (sorted.size() * 99 + 99) / 100;
+        summary.p99 = sorted[rank - 1];
+
+        summaries.push_back(summary);
+    }
+
+    std::sort(summaries.begin(), summaries.end(), [](const ProfileSummary &a, const ProfileSummary &b) {
+        return a.average > b.average;
+    });
+
+    return summaries;
+}
+
+void Profiler::PrintSummary(std::ostream &stream)
+{
+    std::vector<ProfileSummary> summaries = GetSummaries();
+
+    size_t nameWidth = 5;
+    for (int i = 0; i < summaries.size(); ++i)
+    {
+        nameWidth = std::max(nameWidth, summaries[i].name.size());
+    }
+
+    std::ios::fmtflags flags = stream.flags();
+    stream << std::left << std::setw(nameWidth) << "Scope" << std::right << std::setw(10) << "calls"
+           << std::setw(10) << "min ms" << std::setw(10) << "avg ms" << std::setw(10) << "p99 ms" << std::endl;
+    stream << std::fixed << std::setprecision(3);
+    for (int i = 0; i < summaries.size(); ++i)
+    {
+        const ProfileSummary &summary = summaries[i];
+        stream << std::left << std::setw(nameWidth) << summary.name << std::right << std::setw(10) << summary.calls
+               << std::setw(10) << summary.min << std::setw(10) << summary.average
+               << std::setw(10) << summary.p99 << std::endl;
+    }
+    stream.flags(flags);
+
+    unsigned long long dropped = GetDroppedEventCount();
+    if (dropped > 0)
+        stream << dropped << " events dropped" << std::endl;
+}
+
+void Profiler::WriteChromeTrace(std::ostream &stream)
+{
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+    stream << std::fixed << std::setprecision(3);
+
+    stream << "{\"traceEvents\":[";
+    bool first = true;
+
+    _mutex->Lock();
+    for (int i = 0; i < _threads.size(); ++i)
+    {
+        if (_threads[i]->name.empty())
+            continue;
+
+        stream << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+               << _threads[i]->id << ",\"args\":{\"name\":";
+        WriteJsonString(stream, _threads[i]->name);
+        stream << "}}";
+        first = false;
+    }
+    _mutex->Unlock();
+
+    // Complete events, in microseconds since the profiler was created
+    for (int i = 0; i < _trace.size(); ++i)
+    {
+        const TraceEvent &event = _trace[i];
+        stream << (first ? "\n" : ",\n") << "{\"name\":";
+        WriteJsonString(stream, event.name);
+        stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.threadId
+               << ",\"ts\":" << (double)(long long)(event.start - _startTime) / 1000.0
+               << ",\"dur\":" << (double)(event.end - event.start) / 1000.0 << "}";
+        first = false;
+    }
+
+    stream << "\n]}" << std::endl;
+
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+bool Profiler::SaveChromeTrace(const std::string &fileName)
+{
+    std::ofstream file(fileName.c_str());
+    if (!file)
+        return false;
+
+    WriteChromeTrace(file);
+    return file.good();
+}
+
+void Profiler::ClearTrace()
+{
+    _trace.clear();
+}
+
+unsigned long long Profiler::GetDroppedEventCount()
+{
+    unsigned long long dropped = _droppedTraceEvents;
+
+    _mutex->Lock();
+    for (int i = 0; i < _threads.size(); ++i)
+    {
+        dropped += _threads[i]->dropped.load(std::memory_order_relaxed);
+    }
+    _mutex->Unlock();
+
+    return dropped;
+}
+
+Profiler::ThreadBuffer *Profiler::getThreadBuffer()
+{
+    if (threadBufferCache.profilerId == _id)
+        return (ThreadBuffer *)threadBufferCache.buffer;
+
+    ThreadBuffer *thread = new ThreadBuffer();
+    thread->dropped = 0;
+
+    _mutex->Lock();
+    thread->id = _threads.size() + 1;
+    _threads.push_back(thread);
+    _mutex->Unlock();
+
+    threadBufferCache.profilerId = _id;
+    threadBufferCache.buffer = thread;
+    return thread;
+}
+
+Profiler::ScopeSamples &Profiler::getScopeSamples(const char *name)
+{
+    std::unordered_map<const char*, ScopeSamples*>::iterator found = _scopesByName.find(name);
+    if (found != _scopesByName.end())
+        return *found->second;
+
+    ScopeSamples *samples = &_scopes[name];
+    _scopesByName[name] = samples;
+    return *samples;
+}
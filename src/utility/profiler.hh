@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "system/mutex.hh"
+#include "spscqueue.hh"
+
+static const unsigned int PROFILE_THREAD_BUFFER_SIZE = 16384;
+static const size_t DEFAULT_PROFILE_SUMMARY_WINDOW = 1000;
+static const size_t DEFAULT_PROFILE_TRACE_CAPACITY = 1000000;
+
+// Scope timers are only built in with ENABLE_PROFILING (make PROFILE=1).
+// Names must be string literals, since only the pointer is recorded.
+#ifdef ENABLE_PROFILING
+#define PROFILE_CONCATENATE_(a, b) a##b
+#define PROFILE_CONCATENATE(a, b) PROFILE_CONCATENATE_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCATENATE(profileScope, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::GetInstance()->SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD(name)
+#endif
+
+typedef struct ProfileEvent
+{
+    const char *name;
+    unsigned long long start;
+    unsigned long long end;
+} ProfileEvent;
+
+// Times in milliseconds over the last window of calls to a scope
+typedef struct ProfileSummary
+{
+    std::string name;
+    unsigned long long calls;
+    double min;
+    double average;
+    double p99;
+    double max;
+} ProfileSummary;
+
+// Collects timed scopes from any number of threads. Each thread records
+// into its own ring without locking; Collect drains the rings into a
+// rolling per-scope summary and a trace that can be opened in
+// chrome://tracing. Collect must always be called from the same thread,
+// often enough for the rings not to fill up.
+class Profiler
+{
+public:
+    Profiler(size_t summaryWindow = DEFAULT_PROFILE_SUMMARY_WINDOW,
+             size_t traceCapacity = DEFAULT_PROFILE_TRACE_CAPACITY);
+    ~Profiler();
+
+    static Profiler *GetInstance();
+
+    static unsigned long long GetTime()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Records a scope of the calling thread, with times from GetTime
+    void Record(const char *name, unsigned long long start, unsigned long long end);
+
+    // Names the calling thread in the trace
+    void SetThreadName(const std::string &name);
+
+    void Collect();
+
+    // Sorted by average time, longest first
+    std::vector<ProfileSummary> GetSummaries();
+    void PrintSummary(std::ostream &stream);
+
+    void WriteChromeTrace(std::ostream &stream);
+    bool SaveChromeTrace(const std::string &fileName);
+    void ClearTrace();
+
+    // Events lost to full thread rings or a full trace
+    unsigned long long GetDroppedEventCount();
+
+private:
+    typedef struct ThreadBuffer
+    {
+        unsigned int id;
+        std::string name;
+        SpscQueue<ProfileEvent, PROFILE_THREAD_BUFFER_SIZE> events;
+        std::atomic<unsigned long long> dropped;
+    } ThreadBuffer;
+
+    typedef struct TraceEvent
+    {
+        const char *name;
+        unsigned int threadId;
+        unsigned long long start;
+        unsigned long long end;
+    } TraceEvent;
+
+    typedef struct ScopeSamples
+    {
+        std::vector<double> durations;
+        size_t next;
+        unsigned long long calls;
+    } ScopeSamples;
+
+    unsigned int _id;
+    unsigned long long _startTime;
+    size_t _summaryWindow;
+    size_t _traceCapacity;
+
+    System::Mutex *_mutex;
+    std::vector<ThreadBuffer*> _threads;
+
+    std::vector<TraceEvent> _trace;
+    unsigned long long _droppedTraceEvents;
+    std::unordered_map<std::string, ScopeSamples> _scopes;
+    // The same name may be recorded from literals in several files
+    std::unordered_map<const char*, ScopeSamples*> _scopesByName;
+
+private:
+    ThreadBuffer *getThreadBuffer();
+    ScopeSamples &getScopeSamples(const char *name);
+
+    Profiler(const Profiler &o) = delete;
+};
+
+class ProfileScope
+{
+public:
+    ProfileScope(const char *name, Profiler *profiler = Profiler::GetInstance())
+        : _profiler(profiler), _name(name), _start(Profiler::GetTime())
+    {
+    }
+
+    ~ProfileScope()
+    {
+        _profiler->Record(_name, _start, Profiler::GetTime());
+    }
+
+private:
+    Profiler *_profiler;
+    const char *_name;
+    unsigned long long _start;
+
+    ProfileScope(const ProfileScope &o) = delete;
+};
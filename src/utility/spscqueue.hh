@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+static const size_t SPSC_QUEUE_CACHE_LINE_SIZE = 64;
+
+// Fixed-size ring for passing items from exactly one producer thread to
+// exactly one consumer thread. Neither side ever blocks; TryPush fails
+// when the ring is full and TryPop when it is empty.
+template <typename T, unsigned int Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue()
+        : _head(0), _tail(0)
+    {
+    }
+
+    // Producer thread
+    bool TryPush(const T &item)
+    {
+        unsigned int tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        _items[tail & (Capacity - 1)] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread
+    bool TryPop(T &item)
+    {
+        unsigned int head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire))
+            return false;
+
+        item = _items[head & (Capacity - 1)];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T _items[Capacity];
+
+    // Kept a cache line apart so the two threads do not share one. This is
+    // padding rather than alignas, since queues are also allocated with new,
+    // which only guarantees 64 byte alignment from C++17 on.
+    std::atomic<unsigned int> _head;
+    char _padding[SPSC_QUEUE_CACHE_LINE_SIZE];
+    std::atomic<unsigned int> _tail;
+
+    SpscQueue(const SpscQueue &o) = delete;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+
 #include "framework/platform.hh"
 
 class ISystemTimer
@@ -24,3 +26,19 @@ public:
 private:
     System::Utility *m_utility;
 };
+
+class IMonotonicClock
+{
+public:
+    virtual unsigned long long GetNanoseconds() = 0;
+};
+
+class MonotonicClock : public IMonotonicClock
+{
+public:
+    virtual unsigned long long GetNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
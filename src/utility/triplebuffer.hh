@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+
+// Hands the latest value from one producer thread to one consumer thread
+// without either of them blocking. The producer fills GetWriteBuffer and
+// calls Publish; the consumer calls Acquire and then reads GetReadBuffer,
+// which is left alone until its next Acquire. The write buffer is a stale
+// slot after each Publish, so the producer has to fill it completely.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer()
+        : _writeIndex(0), _middle(1), _readIndex(2)
+    {
+    }
+
+    T &GetWriteBuffer()
+    {
+        return _buffers[_writeIndex];
+    }
+
+    void Publish()
+    {
+        unsigned int previous = _middle.exchange(_writeIndex | FRESH, std::memory_order_acq_rel);
+        _writeIndex = previous & INDEX_MASK;
+    }
+
+    // Returns false when nothing was published since the last call
+    bool Acquire()
+    {
+        if ((_middle.load(std::memory_order_relaxed) & FRESH) == 0)
+            return false;
+
+        unsigned int previous = _middle.exchange(_readIndex, std::memory_order_acq_rel);
+        _readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    T &GetReadBuffer()
+    {
+        return _buffers[_readIndex];
+    }
+
+    const T &GetReadBuffer() const
+    {
+        return _buffers[_readIndex];
+    }
+
+private:
+    enum
+    {
+        INDEX_MASK = 3,
+        FRESH = 4
+    };
+
+    T _buffers[3];
+    unsigned int _writeIndex;
+    std::atomic<unsigned int> _middle;
+    unsigned int _readIndex;
+
+    TripleBuffer(const TripleBuffer &o) = delete;
+};
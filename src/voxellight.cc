@@ -0,0 +1,274 @@
+#include <cstring>
+
+#include "voxellight.hh"
+
+static const int NeighborOffsets[6][3] = {
+    { 0,  1,  0 },
+    { 0, -1,  0 },
+    {-1,  0,  0 },
+    { 1,  0,  0 },
+    { 0,  0,  1 },
+    { 0,  0, -1 }
+};
+
+static const int DownNeighbor = 1;
+
+static void GetCoordinates(int index, int *x, int *y, int *z)
+{
+    *x = index % VOXEL_SECTOR_SIZE;
+    *z = (index / VOXEL_SECTOR_SIZE) % VOXEL_SECTOR_SIZE;
+    *y = index / (VOXEL_SECTOR_SIZE * VOXEL_SECTOR_SIZE);
+}
+
+static bool IsInSector(int x, int y, int z)
+{
+    return x >= 0 && y >= 0 && z >= 0 &&
+        x < VOXEL_SECTOR_SIZE && y < VOXEL_SECTOR_SIZE && z < VOXEL_SECTOR_SIZE;
+}
+
+static bool IsOnBoundary(int x, int y, int z)
+{
+    const int last = VOXEL_SECTOR_SIZE - 1;
+    return x == 0 || y == 0 || z == 0 || x == last || y == last || z == last;
+}
+
+VoxelLightMap::VoxelLightMap()
+    : _boundaryChanged(false)
+{
+    setSkyEntry(NULL);
+    fillLevel(Channel::Sky, VOXEL_MAX_LIGHT);
+    fillLevel(Channel::Block, 0);
+}
+
+bool VoxelLightMap::Rebuild(const VoxelCollection &collection, const VoxelLightMap *above)
+{
+    unsigned char bottom[VOXEL_SECTOR_SIZE * VOXEL_SECTOR_SIZE / 2];
+    memcpy(bottom, _skyLight, sizeof(bottom));
+
+    setSkyEntry(above);
+    rebuildChannel(collection, Channel::Sky);
+    rebuildChannel(collection, Channel::Block);
+
+    return memcmp(bottom, _skyLight, sizeof(bottom)) != 0;
+}
+
+bool VoxelLightMap::Update(const VoxelCollection &collection, const Position &position)
+{
+    _boundaryChanged = false;
+
+    updateChannel(collection, Channel::Sky, position);
+    updateChannel(collection, Channel::Block, position);
+
+    return _boundaryChanged;
+}
+
+void VoxelLightMap::setSkyEntry(const VoxelLightMap *above)
+{
+    _isOpenSky = true;
+    for (int z = 0; z < VOXEL_SECTOR_SIZE; ++z)
+    {
+        for (int x = 0; x < VOXEL_SECTOR_SIZE; ++x)
+        {
+            LightValue level = VOXEL_MAX_LIGHT;
+            if (above != NULL)
+            {
+                // Full sky light keeps going straight down, anything else
+                // falls off by one on the way in
+                level = above->GetLight(Channel::Sky, Position(x, 0, z));
+                if (level > 0 && level < VOXEL_MAX_LIGHT)
+                    --level;
+            }
+
+            _skyEntry[VOXEL_SECTOR_SIZE * z + x] = level;
+            _isOpenSky = _isOpenSky && level == VOXEL_MAX_LIGHT;
+        }
+    }
+}
+
+void VoxelLightMap::setLevel(Channel channel, int index, LightValue level)
+{
+    unsigned char *nibble = &getNibbles(channel)[index >> 1];
+    int shift = (index & 1) << 2;
+    unsigned char updated = (*nibble & ~(0xF << shift)) | (level << shift);
+
+    if (updated == *nibble)
+        return;
+
+    *nibble = updated;
+
+    int x, y, z;
+    GetCoordinates(index, &x, &y, &z);
+    if (IsOnBoundary(x, y, z))
+        _boundaryChanged = true;
+}
+
+void VoxelLightMap::fillLevel(Channel channel, LightValue level)
+{
+    memset(getNibbles(channel), (level << 4) | level, VOXEL_SECTOR_ARRAY_SIZE / 2);
+}
+
+LightValue VoxelLightMap::getSourceLevel(const VoxelCollection &collection, Channel channel,
+                                         int x, int y, int z) const
+{
+    const Voxel *voxel = collection.GetVoxel(Position(x, y, z));
+
+    if (channel == Channel::Sky)
+        return (voxel == NULL && y == VOXEL_SECTOR_SIZE - 1) ? _skyEntry[VOXEL_SECTOR_SIZE * z + x] : 0;
+
+    return voxel == NULL ? 0 : voxel->_type.GetLightEmission();
+}
+
+void VoxelLightMap::rebuildChannel(const VoxelCollection &collection, Channel channel)
+{
+    if (collection.IsEmpty() && (channel == Channel::Block || _isOpenSky))
+    {
+        fillLevel(channel, channel == Channel::Sky ? VOXEL_MAX_LIGHT : 0);
+        return;
+    }
+
+    fillLevel(channel, 0);
+
+    if (collection.IsUniform() && collection.IsFull() &&
+        getSourceLevel(collection, channel, 0, 0, 0) == 0)
+    {
+        return;
+    }
+
+    _propagationQueue.clear();
+
+    for (int y = 0; y < VOXEL_SECTOR_SIZE; ++y)
+    {
+        for (int z = 0; z < VOXEL_SECTOR_SIZE; ++z)
+        {
+            for (int x = 0; x < VOXEL_SECTOR_SIZE; ++x)
+            {
+                LightValue source = getSourceLevel(collection, channel, x, y, z);
+                if (source > 0)
+                {
+                    int index = getIndex(x, y, z);
+                    setLevel(channel, index, source);
+                    _propagationQueue.push_back(index);
+                }
+            }
+        }
+    }
+
+    propagateLight(collection, channel);
+}
+
+void VoxelLightMap::updateChannel(const VoxelCollection &collection, Channel channel,
+                                  const Position &position)
+{
+    int index = getIndex(position.x, position.y, position.z);
+    LightValue level = getLevel(channel, index);
+
+    _removalQueue.clear();
+    _propagationQueue.clear();
+
+    if (level > 0)
+    {
+        setLevel(channel, index, 0);
+        _removalQueue.push_back(LightNode(index, level));
+        removeLight(collection, channel);
+    }
+
+    LightValue source = getSourceLevel(collection, channel, position.x, position.y, position.z);
+    if (source > 0)
+    {
+        setLevel(channel, index, source);
+        _propagationQueue.push_back(index);
+    }
+
+    // A cleared cell is lit again by whatever surrounds it
+    if (collection.GetVoxel(position) == NULL)
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            int x = position.x + NeighborOffsets[i][0];
+            int y = position.y + NeighborOffsets[i][1];
+            int z = position.z + NeighborOffsets[i][2];
+
+            if (IsInSector(x, y, z) && getLevel(channel, getIndex(x, y, z)) > 0)
+                _propagationQueue.push_back(getIndex(x, y, z));
+        }
+    }
+
+    propagateLight(collection, channel);
+}
+
+void VoxelLightMap::removeLight(const VoxelCollection &collection, Channel channel)
+{
+    for (size_t head = 0; head < _removalQueue.size(); ++head)
+    {
+        LightNode node = _removalQueue[head];
+        int nodeX, nodeY, nodeZ;
+        GetCoordinates(node.index, &nodeX, &nodeY, &nodeZ);
+
+        for (int i = 0; i < 6; ++i)
+        {
+            int x = nodeX + NeighborOffsets[i][0];
+            int y = nodeY + NeighborOffsets[i][1];
+            int z = nodeZ + NeighborOffsets[i][2];
+
+            if (!IsInSector(x, y, z))
+                continue;
+
+            int neighbor = getIndex(x, y, z);
+            LightValue neighborLevel = getLevel(channel, neighbor);
+            if (neighborLevel == 0)
+                continue;
+
+            bool isSkyColumn = channel == Channel::Sky && i == DownNeighbor &&
+                node.level == VOXEL_MAX_LIGHT;
+
+            if (getSourceLevel(collection, channel, x, y, z) == 0 &&
+                (neighborLevel < node.level || isSkyColumn))
+            {
+                setLevel(channel, neighbor, 0);
+                _removalQueue.push_back(LightNode(neighbor, neighborLevel));
+            }
+            else
+            {
+                _propagationQueue.push_back(neighbor);
+            }
+        }
+    }
+}
+
+void VoxelLightMap::propagateLight(const VoxelCollection &collection, Channel channel)
+{
+    for (size_t head = 0; head < _propagationQueue.size(); ++head)
+    {
+        int index = _propagationQueue[head];
+        LightValue level = getLevel(channel, index);
+        if (level <= 1)
+            continue;
+
+        int nodeX, nodeY, nodeZ;
+        GetCoordinates(index, &nodeX, &nodeY, &nodeZ);
+
+        for (int i = 0; i < 6; ++i)
+        {
+            int x = nodeX + NeighborOffsets[i][0];
+            int y = nodeY + NeighborOffsets[i][1];
+            int z = nodeZ + NeighborOffsets[i][2];
+
+            if (!IsInSector(x, y, z) || collection.GetVoxel(Position(x, y, z)) != NULL)
+                continue;
+
+            // Full sky light travels straight down without falling off
+            LightValue spreadLevel = level - 1;
+            if (channel == Channel::Sky && i == DownNeighbor && level == VOXEL_MAX_LIGHT)
+                spreadLevel = VOXEL_MAX_LIGHT;
+
+            int neighbor = getIndex(x, y, z);
+            if (getLevel(channel, neighbor) < spreadLevel)
+            {
+                setLevel(channel, neighbor, spreadLevel);
+                _propagationQueue.push_back(neighbor);
+            }
+        }
+    }
+
+    _propagationQueue.clear();
+}
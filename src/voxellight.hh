@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+
+#include "types.hh"
+#include "voxels.hh"
+
+const int VOXEL_MAX_LIGHT = 15;
+
+typedef unsigned char LightValue;
+
+// Per-voxel sky and block light for a single sector, stored as two
+// nibble arrays. Light is propagated with a breadth-first flood fill. Sky
+// light enters through the top layer, from the bottom layer of the sector
+// above or as open sky when there is none.
+class VoxelLightMap
+{
+public:
+    enum class Channel
+    {
+        Sky,
+        Block
+    };
+
+public:
+    VoxelLightMap();
+
+    LightValue GetLight(Channel channel, const Position &position) const
+    {
+        return getLevel(channel, getIndex(position.x, position.y, position.z));
+    }
+
+    // Sky light in the high nibble, block light in the low nibble
+    unsigned char GetPackedLight(const Position &position) const
+    {
+        int index = getIndex(position.x, position.y, position.z);
+        return (getLevel(Channel::Sky, index) << 4) | getLevel(Channel::Block, index);
+    }
+
+    // Returns true when the sky light of the bottom layer changed, in which
+    // case the sector below has to be rebuilt with this one above it
+    bool Rebuild(const VoxelCollection &collection, const VoxelLightMap *above = NULL);
+
+    // Relights only the area affected by an edit at position, with the sky
+    // light entering from above as of the last Rebuild. Returns true when a
+    // cell on the sector boundary changed level.
+    bool Update(const VoxelCollection &collection, const Position &position);
+
+private:
+    typedef struct LightNode
+    {
+        LightNode(int _index, LightValue _level)
+            : index(_index), level(_level)
+        {
+        }
+
+        int index;
+        LightValue level;
+    } LightNode;
+
+    unsigned char _skyLight[VOXEL_SECTOR_ARRAY_SIZE / 2];
+    unsigned char _blockLight[VOXEL_SECTOR_ARRAY_SIZE / 2];
+
+    // Sky light entering each column of the top layer, indexed by z and x
+    LightValue _skyEntry[VOXEL_SECTOR_SIZE * VOXEL_SECTOR_SIZE];
+    bool _isOpenSky;
+
+    std::vector<LightNode> _removalQueue;
+    std::vector<int> _propagationQueue;
+    bool _boundaryChanged;
+
+private:
+    static int getIndex(int x, int y, int z)
+    {
+        return VOXEL_SECTOR_SIZE * VOXEL_SECTOR_SIZE * y +
+            VOXEL_SECTOR_SIZE * z +
+            x;
+    }
+
+    unsigned char *getNibbles(Channel channel)
+    {
+        return channel == Channel::Sky ? _skyLight : _blockLight;
+    }
+
+    const unsigned char *getNibbles(Channel channel) const
+    {
+        return channel == Channel::Sky ? _skyLight : _blockLight;
+    }
+
+    LightValue getLevel(Channel channel, int index) const
+    {
+        return (getNibbles(channel)[index >> 1] >> ((index & 1) << 2)) & 0xF;
+    }
+
+    void setSkyEntry(const VoxelLightMap *above);
+    void setLevel(Channel channel, int index, LightValue level);
+    void fillLevel(Channel channel, LightValue level);
+
+    LightValue getSourceLevel(const VoxelCollection &collection, Channel channel, int x, int y, int z) const;
+    void updateChannel(const VoxelCollection &collection, Channel channel, const Position &position);
+    void rebuildChannel(const VoxelCollection &collection, Channel channel);
+    void removeLight(const VoxelCollection &collection, Channel channel);
+    void propagateLight(const VoxelCollection &collection, Channel channel);
+};
@@ -0,0 +1,141 @@
+#include "voxellod.hh"
+
+VoxelLodGrid::VoxelLodGrid(const VoxelCollection &collection, const VoxelLightMap &lightMap,
+                           const VoxelSectorNeighbors &neighbors, int level)
+    : _size(VOXEL_SECTOR_SIZE >> level), _scale(1 << level), _solidCount(0), _neighbors(neighbors)
+{
+    _voxels = new const Voxel*[_size * _size * _size];
+    _light = new unsigned char[_size * _size * _size];
+
+    for (int y = 0; y < _size; ++y)
+    {
+        for (int z = 0; z < _size; ++z)
+        {
+            for (int x = 0; x < _size; ++x)
+            {
+                const Voxel *voxel;
+                if (collection.IsUniform())
+                    voxel = collection.GetUniformVoxel();
+                else
+                    voxel = voteBlock(collection, x, y, z);
+
+                _voxels[getIndex(x, y, z)] = voxel;
+                _light[getIndex(x, y, z)] = averageLight(collection, lightMap, x, y, z);
+                if (voxel != NULL)
+                    ++_solidCount;
+            }
+        }
+    }
+}
+
+VoxelLodGrid::~VoxelLodGrid()
+{
+    delete[] _light;
+    delete[] _voxels;
+}
+
+unsigned char VoxelLodGrid::GetPackedLight(int x, int y, int z) const
+{
+    if (x >= 0 && y >= 0 && z >= 0 && x < _size && y < _size && z < _size)
+        return _light[getIndex(x, y, z)];
+
+    // Cells past an edge or a corner come from the sector sharing it
+    int sectorX = x < 0 ? -1 : (x >= _size ? 1 : 0);
+    int sectorY = y < 0 ? -1 : (y >= _size ? 1 : 0);
+    int sectorZ = z < 0 ? -1 : (z >= _size ? 1 : 0);
+
+    const VoxelCollection *collection = _neighbors.Get(sectorX, sectorY, sectorZ);
+    const VoxelLightMap *lightMap = _neighbors.GetLightMap(sectorX, sectorY, sectorZ);
+    if (collection == NULL || lightMap == NULL)
+        return VOXEL_MAX_LIGHT << 4;
+
+    return averageLight(*collection, *lightMap, (x + _size) % _size, (y + _size) % _size, (z + _size) % _size);
+}
+
+const Voxel *VoxelLodGrid::voteBlock(const VoxelCollection &collection, int x, int y, int z) const
+{
+    const int maxVotes = 8 * 8 * 8;
+    const Voxel *candidates[maxVotes];
+    int votes[maxVotes];
+    int candidateCount = 0;
+    int airVotes = 0;
+
+    for (int i = 0; i < _scale; ++i)
+    {
+        for (int j = 0; j < _scale; ++j)
+        {
+            for (int k = 0; k < _scale; ++k)
+            {
+                const Voxel *voxel = collection.GetVoxel(Position(x * _scale + i,
+                                                                  y * _scale + j,
+                                                                  z * _scale + k));
+                if (voxel == NULL)
+                {
+                    ++airVotes;
+                    continue;
+                }
+
+                int candidate = 0;
+                while (candidate < candidateCount && candidates[candidate] != voxel)
+                {
+                    ++candidate;
+                }
+
+                if (candidate == candidateCount)
+                {
+                    candidates[candidateCount] = voxel;
+                    votes[candidateCount] = 0;
+                    ++candidateCount;
+                }
+
+                ++votes[candidate];
+            }
+        }
+    }
+
+    // Ties between air and a solid type go to the solid so thin features
+    // don't vanish at coarser levels
+    const Voxel *winner = NULL;
+    int winnerVotes = airVotes;
+    for (int i = 0; i < candidateCount; ++i)
+    {
+        if (votes[i] > winnerVotes || (winner == NULL && votes[i] == winnerVotes))
+        {
+            winner = candidates[i];
+            winnerVotes = votes[i];
+        }
+    }
+
+    return winner;
+}
+
+// Solid cells carry no light, so only the open ones are averaged. A block
+// without any keeps the light of a solid cell.
+unsigned char VoxelLodGrid::averageLight(const VoxelCollection &collection, const VoxelLightMap &lightMap,
+                                         int x, int y, int z) const
+{
+    int sky = 0, block = 0, samples = 0;
+
+    for (int i = 0; i < _scale; ++i)
+    {
+        for (int j = 0; j < _scale; ++j)
+        {
+            for (int k = 0; k < _scale; ++k)
+            {
+                Position position(x * _scale + i, y * _scale + j, z * _scale + k);
+                if (collection.GetVoxel(position) != NULL)
+                    continue;
+
+                unsigned char light = lightMap.GetPackedLight(position);
+                sky += light >> 4;
+                block += light & 0xF;
+                ++samples;
+            }
+        }
+    }
+
+    if (samples == 0)
+        return 0;
+
+    return (((sky + samples / 2) / samples) << 4) | ((block + samples / 2) / samples);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "types.hh"
+#include "voxellight.hh"
+#include "voxels.hh"
+#include "voxelsectorneighbors.hh"
+
+const int VOXEL_LOD_LEVEL_COUNT = 4;
+const float VOXEL_LOD_MIN_CELL_PIXELS = 4.0f;
+
+// A sector downsampled by 2^level, each cell holding the majority voxel
+// type of the block it covers and the average light of its open cells
+class VoxelLodGrid
+{
+public:
+    VoxelLodGrid(const VoxelCollection &collection, const VoxelLightMap &lightMap,
+                 const VoxelSectorNeighbors &neighbors, int level);
+    ~VoxelLodGrid();
+
+    int GetSize() const
+    {
+        return _size;
+    }
+
+    int GetScale() const
+    {
+        return _scale;
+    }
+
+    bool IsEmpty() const
+    {
+        return _solidCount == 0;
+    }
+
+    bool IsFull() const
+    {
+        return _solidCount == _size * _size * _size;
+    }
+
+    const Voxel *GetVoxel(int x, int y, int z) const
+    {
+        return _voxels[getIndex(x, y, z)];
+    }
+
+    // Cells outside the grid are treated as open so that coarse sectors
+    // always close their boundary against neighbours of any level
+    bool IsSolid(int x, int y, int z) const
+    {
+        if (x < 0 || y < 0 || z < 0 || x >= _size || y >= _size || z >= _size)
+            return false;
+
+        return GetVoxel(x, y, z) != NULL;
+    }
+
+    // Cells outside the grid are downsampled from the neighbouring sector,
+    // like the full resolution mesh samples its neighbours
+    unsigned char GetPackedLight(int x, int y, int z) const;
+
+private:
+    int _size;
+    int _scale;
+    int _solidCount;
+    const Voxel **_voxels;
+    unsigned char *_light;
+    const VoxelSectorNeighbors &_neighbors;
+
+private:
+    int getIndex(int x, int y, int z) const
+    {
+        return _size * _size * y + _size * z + x;
+    }
+
+    const Voxel *voteBlock(const VoxelCollection &collection, int x, int y, int z) const;
+    unsigned char averageLight(const VoxelCollection &collection, const VoxelLightMap &lightMap,
+                               int x, int y, int z) const;
+
+    VoxelLodGrid(const VoxelLodGrid &o) = delete;
+};
+
+class VoxelLodSelector
+{
+public:
+    VoxelLodSelector()
+        : _pixelsPerUnit(VOXEL_LOD_MIN_CELL_PIXELS)
+    {
+    }
+
+    void SetPixelsPerUnit(float pixelsPerUnit)
+    {
+        _pixelsPerUnit = pixelsPerUnit;
+    }
+
+    // Picks the coarsest level whose cells are at most
+    // VOXEL_LOD_MIN_CELL_PIXELS on screen, or level 0 when single voxels
+    // are already larger than that
+    int GetLevel() const
+    {
+        int level = 0;
+        while (level < VOXEL_LOD_LEVEL_COUNT - 1 &&
+               (1 << (level + 1)) * _pixelsPerUnit <= VOXEL_LOD_MIN_CELL_PIXELS)
+        {
+            ++level;
+        }
+
+        return level;
+    }
+
+private:
+    float _pixelsPerUnit;
+};
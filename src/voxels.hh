@@ -14,8 +14,8 @@ typedef unsigned char VoxelId;
 class VoxelType
 {
 public:
-    VoxelType(IndexValue tileX, IndexValue tileY)
-        : _tileX(tileX), _tileY(tileY)
+    VoxelType(IndexValue tileX, IndexValue tileY, IndexValue lightEmission = 0)
+        : _tileX(tileX), _tileY(tileY), _lightEmission(lightEmission)
     {
     }
 
@@ -29,9 +29,15 @@ public:
         return _tileY;
     }
 
+    IndexValue GetLightEmission() const
+    {
+        return _lightEmission;
+    }
+
 private:
     IndexValue _tileX;
     IndexValue _tileY;
+    IndexValue _lightEmission;
 };
 
 typedef struct Voxel
@@ -75,35 +81,157 @@ class VoxelCollection
 {
 public:
     VoxelCollection(VoxelRepository *voxelRepository)
-        : _repository(voxelRepository)
+        : _repository(voxelRepository), _voxels(NULL), _uniformVoxel(NULL),
+          _solidCount(0)
     {
-        _voxels = new const Voxel*[VOXEL_SECTOR_ARRAY_SIZE];
-        for (int i = 0; i < VOXEL_SECTOR_ARRAY_SIZE; ++i)
+        for (int i = 0; i < VOXEL_TYPE_COUNT; ++i)
         {
-            _voxels[i] = NULL;
+            _typeCounts[i] = 0;
         }
     }
 
+    ~VoxelCollection()
+    {
+        delete[] _voxels;
+    }
+
     const Voxel *GetVoxel(const Position &position) const
     {
-        return *getVoxelAtIndex(position);
+        if (_voxels == NULL)
+            return _uniformVoxel;
+
+        return _voxels[getIndex(position)];
     }
 
     void SetVoxel(const Position &position, IndexValue type)
     {
-        *getVoxelAtIndex(position) = _repository->GetVoxel(type);
+        setVoxel(position, _repository->GetVoxel(type));
+    }
+
+    void ClearVoxel(const Position &position)
+    {
+        setVoxel(position, NULL);
+    }
+
+    void Fill(IndexValue type)
+    {
+        fill(_repository->GetVoxel(type));
+    }
+
+    void Clear()
+    {
+        fill(NULL);
+    }
+
+    int GetSolidCount() const
+    {
+        return _solidCount;
+    }
+
+    bool IsEmpty() const
+    {
+        return _solidCount == 0;
+    }
+
+    bool IsFull() const
+    {
+        return _solidCount == VOXEL_SECTOR_ARRAY_SIZE;
+    }
+
+    bool IsUniform() const
+    {
+        return _voxels == NULL || IsEmpty() ||
+            (IsFull() && _typeCounts[_voxels[0]->id] == VOXEL_SECTOR_ARRAY_SIZE);
+    }
+
+    // Only meaningful when IsUniform() is true
+    const Voxel *GetUniformVoxel() const
+    {
+        if (IsEmpty())
+            return NULL;
+
+        if (_voxels == NULL)
+            return _uniformVoxel;
+
+        return _voxels[0];
     }
 
 private:
+    static const int VOXEL_TYPE_COUNT = 256;
+
     VoxelRepository *_repository;
 
+    // NULL while every cell holds _uniformVoxel; allocated on the first
+    // write that breaks uniformity
     const Voxel **_voxels;
+    const Voxel *_uniformVoxel;
+
+    int _solidCount;
+    int _typeCounts[VOXEL_TYPE_COUNT];
 
 private:
-    const Voxel **getVoxelAtIndex(const Position &position) const
+    int getIndex(const Position &position) const
+    {
+        return VOXEL_SECTOR_SIZE * VOXEL_SECTOR_SIZE * position.y +
+            VOXEL_SECTOR_SIZE * position.z +
+            position.x;
+    }
+
+    void fill(const Voxel *voxel)
+    {
+        delete[] _voxels;
+        _voxels = NULL;
+        _uniformVoxel = voxel;
+
+        for (int i = 0; i < VOXEL_TYPE_COUNT; ++i)
+        {
+            _typeCounts[i] = 0;
+        }
+
+        if (voxel == NULL)
+        {
+            _solidCount = 0;
+        }
+        else
+        {
+            _solidCount = VOXEL_SECTOR_ARRAY_SIZE;
+            _typeCounts[voxel->id] = VOXEL_SECTOR_ARRAY_SIZE;
+        }
+    }
+
+    void setVoxel(const Position &position, const Voxel *voxel)
     {
-        return &_voxels[VOXEL_SECTOR_SIZE * VOXEL_SECTOR_SIZE * position.y +
-                        VOXEL_SECTOR_SIZE * position.z +
-                        position.x];
+        if (_voxels == NULL)
+        {
+            if (voxel == _uniformVoxel)
+                return;
+
+            _voxels = new const Voxel*[VOXEL_SECTOR_ARRAY_SIZE];
+            for (int i = 0; i < VOXEL_SECTOR_ARRAY_SIZE; ++i)
+            {
+                _voxels[i] = _uniformVoxel;
+            }
+        }
+
+        const Voxel **cell = &_voxels[getIndex(position)];
+        if (*cell != NULL)
+        {
+            --_solidCount;
+            --_typeCounts[(*cell)->id];
+        }
+
+        if (voxel != NULL)
+        {
+            ++_solidCount;
+            ++_typeCounts[voxel->id];
+        }
+
+        *cell = voxel;
+
+        if (IsUniform())
+            fill(GetUniformVoxel());
     }
+
+    VoxelCollection(const VoxelCollection &o) = delete;
+    VoxelCollection &operator=(const VoxelCollection &o) = delete;
 };
@@ -6,75 +6,65 @@
 #include "entity.hh"
 #include "tilerenderer.hh"
 #include "types.hh"
+#include "voxellight.hh"
+#include "voxellod.hh"
 #include "voxels.hh"
 #include "voxelsectorexporter.hh"
+#include "voxelsectormesher.hh"
 
 class VoxelSectorGraphicsComponent
 {
 public:
-    VoxelSectorGraphicsComponent(IRenderer *renderer, TileRenderer *tileRenderer)
-        : _renderer(renderer), _tileRenderer(tileRenderer)
+    VoxelSectorGraphicsComponent(IRenderer *renderer, TileRenderer *tileRenderer,
+                                 const VoxelLodSelector *lodSelector)
+        : _renderer(renderer), _tileRenderer(tileRenderer),
+          _lodSelector(lodSelector), _mesher(tileRenderer)
     {
+        Invalidate();
     }
 
-    void update(const VoxelCollection &collection, const Position &sectorPosition)
+    void update(const VoxelCollection &collection,
+                const VoxelLightMap &lightMap,
+                const VoxelSectorNeighbors &neighbors,
+                const Position &sectorPosition)
     {
+        int level = _lodSelector->GetLevel();
+        RenderObject &mesh = _meshes[level];
+
+        if (_isMeshDirty[level])
+        {
+            _mesher.BuildMesh(collection, lightMap, neighbors, level, mesh);
+            _isMeshDirty[level] = false;
+        }
+
+        if (mesh._indices.empty())
+            return;
+
         glm::vec3 translation = glm::vec3(sectorPosition.x * VOXEL_SECTOR_SIZE,
                                           sectorPosition.y * VOXEL_SECTOR_SIZE,
                                           sectorPosition.z * VOXEL_SECTOR_SIZE);
         glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), translation);
         _renderer->SetModelMatrix(translationMatrix);
 
-        int x, y, z;
-        for (x = 0; x < VOXEL_SECTOR_SIZE; ++x)
+        _tileRenderer->Render(mesh);
+    }
+
+    void Invalidate()
+    {
+        for (int i = 0; i < VOXEL_LOD_LEVEL_COUNT; ++i)
         {
-            for (y = 0; y < VOXEL_SECTOR_SIZE; ++y)
-            {
-                for (z = 0; z < VOXEL_SECTOR_SIZE; ++z)
-                {
-                    renderVoxel(collection, x, y, z);
-                }
-            }
+            _isMeshDirty[i] = true;
         }
-   }
+    }
 
 private:
     IRenderer *_renderer;
     TileRenderer *_tileRenderer;
+    const VoxelLodSelector *_lodSelector;
+    VoxelSectorMesher _mesher;
 
-private:
-    void renderVoxel(const VoxelCollection &collection, int x, int y, int z)
-    {
-        const Voxel *voxel = collection.GetVoxel(Position(x, y, z));
-        if (voxel != NULL)
-        {
-            const VoxelType &type = voxel->_type;
-
-            _tileRenderer->Render(type.GetTileX(), type.GetTileY(),
-                                  glm::vec4(x, y, z, 1.0),
-                                  Direction::Left);
-
-            _tileRenderer->Render(type.GetTileX(), type.GetTileY(),
-                                  glm::vec4(x, y, z, 1.0),
-                                  Direction::Right);
-
-            _tileRenderer->Render(type.GetTileX(), type.GetTileY(),
-                                  glm::vec4(x, y, z, 1.0),
-                                  Direction::Up);
-
-            _tileRenderer->Render(type.GetTileX(), type.GetTileY(),
-                                  glm::vec4(x, y, z, 1.0),
-                                  Direction::Down);
-
-            _tileRenderer->Render(type.GetTileX(), type.GetTileY(),
-                                  glm::vec4(x, y, z, 1.0),
-                                  Direction::Forward);
-
-            _tileRenderer->Render(type.GetTileX(), type.GetTileY(),
-                                  glm::vec4(x, y, z, 1.0),
-                                  Direction::Backward);
-        }
-    }
+    RenderObject _meshes[VOXEL_LOD_LEVEL_COUNT];
+    bool _isMeshDirty[VOXEL_LOD_LEVEL_COUNT];
 };
 
 class VoxelSector : public Entity
@@ -89,16 +79,66 @@ public:
           _sectorPosition(sectorPosition)
     {
         _collection = new VoxelCollection(_repository);
+
+        for (int i = 0; i < DIRECTION_COUNT; ++i)
+        {
+            _neighbors[i] = NULL;
+        }
     }
 
     void update()
     {
-        _graphicsComponent->update(*_collection, _sectorPosition);
+        VoxelSectorNeighbors neighbors;
+        for (int z = -1; z <= 1; ++z)
+        {
+            for (int y = -1; y <= 1; ++y)
+            {
+                for (int x = -1; x <= 1; ++x)
+                {
+                    const VoxelSector *neighbor = getNeighbor(x, y, z);
+                    if (neighbor != NULL && (x != 0 || y != 0 || z != 0))
+                        neighbors.Set(x, y, z, neighbor->_collection, &neighbor->_lightMap);
+                }
+            }
+        }
+
+        _graphicsComponent->update(*_collection, _lightMap, neighbors, _sectorPosition);
     }
 
     void SetVoxel(const Position &position, IndexValue type)
     {
         _collection->SetVoxel(position, type);
+        updateLight(position);
+        invalidate(position);
+    }
+
+    void ClearVoxel(const Position &position)
+    {
+        _collection->ClearVoxel(position);
+        updateLight(position);
+        invalidate(position);
+    }
+
+    void Fill(IndexValue type)
+    {
+        _collection->Fill(type);
+        relight();
+    }
+
+    void SetNeighbor(Direction direction, VoxelSector *neighbor)
+    {
+        _neighbors[(int)direction] = neighbor;
+        if (neighbor != NULL)
+            neighbor->_neighbors[(int)GetOppositeDirection(direction)] = this;
+
+        // Sectors across an edge or a corner sample this one too
+        invalidateAll();
+
+        // Sky light reaches the lower sector through the upper one
+        if (direction == Direction::Up)
+            relight();
+        else if (direction == Direction::Down && neighbor != NULL)
+            neighbor->relight();
     }
 
     void Export(const std::string &fileName)
@@ -108,22 +148,130 @@ public:
 
     void Import(const std::string &fileName)
     {
+        VoxelCollection *collection = VoxelSectorImporter(_repository).ImportSector(fileName);
+        if (collection == NULL)
+            return;
+
         delete _collection;
-        _collection = VoxelSectorImporter(_repository).ImportSector(fileName);
+        _collection = collection;
+        relight();
     }
 
 private:
     VoxelSectorGraphicsComponent *_graphicsComponent;
     VoxelRepository *_repository;
     VoxelCollection *_collection;
+    VoxelLightMap _lightMap;
     Position _sectorPosition;
+    VoxelSector *_neighbors[DIRECTION_COUNT];
+
+private:
+    void updateLight(const Position &position)
+    {
+        // Light that reaches the sector edge is sampled by neighbour meshes
+        if (_lightMap.Update(*_collection, position))
+        {
+            invalidateAll();
+            relightBelow();
+        }
+    }
+
+    void relight()
+    {
+        const VoxelSector *above = _neighbors[(int)Direction::Up];
+        bool bottomChanged = _lightMap.Rebuild(*_collection, above != NULL ? &above->_lightMap : NULL);
+        invalidateAll();
+
+        if (bottomChanged)
+            relightBelow();
+    }
+
+    // Rebuilds the sectors below for as long as the sky light leaving
+    // through their bottom layer changes
+    void relightBelow()
+    {
+        VoxelSector *below = _neighbors[(int)Direction::Down];
+        if (below != NULL)
+            below->relight();
+    }
+
+    void invalidate(const Position &position)
+    {
+        // Edits on the sector boundary can expose or hide neighbor faces, and
+        // change the occlusion and lighting of the sectors across its edges
+        // and corners
+        int sides[3] = {
+            getBoundarySide(position.x), getBoundarySide(position.y), getBoundarySide(position.z)
+        };
+
+        for (int z = -1; z <= 1; ++z)
+        {
+            for (int y = -1; y <= 1; ++y)
+            {
+                for (int x = -1; x <= 1; ++x)
+                {
+                    if ((x == 0 || x == sides[0]) && (y == 0 || y == sides[1]) && (z == 0 || z == sides[2]))
+                        invalidateNeighbor(x, y, z);
+                }
+            }
+        }
+    }
+
+    void invalidateAll()
+    {
+        for (int z = -1; z <= 1; ++z)
+        {
+            for (int y = -1; y <= 1; ++y)
+            {
+                for (int x = -1; x <= 1; ++x)
+                {
+                    invalidateNeighbor(x, y, z);
+                }
+            }
+        }
+    }
+
+    void invalidateNeighbor(int x, int y, int z)
+    {
+        VoxelSector *neighbor = getNeighbor(x, y, z);
+        if (neighbor != NULL)
+            neighbor->_graphicsComponent->Invalidate();
+    }
+
+    static int getBoundarySide(int coordinate)
+    {
+        if (coordinate == 0)
+            return -1;
+
+        return coordinate == VOXEL_SECTOR_SIZE - 1 ? 1 : 0;
+    }
+
+    // Edge and corner neighbours are reached through the face neighbours,
+    // one axis at a time; offset (0, 0, 0) is the sector itself
+    VoxelSector *getNeighbor(int x, int y, int z)
+    {
+        const int offsets[3] = { x, y, z };
+        const Direction negative[3] = { Direction::Left, Direction::Down, Direction::Backward };
+        const Direction positive[3] = { Direction::Right, Direction::Up, Direction::Forward };
+
+        VoxelSector *sector = this;
+        for (int axis = 0; axis < 3 && sector != NULL; ++axis)
+        {
+            if (offsets[axis] != 0)
+                sector = sector->_neighbors[(int)(offsets[axis] < 0 ? negative[axis] : positive[axis])];
+        }
+
+        return sector;
+    }
 };
 
 VoxelSector *CreateVoxelSector(IRenderer *renderer, TileRenderer *tileRenderer,
+                               const VoxelLodSelector *lodSelector,
                                VoxelRepository *voxelRepository,
                                const Position &sectorPosition)
 {
-    VoxelSectorGraphicsComponent *graphicsComponent = new VoxelSectorGraphicsComponent(renderer, tileRenderer);
+    VoxelSectorGraphicsComponent *graphicsComponent = new VoxelSectorGraphicsComponent(renderer, tileRenderer,
+                                                                                       lodSelector);
     VoxelSector *sector = new VoxelSector(graphicsComponent, voxelRepository,
                                           sectorPosition);
 
@@ -15,6 +15,16 @@ IndexValue GetIndexLocation(int x, int y, int z)
         x;
 }
 
+VoxelRecord MakeVoxelRecord(const Voxel *voxel)
+{
+    VoxelRecord record;
+    if (voxel == NULL)
+        record.index = 0;
+    else
+        record.index = voxel->id + 1;
+    return record;
+}
+
 VoxelSectorExporter::VoxelSectorExporter()
 {
 }
@@ -25,7 +35,17 @@ void VoxelSectorExporter::ExportSector(const VoxelCollection &collection, const
     if (file == NULL)
         return;
 
+    // Uniform sectors are stored as a single record
+    if (collection.IsUniform())
+    {
+        VoxelRecord record = MakeVoxelRecord(collection.GetUniformVoxel());
+        fwrite(&record, sizeof(VoxelRecord), 1, file);
+        fclose(file);
+        return;
+    }
+
     std::vector<VoxelRecord> records;
+    records.reserve(VOXEL_SECTOR_ARRAY_SIZE);
 
     for (int z = 0; z < VOXEL_SECTOR_SIZE; ++z)
     {
@@ -33,13 +53,7 @@ void VoxelSectorExporter::ExportSector(const VoxelCollection &collection, const
         {
             for (int x = 0; x < VOXEL_SECTOR_SIZE; ++x)
             {
-                VoxelRecord record;
-                const Voxel *voxel = collection.GetVoxel(Position(x, y, z));
-                if (voxel == NULL)
-                    record.index = 0;
-                else
-                    record.index = voxel->id + 1;
-                records.push_back(record);
+                records.push_back(MakeVoxelRecord(collection.GetVoxel(Position(x, y, z))));
             }
         }
     }
@@ -62,12 +76,19 @@ VoxelCollection *VoxelSectorImporter::ImportSector(const std::string &fileName)
 
     VoxelRecord records[VOXEL_SECTOR_ARRAY_SIZE];
 
-    fread(records, sizeof(VoxelRecord), VOXEL_SECTOR_ARRAY_SIZE, file);
+    size_t recordCount = fread(records, sizeof(VoxelRecord), VOXEL_SECTOR_ARRAY_SIZE, file);
 
     fclose(file);
 
     VoxelCollection *collection = new VoxelCollection(_repository);
 
+    if (recordCount == 1)
+    {
+        if (records[0].index != 0)
+            collection->Fill(records[0].index - 1);
+        return collection;
+    }
+
     for (int z = 0; z < VOXEL_SECTOR_SIZE; ++z)
     {
         for (int y = 0; y < VOXEL_SECTOR_SIZE; ++y)
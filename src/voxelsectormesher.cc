@@ -0,0 +1,330 @@
+#include "utility/profiler.hh"
+#include "voxelsectormesher.hh"
+
+static const Direction AllDirections[DIRECTION_COUNT] = {
+    Direction::Up,
+    Direction::Down,
+    Direction::Left,
+    Direction::Right,
+    Direction::Forward,
+    Direction::Backward
+};
+
+// Full resolution view of a sector that looks across into its neighbours
+class CollectionGrid
+{
+public:
+    CollectionGrid(const VoxelCollection &collection, const VoxelLightMap &lightMap,
+                   const VoxelSectorNeighbors &neighbors)
+        : _collection(collection), _lightMap(lightMap), _neighbors(neighbors)
+    {
+    }
+
+    int GetSize() const
+    {
+        return VOXEL_SECTOR_SIZE;
+    }
+
+    int GetScale() const
+    {
+        return 1;
+    }
+
+    bool IsEmpty() const
+    {
+        return _collection.IsEmpty();
+    }
+
+    bool IsFull() const
+    {
+        return _collection.IsFull();
+    }
+
+    const Voxel *GetVoxel(int x, int y, int z) const
+    {
+        return _collection.GetVoxel(Position(x, y, z));
+    }
+
+    // Cells past an edge or a corner come from the sector sharing it
+    bool IsSolid(int x, int y, int z) const
+    {
+        int sectorX = getSectorOffset(x), sectorY = getSectorOffset(y), sectorZ = getSectorOffset(z);
+        if (sectorX == 0 && sectorY == 0 && sectorZ == 0)
+            return _collection.GetVoxel(Position(x, y, z)) != NULL;
+
+        const VoxelCollection *neighbor = _neighbors.Get(sectorX, sectorY, sectorZ);
+        if (neighbor == NULL)
+            return false;
+
+        return neighbor->GetVoxel(wrap(x, y, z)) != NULL;
+    }
+
+    unsigned char GetPackedLight(int x, int y, int z) const
+    {
+        int sectorX = getSectorOffset(x), sectorY = getSectorOffset(y), sectorZ = getSectorOffset(z);
+        if (sectorX == 0 && sectorY == 0 && sectorZ == 0)
+            return _lightMap.GetPackedLight(Position(x, y, z));
+
+        const VoxelLightMap *neighbor = _neighbors.GetLightMap(sectorX, sectorY, sectorZ);
+        if (neighbor == NULL)
+            return VOXEL_MAX_LIGHT << 4;
+
+        return neighbor->GetPackedLight(wrap(x, y, z));
+    }
+
+private:
+    const VoxelCollection &_collection;
+    const VoxelLightMap &_lightMap;
+    const VoxelSectorNeighbors &_neighbors;
+
+private:
+    static int getSectorOffset(int coordinate)
+    {
+        if (coordinate < 0)
+            return -1;
+
+        return coordinate >= VOXEL_SECTOR_SIZE ? 1 : 0;
+    }
+
+    static Position wrap(int x, int y, int z)
+    {
+        return Position((x + VOXEL_SECTOR_SIZE) % VOXEL_SECTOR_SIZE,
+                        (y + VOXEL_SECTOR_SIZE) % VOXEL_SECTOR_SIZE,
+                        (z + VOXEL_SECTOR_SIZE) % VOXEL_SECTOR_SIZE);
+    }
+};
+
+Direction GetOppositeDirection(Direction direction)
+{
+    switch (direction)
+    {
+    case Direction::Up:
+        return Direction::Down;
+    case Direction::Down:
+        return Direction::Up;
+    case Direction::Left:
+        return Direction::Right;
+    case Direction::Right:
+        return Direction::Left;
+    case Direction::Forward:
+        return Direction::Backward;
+    case Direction::Backward:
+        return Direction::Forward;
+    }
+
+    return direction;
+}
+
+Position GetDirectionOffset(Direction direction)
+{
+    switch (direction)
+    {
+    case Direction::Up:
+        return Position(0, 1, 0);
+    case Direction::Down:
+        return Position(0, -1, 0);
+    case Direction::Left:
+        return Position(-1, 0, 0);
+    case Direction::Right:
+        return Position(1, 0, 0);
+    case Direction::Forward:
+        return Position(0, 0, 1);
+    case Direction::Backward:
+        return Position(0, 0, -1);
+    }
+
+    return Position(0, 0, 0);
+}
+
+VoxelSectorMesher::VoxelSectorMesher(TileRenderer *tileRenderer)
+    : _tileRenderer(tileRenderer)
+{
+}
+
+void VoxelSectorMesher::BuildMesh(const VoxelCollection &collection,
+                                  const VoxelLightMap &lightMap,
+                                  const VoxelSectorNeighbors &neighbors,
+                                  int level, RenderObject &mesh)
+{
+    PROFILE_SCOPE("VoxelSectorMesher::BuildMesh");
+
+    mesh = RenderObject();
+
+    if (collection.IsEmpty() || IsEnclosed(collection, neighbors))
+        return;
+
+    if (level == 0)
+    {
+        buildGridMesh(CollectionGrid(collection, lightMap, neighbors), mesh);
+    }
+    else
+    {
+        buildGridMesh(VoxelLodGrid(collection, lightMap, neighbors, level), mesh);
+    }
+}
+
+bool VoxelSectorMesher::IsEnclosed(const VoxelCollection &collection,
+                                   const VoxelSectorNeighbors &neighbors)
+{
+    if (!collection.IsFull())
+        return false;
+
+    for (int i = 0; i < DIRECTION_COUNT; ++i)
+    {
+        const VoxelCollection *neighbor = neighbors.Get(AllDirections[i]);
+        if (neighbor == NULL || !neighbor->IsFull())
+            return false;
+    }
+
+    return true;
+}
+
+template <class Grid>
+void VoxelSectorMesher::buildGridMesh(const Grid &grid, RenderObject &mesh)
+{
+    if (grid.IsEmpty())
+        return;
+
+    // Interior faces of a full grid are always hidden, so only the
+    // outer layer needs to be visited
+    if (grid.IsFull())
+    {
+        buildShellMesh(grid, mesh);
+        return;
+    }
+
+    for (int x = 0; x < grid.GetSize(); ++x)
+    {
+        for (int y = 0; y < grid.GetSize(); ++y)
+        {
+            for (int z = 0; z < grid.GetSize(); ++z)
+            {
+                appendVisibleFaces(grid, x, y, z, mesh);
+            }
+        }
+    }
+}
+
+template <class Grid>
+void VoxelSectorMesher::buildShellMesh(const Grid &grid, RenderObject &mesh)
+{
+    const int last = grid.GetSize() - 1;
+
+    for (int i = 0; i < DIRECTION_COUNT; ++i)
+    {
+        Direction direction = AllDirections[i];
+        Position offset = GetDirectionOffset(direction);
+
+        for (int u = 0; u < grid.GetSize(); ++u)
+        {
+            for (int v = 0; v < grid.GetSize(); ++v)
+            {
+                int x = offset.x == 0 ? u : (offset.x > 0 ? last : 0);
+                int y = offset.y == 0 ? (offset.x == 0 ? v : u) : (offset.y > 0 ? last : 0);
+                int z = offset.z == 0 ? v : (offset.z > 0 ? last : 0);
+
+                if (!grid.IsSolid(x + offset.x, y + offset.y, z + offset.z))
+                    appendFace(grid, grid.GetVoxel(x, y, z), x, y, z, direction, mesh);
+            }
+        }
+    }
+}
+
+template <class Grid>
+void VoxelSectorMesher::appendVisibleFaces(const Grid &grid, int x, int y, int z, RenderObject &mesh)
+{
+    const Voxel *voxel = grid.GetVoxel(x, y, z);
+    if (voxel == NULL)
+        return;
+
+    for (int i = 0; i < DIRECTION_COUNT; ++i)
+    {
+        Position offset = GetDirectionOffset(AllDirections[i]);
+
+        if (!grid.IsSolid(x + offset.x, y + offset.y, z + offset.z))
+            appendFace(grid, voxel, x, y, z, AllDirections[i], mesh);
+    }
+}
+
+template <class Grid>
+void VoxelSectorMesher::appendFace(const Grid &grid, const Voxel *voxel, int x, int y, int z,
+                                   Direction direction, RenderObject &mesh)
+{
+    const VoxelType &type = voxel->_type;
+    int scale = grid.GetScale();
+
+    // Voxels span downwards from their location, so a scaled cell is
+    // anchored at the top of the block it covers
+    glm::vec4 location(x * scale, (y + 1) * scale - 1, z * scale, 1.0);
+
+    _tileRenderer->AppendFace(mesh, type.GetTileX(), type.GetTileY(),
+                              location, direction, scale);
+
+    appendVertexLighting(grid, x, y, z, direction, mesh);
+}
+
+template <class Grid>
+void VoxelSectorMesher::appendVertexLighting(const Grid &grid, int x, int y, int z,
+                                             Direction direction, RenderObject &mesh)
+{
+    const int verticesPerFace = 6;
+    const int componentsPerVertex = 4;
+
+    Position offset = GetDirectionOffset(direction);
+    int normal[3] = { offset.x, offset.y, offset.z };
+    int front[3] = { x + offset.x, y + offset.y, z + offset.z };
+    float center[3] = { x + 0.5f, y + 0.5f, z + 0.5f };
+    float scale = grid.GetScale();
+
+    size_t firstVertex = mesh._vertices.size() / componentsPerVertex - verticesPerFace;
+    for (size_t vertex = firstVertex; vertex < firstVertex + verticesPerFace; ++vertex)
+    {
+        const float *position = &mesh._vertices[vertex * componentsPerVertex];
+        float corner[3] = { position[0] / scale, (position[1] + 1) / scale, position[2] / scale };
+
+        // Step from the cell in front of the face towards this corner
+        // along each of the two axes spanning the face
+        int steps[2][3] = { { 0, 0, 0 }, { 0, 0, 0 } };
+        int tangent = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (normal[axis] == 0)
+            {
+                steps[tangent][axis] = corner[axis] > center[axis] ? 1 : -1;
+                ++tangent;
+            }
+        }
+
+        int cells[4][3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            cells[0][axis] = front[axis];
+            cells[1][axis] = front[axis] + steps[0][axis];
+            cells[2][axis] = front[axis] + steps[1][axis];
+            cells[3][axis] = front[axis] + steps[0][axis] + steps[1][axis];
+        }
+
+        bool side1 = grid.IsSolid(cells[1][0], cells[1][1], cells[1][2]);
+        bool side2 = grid.IsSolid(cells[2][0], cells[2][1], cells[2][2]);
+        bool cornerSolid = grid.IsSolid(cells[3][0], cells[3][1], cells[3][2]);
+        int occlusion = (side1 && side2) ? 0 : 3 - (side1 + side2 + cornerSolid);
+
+        // Smooth lighting: average the open cells touching this corner
+        int sky = 0, block = 0, samples = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (i > 0 && grid.IsSolid(cells[i][0], cells[i][1], cells[i][2]))
+                continue;
+
+            unsigned char light = grid.GetPackedLight(cells[i][0], cells[i][1], cells[i][2]);
+            sky += light >> 4;
+            block += light & 0xF;
+            ++samples;
+        }
+
+        mesh._light.push_back(occlusion * 255 / 3);
+        mesh._light.push_back(sky * 255 / (samples * VOXEL_MAX_LIGHT));
+        mesh._light.push_back(block * 255 / (samples * VOXEL_MAX_LIGHT));
+        mesh._light.push_back(255);
+    }
+}
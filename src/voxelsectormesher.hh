@@ -0,0 +1,50 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "rendering/irenderer.hh"
+#include "tilerenderer.hh"
+#include "types.hh"
+#include "voxellight.hh"
+#include "voxellod.hh"
+#include "voxels.hh"
+#include "voxelsectorneighbors.hh"
+
+Direction GetOppositeDirection(Direction direction);
+Position GetDirectionOffset(Direction direction);
+
+class VoxelSectorMesher
+{
+public:
+    VoxelSectorMesher(TileRenderer *tileRenderer);
+
+    // Level 0 is full resolution; level n meshes the sector downsampled
+    // by 2^n (see VoxelLodGrid). Every vertex gets four bytes of
+    // lighting in mesh._light: ambient occlusion, sky light, block light
+    // and an unused channel.
+    void BuildMesh(const VoxelCollection &collection,
+                   const VoxelLightMap &lightMap,
+                   const VoxelSectorNeighbors &neighbors,
+                   int level, RenderObject &mesh);
+
+    static bool IsEnclosed(const VoxelCollection &collection,
+                           const VoxelSectorNeighbors &neighbors);
+
+private:
+    TileRenderer *_tileRenderer;
+
+private:
+    template <class Grid>
+    void buildGridMesh(const Grid &grid, RenderObject &mesh);
+    template <class Grid>
+    void buildShellMesh(const Grid &grid, RenderObject &mesh);
+    template <class Grid>
+    void appendVisibleFaces(const Grid &grid, int x, int y, int z, RenderObject &mesh);
+
+    template <class Grid>
+    void appendFace(const Grid &grid, const Voxel *voxel, int x, int y, int z,
+                    Direction direction, RenderObject &mesh);
+    template <class Grid>
+    void appendVertexLighting(const Grid &grid, int x, int y, int z,
+                              Direction direction, RenderObject &mesh);
+};
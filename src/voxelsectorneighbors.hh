@@ -0,0 +1,90 @@
+#pragma once
+
+#include "tilerenderer.hh"
+#include "voxellight.hh"
+#include "voxels.hh"
+
+const int DIRECTION_COUNT = 6;
+
+// The sectors around one sector, addressed by their offset of -1, 0 or 1
+// on each axis. Besides the six sharing a face, the ones sharing only an
+// edge or a corner are kept for ambient occlusion and smooth lighting.
+class VoxelSectorNeighbors
+{
+public:
+    VoxelSectorNeighbors()
+    {
+        for (int i = 0; i < NEIGHBOR_SLOT_COUNT; ++i)
+        {
+            _collections[i] = NULL;
+            _lightMaps[i] = NULL;
+        }
+    }
+
+    const VoxelCollection *Get(Direction direction) const
+    {
+        return _collections[getIndex(direction)];
+    }
+
+    const VoxelLightMap *GetLightMap(Direction direction) const
+    {
+        return _lightMaps[getIndex(direction)];
+    }
+
+    void Set(Direction direction, const VoxelCollection *collection,
+             const VoxelLightMap *lightMap)
+    {
+        _collections[getIndex(direction)] = collection;
+        _lightMaps[getIndex(direction)] = lightMap;
+    }
+
+    const VoxelCollection *Get(int x, int y, int z) const
+    {
+        return _collections[getIndex(x, y, z)];
+    }
+
+    const VoxelLightMap *GetLightMap(int x, int y, int z) const
+    {
+        return _lightMaps[getIndex(x, y, z)];
+    }
+
+    void Set(int x, int y, int z, const VoxelCollection *collection,
+             const VoxelLightMap *lightMap)
+    {
+        _collections[getIndex(x, y, z)] = collection;
+        _lightMaps[getIndex(x, y, z)] = lightMap;
+    }
+
+private:
+    static const int NEIGHBOR_SLOT_COUNT = 27;
+
+    const VoxelCollection *_collections[NEIGHBOR_SLOT_COUNT];
+    const VoxelLightMap *_lightMaps[NEIGHBOR_SLOT_COUNT];
+
+private:
+    static int getIndex(int x, int y, int z)
+    {
+        return (x + 1) + (y + 1) * 3 + (z + 1) * 9;
+    }
+
+    static int getIndex(Direction direction)
+    {
+        switch (direction)
+        {
+        case Direction::Up:
+            return getIndex(0, 1, 0);
+        case Direction::Down:
+            return getIndex(0, -1, 0);
+        case Direction::Left:
+            return getIndex(-1, 0, 0);
+        case Direction::Right:
+            return getIndex(1, 0, 0);
+        case Direction::Forward:
+            return getIndex(0, 0, 1);
+        case Direction::Backward:
+            return getIndex(0, 0, -1);
+        }
+
+        return getIndex(0, 0, 0);
+    }
+};
@@ -0,0 +1,136 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "allocationcounter.hh"
+
+#ifdef COUNT_ALLOCATIONS
+
+// Every block carries its size in front so frees can be accounted for
+static const size_t HEADER_SIZE = 16;
+
+static std::atomic<bool> counting(false);
+static std::atomic<size_t> allocationCount(0);
+static std::atomic<size_t> currentBytes(0);
+static std::atomic<size_t> baselineBytes(0);
+static std::atomic<size_t> peakBytes(0);
+
+static void *Allocate(size_t size)
+{
+    char *block = (char *)malloc(size + HEADER_SIZE);
+    if (block == NULL)
+        return NULL;
+
+    *(size_t *)block = size;
+    size_t bytes = currentBytes += size;
+
+    if (counting)
+    {
+        ++allocationCount;
+
+        size_t peak = peakBytes;
+        while (bytes > peak && !peakBytes.compare_exchange_weak(peak, bytes)) {}
+    }
+
+    return block + HEADER_SIZE;
+}
+
+static void Free(void *pointer)
+{
+    if (pointer == NULL)
+        return;
+
+    char *block = (char *)pointer - HEADER_SIZE;
+    currentBytes -= *(size_t *)block;
+    free(block);
+}
+
+void StartAllocationCounting()
+{
+    allocationCount = 0;
+    baselineBytes = (size_t)currentBytes;
+    peakBytes = (size_t)currentBytes;
+    counting = true;
+}
+
+AllocationStatistics StopAllocationCounting()
+{
+    counting = false;
+
+    AllocationStatistics statistics;
+    statistics.allocationCount = allocationCount;
+    statistics.peakBytes = peakBytes - baselineBytes;
+
+    return statistics;
+}
+
+bool IsCountingAllocations()
+{
+    return true;
+}
+
+void *operator new(size_t size)
+{
+    void *pointer = Allocate(size);
+    if (pointer == NULL)
+        throw std::bad_alloc();
+
+    return pointer;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return Allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return Allocate(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    Free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    Free(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept
+{
+    Free(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept
+{
+    Free(pointer);
+}
+
+#else
+
+void StartAllocationCounting()
+{
+}
+
+AllocationStatistics StopAllocationCounting()
+{
+    AllocationStatistics statistics;
+    statistics.allocationCount = 0;
+    statistics.peakBytes = 0;
+
+    return statistics;
+}
+
+bool IsCountingAllocations()
+{
+    return false;
+}
+
+#endif
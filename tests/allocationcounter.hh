@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+typedef struct AllocationStatistics
+{
+    size_t allocationCount;
+    size_t peakBytes;
+} AllocationStatistics;
+
+// Counts heap allocations made through operator new between the two calls;
+// peakBytes is the high-water mark above the usage at StartAllocationCounting.
+// Counting replaces the global operator new, so it is only built into the
+// benchmark binary (make benchmarks defines COUNT_ALLOCATIONS); in the test
+// binary the statistics stay zero and the real allocator is used.
+void StartAllocationCounting();
+AllocationStatistics StopAllocationCounting();
+bool IsCountingAllocations();
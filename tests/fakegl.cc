@@ -0,0 +1,92 @@
+#include <cstdint>
+#include <cstring>
+
+#include "catch.hh"
+#include "fakegl.hh"
+
+FakeGL fakeGL;
+
+static void CODEGEN_FUNCPTR FakeGenBuffers(GLsizei count, GLuint *names)
+{
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        names[i] = ++fakeGL.nextName;
+        fakeGL.buffers[names[i]];
+    }
+}
+
+static void CODEGEN_FUNCPTR FakeDeleteBuffers(GLsizei count, const GLuint *names)
+{
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        fakeGL.buffers.erase(names[i]);
+    }
+}
+
+static void CODEGEN_FUNCPTR FakeBindBuffer(GLenum target, GLuint name)
+{
+    fakeGL.bufferBindings[target] = name;
+}
+
+static void CODEGEN_FUNCPTR FakeBufferData(GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage)
+{
+    std::vector<unsigned char> &buffer = fakeGL.buffers[fakeGL.bufferBindings[target]];
+    buffer.assign(size, 0);
+    if (data != NULL)
+        memcpy(buffer.data(), data, size);
+}
+
+static void *CODEGEN_FUNCPTR FakeMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+    return fakeGL.buffers[fakeGL.bufferBindings[target]].data() + offset;
+}
+
+static GLboolean CODEGEN_FUNCPTR FakeUnmapBuffer(GLenum target)
+{
+    return GL_TRUE;
+}
+
+static void CODEGEN_FUNCPTR FakeCopyBufferSubData(GLenum readTarget, GLenum writeTarget, GLintptr readOffset,
+                                                  GLintptr writeOffset, GLsizeiptr size)
+{
+    std::vector<unsigned char> &source = fakeGL.buffers[fakeGL.bufferBindings[readTarget]];
+    std::vector<unsigned char> &destination = fakeGL.buffers[fakeGL.bufferBindings[writeTarget]];
+    REQUIRE(readOffset + size <= source.size());
+    REQUIRE(writeOffset + size <= destination.size());
+    memcpy(&destination[writeOffset], &source[readOffset], size);
+}
+
+static GLsync CODEGEN_FUNCPTR FakeFenceSync(GLenum condition, GLbitfield flags)
+{
+    ++fakeGL.liveFences;
+    return (GLsync)(uintptr_t)(++fakeGL.nextName);
+}
+
+static GLenum CODEGEN_FUNCPTR FakeClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+{
+    return fakeGL.fencesSignaled ? GL_ALREADY_SIGNALED : GL_TIMEOUT_EXPIRED;
+}
+
+static void CODEGEN_FUNCPTR FakeDeleteSync(GLsync sync)
+{
+    --fakeGL.liveFences;
+}
+
+static void CODEGEN_FUNCPTR FakePixelStorei(GLenum name, GLint value)
+{
+    if (name == GL_UNPACK_ALIGNMENT)
+        fakeGL.unpackAlignment = value;
+}
+
+FakeGLScope::FakeGLScope()
+    : _genBuffers(glGenBuffers, FakeGenBuffers), _deleteBuffers(glDeleteBuffers, FakeDeleteBuffers),
+      _bindBuffer(glBindBuffer, FakeBindBuffer), _bufferData(glBufferData, FakeBufferData),
+      _mapBufferRange(glMapBufferRange, FakeMapBufferRange), _unmapBuffer(glUnmapBuffer, FakeUnmapBuffer),
+      _copyBufferSubData(glCopyBufferSubData, FakeCopyBufferSubData), _fenceSync(glFenceSync, FakeFenceSync),
+      _clientWaitSync(glClientWaitSync, FakeClientWaitSync), _deleteSync(glDeleteSync, FakeDeleteSync),
+      _pixelStorei(glPixelStorei, FakePixelStorei)
+{
+    fakeGL = FakeGL();
+    fakeGL.unpackAlignment = 4;
+    fakeGL.fencesSignaled = true;
+}
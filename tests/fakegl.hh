@@ -0,0 +1,65 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include <GL/gl_core_3_3.h>
+
+// Just enough of a GL driver to run buffer uploads without a context.
+// Buffers are plain byte arrays.
+typedef struct FakeGL
+{
+    GLuint nextName;
+    std::map<GLuint, std::vector<unsigned char> > buffers;
+    std::map<GLenum, GLuint> bufferBindings;
+    GLint unpackAlignment;
+    bool fencesSignaled;
+    int liveFences;
+} FakeGL;
+
+extern FakeGL fakeGL;
+
+// Points a GL function at a fake for the lifetime of the object
+template <class Function>
+class FakeGLFunction
+{
+public:
+    FakeGLFunction(Function &function, Function fake)
+        : _function(function), _original(function)
+    {
+        _function = fake;
+    }
+
+    ~FakeGLFunction()
+    {
+        _function = _original;
+    }
+
+private:
+    Function &_function;
+    Function _original;
+
+    FakeGLFunction(const FakeGLFunction &o) = delete;
+};
+
+// Resets fakeGL and swaps the fake buffer, fence and pixel store functions
+// in for the lifetime of a test. Tests that need more of the driver add
+// their own FakeGLFunction members next to one of these.
+class FakeGLScope
+{
+public:
+    FakeGLScope();
+
+private:
+    FakeGLFunction<decltype(glGenBuffers)> _genBuffers;
+    FakeGLFunction<decltype(glDeleteBuffers)> _deleteBuffers;
+    FakeGLFunction<decltype(glBindBuffer)> _bindBuffer;
+    FakeGLFunction<decltype(glBufferData)> _bufferData;
+    FakeGLFunction<decltype(glMapBufferRange)> _mapBufferRange;
+    FakeGLFunction<decltype(glUnmapBuffer)> _unmapBuffer;
+    FakeGLFunction<decltype(glCopyBufferSubData)> _copyBufferSubData;
+    FakeGLFunction<decltype(glFenceSync)> _fenceSync;
+    FakeGLFunction<decltype(glClientWaitSync)> _clientWaitSync;
+    FakeGLFunction<decltype(glDeleteSync)> _deleteSync;
+    FakeGLFunction<decltype(glPixelStorei)> _pixelStorei;
+};
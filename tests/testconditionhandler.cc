@@ -1,6 +1,10 @@
+#include <chrono>
+#include <iostream>
+
 #include "catch.hh"
 
 #include "conditionhandler.hh"
+#include "input.hh"
 
 class AlwaysTrue : public Condition
 {
@@ -24,18 +28,75 @@ class StubCommand : public Command
 {
 public:
     StubCommand()
-        : wasRun(false)
+        : wasRun(false), runCount(0)
     {
     }
 
     void Execute()
     {
         wasRun = true;
+        ++runCount;
     }
 
     bool wasRun;
+    int runCount;
+};
+
+// Stands in for a key binding, so checks can be counted
+class KeyCondition : public Condition
+{
+public:
+    KeyCondition(System::KeyCode key, const bool *pressed)
+        : checkCount(0), _key(key), _pressed(pressed)
+    {
+    }
+
+    bool Check()
+    {
+        ++checkCount;
+        return *_pressed;
+    }
+
+    bool GetInputSources(std::vector<InputSource> &sources)
+    {
+        sources.push_back(GetKeySource(_key));
+        return true;
+    }
+
+    int checkCount;
+
+private:
+    System::KeyCode _key;
+    const bool *_pressed;
+};
+
+class RemovingCommand : public Command
+{
+public:
+    RemovingCommand(ConditionHandler *handler, Condition *condition, Command *command)
+        : _handler(handler), _condition(condition), _command(command)
+    {
+    }
+
+    void Execute()
+    {
+        _handler->RemoveHandler(_condition, _command);
+    }
+
+private:
+    ConditionHandler *_handler;
+    Condition *_condition;
+    Command *_command;
 };
 
+static InputEvent KeyEvent(InputEvent::Type type, System::KeyCode key)
+{
+    InputEvent event = InputEvent();
+    event.type = type;
+    event.key = key;
+    return event;
+}
+
 TEST_CASE("ConditionHandler")
 {
     ConditionHandler handler;
@@ -68,4 +129,137 @@ TEST_CASE("ConditionHandler")
 
         REQUIRE(command.wasRun == false);
     }
+
+    SECTION("runs event command once for every matching event")
+    {
+        KeyboardEventCondition condition(InputEvent::Type::KeyDown, System::KeyCode::KeySpace);
+        handler.SetEventHandler(&condition, &command);
+
+        std::vector<InputEvent> events;
+        events.push_back(KeyEvent(InputEvent::Type::KeyDown, System::KeyCode::KeySpace));
+        events.push_back(KeyEvent(InputEvent::Type::KeyUp, System::KeyCode::KeySpace));
+        events.push_back(KeyEvent(InputEvent::Type::KeyDown, System::KeyCode::KeyA));
+        events.push_back(KeyEvent(InputEvent::Type::KeyDown, System::KeyCode::KeySpace));
+        handler.Update(events);
+
+        REQUIRE(command.runCount == 2);
+
+        handler.RemoveEventHandler(&condition, &command);
+        handler.Update(events);
+
+        REQUIRE(command.runCount == 2);
+    }
+
+    SECTION("only checks conditions whose inputs changed")
+    {
+        bool pressed = false;
+        KeyCondition condition(System::KeyCode::KeyA, &pressed);
+        handler.SetHandler(&condition, &command);
+
+        std::vector<InputEvent> noEvents;
+        handler.Update(noEvents);
+        REQUIRE(condition.checkCount == 1);
+        REQUIRE(command.runCount == 0);
+
+        std::vector<InputEvent> otherKey(1, KeyEvent(InputEvent::Type::KeyDown, System::KeyCode::KeyB));
+        handler.Update(otherKey);
+        handler.Update(noEvents);
+        REQUIRE(condition.checkCount == 1);
+
+        // Held down, the command keeps running without further checks
+        pressed = true;
+        std::vector<InputEvent> keyDown(1, KeyEvent(InputEvent::Type::KeyDown, System::KeyCode::KeyA));
+        handler.Update(keyDown);
+        handler.Update(noEvents);
+        handler.Update(noEvents);
+        handler.Update(noEvents);
+        REQUIRE(condition.checkCount == 3);
+        REQUIRE(command.runCount == 4);
+
+        pressed = false;
+        std::vector<InputEvent> keyUp(1, KeyEvent(InputEvent::Type::KeyUp, System::KeyCode::KeyA));
+        handler.Update(keyUp);
+        handler.Update(noEvents);
+        REQUIRE(command.runCount == 4);
+    }
+
+    SECTION("runs commands in binding order and allows removal while running")
+    {
+        AlwaysTrue first, second;
+        StubCommand removed;
+        RemovingCommand remover(&handler, &second, &removed);
+        handler.SetHandler(&first, &remover);
+        handler.SetHandler(&second, &removed);
+        handler.Update();
+
+        REQUIRE(removed.wasRun == false);
+
+        handler.SetHandler(&second, &command);
+        handler.Update();
+        REQUIRE(command.runCount == 1);
+    }
+}
+
+// An editor-sized set of key bindings, with one key held at a time and a
+// different one every frame
+TEST_CASE("ConditionHandler benchmark", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+    const int bindingCount = 1000, frameCount = 10000;
+    const System::KeyCode firstKey = System::KeyCode::KeyA;
+    const int keyCount = (int)System::KeyCode::KeyZ - (int)firstKey + 1;
+
+    bool pressed[keyCount] = {};
+    std::vector<KeyCondition*> conditions;
+    StubCommand command;
+    ConditionHandler handler;
+    for (int i = 0; i < bindingCount; ++i)
+    {
+        conditions.push_back(new KeyCondition((System::KeyCode)((int)firstKey + i % keyCount), &pressed[i % keyCount]));
+        handler.SetHandler(conditions.back(), &command);
+    }
+
+    double seconds[2];
+    int runCounts[2];
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int i = 0; i < keyCount; ++i)
+        {
+            pressed[i] = false;
+        }
+        handler.Update();
+        command.runCount = 0;
+
+        Clock::time_point start = Clock::now();
+        std::vector<InputEvent> events(2);
+        for (int frame = 0; frame < frameCount; ++frame)
+        {
+            int released = (frame + keyCount - 1) % keyCount, key = frame % keyCount;
+            pressed[released] = false;
+            pressed[key] = true;
+
+            if (pass == 0)
+            {
+                handler.Update();
+            }
+            else
+            {
+                events[0] = KeyEvent(InputEvent::Type::KeyUp, (System::KeyCode)((int)firstKey + released));
+                events[1] = KeyEvent(InputEvent::Type::KeyDown, (System::KeyCode)((int)firstKey + key));
+                handler.Update(events);
+            }
+        }
+        seconds[pass] = std::chrono::duration<double>(Clock::now() - start).count();
+        runCounts[pass] = command.runCount;
+    }
+
+    REQUIRE(runCounts[0] == runCounts[1]);
+    std::cout << bindingCount << " bindings, " << frameCount << " frames: polling "
+              << seconds[0] * 1e6 / frameCount << " us/frame, indexed "
+              << seconds[1] * 1e6 / frameCount << " us/frame" << std::endl;
+
+    for (int i = 0; i < conditions.size(); ++i)
+    {
+        delete conditions[i];
+    }
 }
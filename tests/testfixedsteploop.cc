@@ -0,0 +1,114 @@
+#include "catch.hh"
+
+#include "utility/fixedsteploop.hh"
+
+// Every read costs a little time, the way a spin loop would
+class FakeClock : public IMonotonicClock
+{
+public:
+    FakeClock(unsigned long long readCost)
+        : now(1234567), readCost(readCost)
+    {
+    }
+
+    unsigned long long GetNanoseconds()
+    {
+        now += readCost;
+        return now;
+    }
+
+    unsigned long long now;
+    unsigned long long readCost;
+};
+
+// Sleeps run long by a repeating amount, like a coarse OS timer
+class FakeSleepService : public ISleepService
+{
+public:
+    FakeSleepService(FakeClock *clock, unsigned long long maxOvershoot)
+        : sleepCount(0), _clock(clock), _maxOvershoot(maxOvershoot)
+    {
+    }
+
+    void Sleep(unsigned int milliseconds)
+    {
+        _clock->now += milliseconds * NANOSECONDS_PER_MILLISECOND + sleepCount * 7919 % (_maxOvershoot + 1);
+        ++sleepCount;
+    }
+
+    unsigned long long sleepCount;
+
+private:
+    FakeClock *_clock;
+    unsigned long long _maxOvershoot;
+};
+
+TEST_CASE("FixedStepLoop keeps its schedule over a million steps")
+{
+    const unsigned long long stepCount = 1000000;
+    FakeClock clock(10000);
+    FakeSleepService sleepService(&clock, 1500000);
+    FixedStepLoop loop(&clock, &sleepService, 60);
+
+    loop.Start();
+    unsigned long long maxLateness = 0;
+    bool singleSteps = true;
+    while (loop.GetStepCount() < stepCount)
+    {
+        singleSteps = singleSteps && loop.BeginFrame() == 1;
+
+        // Frame work of up to 5 ms
+        clock.now += loop.GetStepCount() % 5 * NANOSECONDS_PER_MILLISECOND;
+
+        unsigned long long target = loop.GetStepTime(loop.GetStepCount());
+        loop.WaitForNextStep();
+
+        // The first sleeps teach the loop how far they overshoot
+        if (loop.GetStepCount() > 10)
+            maxLateness = std::max(maxLateness, clock.now - target);
+    }
+
+    REQUIRE(singleSteps);
+    REQUIRE(loop.GetSkippedStepCount() == 0);
+    REQUIRE(maxLateness < 100000);
+    REQUIRE(sleepService.sleepCount >= stepCount);
+
+    // Exactly a million sixtieths of a second later, give or take the spin
+    unsigned long long elapsed = clock.now - loop.GetStepTime(0);
+    unsigned long long expected = stepCount * NANOSECONDS_PER_SECOND / 60;
+    REQUIRE(elapsed >= expected);
+    REQUIRE(elapsed - expected < 100000);
+}
+
+TEST_CASE("FixedStepLoop interpolates and catches up after a stall")
+{
+    FakeClock clock(0);
+    FakeSleepService sleepService(&clock, 0);
+    FixedStepLoop loop(&clock, &sleepService, 100, 4);
+
+    loop.Start();
+    clock.readCost = 1000;
+    REQUIRE(loop.BeginFrame() == 1);
+    REQUIRE(loop.GetInterpolation() < 0.001);
+
+    clock.now += 2498000;
+    REQUIRE(loop.BeginFrame() == 0);
+    REQUIRE(loop.GetInterpolation() == Approx(0.25));
+
+    clock.now += 24999000;
+    REQUIRE(loop.BeginFrame() == 2);
+    REQUIRE(loop.GetInterpolation() == Approx(0.75));
+
+    // A one second stall is not replayed in full
+    clock.now += NANOSECONDS_PER_SECOND - 1000;
+    REQUIRE(loop.BeginFrame() == 4);
+    REQUIRE(loop.GetSkippedStepCount() == 96);
+    REQUIRE(loop.GetStepCount() == 7);
+    REQUIRE(loop.GetInterpolation() == Approx(0.75));
+
+    // Skipped steps keep their slots, so the schedule is unchanged
+    loop.WaitForNextStep();
+    REQUIRE(clock.now >= loop.GetStepTime(103));
+    REQUIRE(clock.now < loop.GetStepTime(103) + 100000);
+    REQUIRE(loop.BeginFrame() == 1);
+}
@@ -0,0 +1,246 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#include <system/thread.hh>
+
+#include "catch.hh"
+
+#include "rendering/framepipeline.hh"
+
+// Writes every call it gets to a log, so recorded and direct drawing can
+// be compared
+class LoggingRenderer : public IRenderer
+{
+public:
+    LoggingRenderer()
+        : nextId(1)
+    {
+    }
+
+    void Render(const std::vector<IndexValue> &indices, const std::vector<float> &vertices,
+                const std::vector<float> &normals, const std::vector<float> &UVs, const IndexValue &materialId)
+    {
+        log << "Render " << indices.size() << " " << vertices[0] << " " << normals.size() << " "
+            << UVs.size() << " " << materialId << "\n";
+    }
+
+    void Render(const std::vector<IndexValue> &indices, const std::vector<float> &vertices,
+                const std::vector<float> &normals, const std::vector<float> &UVs,
+                const std::vector<unsigned char> &light, const IndexValue &materialId)
+    {
+        log << "RenderLit " << indices.size() << " " << vertices[0] << " " << (int)light[0] << " "
+            << materialId << "\n";
+    }
+
+    IndexValue RegisterMesh(const RenderObject &object)
+    {
+        return nextId++;
+    }
+
+    void RenderInstanced(IndexValue meshId, const std::vector<glm::mat4> &modelMatrices,
+                         const IndexValue &materialId)
+    {
+        log << "Instanced " << meshId << " " << modelMatrices.size() << " " << modelMatrices.back()[3][0] << " "
+            << materialId << "\n";
+    }
+
+    void Use()
+    {
+        log << "Use\n";
+    }
+
+    IndexValue RegisterMaterial(MaterialInfo material)
+    {
+        return nextId++;
+    }
+
+    void SetModelMatrix(const glm::mat4 &matrix)
+    {
+        log << "Model " << matrix[3][0] << "\n";
+    }
+
+    void SetViewMatrix(const glm::mat4 &matrix)
+    {
+        log << "View " << matrix[3][0] << "\n";
+    }
+
+    void SetProjectionMatrix(const glm::mat4 &matrix)
+    {
+        log << "Projection " << matrix[3][0] << "\n";
+    }
+
+    std::stringstream log;
+    IndexValue nextId;
+};
+
+static glm::mat4 Translation(float x)
+{
+    glm::mat4 matrix(1.0f);
+    matrix[3][0] = x;
+    return matrix;
+}
+
+static void DrawScene(IRenderer *renderer, IndexValue meshId, float offset)
+{
+    std::vector<IndexValue> indices(6, 0);
+    std::vector<float> vertices(12, offset);
+    std::vector<float> normals(12, 0.0f);
+    std::vector<float> UVs(8, 0.0f);
+    std::vector<unsigned char> light(16, 200);
+    std::vector<glm::mat4> instances(3, Translation(offset));
+
+    renderer->Use();
+    renderer->SetModelMatrix(Translation(offset + 1.0f));
+    renderer->Render(indices, vertices, normals, UVs, 7);
+    renderer->Render(indices, vertices, normals, UVs, light, 8);
+    renderer->RenderInstanced(meshId, instances, 9);
+}
+
+TEST_CASE("Recorded frame packets replay the calls made while recording")
+{
+    LoggingRenderer direct, target;
+    FramePacketRecorder recorder(&target);
+
+    // Registration goes straight through
+    IndexValue meshId = recorder.RegisterMesh(RenderObject());
+    REQUIRE(meshId == 1);
+    REQUIRE(target.log.str().empty());
+
+    recorder.SetViewMatrix(Translation(2.0f));
+    recorder.SetProjectionMatrix(Translation(3.0f));
+    direct.SetViewMatrix(Translation(2.0f));
+    direct.SetProjectionMatrix(Translation(3.0f));
+
+    FramePacket packets[2];
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        recorder.Begin(&packets[frame]);
+        DrawScene(&recorder, meshId, frame * 10.0f);
+        recorder.End();
+    }
+
+    // Matrices set before a packet open it, so each replays on its own
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        LoggingRenderer replayed;
+        packets[frame].Replay(&replayed);
+
+        std::stringstream expected;
+        if (frame == 0)
+            expected << "View 2\nProjection 3\n";
+        else
+            expected << "Model 1\nView 2\nProjection 3\n";
+        expected << "Use\nModel " << frame * 10 + 1 << "\nRender 6 " << frame * 10 << " 12 8 7\n"
+                 << "RenderLit 6 " << frame * 10 << " 200 8\nInstanced 1 3 " << frame * 10 << " 9\n";
+        REQUIRE(replayed.log.str() == expected.str());
+    }
+
+    // Reusing a packet starts it over
+    recorder.Begin(&packets[0]);
+    recorder.End();
+    LoggingRenderer replayed;
+    packets[0].Replay(&replayed);
+    REQUIRE(replayed.log.str() == "Model 11\nView 2\nProjection 3\n");
+}
+
+TEST_CASE("FramePipeline hands whole packets to the render thread")
+{
+    const unsigned long long packetCount = 20000;
+    FramePipeline pipeline;
+    FramePacketRecorder recorder(NULL);
+    std::atomic<bool> done(false);
+
+    System::thread logicThread([&]() {
+        for (unsigned long long i = 1; i <= packetCount; ++i)
+        {
+            FramePacket &packet = pipeline.GetRecordingPacket();
+            recorder.Begin(&packet);
+            packet.step = i;
+            DrawScene(&recorder, 1, (float)i);
+            recorder.End();
+            pipeline.Publish();
+        }
+        done = true;
+    });
+
+    unsigned long long last = 0, received = 0;
+    bool consistent = true;
+    while (last != packetCount)
+    {
+        const FramePacket *packet = pipeline.Acquire(10);
+        if (packet == NULL)
+            continue;
+
+        LoggingRenderer replayed;
+        packet->Replay(&replayed);
+
+        std::stringstream expected;
+        expected << "Use\nModel " << packet->step + 1 << "\nRender 6 " << packet->step << " 12 8 7\n";
+        consistent = consistent && packet->step > last &&
+            replayed.log.str().find(expected.str()) != std::string::npos;
+        last = packet->step;
+        ++received;
+    }
+
+    logicThread.join();
+    REQUIRE(consistent);
+    REQUIRE(received > 0);
+    REQUIRE(pipeline.Acquire(0) == NULL);
+}
+
+static void Work(double milliseconds)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+    Clock::time_point end = Clock::now() + std::chrono::microseconds((long long)(milliseconds * 1000));
+    while (Clock::now() < end)
+    {
+    }
+}
+
+// 4 ms of simulation and 3 ms of drawing per frame, one after the other
+// and then on two threads
+TEST_CASE("Frame pipeline benchmark", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+    const int frameCount = 200;
+    const double logicMilliseconds = 4.0, renderMilliseconds = 3.0;
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < frameCount; ++i)
+    {
+        Work(logicMilliseconds);
+        Work(renderMilliseconds);
+    }
+    double serial = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frameCount;
+
+    FramePipeline pipeline;
+    std::atomic<bool> done(false);
+    int rendered = 0;
+
+    start = Clock::now();
+    System::thread logicThread([&]() {
+        for (int i = 0; i < frameCount; ++i)
+        {
+            pipeline.GetRecordingPacket().step = i;
+            Work(logicMilliseconds);
+            pipeline.Publish();
+        }
+        done = true;
+    });
+
+    while (!done)
+    {
+        if (pipeline.Acquire(10) == NULL)
+            continue;
+
+        Work(renderMilliseconds);
+        ++rendered;
+    }
+    logicThread.join();
+    double pipelined = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frameCount;
+
+    std::cout << "Serial " << serial << " ms/frame, pipelined " << pipelined << " ms/frame ("
+              << rendered << " of " << frameCount << " packets drawn)" << std::endl;
+}
@@ -0,0 +1,198 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <utime.h>
+
+#include <lodepng.h>
+
+#include "catch.hh"
+
+#include "imagecache.hh"
+#include "objimporter/textbuffer.hh"
+
+static int loadCount = 0;
+
+static RawImageInfo *LoadFakeImage(const std::string &fileName)
+{
+    ++loadCount;
+
+    RawImageInfo *image = (RawImageInfo *) calloc(1, sizeof(RawImageInfo));
+    image->width = 1;
+    image->height = 1;
+
+    return image;
+}
+
+// Fails every other load, starting with the first
+static RawImageInfo *LoadFlakyImage(const std::string &fileName)
+{
+    RawImageInfo *image = LoadFakeImage(fileName);
+    if (loadCount % 2 == 1)
+    {
+        free(image);
+        return NULL;
+    }
+
+    return image;
+}
+
+// Mirrors LoadImageFromPNG, which lives outside the test build
+static RawImageInfo *DecodePNG(const std::string &fileName)
+{
+    RawImageInfo *image = (RawImageInfo *) calloc(1, sizeof(RawImageInfo));
+    if (lodepng_decode32_file(&image->data, &image->width, &image->height, fileName.c_str()) != 0)
+    {
+        free(image);
+        return NULL;
+    }
+
+    return image;
+}
+
+static void CopyFile(const std::string &source, const std::string &destination)
+{
+    std::vector<char> contents;
+    ReadFileContents(source, contents);
+
+    FILE *file = fopen(destination.c_str(), "wb");
+    fwrite(contents.data(), contents.size(), 1, file);
+    fclose(file);
+}
+
+TEST_CASE("ImageCache loads each canonical path once")
+{
+    ImageCache cache;
+    loadCount = 0;
+
+    RawImageInfo *first = cache.Load("assets/colors.png", LoadFakeImage);
+    RawImageInfo *second = cache.Load("assets/../assets/./colors.png", LoadFakeImage);
+    RawImageInfo *other = cache.Load("assets/minecraft-tiles.png", LoadFakeImage);
+
+    REQUIRE(first == second);
+    REQUIRE(first != other);
+    REQUIRE(loadCount == 2);
+    REQUIRE(cache.GetSize() == 2);
+}
+
+TEST_CASE("ImageCache decodes asynchronously and reloads changed files")
+{
+    const std::string fileName = "imagecache-test.png";
+    CopyFile("assets/colors.png", fileName);
+
+    ImageCache cache(2);
+    ImageHandle *handle = cache.LoadAsync(fileName, DecodePNG);
+    REQUIRE(cache.LoadAsync(fileName, DecodePNG) == handle);
+
+    RawImageInfo *image = handle->Wait();
+    REQUIRE(image != NULL);
+    REQUIRE(image->width > 0);
+    REQUIRE(handle->IsReady());
+    REQUIRE(handle->Get() == image);
+
+    struct stat fileStat;
+    REQUIRE(stat(fileName.c_str(), &fileStat) == 0);
+    struct utimbuf times;
+    times.actime = fileStat.st_atime;
+    times.modtime = fileStat.st_mtime + 10;
+    REQUIRE(utime(fileName.c_str(), &times) == 0);
+
+    ImageHandle *reloaded = cache.LoadAsync(fileName, DecodePNG);
+    REQUIRE(reloaded != handle);
+    REQUIRE(reloaded->Wait() != image);
+    REQUIRE(handle->Get() == image);
+    REQUIRE(cache.GetSize() == 1);
+    REQUIRE(cache.GetHandleCount() == 2);
+
+    // The superseded handle goes away with its last user
+    handle->Release();
+    REQUIRE(cache.GetHandleCount() == 2);
+    handle->Release();
+    REQUIRE(cache.GetHandleCount() == 1);
+
+    reloaded->Release();
+    REQUIRE(cache.GetHandleCount() == 1);
+    REQUIRE(cache.LoadAsync(fileName, DecodePNG) == reloaded);
+    reloaded->Release();
+
+    REQUIRE(cache.Load("imagecache-missing.png", DecodePNG) == NULL);
+
+    remove(fileName.c_str());
+}
+
+TEST_CASE("ImageCache retries failed decodes")
+{
+    ImageCache cache(1);
+    loadCount = 0;
+
+    ImageHandle *failed = cache.LoadAsync("assets/colors.png", LoadFlakyImage);
+    REQUIRE(failed->Wait() == NULL);
+    REQUIRE(cache.GetSize() == 0);
+
+    ImageHandle *retried = cache.LoadAsync("assets/colors.png", LoadFlakyImage);
+    REQUIRE(retried != failed);
+    REQUIRE(retried->Wait() != NULL);
+    REQUIRE(failed->Get() == NULL);
+    REQUIRE(cache.GetSize() == 1);
+    REQUIRE(loadCount == 2);
+
+    failed->Release();
+    retried->Release();
+    REQUIRE(cache.GetHandleCount() == 1);
+    REQUIRE(cache.Load("assets/colors.png", LoadFlakyImage) != NULL);
+    REQUIRE(loadCount == 2);
+}
+
+TEST_CASE("Parallel image decoding benchmark", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+    const int imageCount = 100;
+
+    std::vector<std::string> fileNames;
+    for (int i = 0; i < imageCount; ++i)
+    {
+        std::stringstream fileName;
+        fileName << "imagecache-benchmark-" << i << ".png";
+        fileNames.push_back(fileName.str());
+        CopyFile("assets/minecraft-tiles.png", fileNames.back());
+    }
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < imageCount; ++i)
+    {
+        RawImageInfo *image = DecodePNG(fileNames[i]);
+        free(image->data);
+        free(image);
+    }
+    double serialMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    start = Clock::now();
+    {
+        ImageCache cache;
+        std::vector<ImageHandle*> handles;
+        for (int i = 0; i < imageCount; ++i)
+        {
+            handles.push_back(cache.LoadAsync(fileNames[i], DecodePNG));
+        }
+
+        for (int i = 0; i < imageCount; ++i)
+        {
+            handles[i]->Wait();
+            handles[i]->Release();
+        }
+    }
+    double parallelMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::cout << imageCount << " images: serial " << serialMilliseconds << " ms, "
+              << GetProcessorCount() << " workers " << parallelMilliseconds << " ms" << std::endl;
+
+    for (int i = 0; i < imageCount; ++i)
+    {
+        remove(fileNames[i].c_str());
+    }
+}
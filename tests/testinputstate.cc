@@ -0,0 +1,248 @@
+#include <atomic>
+
+#include <system/thread.hh>
+
+#include "catch.hh"
+
+#include "inputstate.hh"
+#include "mousetracker.hh"
+
+class StubMouseReader : public Framework::ReadingMouseState
+{
+public:
+    StubMouseReader()
+        : x(0), y(0), scrollDelta(0), buttonQueries(0)
+    {
+    }
+
+    int GetMouseX() const
+    {
+        return x;
+    }
+
+    int GetMouseY() const
+    {
+        return y;
+    }
+
+    Framework::KeyState GetMouseButtonState(System::MouseButton button)
+    {
+        ++buttonQueries;
+        return buttons.test((size_t)button) ? Framework::KeyState::Pressed : Framework::KeyState::Unpressed;
+    }
+
+    int GetScrollDelta()
+    {
+        return scrollDelta;
+    }
+
+    int x, y, scrollDelta;
+    MouseButtonSnapshot buttons;
+    int buttonQueries;
+};
+
+class FakeTimer : public ISystemTimer
+{
+public:
+    FakeTimer()
+        : ticks(0)
+    {
+    }
+
+    unsigned int GetTicks()
+    {
+        return ticks;
+    }
+
+    unsigned int ticks;
+};
+
+TEST_CASE("InputState only changes on Update")
+{
+    StubMouseReader mouse;
+    FakeTimer timer;
+    InputState input(&mouse, &timer);
+
+    input.PressKey(System::KeyCode::KeyQ);
+    input.PressKey(System::KeyCode::KeyUpArrow);
+    mouse.buttons.set((size_t)System::MouseButton::Button2);
+    mouse.x = 10;
+    mouse.scrollDelta = -3;
+
+    REQUIRE(input.GetKeyState(System::KeyCode::KeyQ) == Framework::KeyState::Unpressed);
+    REQUIRE(input.GetMouseX() == 0);
+
+    input.Update();
+    REQUIRE(input.GetKeyState(System::KeyCode::KeyQ) == Framework::KeyState::Pressed);
+    REQUIRE(input.GetKeyState(System::KeyCode::KeyUpArrow) == Framework::KeyState::Pressed);
+    REQUIRE(input.GetKeyState(System::KeyCode::KeyDownArrow) == Framework::KeyState::Unpressed);
+    REQUIRE(input.GetMouseButtonState(System::MouseButton::Button2) == Framework::KeyState::Pressed);
+    REQUIRE(input.GetMouseX() == 10);
+    REQUIRE(input.GetScrollDelta() == -3);
+
+    // The mouse is sampled once per frame however often it is queried
+    int queries = mouse.buttonQueries;
+    for (int i = 0; i < 100; ++i)
+    {
+        input.GetMouseButtonState(System::MouseButton::Button2);
+    }
+    REQUIRE(mouse.buttonQueries == queries);
+
+    input.UnpressKey(System::KeyCode::KeyQ);
+    input.Update();
+    REQUIRE(input.GetKeyState(System::KeyCode::KeyQ) == Framework::KeyState::Unpressed);
+    REQUIRE(input.GetPrevious().GetKeyState(System::KeyCode::KeyQ) == Framework::KeyState::Pressed);
+    REQUIRE(input.GetKeyState(System::KeyCode::KeyUpArrow) == Framework::KeyState::Pressed);
+}
+
+TEST_CASE("MouseTracker reports button edges for every button")
+{
+    StubMouseReader mouse;
+    MouseTracker tracker(&mouse);
+
+    mouse.buttons.set((size_t)System::MouseButton::Button1);
+    tracker.update();
+    REQUIRE(tracker.IsButtonDownFrame(System::MouseButton::Button1));
+    REQUIRE_FALSE(tracker.IsButtonDownFrame(System::MouseButton::Button2));
+
+    tracker.update();
+    REQUIRE_FALSE(tracker.IsButtonDownFrame(System::MouseButton::Button1));
+
+    mouse.buttons.reset();
+    tracker.update();
+    REQUIRE(tracker.IsButtonUpFrame(System::MouseButton::Button1));
+}
+
+TEST_CASE("InputState keeps every event between updates")
+{
+    StubMouseReader mouse;
+    FakeTimer timer;
+    InputState input(&mouse, &timer);
+
+    // A tap shorter than a frame never shows in the sampled state
+    timer.ticks = 3;
+    input.PressKey(System::KeyCode::KeySpace);
+    input.PressKey(System::KeyCode::KeySpace);
+    timer.ticks = 7;
+    input.UnpressKey(System::KeyCode::KeySpace);
+
+    timer.ticks = 16;
+    mouse.x = 5;
+    mouse.scrollDelta = 2;
+    mouse.buttons.set((size_t)System::MouseButton::Button1);
+    input.Update();
+    REQUIRE(input.GetKeyState(System::KeyCode::KeySpace) == Framework::KeyState::Unpressed);
+
+    const std::vector<InputEvent> &events = input.GetEvents();
+    REQUIRE(events.size() == 5);
+    REQUIRE(events[0].type == InputEvent::Type::KeyDown);
+    REQUIRE(events[0].key == System::KeyCode::KeySpace);
+    REQUIRE(events[0].timestamp == 3);
+    REQUIRE(events[1].type == InputEvent::Type::KeyUp);
+    REQUIRE(events[1].timestamp == 7);
+    REQUIRE(events[2].type == InputEvent::Type::MouseButtonDown);
+    REQUIRE(events[2].button == System::MouseButton::Button1);
+    REQUIRE(events[3].type == InputEvent::Type::MouseMove);
+    REQUIRE(events[3].mouseX == 5);
+    REQUIRE(events[4].type == InputEvent::Type::MouseScroll);
+    REQUIRE(events[4].scrollDelta == 2);
+    REQUIRE(events[4].timestamp == 16);
+
+    mouse.scrollDelta = 0;
+    input.Update();
+    REQUIRE(input.GetEvents().empty());
+
+    // A stalled logic thread loses the newest events, never the state
+    for (int i = 0; i < INPUT_EVENT_QUEUE_SIZE; ++i)
+    {
+        input.PressKey(System::KeyCode::KeyA);
+        input.UnpressKey(System::KeyCode::KeyA);
+    }
+    input.PressKey(System::KeyCode::KeyB);
+    input.Update();
+    REQUIRE(input.GetEvents().size() == INPUT_EVENT_QUEUE_SIZE);
+    REQUIRE(input.GetDroppedEventCount() == INPUT_EVENT_QUEUE_SIZE + 1);
+    REQUIRE(input.GetKeyState(System::KeyCode::KeyB) == Framework::KeyState::Pressed);
+}
+
+TEST_CASE("SpscQueue passes items between threads in order")
+{
+    const unsigned int count = 200000;
+    SpscQueue<unsigned int, 64> queue;
+
+    System::thread producer([&]() {
+        for (unsigned int i = 1; i <= count; ++i)
+        {
+            while (!queue.TryPush(i))
+            {
+            }
+        }
+    });
+
+    unsigned int expected = 1;
+    bool ordered = true;
+    while (expected <= count)
+    {
+        unsigned int item;
+        if (queue.TryPop(item))
+        {
+            ordered = ordered && item == expected;
+            ++expected;
+        }
+    }
+
+    producer.join();
+    unsigned int item;
+    REQUIRE(ordered);
+    REQUIRE_FALSE(queue.TryPop(item));
+}
+
+typedef struct Stamped
+{
+    unsigned int values[16];
+} Stamped;
+
+TEST_CASE("TripleBuffer hands over whole values between threads")
+{
+    const unsigned int count = 200000;
+    TripleBuffer<Stamped> buffer;
+    std::atomic<bool> done(false);
+
+    System::thread producer([&]() {
+        for (unsigned int i = 1; i <= count; ++i)
+        {
+            Stamped &stamped = buffer.GetWriteBuffer();
+            for (int j = 0; j < 16; ++j)
+            {
+                stamped.values[j] = i;
+            }
+            buffer.Publish();
+        }
+        done = true;
+    });
+
+    unsigned int last = 0;
+    bool torn = false, backwards = false;
+    while (last != count)
+    {
+        bool finished = done;
+        if (!buffer.Acquire())
+        {
+            REQUIRE_FALSE(finished);
+            continue;
+        }
+
+        const Stamped &stamped = buffer.GetReadBuffer();
+        for (int j = 1; j < 16; ++j)
+        {
+            torn = torn || stamped.values[j] != stamped.values[0];
+        }
+        backwards = backwards || stamped.values[0] <= last;
+        last = stamped.values[0];
+    }
+
+    producer.join();
+    REQUIRE_FALSE(torn);
+    REQUIRE_FALSE(backwards);
+    REQUIRE_FALSE(buffer.Acquire());
+}
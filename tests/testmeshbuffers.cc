@@ -0,0 +1,174 @@
+#include <cstring>
+#include <vector>
+
+#include "catch.hh"
+#include "fakegl.hh"
+
+#include "rendering/meshbuffers.hh"
+#include "rendering/uploadmanager.hh"
+
+// Records the draw calls of a mesh on top of the fake buffer driver
+static struct FakeDrawGL
+{
+    GLuint boundVertexArray;
+    int lightDefaultCalls;
+    GLuint lightDefaultVertexArray;
+    int drawCalls;
+    GLsizei drawnInstances;
+    std::vector<unsigned char> drawnInstanceData;
+} fake;
+
+static void CODEGEN_FUNCPTR FakeGenVertexArrays(GLsizei count, GLuint *names)
+{
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        names[i] = ++fakeGL.nextName;
+    }
+}
+
+static void CODEGEN_FUNCPTR FakeBindVertexArray(GLuint name)
+{
+    fake.boundVertexArray = name;
+}
+
+static void CODEGEN_FUNCPTR FakeDeleteVertexArrays(GLsizei count, const GLuint *names)
+{
+}
+
+static void CODEGEN_FUNCPTR FakeEnableVertexAttribArray(GLuint index)
+{
+}
+
+static void CODEGEN_FUNCPTR FakeVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                                    GLsizei stride, const GLvoid *pointer)
+{
+}
+
+static void CODEGEN_FUNCPTR FakeVertexAttribDivisor(GLuint index, GLuint divisor)
+{
+}
+
+static void CODEGEN_FUNCPTR FakeVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+    REQUIRE(index == 3);
+    REQUIRE((x == 1.0f && y == 1.0f && z == 1.0f && w == 1.0f));
+    ++fake.lightDefaultCalls;
+    fake.lightDefaultVertexArray = fake.boundVertexArray;
+}
+
+static void CODEGEN_FUNCPTR FakeDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
+                                                      const GLvoid *indices, GLsizei instanceCount)
+{
+    ++fake.drawCalls;
+    fake.drawnInstances = instanceCount;
+    fake.drawnInstanceData = fakeGL.buffers[fakeGL.bufferBindings[GL_ARRAY_BUFFER]];
+}
+
+// Adds the vertex array and instanced draw functions to the fake buffer driver
+class FakeDrawGLScope
+{
+public:
+    FakeDrawGLScope()
+        : _genVertexArrays(glGenVertexArrays, FakeGenVertexArrays),
+          _bindVertexArray(glBindVertexArray, FakeBindVertexArray),
+          _deleteVertexArrays(glDeleteVertexArrays, FakeDeleteVertexArrays),
+          _enableVertexAttribArray(glEnableVertexAttribArray, FakeEnableVertexAttribArray),
+          _vertexAttribPointer(glVertexAttribPointer, FakeVertexAttribPointer),
+          _vertexAttribDivisor(glVertexAttribDivisor, FakeVertexAttribDivisor),
+          _vertexAttrib4f(glVertexAttrib4f, FakeVertexAttrib4f),
+          _drawElementsInstanced(glDrawElementsInstanced, FakeDrawElementsInstanced)
+    {
+        fake = FakeDrawGL();
+    }
+
+private:
+    FakeGLScope _buffers;
+    FakeGLFunction<decltype(glGenVertexArrays)> _genVertexArrays;
+    FakeGLFunction<decltype(glBindVertexArray)> _bindVertexArray;
+    FakeGLFunction<decltype(glDeleteVertexArrays)> _deleteVertexArrays;
+    FakeGLFunction<decltype(glEnableVertexAttribArray)> _enableVertexAttribArray;
+    FakeGLFunction<decltype(glVertexAttribPointer)> _vertexAttribPointer;
+    FakeGLFunction<decltype(glVertexAttribDivisor)> _vertexAttribDivisor;
+    FakeGLFunction<decltype(glVertexAttrib4f)> _vertexAttrib4f;
+    FakeGLFunction<decltype(glDrawElementsInstanced)> _drawElementsInstanced;
+};
+
+static RenderObject MakeTriangle(bool withLight)
+{
+    RenderObject object;
+    object._indices = { 0, 1, 2 };
+    object._vertices = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f };
+    object._normals = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f };
+    object._uvCoords = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f };
+    if (withLight)
+        object._light.assign(12, 255);
+
+    return object;
+}
+
+TEST_CASE("MeshBuffers draws every instance with a single call", "[meshbuffers]")
+{
+    FakeDrawGLScope scope;
+    UploadManager uploadManager(1024);
+    GLuint instanceBuffer;
+    glGenBuffers(1, &instanceBuffer);
+
+    MeshBuffers mesh(MakeTriangle(false), instanceBuffer, &uploadManager);
+    std::vector<glm::mat4> modelMatrices(1, glm::mat4(1.0f));
+
+    // Nothing is drawn until the vertex data has arrived
+    mesh.DrawInstanced(modelMatrices);
+    REQUIRE_FALSE(mesh.IsUploaded());
+    REQUIRE(fake.drawCalls == 0);
+
+    uploadManager.Flush();
+    REQUIRE(mesh.IsUploaded());
+
+    int drawCalls = 0;
+    for (int instanceCount = 1; instanceCount <= 1000; instanceCount *= 10)
+    {
+        modelMatrices.resize(instanceCount);
+        for (int i = 0; i < instanceCount; ++i)
+        {
+            modelMatrices[i] = glm::mat4(1.0f);
+            modelMatrices[i][3] = glm::vec4((float)i, (float)instanceCount, 0.0f, 1.0f);
+        }
+
+        mesh.DrawInstanced(modelMatrices);
+
+        REQUIRE(fake.drawCalls == ++drawCalls);
+        REQUIRE(fake.drawnInstances == instanceCount);
+        REQUIRE(fake.drawnInstanceData.size() == instanceCount * sizeof(glm::mat4));
+        REQUIRE(memcmp(fake.drawnInstanceData.data(), modelMatrices.data(), fake.drawnInstanceData.size()) == 0);
+    }
+
+    modelMatrices.clear();
+    mesh.DrawInstanced(modelMatrices);
+    REQUIRE(fake.drawCalls == drawCalls);
+}
+
+TEST_CASE("MeshBuffers sets the default lighting at draw time", "[meshbuffers]")
+{
+    FakeDrawGLScope scope;
+    UploadManager uploadManager(1024);
+    GLuint instanceBuffer;
+    glGenBuffers(1, &instanceBuffer);
+    std::vector<glm::mat4> modelMatrices(2, glm::mat4(1.0f));
+
+    MeshBuffers unlit(MakeTriangle(false), instanceBuffer, &uploadManager);
+    MeshBuffers lit(MakeTriangle(true), instanceBuffer, &uploadManager);
+    uploadManager.Flush();
+
+    // The constant attribute value is context state, so setting it while
+    // building the vertex array would not survive other draws
+    REQUIRE(fake.lightDefaultCalls == 0);
+
+    lit.DrawInstanced(modelMatrices);
+    REQUIRE(fake.lightDefaultCalls == 0);
+
+    unlit.DrawInstanced(modelMatrices);
+    unlit.DrawInstanced(modelMatrices);
+    REQUIRE(fake.lightDefaultCalls == 2);
+    REQUIRE(fake.lightDefaultVertexArray == fake.boundVertexArray);
+    REQUIRE(fake.drawCalls == 3);
+}
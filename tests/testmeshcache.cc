@@ -0,0 +1,148 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "catch.hh"
+
+#include "objimporter/meshcache.hh"
+
+static void WriteTextFile(const std::string &fileName, const std::string &contents)
+{
+    FILE *file = fopen(fileName.c_str(), "wb");
+    fwrite(contents.data(), contents.size(), 1, file);
+    fclose(file);
+}
+
+static void MakeDirectory(const std::string &name)
+{
+#ifdef _WIN32
+    _mkdir(name.c_str());
+#else
+    mkdir(name.c_str(), 0755);
+#endif
+}
+
+static void RemoveDirectory(const std::string &name)
+{
+#ifdef _WIN32
+    _rmdir(name.c_str());
+#else
+    rmdir(name.c_str());
+#endif
+}
+
+TEST_CASE("Cooked meshes round trip and go stale with their source")
+{
+    const std::string sourceFileName = "meshcache-test.obj";
+    const std::string cookedFileName = GetCookedMeshPath("", sourceFileName);
+
+    WriteTextFile(sourceFileName,
+                  "v 0.0 0.0 0.0\nv 1.0 0.0 0.0\nv 1.0 1.0 0.0\nv 0.0 1.0 0.0\n"
+                  "vn 0.0 0.0 1.0\nf 1//1 2//1 3//1 4//1\n");
+
+    CookedMesh cooked = CookObjFile("", sourceFileName);
+    REQUIRE(SaveCookedMesh(cookedFileName, cooked));
+
+    CookedMesh loaded;
+    REQUIRE(LoadCookedMesh(cookedFileName, loaded));
+    REQUIRE(loaded.renderObjects.size() == cooked.renderObjects.size());
+    REQUIRE(loaded.renderObjects[0]._indices == cooked.renderObjects[0]._indices);
+    REQUIRE(loaded.renderObjects[0]._vertices == cooked.renderObjects[0]._vertices);
+    REQUIRE(loaded.renderObjects[0]._normals == cooked.renderObjects[0]._normals);
+    REQUIRE(loaded.renderObjects[0]._indexCount == 6);
+
+    WriteTextFile(sourceFileName,
+                  "v 0.0 0.0 0.0\nv 2.0 0.0 0.0\nv 0.0 2.0 0.0\n"
+                  "vn 0.0 0.0 1.0\nf 1//1 2//1 3//1\n");
+    REQUIRE_FALSE(LoadCookedMesh(cookedFileName, loaded));
+
+    WriteTextFile(cookedFileName, "not a cooked mesh");
+    REQUIRE_FALSE(LoadCookedMesh(cookedFileName, loaded));
+
+    remove(sourceFileName.c_str());
+    remove(cookedFileName.c_str());
+}
+
+TEST_CASE("Meshes load when the cooked file cannot be written")
+{
+    const std::string sourceFileName = "meshcache-unwritable.obj";
+    const std::string cookedFileName = GetCookedMeshPath("", sourceFileName);
+
+    WriteTextFile(sourceFileName,
+                  "v 0.0 0.0 0.0\nv 1.0 0.0 0.0\nv 1.0 1.0 0.0\n"
+                  "vn 0.0 0.0 1.0\nf 1//1 2//1 3//1\n");
+
+    // A directory in the way of the cooked file makes opening it for writing fail
+    MakeDirectory(cookedFileName);
+
+    CookedMesh cooked = CookObjFile("", sourceFileName);
+    REQUIRE_FALSE(SaveCookedMesh(cookedFileName, cooked));
+
+    CookedMesh loaded;
+    REQUIRE_NOTHROW(loaded = LoadObjFileCached("", sourceFileName));
+    REQUIRE(loaded.renderObjects.size() == 1);
+    REQUIRE(loaded.renderObjects[0]._indices == cooked.renderObjects[0]._indices);
+
+    RemoveDirectory(cookedFileName);
+    remove(sourceFileName.c_str());
+}
+
+TEST_CASE("Cooked mesh load benchmark", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    DIR *directory = opendir("assets");
+    REQUIRE(directory != NULL);
+
+    while (dirent *entry = readdir(directory))
+    {
+        std::string fileName = entry->d_name;
+        if (fileName.size() < 4 || fileName.substr(fileName.size() - 4) != ".obj")
+            continue;
+
+        const std::string cookedFileName = fileName + ".benchmark-cooked";
+        const int loadCount = 20;
+
+        try
+        {
+            Clock::time_point start = Clock::now();
+            CookedMesh cooked;
+            for (int i = 0; i < loadCount; ++i)
+            {
+                cooked = CookObjFile("assets/", fileName);
+            }
+            double coldMicroseconds = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / loadCount;
+
+            SaveCookedMesh(cookedFileName, cooked);
+
+            start = Clock::now();
+            CookedMesh loaded;
+            for (int i = 0; i < loadCount; ++i)
+            {
+                LoadCookedMesh(cookedFileName, loaded);
+            }
+            double warmMicroseconds = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / loadCount;
+
+            std::cout << fileName << ": parse " << coldMicroseconds << " us, cooked " << warmMicroseconds << " us" << std::endl;
+        }
+        catch (std::runtime_error &error)
+        {
+            std::cout << fileName << ": " << error.what() << std::endl;
+        }
+
+        remove(cookedFileName.c_str());
+    }
+
+    closedir(directory);
+}
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+#include "catch.hh"
+
+#include "meshcompression.hh"
+#include "meshoptimizer.hh"
+#include "objimporter/meshcache.hh"
+
+// Welded UV sphere; an odd vertex count leaves a scalar tail after the SIMD loops
+static RenderObject MakeSphere(int rings, int segments, float radius)
+{
+    RenderObject object;
+    for (int ring = 0; ring <= rings; ++ring)
+    {
+        for (int segment = 0; segment <= segments; ++segment)
+        {
+            float theta = 3.14159265f * ring / rings;
+            float phi = 2.0f * 3.14159265f * segment / segments;
+            float normal[3] = { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+
+            for (int i = 0; i < 3; ++i)
+            {
+                object._vertices.push_back(normal[i] * radius + 10.0f);
+                object._normals.push_back(normal[i]);
+            }
+            object._vertices.push_back(1.0f);
+            object._uvCoords.push_back((float)segment / segments);
+            object._uvCoords.push_back((float)ring / rings);
+            object._light.push_back(ring);
+            object._light.push_back(segment);
+            object._light.push_back(255);
+            object._light.push_back(0);
+        }
+    }
+
+    for (int ring = 0; ring < rings; ++ring)
+    {
+        for (int segment = 0; segment < segments; ++segment)
+        {
+            IndexValue first = ring * (segments + 1) + segment;
+            IndexValue second = first + segments + 1;
+            IndexValue quad[6] = { first, second, first + 1, second, second + 1, first + 1 };
+            object._indices.insert(object._indices.end(), quad, quad + 6);
+        }
+    }
+
+    return object;
+}
+
+// The index codec may rotate a triangle's corners but keeps its winding
+static std::vector<IndexValue> GetRotatedTriangles(const std::vector<IndexValue> &indices)
+{
+    std::vector<IndexValue> rotated(indices);
+    for (size_t i = 0; i + 2 < rotated.size(); i += 3)
+    {
+        while (rotated[i] > rotated[i + 1] || rotated[i] > rotated[i + 2])
+        {
+            std::rotate(rotated.begin() + i, rotated.begin() + i + 1, rotated.begin() + i + 3);
+        }
+    }
+
+    return rotated;
+}
+
+TEST_CASE("Compressed meshes decode within quantization error")
+{
+    const float radius = 4.0f;
+    RenderObject object = MakeSphere(17, 30, radius);
+    object._materialName = "sphere";
+    OptimizeMesh(object);
+
+    CompressedRenderObject compressed = CompressRenderObject(object);
+    REQUIRE(IsValidCompressedRenderObject(compressed));
+
+    RenderObject decompressed = DecompressRenderObject(compressed);
+    REQUIRE(decompressed._materialName == "sphere");
+    REQUIRE(GetRotatedTriangles(decompressed._indices) == GetRotatedTriangles(object._indices));
+    REQUIRE(decompressed._light == object._light);
+    REQUIRE(decompressed._vertices.size() == object._vertices.size());
+    REQUIRE(decompressed._normals.size() == object._normals.size());
+    REQUIRE(decompressed._uvCoords.size() == object._uvCoords.size());
+
+    const float positionError = 2.0f * radius / 65535.0f;
+    size_t vertexCount = object._vertices.size() / 4;
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        float dot = 0.0f;
+        for (int i = 0; i < 3; ++i)
+        {
+            REQUIRE(std::fabs(decompressed._vertices[vertex * 4 + i] - object._vertices[vertex * 4 + i]) <= positionError);
+            dot += decompressed._normals[vertex * 3 + i] * object._normals[vertex * 3 + i];
+        }
+        REQUIRE(decompressed._vertices[vertex * 4 + 3] == 1.0f);
+        REQUIRE(dot > 0.999f);
+
+        for (int i = 0; i < 2; ++i)
+        {
+            REQUIRE(std::fabs(decompressed._uvCoords[vertex * 2 + i] - object._uvCoords[vertex * 2 + i]) <= 1.0f / 2048.0f);
+        }
+    }
+
+    REQUIRE(GetMemoryFootprint(object) >= 3 * GetMemoryFootprint(compressed));
+
+    compressed._indices.push_back(0x80);
+    REQUIRE_FALSE(IsValidCompressedRenderObject(compressed));
+    REQUIRE_THROWS_AS(DecompressRenderObject(compressed), std::runtime_error);
+}
+
+TEST_CASE("Half floats round to nearest and keep special values")
+{
+    REQUIRE(FloatToHalf(1.0f) == 0x3c00);
+    REQUIRE(FloatToHalf(-2.0f) == 0xc000);
+    REQUIRE(FloatToHalf(65504.0f) == 0x7bff);
+    REQUIRE(FloatToHalf(1.0e6f) == 0x7c00);
+    REQUIRE(FloatToHalf(5.96046448e-8f) == 0x0001);
+    REQUIRE(HalfToFloat(0x3555) == Approx(0.333251953f));
+    REQUIRE(std::isnan(HalfToFloat(FloatToHalf(NAN))));
+
+    for (unsigned int half = 0; half < 0x7c00; ++half)
+    {
+        REQUIRE(FloatToHalf(HalfToFloat(half)) == half);
+        REQUIRE(FloatToHalf(HalfToFloat(half | 0x8000)) == (half | 0x8000));
+    }
+}
+
+TEST_CASE("Mesh compression benchmark", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    DIR *directory = opendir("assets");
+    REQUIRE(directory != NULL);
+
+    while (dirent *entry = readdir(directory))
+    {
+        std::string fileName = entry->d_name;
+        if (fileName.size() < 4 || fileName.substr(fileName.size() - 4) != ".obj")
+            continue;
+
+        try
+        {
+            CookedMesh cooked = CookObjFile("assets/", fileName);
+            if (cooked.renderObjects.empty())
+                continue;
+
+            size_t compressedBytes = 0;
+            size_t decompressedBytes = 0;
+            int decodeCount = 0;
+
+            Clock::time_point start = Clock::now();
+            double seconds = 0.0;
+            while (seconds < 0.2)
+            {
+                compressedBytes = 0;
+                decompressedBytes = 0;
+                for (int i = 0; i < cooked.renderObjects.size(); ++i)
+                {
+                    RenderObject object = DecompressRenderObject(cooked.renderObjects[i]);
+                    compressedBytes += GetMemoryFootprint(cooked.renderObjects[i]);
+                    decompressedBytes += GetMemoryFootprint(object);
+                }
+                ++decodeCount;
+                seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            }
+
+            double megabytes = decompressedBytes * (double)decodeCount / (1024.0 * 1024.0);
+            std::cout << fileName << ": " << decompressedBytes << " -> " << compressedBytes << " bytes ("
+                      << (double)decompressedBytes / compressedBytes << "x), decode " << megabytes / seconds << " MB/s" << std::endl;
+        }
+        catch (std::runtime_error &error)
+        {
+            std::cout << fileName << ": " << error.what() << std::endl;
+        }
+    }
+
+    closedir(directory);
+}
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+#include "catch.hh"
+
+#include "meshoptimizer.hh"
+#include "objimporter/objimporter.hh"
+#include "objimporter/objparser.hh"
+
+typedef std::vector<float> TrianglePositions;
+
+// Unwelded grid of gridSize x gridSize quads, six corners per quad, with the
+// triangles shuffled so the input has no cache locality
+static RenderObject MakeShuffledGrid(int gridSize)
+{
+    RenderObject object;
+    std::vector<int> quads;
+    for (int i = 0; i < gridSize * gridSize; ++i)
+    {
+        quads.push_back(i);
+    }
+
+    unsigned int seed = 12345;
+    for (int i = quads.size() - 1; i > 0; --i)
+    {
+        seed = seed * 1103515245 + 12345;
+        std::swap(quads[i], quads[(seed >> 8) % (i + 1)]);
+    }
+
+    const int corners[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 } };
+    for (int i = 0; i < quads.size(); ++i)
+    {
+        int x = quads[i] % gridSize;
+        int y = quads[i] / gridSize;
+
+        for (int corner = 0; corner < 6; ++corner)
+        {
+            object._indices.push_back(object._indices.size());
+            object._vertices.push_back((float)(x + corners[corner][0]));
+            object._vertices.push_back((float)(y + corners[corner][1]));
+            object._vertices.push_back(0.0f);
+            object._vertices.push_back(1.0f);
+            object._normals.push_back(0.0f);
+            object._normals.push_back(0.0f);
+            object._normals.push_back(1.0f);
+            object._uvCoords.push_back((float)(x + corners[corner][0]) / gridSize);
+            object._uvCoords.push_back((float)(y + corners[corner][1]) / gridSize);
+        }
+    }
+
+    return object;
+}
+
+// Triangles as position lists rotated to start at their smallest corner, so
+// reordered and renumbered meshes compare equal while winding still matters
+static std::vector<TrianglePositions> GetSortedTriangles(const RenderObject &object)
+{
+    std::vector<TrianglePositions> triangles;
+    for (int i = 0; i + 2 < object._indices.size(); i += 3)
+    {
+        std::vector<TrianglePositions> corners(3);
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            const float *position = &object._vertices[object._indices[i + corner] * 4];
+            corners[corner].assign(position, position + 3);
+        }
+
+        int first = std::min_element(corners.begin(), corners.end()) - corners.begin();
+        TrianglePositions triangle;
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            const TrianglePositions &position = corners[(first + corner) % 3];
+            triangle.insert(triangle.end(), position.begin(), position.end());
+        }
+        triangles.push_back(triangle);
+    }
+
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+TEST_CASE("Mesh optimizer welds, reorders and keeps every triangle")
+{
+    const int gridSize = 32;
+    RenderObject original = MakeShuffledGrid(gridSize);
+    RenderObject object = original;
+
+    WeldVertices(object);
+    REQUIRE(object._vertices.size() / 4 == (gridSize + 1) * (gridSize + 1));
+    REQUIRE(object._normals.size() / 3 == (gridSize + 1) * (gridSize + 1));
+    REQUIRE(object._uvCoords.size() / 2 == (gridSize + 1) * (gridSize + 1));
+    REQUIRE(GetSortedTriangles(object) == GetSortedTriangles(original));
+
+    size_t vertexCount = object._vertices.size() / 4;
+    VertexCacheStatistics before = AnalyzeVertexCache(object._indices, vertexCount);
+    OptimizeVertexCache(object._indices, vertexCount);
+    VertexCacheStatistics after = AnalyzeVertexCache(object._indices, vertexCount);
+
+    REQUIRE(after.acmr < before.acmr);
+    REQUIRE(after.acmr < 0.8f);
+    REQUIRE(GetSortedTriangles(object) == GetSortedTriangles(original));
+
+    OptimizeOverdraw(object, 1.05f);
+    REQUIRE(AnalyzeVertexCache(object._indices, vertexCount).acmr <= after.acmr * 1.05f + 0.01f);
+    REQUIRE(GetSortedTriangles(object) == GetSortedTriangles(original));
+
+    OptimizeVertexFetch(object);
+    IndexValue nextVertex = 0;
+    for (int i = 0; i < object._indices.size(); ++i)
+    {
+        REQUIRE(object._indices[i] <= nextVertex);
+        if (object._indices[i] == nextVertex)
+            ++nextVertex;
+    }
+    REQUIRE(nextVertex == vertexCount);
+    REQUIRE(GetSortedTriangles(object) == GetSortedTriangles(original));
+}
+
+TEST_CASE("Mesh optimizer asset report", "[.][benchmark]")
+{
+    DIR *directory = opendir("assets");
+    REQUIRE(directory != NULL);
+
+    while (dirent *entry = readdir(directory))
+    {
+        std::string fileName = entry->d_name;
+        if (fileName.size() < 4 || fileName.substr(fileName.size() - 4) != ".obj")
+            continue;
+
+        try
+        {
+            ObjParser::ObjFileParser parser("assets/", fileName.c_str());
+            ObjParser::IParseResult *result = parser.Parse();
+            ObjImporter importer(result);
+            std::vector<RenderObject> renderObjects = importer.TakeRenderObjects();
+            delete result;
+
+            for (int i = 0; i < renderObjects.size(); ++i)
+            {
+                RenderObject &object = renderObjects[i];
+                VertexCacheStatistics imported = AnalyzeVertexCache(object._indices, object._vertices.size() / 4);
+
+                WeldVertices(object);
+                VertexCacheStatistics welded = AnalyzeVertexCache(object._indices, object._vertices.size() / 4);
+
+                OptimizeMesh(object, true);
+                VertexCacheStatistics optimized = AnalyzeVertexCache(object._indices, object._vertices.size() / 4);
+
+                std::cout << fileName << " [" << object._materialName << "] " << object._indices.size() / 3 << " triangles: "
+                          << "imported ACMR " << imported.acmr << " ATVR " << imported.atvr
+                          << ", welded ACMR " << welded.acmr << " ATVR " << welded.atvr
+                          << ", optimized ACMR " << optimized.acmr << " ATVR " << optimized.atvr << std::endl;
+            }
+        }
+        catch (std::runtime_error &error)
+        {
+            std::cout << fileName << ": " << error.what() << std::endl;
+        }
+    }
+
+    closedir(directory);
+}
@@ -0,0 +1,649 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "allocationcounter.hh"
+#include "catch.hh"
+
+#include "imagecache.hh"
+#include "objimporter/objimporter.hh"
+#include "objimporter/mtlfileparser.hh"
+#include "objimporter/objparser.hh"
+#include "objimporter/streamingobjimporter.hh"
+#include "objimporter/textbuffer.hh"
+
+static void WriteTextFile(const std::string &fileName, const std::string &contents)
+{
+    FILE *file = fopen(fileName.c_str(), "wb");
+    fwrite(contents.data(), contents.size(), 1, file);
+    fclose(file);
+}
+
+static void WriteSyntheticObjFile(const std::string &fileName, int gridSize)
+{
+    FILE *file = fopen(fileName.c_str(), "wb");
+
+    fprintf(file, "# synthetic grid\n");
+    for (int z = 0; z <= gridSize; ++z)
+    {
+        for (int x = 0; x <= gridSize; ++x)
+        {
+            fprintf(file, "v %f %f %f\n", x * 0.125f - 3.5f, (x * z % 17) * 0.0625f, z * -0.125f);
+            fprintf(file, "vt %f %f\n", (float)x / gridSize, (float)z / gridSize);
+        }
+    }
+    fprintf(file, "vn 0.000000 1.000000 0.000000\n");
+
+    for (int z = 0; z < gridSize; ++z)
+    {
+        for (int x = 0; x < gridSize; ++x)
+        {
+            int first = z * (gridSize + 1) + x + 1;
+            int second = first + gridSize + 1;
+            fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1 %d/%d/1\n",
+                    first, first, second, second, second + 1, second + 1, first + 1, first + 1);
+        }
+    }
+
+    fclose(file);
+}
+
+static void WriteMaterialObjFile(const std::string &fileName, const std::string &materialFileName, int gridSize)
+{
+    WriteTextFile(materialFileName, "newmtl Red\nKd 1.0 0.0 0.0\n\nnewmtl Blue\nKd 0.0 0.0 1.0\n");
+
+    FILE *file = fopen(fileName.c_str(), "wb");
+
+    fprintf(file, "mtllib %s\nvn 0.0 1.0 0.0\n", materialFileName.c_str());
+    for (int z = 0; z <= gridSize; ++z)
+    {
+        for (int x = 0; x <= gridSize; ++x)
+        {
+            fprintf(file, "v %f %f %f\nvt %f %f\n", x * 0.5f, (float)(x * z % 5), z * 0.5f, (float)x / gridSize, (float)z / gridSize);
+        }
+
+        if (z == 0)
+            continue;
+
+        if (z % 7 == 1)
+            fprintf(file, "usemtl %s\n", z % 14 == 1 ? "Red" : "Blue");
+
+        for (int x = 0; x < gridSize; ++x)
+        {
+            if (x % 2 == 0)
+            {
+                int first = (z - 1) * (gridSize + 1) + x + 1;
+                int second = first + gridSize + 1;
+                fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1\n", first, first, second, second, second + 1, second + 1);
+            }
+            else
+            {
+                int first = x - 2 * (gridSize + 1);
+                int second = x - (gridSize + 1);
+                fprintf(file, "f %d/%d/-1 %d/%d/-1 %d/%d/-1\n", first, first, second, second, second + 1, second + 1);
+            }
+        }
+    }
+
+    fclose(file);
+}
+
+// Repeats every object of an OBJ file, offsetting the face indices of each copy
+static void WriteScaledObjFile(const std::string &sourceFileName, const std::string &fileName, int copyCount)
+{
+    std::ifstream source(sourceFileName.c_str());
+    std::vector<std::string> lines;
+    int counts[3] = { 0, 0, 0 };
+
+    for (std::string line; std::getline(source, line);)
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+
+        lines.push_back(line);
+        counts[0] += line.compare(0, 2, "v ") == 0;
+        counts[1] += line.compare(0, 3, "vt ") == 0;
+        counts[2] += line.compare(0, 3, "vn ") == 0;
+    }
+
+    std::ofstream output(fileName.c_str());
+    for (int copy = 0; copy < copyCount; ++copy)
+    {
+        for (int i = 0; i < lines.size(); ++i)
+        {
+            if (lines[i].compare(0, 2, "f ") != 0)
+            {
+                if (copy == 0 || lines[i].compare(0, 7, "mtllib ") != 0)
+                    output << lines[i] << "\n";
+                continue;
+            }
+
+            std::istringstream corners(lines[i].substr(2));
+            output << "f";
+            for (std::string corner; corners >> corner;)
+            {
+                output << " ";
+
+                std::istringstream indices(corner);
+                std::string index;
+                for (int attribute = 0; std::getline(indices, index, '/'); ++attribute)
+                {
+                    if (attribute > 0)
+                        output << "/";
+                    if (!index.empty())
+                        output << atoi(index.c_str()) + copy * counts[attribute];
+                }
+            }
+            output << "\n";
+        }
+    }
+}
+
+static bool FacesMatch(const ObjParser::FaceList &first, const ObjParser::FaceList &second)
+{
+    return first.corners.size() == second.corners.size() &&
+        memcmp(first.corners.data(), second.corners.data(), first.corners.size() * sizeof(ObjParser::FaceCorner)) == 0 &&
+        first.offsets == second.offsets &&
+        first.counts == second.counts &&
+        first.materialIds == second.materialIds &&
+        first.materialNames == second.materialNames;
+}
+
+TEST_CASE("ObjFileParser reads values and faces")
+{
+    const std::string fileName = "objparser-test.obj";
+    WriteTextFile(fileName,
+                  "# comment line\r\n"
+                  "o thing\r\n"
+                  "v -1.5 2 0.25\r\n"
+                  "v 1e-2 -2.5E+1 .5   \r\n"
+                  "v 0.0 1.0 0.0\r\n"
+                  "vt 0.5 1\r\n"
+                  "vn 0 0 -1\r\n"
+                  "s off\r\n"
+                  "f 1/1/1 2/1/1 3/1/1 # trailing comment\r\n"
+                  "f 3//1 2//1 1//1");
+
+    ObjParser::ObjFileParser parser("", fileName.c_str());
+    ObjParser::IParseResult *result = parser.Parse();
+
+    std::vector<ObjParser::Vertex> vertices = result->GetVertices();
+    REQUIRE(vertices.size() == 3);
+    REQUIRE(vertices[0].coordinates[0] == -1.5f);
+    REQUIRE(vertices[0].coordinates[1] == 2.0f);
+    REQUIRE(vertices[0].coordinates[2] == 0.25f);
+    REQUIRE(vertices[0].coordinates[3] == 1.0f);
+    REQUIRE(vertices[1].coordinates[0] == 0.01f);
+    REQUIRE(vertices[1].coordinates[1] == -25.0f);
+    REQUIRE(vertices[1].coordinates[2] == 0.5f);
+
+    REQUIRE(result->GetUVCoords().size() == 1);
+    REQUIRE(result->GetNormals()[0].coordinates[2] == -1.0f);
+
+    const ObjParser::FaceList &faces = result->GetFaces();
+    REQUIRE(faces.Size() == 2);
+    REQUIRE(faces.counts[0] == 3);
+    REQUIRE(faces.corners[faces.offsets[0] + 1].vertex == 1);
+    REQUIRE(faces.corners[faces.offsets[0] + 2].uv == 0);
+    REQUIRE(faces.corners[faces.offsets[1]].vertex == 2);
+    REQUIRE(faces.corners[faces.offsets[1]].uv == ObjParser::NO_INDEX);
+    REQUIRE(faces.corners[faces.offsets[1] + 2].normal == 0);
+    REQUIRE(faces.materialNames[faces.materialIds[1]].empty());
+
+    remove(fileName.c_str());
+}
+
+TEST_CASE("ParseInt clamps values that do not fit")
+{
+    const char *text[] = { "123456789", "1234567890", "2147483647", "2147483648", "-99999999999" };
+    int expected[] = { 123456789, 1234567890, INT_MAX, INT_MAX, -INT_MAX };
+
+    for (int i = 0; i < 5; ++i)
+    {
+        StringRange range = { text[i], text[i] + strlen(text[i]) };
+        REQUIRE(ParseInt(range) == expected[i]);
+    }
+}
+
+TEST_CASE("ObjFileParser reports errors in material libraries")
+{
+    const std::string fileName = "objparser-bad-material.obj";
+    const std::string materialFileName = "objparser-bad-material.mtl";
+    WriteTextFile(materialFileName, "newmtl Red\nKd 1.0 0.0 0.0\nnewmtl Blue\nKd 0.0 0.0 1.0\n@\n");
+    WriteTextFile(fileName, "mtllib " + materialFileName + "\nv 0 0 0\nv 1 0 0\nv 0 1 0\nusemtl Red\nf 1 2 3\n");
+
+    // The two materials read before the error are freed, which the
+    // sanitizer builds check
+    ObjParser::ObjFileParser parser("", fileName.c_str());
+    REQUIRE_THROWS_AS(parser.Parse(), std::runtime_error);
+
+    remove(fileName.c_str());
+    remove(materialFileName.c_str());
+}
+
+TEST_CASE("ObjFileParser parallel parse matches the serial parse")
+{
+    const std::string fileName = "objparser-parallel.obj";
+    const std::string materialFileName = "objparser-parallel.mtl";
+    WriteMaterialObjFile(fileName, materialFileName, 200);
+
+    ObjParser::ObjFileParser serialParser("", fileName.c_str());
+    ObjParser::IParseResult *serial = serialParser.Parse();
+    ObjParser::ObjFileParser parallelParser("", fileName.c_str());
+    ObjParser::IParseResult *parallel = parallelParser.ParseParallel(8);
+
+    std::vector<ObjParser::Vertex> serialVertices = serial->GetVertices();
+    std::vector<ObjParser::Vertex> parallelVertices = parallel->GetVertices();
+    REQUIRE(serialVertices.size() == 201 * 201);
+    REQUIRE(parallelVertices.size() == serialVertices.size());
+    REQUIRE(memcmp(serialVertices.data(), parallelVertices.data(), serialVertices.size() * sizeof(ObjParser::Vertex)) == 0);
+
+    REQUIRE(parallel->GetUVCoords().size() == serial->GetUVCoords().size());
+    REQUIRE(parallel->GetNormals().size() == serial->GetNormals().size());
+    REQUIRE(parallel->GetMaterialLibraries() == serial->GetMaterialLibraries());
+    REQUIRE(parallel->GetMaterials().size() == 2);
+
+    const ObjParser::FaceList &serialFaces = serial->GetFaces();
+    const ObjParser::FaceList &parallelFaces = parallel->GetFaces();
+    REQUIRE(serialFaces.Size() == 200 * 200);
+    REQUIRE(FacesMatch(serialFaces, parallelFaces));
+
+    // Relative indices resolve to the same vertices as their absolute twins
+    const ObjParser::FaceCorner *corners = &serialFaces.corners[serialFaces.offsets[1]];
+    REQUIRE(corners[0].vertex == 1);
+    REQUIRE(corners[1].vertex == 202);
+    REQUIRE(corners[2].uv == 203);
+    REQUIRE(corners[0].normal == 0);
+    REQUIRE(serialFaces.materialNames[serialFaces.materialIds[0]] == "Red");
+    REQUIRE(serialFaces.materialNames[serialFaces.materialIds[200 * 7]] == "Blue");
+
+    remove(fileName.c_str());
+    remove(materialFileName.c_str());
+}
+
+TEST_CASE("ObjImporter triangulates polygons as a fan")
+{
+    const std::string fileName = "objimporter-fan.obj";
+    WriteTextFile(fileName,
+                  "v 0 0 0\nv 1 0 0\nv 2 1 0\nv 1 2 0\nv 0 1 0\n"
+                  "f 1 2 3 4 5\n");
+
+    ObjParser::ObjFileParser parser("", fileName.c_str());
+    ObjImporter importer(parser.Parse());
+    std::vector<RenderObject> renderObjects = importer.GetRenderObjects();
+
+    REQUIRE(renderObjects.size() == 1);
+    const RenderObject &object = renderObjects[0];
+    REQUIRE(object._indices.size() == 9);
+
+    // Every triangle starts at the first corner and has the face normal
+    for (int i = 0; i < 9; i += 3)
+    {
+        REQUIRE(object._vertices[i * 4] == 0.0f);
+        REQUIRE(object._vertices[i * 4 + 1] == 0.0f);
+    }
+    REQUIRE(object._vertices[4 * 4] == 2.0f);
+    REQUIRE(object._vertices[8 * 4 + 1] == 1.0f);
+    REQUIRE(object._normals[2] == 1.0f);
+
+    remove(fileName.c_str());
+}
+
+TEST_CASE("MtlFileParser reads CRLF files and texture maps")
+{
+    const std::string fileName = "mtlparser-maps.mtl";
+    WriteTextFile(fileName,
+                  "# exported\r\n"
+                  "newmtl 01_Wood\r\n"
+                  "\tNs 96.078431\r\n"
+                  "Ka 0.1 0.2 0.3\r\n"
+                  "Kd 1.0 0.5 0.25\r\n"
+                  "Ks 0.5 0.5 0.5\r\n"
+                  "Ke 0.0 0.0 0.0\r\n"
+                  "d 1.0\r\n"
+                  "illum 2\r\n"
+                  "map_Kd wood diffuse.png\r\n"
+                  "map_Ks -clamp on wood-specular.png\r\n"
+                  "map_bump -bm 0.5 1342371.png\r\n"
+                  "\r\n"
+                  "newmtl Plain\r\n"
+                  "Kd 0.0 0.0 1.0");
+
+    ObjParser::MtlFileParser parser("", fileName.c_str());
+    parser.Parse();
+    std::vector<ObjParser::Material*> materials = parser.GetMaterials();
+
+    REQUIRE(materials.size() == 2);
+    REQUIRE(materials[0]->name == "01_Wood");
+    REQUIRE(materials[0]->specularExponent == Approx(96.078431f));
+    REQUIRE(materials[0]->ambientColor.blue == Approx(0.3f));
+    REQUIRE(materials[0]->diffuseColor.green == Approx(0.5f));
+    REQUIRE(materials[0]->diffuseMap == "wood diffuse.png");
+    REQUIRE(materials[0]->specularMap == "wood-specular.png");
+    REQUIRE(materials[0]->bumpMap == "1342371.png");
+
+    REQUIRE(materials[1]->name == "Plain");
+    REQUIRE(materials[1]->diffuseColor.blue == 1.0f);
+    REQUIRE(materials[1]->diffuseMap.empty());
+    REQUIRE(materials[1]->bumpMap.empty());
+
+    for (int i = 0; i < materials.size(); ++i)
+    {
+        delete materials[i];
+    }
+
+    WriteTextFile(fileName, "Kd 1.0 1.0 1.0\nnewmtl Late\n");
+    ObjParser::MtlFileParser orphanParser("", fileName.c_str());
+    REQUIRE_THROWS_AS(orphanParser.Parse(), std::runtime_error);
+
+    remove(fileName.c_str());
+}
+
+TEST_CASE("StreamingObjImporter batches match the ObjImporter output")
+{
+    const std::string fileName = "objimporter-streaming.obj";
+    const std::string materialFileName = "objimporter-streaming.mtl";
+    WriteMaterialObjFile(fileName, materialFileName, 40);
+
+    ObjParser::ObjFileParser parser("", fileName.c_str());
+    ObjParser::IParseResult *result = parser.Parse();
+    ObjImporter importer(result);
+    const std::vector<RenderObject> &expected = importer.GetRenderObjects();
+
+    // Consecutive batches of one material concatenate to one ObjImporter render object
+    std::vector<RenderObject> merged;
+    {
+        const size_t batchTriangles = 50;
+        StreamingObjImporter streamingImporter("", fileName, batchTriangles, 2);
+
+        RenderObject batch;
+        while (streamingImporter.WaitForBatch(batch))
+        {
+            REQUIRE(batch._indices.size() / 3 <= batchTriangles);
+            REQUIRE(batch._indices.size() > 0);
+
+            if (merged.empty() || merged.back()._materialName != batch._materialName)
+            {
+                merged.push_back(RenderObject());
+                merged.back()._materialName = batch._materialName;
+            }
+
+            RenderObject &object = merged.back();
+            object._vertices.insert(object._vertices.end(), batch._vertices.begin(), batch._vertices.end());
+            object._normals.insert(object._normals.end(), batch._normals.begin(), batch._normals.end());
+            object._uvCoords.insert(object._uvCoords.end(), batch._uvCoords.begin(), batch._uvCoords.end());
+        }
+
+        REQUIRE(streamingImporter.IsFinished());
+    }
+
+    REQUIRE(merged.size() == expected.size());
+    for (int i = 0; i < merged.size(); ++i)
+    {
+        REQUIRE(merged[i]._materialName == expected[i]._materialName);
+        REQUIRE(merged[i]._vertices == expected[i]._vertices);
+        REQUIRE(merged[i]._normals == expected[i]._normals);
+        REQUIRE(merged[i]._uvCoords == expected[i]._uvCoords);
+    }
+
+    delete result;
+    remove(fileName.c_str());
+    remove(materialFileName.c_str());
+}
+
+TEST_CASE("StreamingObjImporter reports errors and stops early")
+{
+    const std::string fileName = "objimporter-streaming-error.obj";
+    WriteTextFile(fileName, "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 3\nv 0 x 0\n");
+
+    {
+        StreamingObjImporter streamingImporter("", fileName, 1, 1);
+        RenderObject batch;
+        REQUIRE_THROWS_AS(while (streamingImporter.WaitForBatch(batch)) {}, std::runtime_error);
+    }
+
+    // Destroying the importer while the worker waits for queue space must not block
+    const std::string gridFileName = "objimporter-streaming-grid.obj";
+    WriteSyntheticObjFile(gridFileName, 50);
+    {
+        StreamingObjImporter streamingImporter("", gridFileName, 10, 1);
+        RenderObject batch;
+        REQUIRE(streamingImporter.WaitForBatch(batch));
+        REQUIRE(batch._indices.size() == 30);
+    }
+
+    remove(fileName.c_str());
+    remove(gridFileName.c_str());
+}
+
+TEST_CASE("ObjFileParser benchmark", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    const std::string fileName = "objparser-benchmark.obj";
+    WriteSyntheticObjFile(fileName, 600);
+
+    FILE *file = fopen(fileName.c_str(), "rb");
+    fseek(file, 0, SEEK_END);
+    double megabytes = ftell(file) / (1024.0 * 1024.0);
+    fclose(file);
+
+    for (int chunkCount = 1; chunkCount <= 8; chunkCount *= 2)
+    {
+        Clock::time_point start = Clock::now();
+        ObjParser::ObjFileParser parser("", fileName.c_str());
+        ObjParser::IParseResult *result = parser.ParseParallel(chunkCount);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << "ObjFileParser (" << chunkCount << " chunks): " << megabytes << " MB in "
+                  << seconds * 1000.0 << " ms (" << megabytes / seconds << " MB/s)" << std::endl;
+    }
+
+    remove(fileName.c_str());
+}
+
+// Tokenizes the way the parser used to: one character at a time through ifstream
+// get/peek, a string per token and atof for every value.
+static double ScanObjFileWithStream(const std::string &fileName)
+{
+    std::ifstream stream(fileName.c_str());
+    std::string token;
+    double sum = 0.0;
+
+    for (int c = stream.get(); c != EOF; c = stream.get())
+    {
+        if (c == '#')
+        {
+            while (c != EOF && c != '\n')
+            {
+                c = stream.get();
+            }
+            continue;
+        }
+        if (isspace(c) || c == '/')
+        {
+            continue;
+        }
+
+        token.assign(1, (char)c);
+        while (stream.peek() != EOF && !isspace(stream.peek()) && stream.peek() != '/')
+        {
+            token.push_back((char)stream.get());
+        }
+        if (isdigit(token[0]) || token[0] == '-' || token[0] == '.')
+        {
+            sum += atof(token.c_str());
+        }
+    }
+    return sum;
+}
+
+TEST_CASE("ObjFileParser speedup over stream tokenizing", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    const std::string fileName = "objparser-speedup.obj";
+    WriteSyntheticObjFile(fileName, 600);
+
+    double streamSeconds = 1e9;
+    double parserSeconds = 1e9;
+    for (int run = 0; run < 3; ++run)
+    {
+        Clock::time_point start = Clock::now();
+        double sum = ScanObjFileWithStream(fileName);
+        streamSeconds = std::min(streamSeconds, std::chrono::duration<double>(Clock::now() - start).count());
+        REQUIRE(sum != 0.0);
+
+        start = Clock::now();
+        ObjParser::ObjFileParser parser("", fileName.c_str());
+        ObjParser::IParseResult *result = parser.ParseParallel(GetProcessorCount());
+        parserSeconds = std::min(parserSeconds, std::chrono::duration<double>(Clock::now() - start).count());
+        REQUIRE(result->GetFaces().Size() == 600 * 600);
+        delete result;
+    }
+
+    double speedup = streamSeconds / parserSeconds;
+    std::cout << "Stream tokenizing: " << streamSeconds * 1000.0 << " ms, ObjFileParser: "
+              << parserSeconds * 1000.0 << " ms (" << speedup << "x)" << std::endl;
+    if (speedup < 10.0)
+        WARN("ObjFileParser is below the 10x target over stream tokenizing");
+
+    remove(fileName.c_str());
+}
+
+TEST_CASE("ObjFileParser allocation benchmark", "[.][benchmark]")
+{
+    const std::string fileName = "objparser-allocations.obj";
+    WriteSyntheticObjFile(fileName, 600);
+
+    if (!IsCountingAllocations())
+        std::cout << "Allocation counts are only measured by bin/benchmarks.exe (make benchmarks)" << std::endl;
+
+    StartAllocationCounting();
+    ObjParser::ObjFileParser parser("", fileName.c_str());
+    ObjParser::IParseResult *result = parser.Parse();
+    AllocationStatistics parseStatistics = StopAllocationCounting();
+
+    StartAllocationCounting();
+    ObjImporter importer(result);
+    AllocationStatistics importStatistics = StopAllocationCounting();
+
+    std::cout << "ObjFileParser: " << result->GetFaces().Size() << " faces, " << parseStatistics.allocationCount
+              << " allocations, peak " << parseStatistics.peakBytes / (1024 * 1024) << " MB" << std::endl;
+    std::cout << "ObjImporter: " << importStatistics.allocationCount << " allocations, peak "
+              << importStatistics.peakBytes / (1024 * 1024) << " MB" << std::endl;
+
+    remove(fileName.c_str());
+}
+
+TEST_CASE("ObjImporter scaled asset memory benchmark", "[.][benchmark]")
+{
+    const std::string fileName = "textured-things-x100.obj";
+    WriteScaledObjFile("assets/textured-things.obj", "assets/" + fileName, 100);
+
+    if (!IsCountingAllocations())
+        std::cout << "Allocation counts are only measured by bin/benchmarks.exe (make benchmarks)" << std::endl;
+
+    StartAllocationCounting();
+    {
+        ObjParser::ObjFileParser parser("assets/", fileName.c_str());
+        ObjParser::IParseResult *result = parser.Parse();
+        ObjImporter importer(result);
+        std::vector<RenderObject> renderObjects = importer.TakeRenderObjects();
+        delete result;
+
+        std::cout << "textured-things x100: " << renderObjects.size() << " render objects" << std::endl;
+    }
+    AllocationStatistics statistics = StopAllocationCounting();
+
+    std::cout << "Parse and import: " << statistics.allocationCount << " allocations, peak "
+              << statistics.peakBytes / 1024 << " KB" << std::endl;
+
+    remove(("assets/" + fileName).c_str());
+}
+
+TEST_CASE("StreamingObjImporter latency benchmark", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    const std::string fileName = "objimporter-streaming-benchmark.obj";
+    WriteSyntheticObjFile(fileName, 600);
+
+    if (!IsCountingAllocations())
+        std::cout << "Allocation counts are only measured by bin/benchmarks.exe (make benchmarks)" << std::endl;
+
+    StartAllocationCounting();
+    Clock::time_point start = Clock::now();
+    {
+        ObjParser::ObjFileParser parser("", fileName.c_str());
+        ObjParser::IParseResult *result = parser.Parse();
+        ObjImporter importer(result);
+        delete result;
+    }
+    double importSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    AllocationStatistics importStatistics = StopAllocationCounting();
+
+    StartAllocationCounting();
+    start = Clock::now();
+    double firstBatchSeconds = 0.0;
+    size_t batchCount = 0;
+    {
+        StreamingObjImporter streamingImporter("", fileName);
+        RenderObject batch;
+        while (streamingImporter.WaitForBatch(batch))
+        {
+            if (batchCount++ == 0)
+                firstBatchSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+    }
+    double streamSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    AllocationStatistics streamStatistics = StopAllocationCounting();
+
+    std::cout << "ObjImporter: " << importSeconds * 1000.0 << " ms, peak "
+              << importStatistics.peakBytes / (1024 * 1024) << " MB" << std::endl;
+    std::cout << "StreamingObjImporter: first batch after " << firstBatchSeconds * 1000.0 << " ms, "
+              << batchCount << " batches in " << streamSeconds * 1000.0 << " ms, peak "
+              << streamStatistics.peakBytes / (1024 * 1024) << " MB" << std::endl;
+
+    remove(fileName.c_str());
+}
+
+TEST_CASE("MtlFileParser benchmark", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    const std::string fileName = "mtlparser-benchmark.mtl";
+    FILE *file = fopen(fileName.c_str(), "wb");
+    for (int i = 0; i < 50000; ++i)
+    {
+        fprintf(file, "newmtl Material.%03d\r\nNs 96.078431\r\nKa 0.000000 0.000000 0.000000\r\n"
+                "Kd 0.640000 0.640000 0.640000\r\nKs 0.500000 0.500000 0.500000\r\nNi 1.000000\r\n"
+                "d 1.000000\r\nillum 2\r\nmap_Kd textures/diffuse-%d.png\r\n\r\n", i, i);
+    }
+    double megabytes = ftell(file) / (1024.0 * 1024.0);
+    fclose(file);
+
+    Clock::time_point start = Clock::now();
+    ObjParser::MtlFileParser parser("", fileName.c_str());
+    parser.Parse();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<ObjParser::Material*> materials = parser.GetMaterials();
+    std::cout << "MtlFileParser: " << materials.size() << " materials, " << megabytes << " MB in "
+              << seconds * 1000.0 << " ms (" << megabytes / seconds << " MB/s)" << std::endl;
+
+    for (int i = 0; i < materials.size(); ++i)
+    {
+        delete materials[i];
+    }
+
+    remove(fileName.c_str());
+}
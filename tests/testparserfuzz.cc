@@ -0,0 +1,176 @@
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+#include "catch.hh"
+
+#include "objimporter/mtlfileparser.hh"
+#include "objimporter/objimporter.hh"
+#include "objimporter/objparser.hh"
+#include "objimporter/textbuffer.hh"
+
+// Same work as fuzz/*parserfuzzer.cc; anything but a runtime_error escapes and fails the test
+static bool ParseCorpusFile(const std::string &fileName, const std::vector<char> &contents)
+{
+    if (fileName.substr(fileName.size() - 4) == ".mtl")
+    {
+        ObjParser::MtlFileParser parser("", fileName.c_str());
+        bool parsed = true;
+        try
+        {
+            parser.ParseBuffer(contents.data(), contents.size());
+        }
+        catch (std::runtime_error &)
+        {
+            parsed = false;
+        }
+
+        std::vector<ObjParser::Material*> materials = parser.GetMaterials();
+        for (int i = 0; i < materials.size(); ++i)
+        {
+            delete materials[i];
+        }
+        return parsed;
+    }
+
+    ObjParser::ObjFileParser parser("assets/", fileName.c_str());
+    ObjParser::IParseResult *result = NULL;
+    try
+    {
+        result = parser.ParseBuffer(contents.data(), contents.size());
+    }
+    catch (std::runtime_error &)
+    {
+        return false;
+    }
+
+    ObjImporter importer(result);
+    delete result;
+    return true;
+}
+
+// The seed corpus: every OBJ and MTL file in assets/
+static std::vector<std::string> GetCorpusFileNames()
+{
+    std::vector<std::string> fileNames;
+
+    DIR *directory = opendir("assets");
+    if (directory == NULL)
+        return fileNames;
+
+    while (dirent *entry = readdir(directory))
+    {
+        std::string fileName = entry->d_name;
+        if (fileName.size() > 4 && (fileName.substr(fileName.size() - 4) == ".obj" || fileName.substr(fileName.size() - 4) == ".mtl"))
+            fileNames.push_back(fileName);
+    }
+
+    closedir(directory);
+    return fileNames;
+}
+
+static unsigned int NextRandom(unsigned int &seed)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+// Byte flips, truncations, spliced and deleted ranges biased towards the
+// characters the scanners care about
+static std::vector<char> Mutate(const std::vector<char> &contents, unsigned int &seed)
+{
+    static const char alphabet[] = "0123456789-+./eE \t\r\n#vfntu";
+    std::vector<char> mutated = contents;
+    int mutationCount = 1 + NextRandom(seed) % 4;
+
+    for (int i = 0; i < mutationCount && !mutated.empty(); ++i)
+    {
+        size_t position = NextRandom(seed) % mutated.size();
+        size_t length = 1 + NextRandom(seed) % 16;
+
+        switch (NextRandom(seed) % 4)
+        {
+        case 0:
+            mutated[position] = alphabet[NextRandom(seed) % (sizeof(alphabet) - 1)];
+            break;
+        case 1:
+            mutated.resize(position);
+            break;
+        case 2:
+            mutated.erase(mutated.begin() + position, mutated.begin() + std::min(mutated.size(), position + length));
+            break;
+        case 3:
+        {
+            size_t source = NextRandom(seed) % mutated.size();
+            std::vector<char> splice(mutated.begin() + source, mutated.begin() + std::min(mutated.size(), source + length));
+            mutated.insert(mutated.begin() + position, splice.begin(), splice.end());
+            break;
+        }
+        }
+    }
+
+    return mutated;
+}
+
+TEST_CASE("Parsers reject mutated corpus files with runtime errors only")
+{
+    std::vector<std::string> fileNames = GetCorpusFileNames();
+    REQUIRE(!fileNames.empty());
+
+    unsigned int seed = 2024;
+    for (int i = 0; i < fileNames.size(); ++i)
+    {
+        std::vector<char> contents;
+        REQUIRE(ReadFileContents("assets/" + fileNames[i], contents));
+        REQUIRE(ParseCorpusFile(fileNames[i], contents));
+
+        for (int mutation = 0; mutation < 500; ++mutation)
+        {
+            ParseCorpusFile(fileNames[i], Mutate(contents, seed));
+        }
+    }
+
+    const char *hostile[] = {
+        "f 1 2 3\n",
+        "v 0 0 0\nf 1 -5 1\n",
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1/9 2/9 3/9\n",
+        "v 0 0 0\nf 99999999999999999999 1 1\n",
+        "f\n",
+        "usemtl\n"
+    };
+    for (int i = 0; i < sizeof(hostile) / sizeof(hostile[0]); ++i)
+    {
+        std::string text = hostile[i];
+        INFO(text);
+        REQUIRE_FALSE(ParseCorpusFile("hostile.obj", std::vector<char>(text.begin(), text.end())));
+    }
+}
+
+TEST_CASE("Parser corpus throughput benchmark", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    std::vector<std::string> fileNames = GetCorpusFileNames();
+    for (int i = 0; i < fileNames.size(); ++i)
+    {
+        std::vector<char> contents;
+        ReadFileContents("assets/" + fileNames[i], contents);
+
+        int runCount = 0;
+        double seconds = 0.0;
+        Clock::time_point start = Clock::now();
+        while (seconds < 0.2)
+        {
+            ParseCorpusFile(fileNames[i], contents);
+            ++runCount;
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        double megabytes = contents.size() * (double)runCount / (1024.0 * 1024.0);
+        std::cout << fileNames[i] << ": " << contents.size() << " bytes, " << megabytes / seconds << " MB/s" << std::endl;
+    }
+}
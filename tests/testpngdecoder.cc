@@ -0,0 +1,129 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <lodepng.h>
+
+#include "catch.hh"
+
+// CRCs of the RGBA8 pixels the scalar byte-at-a-time decoder produced for the
+// bundled assets; the table driven inflate and SSE2 unfilters must match them
+static const unsigned COLORS_CRC = 0x77499bbf;
+static const unsigned MINECRAFT_TILES_CRC = 0xdb5f636b;
+
+static unsigned DecodeFileCRC(const char *fileName)
+{
+    unsigned char *pixels;
+    unsigned width, height;
+    if (lodepng_decode32_file(&pixels, &width, &height, fileName) != 0)
+        return 0;
+
+    unsigned crc = lodepng_crc32(pixels, width * height * 4);
+    free(pixels);
+
+    return crc;
+}
+
+// Gradients with noise, so the encoder's filter heuristic picks all five
+// filters and deflate emits literals, short matches and long overlapping runs
+static std::vector<unsigned char> CreateTestImage(unsigned width, unsigned height, unsigned channels, unsigned seed)
+{
+    std::vector<unsigned char> pixels(width * height * channels);
+    for (unsigned y = 0; y < height; ++y)
+    {
+        for (unsigned x = 0; x < width; ++x)
+        {
+            seed = seed * 1103515245 + 12345;
+            unsigned char *pixel = &pixels[(y * width + x) * channels];
+            for (unsigned c = 0; c < channels; ++c)
+            {
+                unsigned char noise = (seed >> (8 + c * 4)) & 7;
+                pixel[c] = ((x / 8 + y / 8) & 1) ? (x * (c + 1) + y) + noise : 200;
+            }
+        }
+    }
+
+    return pixels;
+}
+
+TEST_CASE("PNG decoding is bit-identical to the reference decoder")
+{
+    REQUIRE(DecodeFileCRC("assets/colors.png") == COLORS_CRC);
+    REQUIRE(DecodeFileCRC("assets/minecraft-tiles.png") == MINECRAFT_TILES_CRC);
+
+    const LodePNGColorType colorTypes[] = { LCT_GREY, LCT_GREY_ALPHA, LCT_RGB, LCT_RGBA };
+    const unsigned channelCounts[] = { 1, 2, 3, 4 };
+    const LodePNGFilterStrategy filterStrategies[] = { LFS_ZERO, LFS_MINSUM, LFS_ENTROPY };
+
+    for (int type = 0; type < 4; ++type)
+    {
+        for (unsigned interlace = 0; interlace < 2; ++interlace)
+        {
+            for (unsigned blockType = 0; blockType < 3; ++blockType)
+            {
+                for (int strategy = 0; strategy < 3; ++strategy)
+                {
+                    const unsigned width = 61;
+                    const unsigned height = 37;
+                    std::vector<unsigned char> pixels = CreateTestImage(width, height, channelCounts[type], type + blockType);
+
+                    lodepng::State state;
+                    state.info_raw.colortype = colorTypes[type];
+                    state.info_png.color.colortype = colorTypes[type];
+                    state.info_png.interlace_method = interlace;
+                    state.encoder.auto_convert = 0;
+                    state.encoder.filter_strategy = filterStrategies[strategy];
+                    state.encoder.zlibsettings.btype = blockType;
+
+                    std::vector<unsigned char> png;
+                    REQUIRE(lodepng::encode(png, pixels, width, height, state) == 0);
+
+                    std::vector<unsigned char> decoded;
+                    unsigned decodedWidth, decodedHeight;
+                    INFO("color type " << colorTypes[type] << ", interlace " << interlace
+                         << ", block type " << blockType << ", filter strategy " << strategy);
+                    REQUIRE(lodepng::decode(decoded, decodedWidth, decodedHeight, png.data(), png.size(),
+                                            colorTypes[type]) == 0);
+                    REQUIRE(decoded == pixels);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("PNG decoding benchmark", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+    const int decodeCount = 10;
+
+    std::vector<unsigned char> tiles;
+    lodepng::load_file(tiles, "assets/minecraft-tiles.png");
+    REQUIRE(!tiles.empty());
+
+    // A large noisy atlas stresses inflate more than the mostly flat tiles
+    const unsigned atlasSize = 2048;
+    std::vector<unsigned char> atlas;
+    REQUIRE(lodepng::encode(atlas, CreateTestImage(atlasSize, atlasSize, 4, 1), atlasSize, atlasSize) == 0);
+
+    const std::vector<unsigned char> *files[] = { &tiles, &atlas };
+    const char *names[] = { "minecraft-tiles.png", "atlas" };
+    for (int i = 0; i < 2; ++i)
+    {
+        unsigned char *pixels;
+        unsigned width, height;
+
+        Clock::time_point start = Clock::now();
+        for (int j = 0; j < decodeCount; ++j)
+        {
+            REQUIRE(lodepng_decode32(&pixels, &width, &height, files[i]->data(), files[i]->size()) == 0);
+            free(pixels);
+        }
+        double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / decodeCount;
+
+        double megabytes = width * height * 4 / 1000000.0;
+        std::cout << names[i] << " " << width << "x" << height << ", " << files[i]->size() << " bytes: "
+                  << milliseconds << " ms, " << megabytes * 1000.0 / milliseconds << " MB/s" << std::endl;
+    }
+}
@@ -0,0 +1,137 @@
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <system/thread.hh>
+
+#include "catch.hh"
+
+#include "utility/profiler.hh"
+
+static const unsigned long long NANOSECONDS_PER_MILLISECOND = 1000000ULL;
+
+TEST_CASE("Profiler summarizes the last window of each scope")
+{
+    Profiler profiler(100);
+
+    // 1..200 ms, of which only 101..200 are in the window
+    for (unsigned long long i = 1; i <= 200; ++i)
+    {
+        profiler.Record("Update", 0, i * NANOSECONDS_PER_MILLISECOND);
+    }
+    profiler.Record("Render", 0, 1000 * NANOSECONDS_PER_MILLISECOND);
+    profiler.Collect();
+
+    std::vector<ProfileSummary> summaries = profiler.GetSummaries();
+    REQUIRE(summaries.size() == 2);
+    REQUIRE(summaries[0].name == "Render");
+    REQUIRE(summaries[0].calls == 1);
+    REQUIRE(summaries[0].p99 == Approx(1000.0));
+
+    REQUIRE(summaries[1].name == "Update");
+    REQUIRE(summaries[1].calls == 200);
+    REQUIRE(summaries[1].min == Approx(101.0));
+    REQUIRE(summaries[1].average == Approx(150.5));
+    REQUIRE(summaries[1].p99 == Approx(199.0));
+    REQUIRE(summaries[1].max == Approx(200.0));
+
+    std::stringstream summary;
+    profiler.PrintSummary(summary);
+    REQUIRE(summary.str().find("Update") != std::string::npos);
+    REQUIRE(summary.str().find("150.500") != std::string::npos);
+}
+
+TEST_CASE("Profiler writes scopes as Chrome trace events")
+{
+    Profiler profiler;
+    profiler.SetThreadName("Logic \"main\"");
+
+    unsigned long long start = Profiler::GetTime();
+    {
+        ProfileScope outer("Frame", &profiler);
+        ProfileScope inner("Entity::update", &profiler);
+    }
+    profiler.Record("Parse", start, start + 1500);
+    profiler.Collect();
+
+    std::stringstream trace;
+    profiler.WriteChromeTrace(trace);
+    std::string json = trace.str();
+
+    REQUIRE(json.find("{\"traceEvents\":[") == 0);
+    REQUIRE(json.find("\"args\":{\"name\":\"Logic \\\"main\\\"\"}") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"Frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"Entity::update\"") != std::string::npos);
+    REQUIRE(json.find("\"dur\":1.500}") != std::string::npos);
+    REQUIRE(json.substr(json.size() - 4) == "\n]}\n");
+
+    // Scopes close inner first
+    REQUIRE(json.find("Entity::update") < json.find("\"Frame\""));
+
+    profiler.ClearTrace();
+    std::stringstream empty;
+    profiler.WriteChromeTrace(empty);
+    REQUIRE(empty.str().find("\"ph\":\"X\"") == std::string::npos);
+    REQUIRE(profiler.GetSummaries().size() == 3);
+}
+
+TEST_CASE("Profiler collects from several threads while they record")
+{
+    const int threadCount = 4;
+    const int scopeCount = 100000;
+    Profiler profiler(10);
+    std::vector<System::thread*> threads;
+
+    for (int i = 0; i < threadCount; ++i)
+    {
+        threads.push_back(new System::thread([&profiler, i]() {
+            profiler.SetThreadName(i % 2 == 0 ? "Even" : "Odd");
+            for (int j = 0; j < scopeCount; ++j)
+            {
+                ProfileScope scope(i % 2 == 0 ? "Even" : "Odd", &profiler);
+            }
+        }));
+    }
+
+    for (int i = 0; i < 100; ++i)
+    {
+        profiler.Collect();
+    }
+
+    for (int i = 0; i < threadCount; ++i)
+    {
+        threads[i]->join();
+        delete threads[i];
+    }
+    profiler.Collect();
+
+    // Every scope is either summarized or counted as dropped
+    std::vector<ProfileSummary> summaries = profiler.GetSummaries();
+    REQUIRE(summaries.size() == 2);
+    REQUIRE(summaries[0].calls > 0);
+    REQUIRE(summaries[1].calls > 0);
+    REQUIRE(summaries[0].calls + summaries[1].calls + profiler.GetDroppedEventCount() ==
+            (unsigned long long)threadCount * scopeCount);
+}
+
+TEST_CASE("Profile scope overhead benchmark", "[.][benchmark]")
+{
+    const int scopeCount = 1000000;
+    const int batchSize = 10000;
+    Profiler profiler;
+
+    unsigned long long start = Profiler::GetTime();
+    for (int i = 0; i < scopeCount / batchSize; ++i)
+    {
+        for (int j = 0; j < batchSize; ++j)
+        {
+            ProfileScope scope("Scope", &profiler);
+        }
+        profiler.Collect();
+        profiler.ClearTrace();
+    }
+    unsigned long long elapsed = Profiler::GetTime() - start;
+
+    std::cout << "Profile scope with collection " << (double)elapsed / scopeCount << " ns, "
+              << profiler.GetDroppedEventCount() << " dropped" << std::endl;
+}
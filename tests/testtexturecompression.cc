@@ -0,0 +1,217 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#include <lodepng.h>
+
+#include "catch.hh"
+
+#include "texturecompression.hh"
+
+static int loadCount = 0;
+
+// Mirrors LoadImageFromPNG, which lives outside the test build
+static RawImageInfo *LoadPNG(const std::string &fileName)
+{
+    ++loadCount;
+
+    RawImageInfo *image = (RawImageInfo *) malloc(sizeof(RawImageInfo));
+    image->components = GL_RGBA;
+    image->levels = 1;
+    if (lodepng_decode32_file(&image->data, &image->width, &image->height, fileName.c_str()) != 0)
+    {
+        free(image);
+        return NULL;
+    }
+
+    return image;
+}
+
+static void FreeImage(RawImageInfo *image)
+{
+    free(image->data);
+    free(image);
+}
+
+// Mean absolute difference over the RGB channels of RGBA pixels
+static double GetMeanColorError(const unsigned char *first, const unsigned char *second, size_t pixelCount)
+{
+    double error = 0.0;
+    for (size_t i = 0; i < pixelCount * 4; ++i)
+    {
+        if (i % 4 != 3)
+            error += abs(first[i] - second[i]);
+    }
+
+    return error / (pixelCount * 3);
+}
+
+TEST_CASE("BC1 and BC3 blocks decode close to their source")
+{
+    unsigned char pixels[64];
+    unsigned char decoded[64];
+    unsigned char block[16];
+
+    for (int i = 0; i < 16; ++i)
+    {
+        pixels[i * 4] = 200;
+        pixels[i * 4 + 1] = 100;
+        pixels[i * 4 + 2] = 50;
+        pixels[i * 4 + 3] = 255;
+    }
+    EncodeBC1Block(pixels, block);
+    DecodeBC1Block(block, decoded);
+    for (int i = 0; i < 16; ++i)
+    {
+        REQUIRE(abs(decoded[i * 4] - 200) <= 4);
+        REQUIRE(abs(decoded[i * 4 + 1] - 100) <= 2);
+        REQUIRE(abs(decoded[i * 4 + 2] - 50) <= 4);
+        REQUIRE(decoded[i * 4 + 3] == 255);
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        pixels[i * 4] = i * 16;
+        pixels[i * 4 + 1] = 255 - i * 16;
+        pixels[i * 4 + 2] = 128;
+        pixels[i * 4 + 3] = i * 17;
+    }
+    EncodeBC1Block(pixels, block);
+    DecodeBC1Block(block, decoded);
+    REQUIRE(GetMeanColorError(pixels, decoded, 16) < 16.0);
+    REQUIRE(decoded[0] < decoded[60]);
+
+    EncodeBC3Block(pixels, block);
+    DecodeBC3Block(block, decoded);
+    for (int i = 0; i < 16; ++i)
+    {
+        REQUIRE(abs(decoded[i * 4 + 3] - pixels[i * 4 + 3]) <= 19);
+        REQUIRE(abs(decoded[i * 4] - pixels[i * 4]) <= 40);
+    }
+}
+
+TEST_CASE("Compressed textures round trip through the cooked DDS cache")
+{
+    const unsigned int width = 37;
+    const unsigned int height = 21;
+    std::vector<unsigned char> pixels(width * height * 4);
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            unsigned char *pixel = &pixels[(y * width + x) * 4];
+            pixel[0] = x * 255 / width;
+            pixel[1] = y * 255 / height;
+            pixel[2] = 64;
+            pixel[3] = 255;
+        }
+    }
+
+    const std::string sourceFileName = "texturecache-test.png";
+    const std::string cookedFileName = GetCookedTexturePath(sourceFileName);
+    REQUIRE(lodepng_encode32_file(sourceFileName.c_str(), pixels.data(), width, height) == 0);
+    remove(cookedFileName.c_str());
+
+    loadCount = 0;
+    RawImageInfo *cooked = LoadTextureCached(sourceFileName, LoadPNG);
+    REQUIRE(cooked != NULL);
+    REQUIRE(loadCount == 1);
+    REQUIRE(cooked->components == GL_COMPRESSED_RGB_S3TC_DXT1_EXT);
+    REQUIRE(cooked->levels == 6);
+    REQUIRE(GetLevelWidth(*cooked, 5) == 1);
+    REQUIRE(GetImageSize(*cooked) == (10 * 6 + 5 * 3 + 3 * 2 + 1 + 1 + 1) * 8);
+
+    RawImageInfo *decompressed = DecompressImage(*cooked, 0);
+    REQUIRE(decompressed->width == width);
+    REQUIRE(decompressed->height == height);
+    REQUIRE(GetMeanColorError(decompressed->data, pixels.data(), width * height) < 6.0);
+    FreeImage(decompressed);
+
+    RawImageInfo *loaded = LoadTextureCached(sourceFileName, LoadPNG);
+    REQUIRE(loadCount == 1);
+    REQUIRE(loaded->levels == cooked->levels);
+    REQUIRE(memcmp(loaded->data, cooked->data, GetImageSize(*cooked)) == 0);
+    FreeImage(loaded);
+
+    struct stat fileStat;
+    REQUIRE(stat(sourceFileName.c_str(), &fileStat) == 0);
+    struct utimbuf times;
+    times.actime = fileStat.st_atime;
+    times.modtime = fileStat.st_mtime + 10;
+    REQUIRE(utime(sourceFileName.c_str(), &times) == 0);
+
+    loaded = LoadTextureCached(sourceFileName, LoadPNG);
+    REQUIRE(loadCount == 2);
+    FreeImage(loaded);
+
+    pixels[3] = 0;
+    RawImageInfo source = { pixels.data(), width, height, GL_RGBA, 1 };
+    RawImageInfo *transparent = CompressImage(source, false);
+    REQUIRE(transparent->components == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+    REQUIRE(transparent->levels == 1);
+    FreeImage(transparent);
+
+    FreeImage(cooked);
+    remove(sourceFileName.c_str());
+    remove(cookedFileName.c_str());
+}
+
+TEST_CASE("Texture cooking benchmark", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+    const int loadCount = 10;
+
+    DIR *directory = opendir("assets");
+    REQUIRE(directory != NULL);
+
+    while (dirent *entry = readdir(directory))
+    {
+        std::string fileName = entry->d_name;
+        if (fileName.size() < 4 || fileName.substr(fileName.size() - 4) != ".png")
+            continue;
+
+        const std::string sourceFileName = "assets/" + fileName;
+        const std::string cookedFileName = fileName + ".benchmark.dds";
+
+        Clock::time_point start = Clock::now();
+        RawImageInfo *source = NULL;
+        for (int i = 0; i < loadCount; ++i)
+        {
+            if (source != NULL)
+                FreeImage(source);
+            source = LoadPNG(sourceFileName);
+        }
+        double pngMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / loadCount;
+
+        start = Clock::now();
+        RawImageInfo *compressed = CompressImage(*source);
+        double encodeMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        SaveDDS(cookedFileName, *compressed);
+
+        start = Clock::now();
+        for (int i = 0; i < loadCount; ++i)
+        {
+            FreeImage(LoadDDS(cookedFileName));
+        }
+        double ddsMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / loadCount;
+
+        std::cout << fileName << " " << source->width << "x" << source->height
+                  << ": PNG " << pngMilliseconds << " ms, " << GetImageSize(*source) << " bytes; "
+                  << "DDS " << ddsMilliseconds << " ms, " << GetImageSize(*compressed) << " bytes with "
+                  << compressed->levels << " levels; encode " << encodeMilliseconds << " ms" << std::endl;
+
+        FreeImage(source);
+        FreeImage(compressed);
+        remove(cookedFileName.c_str());
+    }
+
+    closedir(directory);
+}
@@ -0,0 +1,304 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "catch.hh"
+#include "fakegl.hh"
+
+#include "rendering/uploadmanager.hh"
+#include "texturecompression.hh"
+#include "utility/frametimehistogram.hh"
+
+// Texture levels are plain byte arrays
+typedef struct FakeTextureLevel
+{
+    GLsizei width;
+    GLenum format;
+    std::vector<unsigned char> data;
+} FakeTextureLevel;
+
+static struct FakeTextureGL
+{
+    std::map<GLuint, std::vector<FakeTextureLevel> > textures;
+    GLuint boundTexture;
+    int errorQueries;
+} fake;
+
+static void CODEGEN_FUNCPTR FakeBindTexture(GLenum target, GLuint name)
+{
+    fake.boundTexture = name;
+}
+
+static FakeTextureLevel &GetFakeLevel(GLint level)
+{
+    std::vector<FakeTextureLevel> &levels = fake.textures[fake.boundTexture];
+    if (levels.size() <= level)
+        levels.resize(level + 1);
+
+    return levels[level];
+}
+
+static void CODEGEN_FUNCPTR FakeTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width,
+                                           GLsizei height, GLint border, GLenum format, GLenum type,
+                                           const GLvoid *pixels)
+{
+    FakeTextureLevel &storage = GetFakeLevel(level);
+    storage.width = width;
+    storage.format = format;
+    storage.data.assign(width * height * (format == GL_RGB ? 3 : 4), 0);
+}
+
+static void CODEGEN_FUNCPTR FakeCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat,
+                                                     GLsizei width, GLsizei height, GLint border,
+                                                     GLsizei imageSize, const GLvoid *data)
+{
+    FakeTextureLevel &storage = GetFakeLevel(level);
+    storage.width = width;
+    storage.format = internalFormat;
+    storage.data.assign(imageSize, 0);
+}
+
+// Sub-images always come from the staging buffer bound for unpacking
+static const unsigned char *GetUnpackSource(const GLvoid *pixels, size_t size)
+{
+    std::vector<unsigned char> &staging = fakeGL.buffers[fakeGL.bufferBindings[GL_PIXEL_UNPACK_BUFFER]];
+    size_t offset = (const GLubyte *)pixels - (const GLubyte *)NULL;
+    REQUIRE(fakeGL.bufferBindings[GL_PIXEL_UNPACK_BUFFER] != 0);
+    REQUIRE(offset + size <= staging.size());
+
+    return &staging[offset];
+}
+
+static void CODEGEN_FUNCPTR FakeTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width,
+                                              GLsizei height, GLenum format, GLenum type, const GLvoid *pixels)
+{
+    FakeTextureLevel &storage = GetFakeLevel(level);
+    size_t rowSize = storage.width * (format == GL_RGB ? 3 : 4);
+    REQUIRE(x == 0);
+    REQUIRE(width == storage.width);
+    REQUIRE((fakeGL.unpackAlignment == 1 || rowSize % 4 == 0));
+    REQUIRE((y + height) * rowSize <= storage.data.size());
+    memcpy(&storage.data[y * rowSize], GetUnpackSource(pixels, height * rowSize), height * rowSize);
+}
+
+static void CODEGEN_FUNCPTR FakeCompressedTexSubImage2D(GLenum target, GLint level, GLint x, GLint y,
+                                                        GLsizei width, GLsizei height, GLenum format,
+                                                        GLsizei imageSize, const GLvoid *data)
+{
+    FakeTextureLevel &storage = GetFakeLevel(level);
+    size_t blockRowSize = (storage.width + 3) / 4 * (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16);
+    REQUIRE(x == 0);
+    REQUIRE(y % 4 == 0);
+    REQUIRE(imageSize == (height + 3) / 4 * blockRowSize);
+    REQUIRE(y / 4 * blockRowSize + imageSize <= storage.data.size());
+    memcpy(&storage.data[y / 4 * blockRowSize], GetUnpackSource(data, imageSize), imageSize);
+}
+
+static GLenum CODEGEN_FUNCPTR FakeGetError()
+{
+    ++fake.errorQueries;
+    return GL_NO_ERROR;
+}
+
+// Adds the texture functions to the fake buffer driver
+class FakeTextureGLScope
+{
+public:
+    FakeTextureGLScope()
+        : _bindTexture(glBindTexture, FakeBindTexture), _texImage2D(glTexImage2D, FakeTexImage2D),
+          _compressedTexImage2D(glCompressedTexImage2D, FakeCompressedTexImage2D),
+          _texSubImage2D(glTexSubImage2D, FakeTexSubImage2D),
+          _compressedTexSubImage2D(glCompressedTexSubImage2D, FakeCompressedTexSubImage2D),
+          _getError(glGetError, FakeGetError)
+    {
+        fake = FakeTextureGL();
+    }
+
+private:
+    FakeGLScope _buffers;
+    FakeGLFunction<decltype(glBindTexture)> _bindTexture;
+    FakeGLFunction<decltype(glTexImage2D)> _texImage2D;
+    FakeGLFunction<decltype(glCompressedTexImage2D)> _compressedTexImage2D;
+    FakeGLFunction<decltype(glTexSubImage2D)> _texSubImage2D;
+    FakeGLFunction<decltype(glCompressedTexSubImage2D)> _compressedTexSubImage2D;
+    FakeGLFunction<decltype(glGetError)> _getError;
+};
+
+static RawImageInfo CreateImage(std::vector<unsigned char> &pixels, unsigned int width, unsigned int height,
+                                GLuint components)
+{
+    pixels.resize(width * height * (components == GL_RGB ? 3 : 4));
+    for (size_t i = 0; i < pixels.size(); ++i)
+    {
+        pixels[i] = (i * 7 + i / 13) & 255;
+    }
+
+    RawImageInfo image = { pixels.data(), width, height, components, 1 };
+    return image;
+}
+
+static bool TextureMatches(GLuint textureId, const RawImageInfo &image)
+{
+    const unsigned char *data = image.data;
+    for (unsigned int level = 0; level < std::max(1u, image.levels); ++level)
+    {
+        const std::vector<unsigned char> &stored = fake.textures[textureId][level].data;
+        if (stored.size() != GetLevelSize(image, level) || memcmp(stored.data(), data, stored.size()) != 0)
+            return false;
+        data += stored.size();
+    }
+
+    return true;
+}
+
+TEST_CASE("Uploads stream through staging buffers within the frame budget")
+{
+    FakeTextureGLScope scope;
+    const size_t budget = 64 * 1024;
+    const GLuint RGBA_TEXTURE = 1000, RGB_TEXTURE = 1001, WIDE_TEXTURE = 1002, COMPRESSED_TEXTURE = 1003;
+
+    std::vector<unsigned char> rgbaPixels, rgbPixels, widePixels;
+    RawImageInfo rgba = CreateImage(rgbaPixels, 100, 70, GL_RGBA);
+    RawImageInfo rgb = CreateImage(rgbPixels, 33, 17, GL_RGB);
+    // A single row of this one is larger than the budget
+    RawImageInfo wide = CreateImage(widePixels, 17000, 3, GL_RGBA);
+    std::vector<unsigned char> compressedSource;
+    RawImageInfo *compressed = CompressImage(CreateImage(compressedSource, 37, 21, GL_RGBA));
+
+    std::vector<unsigned char> bufferData(200000);
+    for (size_t i = 0; i < bufferData.size(); ++i)
+    {
+        bufferData[i] = i % 251;
+    }
+
+    std::vector<int> completed;
+    UploadManager manager(budget, 3);
+    REQUIRE(manager.IsIdle());
+
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, bufferData.size(), NULL, GL_STATIC_DRAW);
+
+    manager.UploadTexture(RGBA_TEXTURE, &rgba, [&]() { completed.push_back(0); });
+    manager.UploadBuffer(buffer, bufferData.data(), bufferData.size(), [&]() { completed.push_back(1); });
+    manager.UploadTexture(RGB_TEXTURE, &rgb, [&]() { completed.push_back(2); });
+    manager.UploadTexture(WIDE_TEXTURE, &wide, [&]() { completed.push_back(3); });
+    manager.UploadTexture(COMPRESSED_TEXTURE, compressed, [&]() { completed.push_back(4); });
+
+    size_t total = GetImageSize(rgba) + bufferData.size() + GetImageSize(rgb) + GetImageSize(wide) +
+        GetImageSize(*compressed);
+    REQUIRE(manager.GetPendingBytes() == total);
+
+    // Nothing is staged while the GPU holds on to every staging buffer
+    int frames = 0;
+    size_t uploaded = 0;
+    while (!manager.IsIdle())
+    {
+        fakeGL.fencesSignaled = frames < 3 || frames > 5;
+        manager.Update();
+        ++frames;
+
+        if (frames > 3 && frames <= 6)
+            REQUIRE(manager.GetLastFrameBytes() == 0);
+        else
+            REQUIRE(manager.GetLastFrameBytes() > 0);
+
+        REQUIRE((manager.GetLastFrameBytes() <= budget || manager.GetLastFrameBytes() == 17000 * 4));
+        REQUIRE(fakeGL.bufferBindings[GL_PIXEL_UNPACK_BUFFER] == 0);
+        REQUIRE(fakeGL.unpackAlignment == 4);
+
+        uploaded += manager.GetLastFrameBytes();
+        REQUIRE(manager.GetPendingBytes() == total - uploaded);
+        REQUIRE(frames < 100);
+    }
+
+    REQUIRE(uploaded == total);
+    REQUIRE(frames >= total / budget + 3);
+    REQUIRE(completed == std::vector<int>({ 0, 1, 2, 3, 4 }));
+    REQUIRE(TextureMatches(RGBA_TEXTURE, rgba));
+    REQUIRE(TextureMatches(RGB_TEXTURE, rgb));
+    REQUIRE(TextureMatches(WIDE_TEXTURE, wide));
+    REQUIRE(TextureMatches(COMPRESSED_TEXTURE, *compressed));
+    REQUIRE(fakeGL.buffers[buffer] == bufferData);
+
+    manager.UploadTexture(RGBA_TEXTURE + 10, &rgba, NULL);
+    manager.Flush();
+    REQUIRE(manager.IsIdle());
+    REQUIRE(TextureMatches(RGBA_TEXTURE + 10, rgba));
+
+    // Format support is known up front, so uploads never poll for errors
+    REQUIRE(fake.errorQueries == 0);
+
+    free(compressed->data);
+    free(compressed);
+}
+
+TEST_CASE("Frame time histograms report the slow tail")
+{
+    FrameTimeHistogram histogram(50);
+    REQUIRE(histogram.GetPercentile(0.99) == 0.0);
+
+    for (int i = 0; i < 990; ++i)
+    {
+        histogram.Add(16.4);
+    }
+    for (int i = 0; i < 10; ++i)
+    {
+        histogram.Add(40.0 + i * 10);
+    }
+
+    REQUIRE(histogram.GetCount() == 1000);
+    REQUIRE(histogram.GetPercentile(0.5) == 17.0);
+    REQUIRE(histogram.GetPercentile(0.99) == 17.0);
+    REQUIRE(histogram.GetPercentile(0.995) > 40.0);
+    REQUIRE(histogram.GetPercentile(1.0) == 130.0);
+    REQUIRE(histogram.GetCountAbove(33.0) == 10);
+    REQUIRE(histogram.GetMax() == 130.0);
+    REQUIRE(histogram.GetMean() == Approx((990 * 16.4 + 850.0) / 1000));
+
+    histogram.Clear();
+    REQUIRE(histogram.GetCount() == 0);
+}
+
+// Registers a burst of 32 1024x1024 textures mid-game, once uploading
+// everything in the frame it arrives and once with the default budget
+TEST_CASE("Upload burst frame time benchmark", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+    FakeTextureGLScope scope;
+
+    std::vector<unsigned char> pixels;
+    RawImageInfo image = CreateImage(pixels, 1024, 1024, GL_RGBA);
+    const int textureCount = 32;
+    const size_t burstSize = textureCount * GetImageSize(image);
+
+    const size_t budgets[] = { burstSize, DEFAULT_UPLOAD_FRAME_BUDGET };
+    for (int i = 0; i < 2; ++i)
+    {
+        UploadManager manager(budgets[i]);
+        FrameTimeHistogram histogram;
+
+        for (int frame = 0; frame < 120; ++frame)
+        {
+            if (frame == 30)
+            {
+                for (int j = 0; j < textureCount; ++j)
+                {
+                    manager.UploadTexture(j + 1, &image, NULL);
+                }
+            }
+
+            Clock::time_point start = Clock::now();
+            manager.Update();
+            histogram.Add(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+
+        REQUIRE(manager.IsIdle());
+        std::cout << "Frame budget " << budgets[i] / 1024 << " KB:" << std::endl;
+        histogram.Print(std::cout);
+    }
+}
@@ -0,0 +1,172 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "catch.hh"
+
+#include "voxellight.hh"
+
+static bool LightMapsMatch(const VoxelLightMap &first, const VoxelLightMap &second)
+{
+    for (int y = 0; y < VOXEL_SECTOR_SIZE; ++y)
+    {
+        for (int z = 0; z < VOXEL_SECTOR_SIZE; ++z)
+        {
+            for (int x = 0; x < VOXEL_SECTOR_SIZE; ++x)
+            {
+                if (first.GetPackedLight(Position(x, y, z)) != second.GetPackedLight(Position(x, y, z)))
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void ApplyRandomEdit(VoxelCollection &collection, VoxelLightMap &lightMap)
+{
+    Position position(rand() % VOXEL_SECTOR_SIZE,
+                      rand() % VOXEL_SECTOR_SIZE,
+                      rand() % VOXEL_SECTOR_SIZE);
+
+    int choice = rand() % 4;
+    if (choice < 2)
+        collection.ClearVoxel(position);
+    else
+        collection.SetVoxel(position, choice - 2);
+
+    lightMap.Update(collection, position);
+}
+
+TEST_CASE("VoxelLightMap")
+{
+    VoxelRepository repository;
+    repository.AddVoxelType(VoxelType(0, 0));
+    repository.AddVoxelType(VoxelType(0, 1, 12));
+
+    VoxelCollection collection(&repository);
+    VoxelLightMap lightMap;
+    lightMap.Rebuild(collection);
+
+    SECTION("lights an empty sector with full sky light")
+    {
+        REQUIRE(lightMap.GetLight(VoxelLightMap::Channel::Sky, Position(3, 0, 7)) == VOXEL_MAX_LIGHT);
+        REQUIRE(lightMap.GetLight(VoxelLightMap::Channel::Block, Position(3, 0, 7)) == 0);
+    }
+
+    SECTION("shadows cells below a solid voxel")
+    {
+        collection.SetVoxel(Position(4, 10, 4), 0);
+        lightMap.Update(collection, Position(4, 10, 4));
+
+        REQUIRE(lightMap.GetLight(VoxelLightMap::Channel::Sky, Position(4, 11, 4)) == VOXEL_MAX_LIGHT);
+        REQUIRE(lightMap.GetLight(VoxelLightMap::Channel::Sky, Position(4, 9, 4)) == VOXEL_MAX_LIGHT - 1);
+    }
+
+    SECTION("falls off by one per step from an emitter")
+    {
+        collection.Fill(0);
+        collection.SetVoxel(Position(8, 8, 8), 1);
+        collection.ClearVoxel(Position(9, 8, 8));
+        collection.ClearVoxel(Position(10, 8, 8));
+        lightMap.Rebuild(collection);
+
+        REQUIRE(lightMap.GetLight(VoxelLightMap::Channel::Block, Position(8, 8, 8)) == 12);
+        REQUIRE(lightMap.GetLight(VoxelLightMap::Channel::Block, Position(9, 8, 8)) == 11);
+        REQUIRE(lightMap.GetLight(VoxelLightMap::Channel::Block, Position(10, 8, 8)) == 10);
+        REQUIRE(lightMap.GetLight(VoxelLightMap::Channel::Sky, Position(10, 8, 8)) == 0);
+    }
+
+    SECTION("incremental updates match a full rebuild")
+    {
+        srand(26);
+        for (int i = 0; i < 2000; ++i)
+        {
+            ApplyRandomEdit(collection, lightMap);
+        }
+
+        VoxelLightMap rebuilt;
+        rebuilt.Rebuild(collection);
+
+        REQUIRE(LightMapsMatch(lightMap, rebuilt));
+    }
+
+    SECTION("takes sky light from the bottom of the sector above")
+    {
+        VoxelCollection aboveCollection(&repository);
+        aboveCollection.Fill(0);
+        VoxelLightMap above;
+        above.Rebuild(aboveCollection);
+
+        REQUIRE(lightMap.Rebuild(collection, &above));
+        REQUIRE(lightMap.GetLight(VoxelLightMap::Channel::Sky, Position(5, 15, 5)) == 0);
+        REQUIRE(lightMap.GetLight(VoxelLightMap::Channel::Sky, Position(5, 0, 5)) == 0);
+
+        // A shaft through the sector above lets the sky back in
+        for (int y = 0; y < VOXEL_SECTOR_SIZE; ++y)
+        {
+            aboveCollection.ClearVoxel(Position(5, y, 5));
+        }
+        above.Rebuild(aboveCollection);
+
+        REQUIRE(lightMap.Rebuild(collection, &above));
+        REQUIRE(lightMap.GetLight(VoxelLightMap::Channel::Sky, Position(5, 0, 5)) == VOXEL_MAX_LIGHT);
+        REQUIRE(lightMap.GetLight(VoxelLightMap::Channel::Sky, Position(6, 0, 5)) == VOXEL_MAX_LIGHT - 1);
+        REQUIRE(lightMap.GetLight(VoxelLightMap::Channel::Sky, Position(9, 15, 5)) == VOXEL_MAX_LIGHT - 4);
+        REQUIRE(!lightMap.Rebuild(collection, &above));
+
+        srand(28);
+        for (int i = 0; i < 2000; ++i)
+        {
+            ApplyRandomEdit(collection, lightMap);
+        }
+
+        VoxelLightMap rebuilt;
+        rebuilt.Rebuild(collection, &above);
+
+        REQUIRE(LightMapsMatch(lightMap, rebuilt));
+    }
+}
+
+TEST_CASE("VoxelLightMap benchmark", "[.][benchmark]")
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    VoxelRepository repository;
+    repository.AddVoxelType(VoxelType(0, 0));
+    repository.AddVoxelType(VoxelType(0, 1, 14));
+
+    VoxelCollection collection(&repository);
+    srand(28);
+    for (int x = 0; x < VOXEL_SECTOR_SIZE; ++x)
+    {
+        for (int z = 0; z < VOXEL_SECTOR_SIZE; ++z)
+        {
+            int height = rand() % VOXEL_SECTOR_SIZE;
+            for (int y = 0; y < height; ++y)
+            {
+                collection.SetVoxel(Position(x, y, z), rand() % 50 == 0 ? 1 : 0);
+            }
+        }
+    }
+
+    VoxelLightMap lightMap;
+    const int rebuildCount = 200;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < rebuildCount; ++i)
+    {
+        lightMap.Rebuild(collection);
+    }
+    double rebuildMicroseconds = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / rebuildCount;
+
+    const int editCount = 20000;
+    start = Clock::now();
+    for (int i = 0; i < editCount; ++i)
+    {
+        ApplyRandomEdit(collection, lightMap);
+    }
+    double editMicroseconds = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / editCount;
+
+    std::cout << "VoxelLightMap full rebuild: " << rebuildMicroseconds << " us" << std::endl;
+    std::cout << "VoxelLightMap incremental edit: " << editMicroseconds << " us" << std::endl;
+}
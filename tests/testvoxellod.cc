@@ -0,0 +1,155 @@
+#include "catch.hh"
+
+#include "voxellod.hh"
+
+TEST_CASE("VoxelLodGrid takes the majority voxel of each block")
+{
+    VoxelRepository repository;
+    repository.AddVoxelType(VoxelType(0, 0));
+    repository.AddVoxelType(VoxelType(0, 1));
+
+    VoxelCollection collection(&repository);
+    VoxelLightMap lightMap;
+    VoxelSectorNeighbors neighbors;
+
+    // Block (0, 0, 0) at level 1: five of type 1, one of type 0 and two air
+    collection.SetVoxel(Position(0, 0, 0), 1);
+    collection.SetVoxel(Position(1, 0, 0), 1);
+    collection.SetVoxel(Position(0, 1, 0), 1);
+    collection.SetVoxel(Position(0, 0, 1), 1);
+    collection.SetVoxel(Position(1, 1, 1), 0);
+    collection.SetVoxel(Position(1, 1, 0), 1);
+
+    // Block (1, 0, 0): four of type 0 tie with four air
+    collection.SetVoxel(Position(2, 0, 0), 0);
+    collection.SetVoxel(Position(3, 0, 0), 0);
+    collection.SetVoxel(Position(2, 1, 0), 0);
+    collection.SetVoxel(Position(3, 1, 0), 0);
+
+    // Block (2, 0, 0): three of type 0 are outvoted by five air
+    collection.SetVoxel(Position(4, 0, 0), 0);
+    collection.SetVoxel(Position(5, 0, 0), 0);
+    collection.SetVoxel(Position(4, 1, 0), 0);
+
+    lightMap.Rebuild(collection);
+    VoxelLodGrid grid(collection, lightMap, neighbors, 1);
+
+    REQUIRE(grid.GetSize() == VOXEL_SECTOR_SIZE / 2);
+    REQUIRE(grid.GetScale() == 2);
+    REQUIRE(grid.GetVoxel(0, 0, 0) == repository.GetVoxel(1));
+    REQUIRE(grid.GetVoxel(1, 0, 0) == repository.GetVoxel(0));
+    REQUIRE(grid.GetVoxel(2, 0, 0) == NULL);
+    REQUIRE(!grid.IsEmpty());
+    REQUIRE(!grid.IsFull());
+
+    // A level 3 cell covers 512 voxels, of which only 13 are solid
+    VoxelLodGrid coarse(collection, lightMap, neighbors, 3);
+    REQUIRE(coarse.IsEmpty());
+}
+
+TEST_CASE("VoxelLodGrid leaves its boundary open")
+{
+    VoxelRepository repository;
+    repository.AddVoxelType(VoxelType(0, 0));
+
+    VoxelCollection collection(&repository);
+    collection.Fill(0);
+    VoxelLightMap lightMap;
+    lightMap.Rebuild(collection);
+    VoxelSectorNeighbors neighbors;
+
+    // Neighbours may be drawn at another level, so a coarse sector always
+    // closes its own sides instead of relying on them
+    for (int level = 1; level < VOXEL_LOD_LEVEL_COUNT; ++level)
+    {
+        VoxelLodGrid grid(collection, lightMap, neighbors, level);
+        REQUIRE(grid.IsFull());
+        REQUIRE(grid.IsSolid(0, 0, 0));
+        REQUIRE(!grid.IsSolid(-1, 0, 0));
+        REQUIRE(!grid.IsSolid(0, grid.GetSize(), 0));
+    }
+}
+
+TEST_CASE("VoxelLodSelector picks coarser levels as voxels shrink on screen")
+{
+    VoxelLodSelector selector;
+
+    selector.SetPixelsPerUnit(100.0f);
+    REQUIRE(selector.GetLevel() == 0);
+
+    // Level 1 cells would be 8 pixels
+    selector.SetPixelsPerUnit(VOXEL_LOD_MIN_CELL_PIXELS);
+    REQUIRE(selector.GetLevel() == 0);
+
+    selector.SetPixelsPerUnit(VOXEL_LOD_MIN_CELL_PIXELS / 2);
+    REQUIRE(selector.GetLevel() == 1);
+
+    selector.SetPixelsPerUnit(VOXEL_LOD_MIN_CELL_PIXELS / 4);
+    REQUIRE(selector.GetLevel() == 2);
+
+    selector.SetPixelsPerUnit(0.01f);
+    REQUIRE(selector.GetLevel() == VOXEL_LOD_LEVEL_COUNT - 1);
+}
+
+TEST_CASE("VoxelLodGrid downsamples light with the voxels")
+{
+    VoxelRepository repository;
+    repository.AddVoxelType(VoxelType(0, 0));
+
+    // Solid up to y = 7 with open sky above
+    VoxelCollection collection(&repository);
+    for (int y = 0; y < 8; ++y)
+    {
+        for (int z = 0; z < VOXEL_SECTOR_SIZE; ++z)
+        {
+            for (int x = 0; x < VOXEL_SECTOR_SIZE; ++x)
+            {
+                collection.SetVoxel(Position(x, y, z), 0);
+            }
+        }
+    }
+
+    VoxelLightMap lightMap;
+    lightMap.Rebuild(collection);
+    VoxelSectorNeighbors neighbors;
+
+    SECTION("open cells keep the light of the cells they cover")
+    {
+        VoxelLodGrid grid(collection, lightMap, neighbors, 1);
+        REQUIRE(grid.GetPackedLight(2, 4, 2) == VOXEL_MAX_LIGHT << 4);
+        REQUIRE(grid.GetPackedLight(2, 3, 2) == 0);
+    }
+
+    SECTION("a buried sector stays dark at every level")
+    {
+        VoxelCollection aboveCollection(&repository);
+        aboveCollection.Fill(0);
+        VoxelLightMap above;
+        above.Rebuild(aboveCollection);
+        lightMap.Rebuild(collection, &above);
+
+        for (int level = 1; level < VOXEL_LOD_LEVEL_COUNT; ++level)
+        {
+            VoxelLodGrid grid(collection, lightMap, neighbors, level);
+            REQUIRE(grid.GetPackedLight(0, grid.GetSize() - 1, 0) == 0);
+        }
+    }
+
+    SECTION("cells past the edge are sampled from the neighbour")
+    {
+        VoxelCollection neighborCollection(&repository);
+        neighborCollection.Fill(0);
+        neighborCollection.ClearVoxel(Position(0, 9, 0));
+        VoxelLightMap neighborLightMap;
+        neighborLightMap.Rebuild(neighborCollection);
+
+        VoxelLodGrid open(collection, lightMap, neighbors, 1);
+        REQUIRE(open.GetPackedLight(-1, 4, 0) == VOXEL_MAX_LIGHT << 4);
+
+        // The only open cell of the neighbour's block is enclosed and dark
+        neighbors.Set(Direction::Left, &neighborCollection, &neighborLightMap);
+        VoxelLodGrid grid(collection, lightMap, neighbors, 1);
+        REQUIRE(grid.GetPackedLight(-1, 4, 0) == 0);
+        REQUIRE(grid.GetPackedLight(-1, 4, 4) == 0);
+    }
+}
@@ -0,0 +1,279 @@
+#include <cstdlib>
+#include <string>
+
+#include "catch.hh"
+
+#include "imagecache.hh"
+#include "voxelsectormesher.hh"
+
+static const int FACES_PER_SECTOR_SIDE = VOXEL_SECTOR_SIZE * VOXEL_SECTOR_SIZE;
+
+// Registers nothing and draws nothing; the mesher only needs a tile renderer
+class NullRenderer : public IRenderer
+{
+public:
+    void Render(const std::vector<IndexValue> &indices, const std::vector<float> &vertices,
+                const std::vector<float> &normals, const std::vector<float> &UVs, const IndexValue &materialId)
+    {
+    }
+
+    void Render(const std::vector<IndexValue> &indices, const std::vector<float> &vertices,
+                const std::vector<float> &normals, const std::vector<float> &UVs,
+                const std::vector<unsigned char> &light, const IndexValue &materialId)
+    {
+    }
+
+    IndexValue RegisterMesh(const RenderObject &object)
+    {
+        return 0;
+    }
+
+    void RenderInstanced(IndexValue meshId, const std::vector<glm::mat4> &modelMatrices,
+                         const IndexValue &materialId)
+    {
+    }
+
+    void Use()
+    {
+    }
+
+    IndexValue RegisterMaterial(MaterialInfo material)
+    {
+        return 0;
+    }
+
+    void SetModelMatrix(const glm::mat4 &matrix)
+    {
+    }
+
+    void SetViewMatrix(const glm::mat4 &matrix)
+    {
+    }
+
+    void SetProjectionMatrix(const glm::mat4 &matrix)
+    {
+    }
+};
+
+static RawImageInfo *LoadFakeTilemap(const std::string &fileName)
+{
+    RawImageInfo *image = (RawImageInfo *) calloc(1, sizeof(RawImageInfo));
+    image->width = 64;
+    image->height = 64;
+
+    return image;
+}
+
+static size_t GetFaceCount(const RenderObject &mesh)
+{
+    // Four bytes of lighting for each of the six vertices of a face
+    return mesh._light.size() / (6 * 4);
+}
+
+TEST_CASE("VoxelCollection tracks solid counts and uniformity")
+{
+    VoxelRepository repository;
+    repository.AddVoxelType(VoxelType(0, 0));
+    repository.AddVoxelType(VoxelType(0, 1));
+
+    VoxelCollection collection(&repository);
+    REQUIRE(collection.IsEmpty());
+    REQUIRE(collection.IsUniform());
+    REQUIRE(collection.GetUniformVoxel() == NULL);
+
+    SECTION("counts set, replaced and cleared voxels")
+    {
+        collection.SetVoxel(Position(1, 2, 3), 0);
+        collection.SetVoxel(Position(4, 5, 6), 1);
+        REQUIRE(collection.GetSolidCount() == 2);
+        REQUIRE(!collection.IsUniform());
+        REQUIRE(collection.GetVoxel(Position(4, 5, 6)) == repository.GetVoxel(1));
+
+        collection.SetVoxel(Position(4, 5, 6), 0);
+        REQUIRE(collection.GetSolidCount() == 2);
+
+        collection.ClearVoxel(Position(1, 2, 3));
+        collection.ClearVoxel(Position(1, 2, 3));
+        REQUIRE(collection.GetSolidCount() == 1);
+
+        collection.ClearVoxel(Position(4, 5, 6));
+        REQUIRE(collection.IsEmpty());
+        REQUIRE(collection.IsUniform());
+        REQUIRE(collection.GetVoxel(Position(4, 5, 6)) == NULL);
+    }
+
+    SECTION("becomes uniform again once every cell holds the same type")
+    {
+        collection.Fill(0);
+        REQUIRE(collection.IsFull());
+        REQUIRE(collection.GetUniformVoxel() == repository.GetVoxel(0));
+
+        collection.SetVoxel(Position(0, 0, 0), 1);
+        REQUIRE(collection.IsFull());
+        REQUIRE(!collection.IsUniform());
+
+        collection.SetVoxel(Position(0, 0, 0), 0);
+        REQUIRE(collection.IsUniform());
+        REQUIRE(collection.GetUniformVoxel() == repository.GetVoxel(0));
+
+        collection.ClearVoxel(Position(15, 15, 15));
+        REQUIRE(collection.GetSolidCount() == VOXEL_SECTOR_ARRAY_SIZE - 1);
+        REQUIRE(!collection.IsFull());
+        REQUIRE(!collection.IsUniform());
+    }
+
+    SECTION("writing the uniform voxel keeps the collection uniform")
+    {
+        collection.ClearVoxel(Position(3, 3, 3));
+        REQUIRE(collection.IsUniform());
+
+        collection.Fill(1);
+        collection.SetVoxel(Position(3, 3, 3), 1);
+        REQUIRE(collection.IsUniform());
+        REQUIRE(collection.GetSolidCount() == VOXEL_SECTOR_ARRAY_SIZE);
+    }
+}
+
+TEST_CASE("VoxelSectorMesher skips sectors with nothing to show")
+{
+    VoxelRepository repository;
+    repository.AddVoxelType(VoxelType(0, 0));
+
+    NullRenderer renderer;
+    TileRenderer tileRenderer(&renderer, ImageCache::GetInstance()->LoadAsync("voxel-test-tilemap", LoadFakeTilemap),
+                              16, 16);
+    VoxelSectorMesher mesher(&tileRenderer);
+
+    VoxelCollection collection(&repository);
+    VoxelLightMap lightMap;
+    VoxelSectorNeighbors neighbors;
+    RenderObject mesh;
+
+    SECTION("an empty sector has no faces")
+    {
+        lightMap.Rebuild(collection);
+        mesher.BuildMesh(collection, lightMap, neighbors, 0, mesh);
+        REQUIRE(mesh._indices.empty());
+    }
+
+    SECTION("a full sector only shows its outer layer")
+    {
+        collection.Fill(0);
+        lightMap.Rebuild(collection);
+        mesher.BuildMesh(collection, lightMap, neighbors, 0, mesh);
+        REQUIRE(GetFaceCount(mesh) == DIRECTION_COUNT * FACES_PER_SECTOR_SIDE);
+    }
+
+    SECTION("full neighbours hide the sides they cover")
+    {
+        VoxelCollection neighbor(&repository);
+        neighbor.Fill(0);
+        VoxelLightMap neighborLightMap;
+        neighborLightMap.Rebuild(neighbor);
+
+        collection.Fill(0);
+        lightMap.Rebuild(collection);
+
+        Direction directions[DIRECTION_COUNT] = {
+            Direction::Up, Direction::Down, Direction::Left,
+            Direction::Right, Direction::Forward, Direction::Backward
+        };
+        for (int i = 0; i < DIRECTION_COUNT - 1; ++i)
+        {
+            neighbors.Set(directions[i], &neighbor, &neighborLightMap);
+        }
+
+        REQUIRE(!VoxelSectorMesher::IsEnclosed(collection, neighbors));
+        mesher.BuildMesh(collection, lightMap, neighbors, 0, mesh);
+        REQUIRE(GetFaceCount(mesh) == FACES_PER_SECTOR_SIDE);
+
+        // Coarse levels close every side, so there are no gaps against
+        // neighbours drawn at another level
+        for (int level = 1; level < VOXEL_LOD_LEVEL_COUNT; ++level)
+        {
+            int size = VOXEL_SECTOR_SIZE >> level;
+            mesher.BuildMesh(collection, lightMap, neighbors, level, mesh);
+            REQUIRE(GetFaceCount(mesh) == DIRECTION_COUNT * size * size);
+        }
+
+        neighbors.Set(directions[DIRECTION_COUNT - 1], &neighbor, &neighborLightMap);
+        REQUIRE(VoxelSectorMesher::IsEnclosed(collection, neighbors));
+        mesher.BuildMesh(collection, lightMap, neighbors, 0, mesh);
+        REQUIRE(mesh._indices.empty());
+    }
+}
+
+// Lighting of the upward face vertex at the given corner of the mesh
+static const unsigned char *FindTopVertexLight(const RenderObject &mesh, float x, float z)
+{
+    for (size_t vertex = 0; vertex < mesh._normals.size() / 3; ++vertex)
+    {
+        const float *position = &mesh._vertices[vertex * 4];
+        if (mesh._normals[vertex * 3 + 1] > 0.5f && position[0] == x && position[2] == z)
+            return &mesh._light[vertex * 4];
+    }
+
+    return NULL;
+}
+
+TEST_CASE("VoxelSectorMesher samples the sectors across edges and corners")
+{
+    VoxelRepository repository;
+    repository.AddVoxelType(VoxelType(0, 0));
+
+    NullRenderer renderer;
+    TileRenderer tileRenderer(&renderer, ImageCache::GetInstance()->LoadAsync("voxel-test-tilemap", LoadFakeTilemap),
+                              16, 16);
+    VoxelSectorMesher mesher(&tileRenderer);
+
+    // The top face of this voxel has a corner on the edge shared with the
+    // sector at (1, 0, -1), whose cell (0, 1, VOXEL_SECTOR_SIZE - 1) touches it
+    const int last = VOXEL_SECTOR_SIZE - 1;
+    VoxelCollection collection(&repository);
+    collection.SetVoxel(Position(last, 0, 0), 0);
+    VoxelLightMap lightMap;
+    lightMap.Rebuild(collection);
+
+    VoxelCollection diagonal(&repository);
+    diagonal.Fill(0);
+    VoxelLightMap diagonalLightMap;
+    VoxelSectorNeighbors neighbors;
+    RenderObject mesh;
+
+    SECTION("without the sector the corner is open and fully lit")
+    {
+        mesher.BuildMesh(collection, lightMap, neighbors, 0, mesh);
+        const unsigned char *light = FindTopVertexLight(mesh, VOXEL_SECTOR_SIZE, 0);
+        REQUIRE(light != NULL);
+        REQUIRE(light[0] == 255);
+        REQUIRE(light[1] == 255);
+    }
+
+    SECTION("a solid cell in the sector occludes the corner")
+    {
+        diagonalLightMap.Rebuild(diagonal);
+        neighbors.Set(1, 0, -1, &diagonal, &diagonalLightMap);
+
+        mesher.BuildMesh(collection, lightMap, neighbors, 0, mesh);
+        const unsigned char *light = FindTopVertexLight(mesh, VOXEL_SECTOR_SIZE, 0);
+        REQUIRE(light != NULL);
+        REQUIRE(light[0] == 2 * 255 / 3);
+        REQUIRE(light[1] == 255);
+
+        // The opposite corner of the face is not next to the sector
+        REQUIRE(FindTopVertexLight(mesh, last, 1)[0] == 255);
+    }
+
+    SECTION("a dark open cell in the sector darkens the corner")
+    {
+        diagonal.ClearVoxel(Position(0, 1, last));
+        diagonalLightMap.Rebuild(diagonal);
+        neighbors.Set(1, 0, -1, &diagonal, &diagonalLightMap);
+
+        mesher.BuildMesh(collection, lightMap, neighbors, 0, mesh);
+        const unsigned char *light = FindTopVertexLight(mesh, VOXEL_SECTOR_SIZE, 0);
+        REQUIRE(light != NULL);
+        REQUIRE(light[0] == 255);
+        REQUIRE(light[1] == 3 * VOXEL_MAX_LIGHT * 255 / (4 * VOXEL_MAX_LIGHT));
+    }
+}